@@ -0,0 +1,438 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "AtlasPacker.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <new>
+
+#include <cocos2d.h>
+
+using std::string;
+using std::vector;
+using std::ofstream;
+using std::unique_ptr;
+using cocos2d::FileUtils;
+using cocos2d::Image;
+using cocos2d::Value;
+using cocos2d::ValueMap;
+
+namespace vigilante {
+
+namespace {
+
+bool isDirectory(const string& path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool isFile(const string& path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+// Sorted, so that the atlases are the same no matter how the filesystem orders them.
+vector<string> listSubdirs(const string& dir) {
+  vector<string> subdirs;
+  DIR* dp = opendir(dir.c_str());
+  if (!dp) {
+    return subdirs;
+  }
+  while (struct dirent* entry = readdir(dp)) {
+    const string name = entry->d_name;
+    if (name != "." && name != ".." && isDirectory(dir + "/" + name)) {
+      subdirs.push_back(name);
+    }
+  }
+  closedir(dp);
+  std::sort(subdirs.begin(), subdirs.end());
+  return subdirs;
+}
+
+string toString(int x, int y) {
+  return "{" + std::to_string(x) + "," + std::to_string(y) + "}";
+}
+
+string toString(float x, float y) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "{%g,%g}", x, y);
+  return buf;
+}
+
+string toString(const MaxRectsPacker::Rect& rect) {
+  return "{" + toString(rect.x, rect.y) + "," + toString(rect.width, rect.height) + "}";
+}
+
+int nextPowerOfTwo(int n) {
+  int p = 1;
+  while (p < n) {
+    p <<= 1;
+  }
+  return p;
+}
+
+}  // namespace
+
+
+AtlasPacker::AtlasPacker(int maxAtlasSize, int padding)
+    : _maxAtlasSize(maxAtlasSize),
+      _padding(padding),
+      _groups(),
+      _atlases(),
+      _unpackedTextureResDirs(),
+      _uniqueFrameCount() {}
+
+
+size_t AtlasPacker::addTextureResDirs(const string& resDir, const string& dirName,
+                                      const string& excludedDirName) {
+  if (dirName == excludedDirName) {
+    return 0;
+  }
+
+  size_t count = 0;
+  if (isFile(resDir + "/" + dirName + "/spritesheet.plist")) {
+    count += addTextureResDir(resDir, dirName) ? 1 : 0;
+  }
+  for (const auto& subdir : listSubdirs(resDir + "/" + dirName)) {
+    count += addTextureResDirs(resDir, dirName + "/" + subdir, excludedDirName);
+  }
+  return count;
+}
+
+bool AtlasPacker::addTextureResDir(const string& resDir, const string& textureResDir) {
+  unique_ptr<AtlasPacker::Group> group(new AtlasPacker::Group());
+  group->textureResDir = textureResDir;
+  group->area = 0;
+  group->sourceBytes = 0;
+
+  // Only the frames StaticActor::createAnimation() would find, i.e., 0.png, 1.png, ...
+  const string dir = resDir + "/" + textureResDir;
+  for (const auto& subdir : listSubdirs(dir)) {
+    for (int i = 0; isFile(dir + "/" + subdir + "/" + std::to_string(i) + ".png"); i++) {
+      AtlasPacker::Frame frame;
+      frame.name = subdir + "/" + std::to_string(i) + ".png";
+      if (!loadFrame(dir + "/" + frame.name, &frame)) {
+        fprintf(stderr, "failed to load %s/%s, skipped\n", dir.c_str(), frame.name.c_str());
+        continue;
+      }
+      group->area += static_cast<long>(frame.trimmedRect.width + _padding) *
+                     (frame.trimmedRect.height + _padding);
+      group->frames.push_back(std::move(frame));
+    }
+  }
+
+  if (group->frames.empty()) {
+    return false;
+  }
+
+  Image image;
+  if (image.initWithImageFile(dir + "/spritesheet.png")) {
+    group->sourceBytes = static_cast<size_t>(image.getWidth()) * image.getHeight() * 4;
+  }
+  _groups.push_back(std::move(group));
+  return true;
+}
+
+void AtlasPacker::pack() {
+  // The largest groups first, and then first fit.
+  vector<AtlasPacker::Group*> groups;
+  for (auto& group : _groups) {
+    groups.push_back(group.get());
+  }
+  std::stable_sort(groups.begin(), groups.end(),
+                   [](const AtlasPacker::Group* a, const AtlasPacker::Group* b) {
+    return a->area > b->area;
+  });
+
+  for (auto group : groups) {
+    bool isPacked = false;
+    for (size_t i = 0; i < _atlases.size() && !isPacked; i++) {
+      isPacked = tryPack(group, _atlases[i].get(), static_cast<int>(i));
+    }
+    if (isPacked) {
+      continue;
+    }
+
+    unique_ptr<AtlasPacker::Atlas> atlas(new AtlasPacker::Atlas(_maxAtlasSize));
+    if (!tryPack(group, atlas.get(), static_cast<int>(_atlases.size()))) {
+      fprintf(stderr, "%s doesn't fit in a %dx%d atlas, skipped\n",
+              group->textureResDir.c_str(), _maxAtlasSize, _maxAtlasSize);
+      _unpackedTextureResDirs.push_back(group->textureResDir);
+      continue;
+    }
+    _atlases.push_back(std::move(atlas));
+  }
+}
+
+bool AtlasPacker::write(const string& resDir, const string& outDirName,
+                        const string& manifestFileName) const {
+  const string outDir = resDir + "/" + outDirName;
+  if (!isDirectory(outDir) && mkdir(outDir.c_str(), 0755) != 0) {
+    fprintf(stderr, "failed to create %s\n", outDir.c_str());
+    return false;
+  }
+
+  ofstream manifest(resDir + "/" + manifestFileName);
+  if (!manifest.is_open()) {
+    fprintf(stderr, "failed to write %s/%s\n", resDir.c_str(), manifestFileName.c_str());
+    return false;
+  }
+
+  for (size_t i = 0; i < _atlases.size(); i++) {
+    const string name = "atlas_" + std::to_string(i);
+    if (!writePng(outDir + "/" + name + ".png", *_atlases[i]) ||
+        !writePlist(outDir + "/" + name + ".plist", name + ".png", *_atlases[i])) {
+      return false;
+    }
+    for (const auto group : _atlases[i]->groups) {
+      manifest << group->textureResDir << " " << outDirName << "/" << name << ".plist" << "\n";
+    }
+  }
+  return true;
+}
+
+size_t AtlasPacker::getFrameCount() const {
+  size_t count = 0;
+  for (const auto& group : _groups) {
+    count += group->frames.size();
+  }
+  return count;
+}
+
+size_t AtlasPacker::getUniqueFrameCount() const {
+  return _uniqueFrameCount;
+}
+
+size_t AtlasPacker::getAtlasCount() const {
+  return _atlases.size();
+}
+
+size_t AtlasPacker::getAtlasBytes() const {
+  size_t bytes = 0;
+  for (const auto& atlas : _atlases) {
+    bytes += static_cast<size_t>(getAtlasWidth(*atlas)) * getAtlasHeight(*atlas) * 4;
+  }
+  return bytes;
+}
+
+size_t AtlasPacker::getSourceBytes() const {
+  size_t bytes = 0;
+  for (const auto& atlas : _atlases) {
+    for (const auto group : atlas->groups) {
+      bytes += group->sourceBytes;
+    }
+  }
+  return bytes;
+}
+
+const vector<string>& AtlasPacker::getUnpackedTextureResDirs() const {
+  return _unpackedTextureResDirs;
+}
+
+
+bool AtlasPacker::loadFrame(const string& fileName, AtlasPacker::Frame* frame) {
+  Image image;
+  if (!image.initWithImageFile(fileName)) {
+    return false;
+  }
+
+  const int width = image.getWidth();
+  const int height = image.getHeight();
+  const unsigned char* data = image.getData();
+  int bytesPerPixel = 0;
+  switch (image.getRenderFormat()) {
+    case cocos2d::Texture2D::PixelFormat::RGBA8888:
+      bytesPerPixel = 4;
+      break;
+    case cocos2d::Texture2D::PixelFormat::RGB888:
+      bytesPerPixel = 3;
+      break;
+    default:
+      return false;
+  }
+
+  auto alphaAt = [=](int x, int y) -> unsigned char {
+    return (bytesPerPixel == 4) ? data[(y * width + x) * 4 + 3] : 0xff;
+  };
+
+  // Trim the fully transparent borders.
+  int minX = width;
+  int minY = height;
+  int maxX = -1;
+  int maxY = -1;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      if (alphaAt(x, y)) {
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+      }
+    }
+  }
+  if (maxX < 0) {
+    // Fully transparent, but cocos2d-x still needs a non-empty rect.
+    minX = minY = maxX = maxY = 0;
+  }
+
+  frame->sourceWidth = width;
+  frame->sourceHeight = height;
+  frame->trimmedRect = {minX, minY, maxX - minX + 1, maxY - minY + 1};
+  frame->pixels.resize(static_cast<size_t>(frame->trimmedRect.width) * frame->trimmedRect.height * 4);
+  frame->atlasIdx = -1;
+  frame->rect = {0, 0, 0, 0};
+
+  uint8_t* out = frame->pixels.data();
+  for (int y = minY; y <= maxY; y++) {
+    for (int x = minX; x <= maxX; x++) {
+      const unsigned char* in = data + (y * width + x) * bytesPerPixel;
+      *out++ = in[0];
+      *out++ = in[1];
+      *out++ = in[2];
+      *out++ = (bytesPerPixel == 4) ? in[3] : 0xff;
+    }
+  }
+
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ull;
+  for (auto byte : frame->pixels) {
+    hash = (hash ^ byte) * 1099511628211ull;
+  }
+  frame->hash = static_cast<size_t>(hash ^ (static_cast<uint64_t>(frame->trimmedRect.width) << 32) ^
+                                    static_cast<uint64_t>(frame->trimmedRect.height));
+  return true;
+}
+
+bool AtlasPacker::isSamePixels(const AtlasPacker::Frame& a, const AtlasPacker::Frame& b) {
+  return a.trimmedRect.width == b.trimmedRect.width &&
+         a.trimmedRect.height == b.trimmedRect.height &&
+         a.pixels == b.pixels;
+}
+
+bool AtlasPacker::tryPack(AtlasPacker::Group* group, AtlasPacker::Atlas* atlas, int atlasIdx) {
+  // Packed on a copy first, so that `atlas` is left untouched if it doesn't fit.
+  MaxRectsPacker packer = atlas->packer;
+  auto frameIdx = atlas->frameIdx;
+  vector<MaxRectsPacker::Rect> rects(group->frames.size());
+  size_t uniqueFrameCount = 0;
+
+  // The tallest frames first.
+  vector<size_t> order(group->frames.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [group](size_t a, size_t b) {
+    return group->frames[a].trimmedRect.height > group->frames[b].trimmedRect.height;
+  });
+
+  for (auto i : order) {
+    const AtlasPacker::Frame& frame = group->frames[i];
+
+    const AtlasPacker::Frame* duplicate = nullptr;
+    auto range = frameIdx.equal_range(frame.hash);
+    for (auto it = range.first; it != range.second && !duplicate; ++it) {
+      if (isSamePixels(*it->second, frame)) {
+        duplicate = it->second;
+      }
+    }
+    if (duplicate) {
+      // It may not have been committed yet, so look it up in `rects` if it's ours.
+      const bool isOurs = duplicate >= group->frames.data() &&
+                          duplicate < group->frames.data() + group->frames.size();
+      rects[i] = (isOurs) ? rects[duplicate - group->frames.data()] : duplicate->rect;
+      continue;
+    }
+
+    MaxRectsPacker::Rect rect;
+    if (!packer.insert(frame.trimmedRect.width + _padding, frame.trimmedRect.height + _padding, &rect)) {
+      return false;
+    }
+    rects[i] = {rect.x, rect.y, frame.trimmedRect.width, frame.trimmedRect.height};
+    frameIdx.insert({frame.hash, &frame});
+    uniqueFrameCount++;
+  }
+
+  for (size_t i = 0; i < group->frames.size(); i++) {
+    group->frames[i].atlasIdx = atlasIdx;
+    group->frames[i].rect = rects[i];
+  }
+  atlas->packer = packer;
+  atlas->frameIdx = std::move(frameIdx);
+  atlas->groups.push_back(group);
+  _uniqueFrameCount += uniqueFrameCount;
+  return true;
+}
+
+bool AtlasPacker::writePng(const string& fileName, const AtlasPacker::Atlas& atlas) const {
+  const int width = getAtlasWidth(atlas);
+  const int height = getAtlasHeight(atlas);
+  vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+
+  for (const auto group : atlas.groups) {
+    for (const auto& frame : group->frames) {
+      const size_t rowSize = static_cast<size_t>(frame.rect.width) * 4;
+      for (int y = 0; y < frame.rect.height; y++) {
+        memcpy(&pixels[(static_cast<size_t>(frame.rect.y + y) * width + frame.rect.x) * 4],
+               &frame.pixels[y * rowSize], rowSize);
+      }
+    }
+  }
+
+  Image image;
+  if (!image.initWithRawData(pixels.data(), pixels.size(), width, height, 8, false) ||
+      !image.saveToFile(fileName, false)) {
+    fprintf(stderr, "failed to write %s\n", fileName.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool AtlasPacker::writePlist(const string& fileName, const string& textureFileName,
+                             const AtlasPacker::Atlas& atlas) const {
+  ValueMap frames;
+  for (const auto group : atlas.groups) {
+    for (const auto& frame : group->frames) {
+      const MaxRectsPacker::Rect& trimmed = frame.trimmedRect;
+      // From the center of the source frame to the center of the trimmed rect, y-up.
+      const float offsetX = trimmed.x + trimmed.width / 2.0f - frame.sourceWidth / 2.0f;
+      const float offsetY = frame.sourceHeight / 2.0f - (trimmed.y + trimmed.height / 2.0f);
+
+      ValueMap dict;
+      dict["frame"] = Value(toString(frame.rect));
+      dict["offset"] = Value(toString(offsetX, offsetY));
+      dict["rotated"] = Value(false);
+      dict["sourceColorRect"] = Value(toString(trimmed));
+      dict["sourceSize"] = Value(toString(frame.sourceWidth, frame.sourceHeight));
+      frames[frame.name] = Value(dict);
+    }
+  }
+
+  ValueMap metadata;
+  metadata["format"] = Value(2);
+  metadata["textureFileName"] = Value(textureFileName);
+  metadata["realTextureFileName"] = Value(textureFileName);
+  metadata["size"] = Value(toString(getAtlasWidth(atlas), getAtlasHeight(atlas)));
+
+  ValueMap dict;
+  dict["frames"] = Value(frames);
+  dict["metadata"] = Value(metadata);
+  if (!FileUtils::getInstance()->writeValueMapToFile(dict, fileName)) {
+    fprintf(stderr, "failed to write %s\n", fileName.c_str());
+    return false;
+  }
+  return true;
+}
+
+int AtlasPacker::getAtlasWidth(const AtlasPacker::Atlas& atlas) const {
+  return std::min(nextPowerOfTwo(atlas.packer.getUsedWidth()), _maxAtlasSize);
+}
+
+int AtlasPacker::getAtlasHeight(const AtlasPacker::Atlas& atlas) const {
+  return std::min(nextPowerOfTwo(atlas.packer.getUsedHeight()), _maxAtlasSize);
+}
+
+}  // namespace vigilante
@@ -0,0 +1,109 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_ATLAS_PACKER_H_
+#define VIGILANTE_ATLAS_PACKER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MaxRectsPacker.h"
+
+namespace vigilante {
+
+// Repacks the frames of many textureResDirs into a few large atlases.
+//
+// Each frame is trimmed to its opaque pixels, and identical frames which end up
+// in the same atlas are stored only once. All frames of a textureResDir are kept
+// within the same atlas, since its sprites are batched by a single SpriteBatchNode
+// (see Character::defineTexture()).
+class AtlasPacker {
+ public:
+  AtlasPacker(int maxAtlasSize, int padding);
+  virtual ~AtlasPacker() = default;
+
+  // Adds every textureResDir (i.e., directory with a spritesheet.plist) under
+  // <resDir>/<dirName>, except those under <resDir>/<excludedDirName>.
+  // @return the number of textureResDirs added
+  size_t addTextureResDirs(const std::string& resDir, const std::string& dirName,
+                           const std::string& excludedDirName);
+
+  // Adds the frames of `textureResDir`, i.e., <resDir>/<textureResDir>/<subdir>/<n>.png,
+  // named "<subdir>/<n>.png" as StaticActor::createAnimation() expects.
+  // @return false if none of its frames could be loaded
+  bool addTextureResDir(const std::string& resDir, const std::string& textureResDir);
+
+  // Packs the frames added so far. The textureResDirs which don't fit even in an
+  // empty atlas are left out, and keep using their own spritesheets.
+  void pack();
+
+  // Writes <outDir>/atlas_<i>.png and .plist (cocos2d-x plist format 2), and the
+  // manifest, which maps each packed textureResDir to its atlas's plist
+  // (see asset_manager::loadAtlasManifest()).
+  // @param outDirName  relative to `resDir`
+  // @return false if any of the files couldn't be written
+  bool write(const std::string& resDir, const std::string& outDirName,
+             const std::string& manifestFileName) const;
+
+  size_t getFrameCount() const;
+  size_t getUniqueFrameCount() const;
+  size_t getAtlasCount() const;
+  size_t getAtlasBytes() const;  // as RGBA8888 textures
+  size_t getSourceBytes() const;  // the packed groups' own spritesheets, as RGBA8888 textures
+  const std::vector<std::string>& getUnpackedTextureResDirs() const;
+
+ private:
+  struct Frame final {
+    std::string name;
+    int sourceWidth;
+    int sourceHeight;
+    MaxRectsPacker::Rect trimmedRect;  // within the source frame, top-left origin
+    std::vector<uint8_t> pixels;  // of the trimmed rect, RGBA8888
+    size_t hash;
+
+    // Where it's packed.
+    int atlasIdx;
+    MaxRectsPacker::Rect rect;
+  };
+
+  struct Group final {
+    std::string textureResDir;
+    std::vector<AtlasPacker::Frame> frames;
+    long area;
+    size_t sourceBytes;  // of its own spritesheet
+  };
+
+  struct Atlas final {
+    explicit Atlas(int size) : packer(size, size), frameIdx(), groups() {}
+
+    MaxRectsPacker packer;
+    // The frames packed into this atlas by their hashes, for deduplication.
+    std::unordered_multimap<size_t, const AtlasPacker::Frame*> frameIdx;
+    std::vector<AtlasPacker::Group*> groups;
+  };
+
+  static bool loadFrame(const std::string& fileName, AtlasPacker::Frame* frame);
+  static bool isSamePixels(const AtlasPacker::Frame& a, const AtlasPacker::Frame& b);
+
+  // Packs all frames of `group` into `atlas`, or none of them at all.
+  bool tryPack(AtlasPacker::Group* group, AtlasPacker::Atlas* atlas, int atlasIdx);
+
+  bool writePng(const std::string& fileName, const AtlasPacker::Atlas& atlas) const;
+  bool writePlist(const std::string& fileName, const std::string& textureFileName,
+                  const AtlasPacker::Atlas& atlas) const;
+
+  int getAtlasWidth(const AtlasPacker::Atlas& atlas) const;
+  int getAtlasHeight(const AtlasPacker::Atlas& atlas) const;
+
+  int _maxAtlasSize;
+  int _padding;
+  std::vector<std::unique_ptr<AtlasPacker::Group>> _groups;
+  std::vector<std::unique_ptr<AtlasPacker::Atlas>> _atlases;
+  std::vector<std::string> _unpackedTextureResDirs;
+  size_t _uniqueFrameCount;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_ATLAS_PACKER_H_
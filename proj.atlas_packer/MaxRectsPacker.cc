@@ -0,0 +1,119 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "MaxRectsPacker.h"
+
+#include <algorithm>
+#include <limits>
+
+using std::vector;
+
+namespace vigilante {
+
+MaxRectsPacker::MaxRectsPacker(int width, int height)
+    : _freeRects({{0, 0, width, height}}),
+      _usedWidth(),
+      _usedHeight() {}
+
+
+bool MaxRectsPacker::insert(int width, int height, MaxRectsPacker::Rect* rect) {
+  int bestShortSideFit = std::numeric_limits<int>::max();
+  int bestLongSideFit = std::numeric_limits<int>::max();
+  const MaxRectsPacker::Rect* bestFreeRect = nullptr;
+
+  for (const auto& freeRect : _freeRects) {
+    if (freeRect.width < width || freeRect.height < height) {
+      continue;
+    }
+
+    const int leftoverX = freeRect.width - width;
+    const int leftoverY = freeRect.height - height;
+    const int shortSideFit = std::min(leftoverX, leftoverY);
+    const int longSideFit = std::max(leftoverX, leftoverY);
+
+    if (shortSideFit < bestShortSideFit ||
+        (shortSideFit == bestShortSideFit && longSideFit < bestLongSideFit)) {
+      bestShortSideFit = shortSideFit;
+      bestLongSideFit = longSideFit;
+      bestFreeRect = &freeRect;
+    }
+  }
+
+  if (!bestFreeRect) {
+    return false;
+  }
+
+  *rect = {bestFreeRect->x, bestFreeRect->y, width, height};
+  splitFreeRects(*rect);
+  pruneFreeRects();
+
+  _usedWidth = std::max(_usedWidth, rect->x + rect->width);
+  _usedHeight = std::max(_usedHeight, rect->y + rect->height);
+  return true;
+}
+
+int MaxRectsPacker::getUsedWidth() const {
+  return _usedWidth;
+}
+
+int MaxRectsPacker::getUsedHeight() const {
+  return _usedHeight;
+}
+
+
+void MaxRectsPacker::splitFreeRects(const MaxRectsPacker::Rect& usedRect) {
+  vector<MaxRectsPacker::Rect> newFreeRects;
+
+  for (auto it = _freeRects.begin(); it != _freeRects.end();) {
+    const MaxRectsPacker::Rect freeRect = *it;
+
+    if (usedRect.x >= freeRect.x + freeRect.width || usedRect.x + usedRect.width <= freeRect.x ||
+        usedRect.y >= freeRect.y + freeRect.height || usedRect.y + usedRect.height <= freeRect.y) {
+      ++it;
+      continue;
+    }
+
+    // Keep the (up to four) maximal parts of `freeRect` around `usedRect`.
+    if (usedRect.x > freeRect.x) {
+      newFreeRects.push_back({freeRect.x, freeRect.y, usedRect.x - freeRect.x, freeRect.height});
+    }
+    if (usedRect.x + usedRect.width < freeRect.x + freeRect.width) {
+      const int x = usedRect.x + usedRect.width;
+      newFreeRects.push_back({x, freeRect.y, freeRect.x + freeRect.width - x, freeRect.height});
+    }
+    if (usedRect.y > freeRect.y) {
+      newFreeRects.push_back({freeRect.x, freeRect.y, freeRect.width, usedRect.y - freeRect.y});
+    }
+    if (usedRect.y + usedRect.height < freeRect.y + freeRect.height) {
+      const int y = usedRect.y + usedRect.height;
+      newFreeRects.push_back({freeRect.x, y, freeRect.width, freeRect.y + freeRect.height - y});
+    }
+
+    it = _freeRects.erase(it);
+  }
+
+  _freeRects.insert(_freeRects.end(), newFreeRects.begin(), newFreeRects.end());
+}
+
+void MaxRectsPacker::pruneFreeRects() {
+  // Remove the free rects which are contained by another one.
+  for (size_t i = 0; i < _freeRects.size(); i++) {
+    for (size_t j = i + 1; j < _freeRects.size(); j++) {
+      if (contains(_freeRects[j], _freeRects[i])) {
+        _freeRects.erase(_freeRects.begin() + i);
+        i--;
+        break;
+      }
+      if (contains(_freeRects[i], _freeRects[j])) {
+        _freeRects.erase(_freeRects.begin() + j);
+        j--;
+      }
+    }
+  }
+}
+
+bool MaxRectsPacker::contains(const MaxRectsPacker::Rect& a, const MaxRectsPacker::Rect& b) {
+  return b.x >= a.x && b.y >= a.y &&
+         b.x + b.width <= a.x + a.width &&
+         b.y + b.height <= a.y + a.height;
+}
+
+}  // namespace vigilante
@@ -0,0 +1,46 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_MAX_RECTS_PACKER_H_
+#define VIGILANTE_MAX_RECTS_PACKER_H_
+
+#include <vector>
+
+namespace vigilante {
+
+// Packs rectangles into a fixed-size page with the MaxRects algorithm
+// (best short side fit). Rectangles are never rotated, since cocos2d-x
+// would have to rotate the pixel art back at runtime.
+class MaxRectsPacker {
+ public:
+  struct Rect final {
+    int x;
+    int y;
+    int width;
+    int height;
+  };
+
+  MaxRectsPacker(int width, int height);
+  virtual ~MaxRectsPacker() = default;
+
+  // @return false if there's no room for a `width` x `height` rectangle,
+  //         in which case the packer is left unchanged.
+  bool insert(int width, int height, MaxRectsPacker::Rect* rect);
+
+  // The size of the smallest area at the top-left corner
+  // which contains all of the rectangles inserted so far.
+  int getUsedWidth() const;
+  int getUsedHeight() const;
+
+ private:
+  void splitFreeRects(const MaxRectsPacker::Rect& usedRect);
+  void pruneFreeRects();
+
+  static bool contains(const MaxRectsPacker::Rect& a, const MaxRectsPacker::Rect& b);
+
+  std::vector<MaxRectsPacker::Rect> _freeRects;
+  int _usedWidth;
+  int _usedHeight;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_MAX_RECTS_PACKER_H_
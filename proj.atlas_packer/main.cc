@@ -0,0 +1,86 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+//
+// Offline atlas packer.
+//
+// Usage: VigilanteAtlasPacker <Resources dir> [--max-size 2048] [--padding 1]
+//
+// Repacks the frames of every spritesheet under <Resources>/Texture into a few
+// large atlases (see AtlasPacker.h), which are written to <Resources>/Texture/atlas,
+// along with the manifest that maps each textureResDir to its atlas. At runtime,
+// asset_manager::loadAtlasManifest() makes the game load the atlases instead of
+// the per-character spritesheets. The frame names are kept as they are, so
+// StaticActor::createAnimation() finds them in either case.
+//
+// Re-run it whenever the textures change. To go back to the per-character
+// spritesheets, simply delete Texture/atlas.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <cocos2d.h>
+#include "AtlasPacker.h"
+
+#define DEFAULT_MAX_ATLAS_SIZE 2048
+#define DEFAULT_PADDING 1
+#define TEXTURE_DIR_NAME "Texture"
+#define ATLAS_DIR_NAME "Texture/atlas"
+#define MANIFEST_FILE_NAME "Texture/atlas/manifest.txt"
+#define BYTES_PER_MB (1024.0 * 1024.0)
+
+using std::string;
+using vigilante::AtlasPacker;
+
+namespace {
+
+void printUsage(const char* argv0) {
+  fprintf(stderr, "usage: %s <Resources dir> [--max-size %d] [--padding %d]\n",
+          argv0, DEFAULT_MAX_ATLAS_SIZE, DEFAULT_PADDING);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  string resDir;
+  int maxAtlasSize = DEFAULT_MAX_ATLAS_SIZE;
+  int padding = DEFAULT_PADDING;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--max-size") && i + 1 < argc) {
+      maxAtlasSize = std::atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--padding") && i + 1 < argc) {
+      padding = std::atoi(argv[++i]);
+    } else if (argv[i][0] != '-' && resDir.empty()) {
+      resDir = argv[i];
+    } else {
+      printUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (resDir.empty() || maxAtlasSize <= 0 || padding < 0) {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // The frames are packed as they are, and the game doesn't premultiply them either.
+  cocos2d::Image::setPNGPremultipliedAlphaEnabled(false);
+
+  AtlasPacker packer(maxAtlasSize, padding);
+  if (packer.addTextureResDirs(resDir, TEXTURE_DIR_NAME, ATLAS_DIR_NAME) == 0) {
+    fprintf(stderr, "no spritesheets found under %s/%s\n", resDir.c_str(), TEXTURE_DIR_NAME);
+    return EXIT_FAILURE;
+  }
+
+  packer.pack();
+  if (!packer.write(resDir, ATLAS_DIR_NAME, MANIFEST_FILE_NAME)) {
+    return EXIT_FAILURE;
+  }
+
+  printf("frames: %zu (%zu unique)\n", packer.getFrameCount(), packer.getUniqueFrameCount());
+  printf("atlases: %zu (%zu spritesheets left unpacked)\n",
+         packer.getAtlasCount(), packer.getUnpackedTextureResDirs().size());
+  printf("texture memory: %.1f MB -> %.1f MB\n",
+         packer.getSourceBytes() / BYTES_PER_MB, packer.getAtlasBytes() / BYTES_PER_MB);
+  return EXIT_SUCCESS;
+}
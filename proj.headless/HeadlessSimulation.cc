@@ -0,0 +1,200 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "HeadlessSimulation.h"
+
+#include <memory>
+
+#include <cocos2d.h>
+#include <Box2D/Box2D.h>
+#include "../src/AssetManager.h"
+#include "../src/CallbackManager.h"
+#include "../src/Constants.h"
+#include "../src/character/Npc.h"
+#include "../src/character/Player.h"
+#include "../src/gameplay/ExpPointTable.h"
+#include "../src/gameplay/ItemPriceTable.h"
+#include "../src/input/InputRecorder.h"
+#include "../src/map/GameMapManager.h"
+#include "../src/scene/GameScene.h"
+#include "../src/util/KeyCodeUtil.h"
+#include "../src/util/RandUtil.h"
+#include "../src/util/Logger.h"
+#include "../src/util/Profiler.h"
+
+#define NPCS_PER_ROW 20
+#define NPC_SPACING_X 16.0f
+#define NPC_SPACING_Y 32.0f
+
+using std::string;
+using std::shared_ptr;
+using cocos2d::Director;
+using cocos2d::GLView;
+using cocos2d::GLViewImpl;
+using cocos2d::PoolManager;
+using cocos2d::Rect;
+using cocos2d::Scene;
+
+namespace vigilante {
+
+const float HeadlessSimulation::kTickDelta = 1 / kFps;
+
+HeadlessSimulation::HeadlessSimulation()
+    : _scene(),
+      _isGameScene(),
+      _isSpritesheetLoadingSerial(),
+      _spawnedNpcs(),
+      _isChurnCrouching() {}
+
+HeadlessSimulation::~HeadlessSimulation() {
+  GameMapManager::getInstance()->joinWorldStep();
+  if (_scene) {
+    _scene->onExit();
+    _scene->release();
+  }
+}
+
+
+bool HeadlessSimulation::init(unsigned int seed) {
+  if (!initDirector()) {
+    return false;
+  }
+
+  enterScene(Scene::create());
+  CallbackManager::getInstance()->setScene(_scene);
+
+  keycode_util::init();
+  rand_util::init(seed);
+
+  exp_point_table::import(asset_manager::kExpPointTable);
+  item_price_table::import(asset_manager::kItemPriceTable);
+
+  _scene->addChild(GameMapManager::getInstance()->getLayer());
+  return true;
+}
+
+bool HeadlessSimulation::initWithGameScene() {
+  if (!initDirector()) {
+    return false;
+  }
+
+  _isGameScene = true;
+  // Started the same way as the replayed session (see MainMenuScene::startRecordedGame()).
+  const string& gameSaveFilePath = InputRecorder::getInstance()->getGameSaveFilePath();
+  GameScene* gameScene = GameScene::create();
+  if (gameSaveFilePath.empty() || !gameScene->loadGame(gameSaveFilePath)) {
+    gameScene->startNewGame();
+  }
+  enterScene(gameScene);
+  return true;
+}
+
+bool HeadlessSimulation::initDirector() {
+  Director* director = Director::getInstance();
+
+  // Create a hidden window which only serves as the owner of the GL context.
+  // GLViewImpl's ctor calls glfwInit() too, but the hint below must be set
+  // before the window is created. glfwInit() is idempotent.
+  if (!glfwInit()) {
+    VGLOG(LOG_ERR, "Failed to initialize glfw.");
+    return false;
+  }
+  glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+  GLView* glview = GLViewImpl::createWithRect("Vigilante (headless)", Rect(0, 0, 1, 1));
+  if (!glview) {
+    VGLOG(LOG_ERR, "Failed to create the GL context.");
+    return false;
+  }
+  director->setOpenGLView(glview);
+  glview->setDesignResolutionSize(kVirtualWidth, kVirtualHeight, ResolutionPolicy::SHOW_ALL);
+
+  asset_manager::loadAtlasManifest(asset_manager::kAtlasManifest);
+  if (_isSpritesheetLoadingSerial) {
+    asset_manager::loadSpritesheetsSerially(asset_manager::kSpritesheetsList);
+  } else {
+    asset_manager::loadSpritesheets(asset_manager::kSpritesheetsList);
+  }
+  return true;
+}
+
+void HeadlessSimulation::enterScene(Scene* scene) {
+  // Actions (and hence CallbackManager's callbacks) only run on nodes that
+  // are running, so the scene has to be entered manually since
+  // Director::runWithScene() only takes effect upon the next drawScene().
+  _scene = scene;
+  _scene->retain();
+  _scene->onEnter();
+  _scene->onEnterTransitionDidFinish();
+}
+
+void HeadlessSimulation::loadGameMap(const string& tmxMapFileName) {
+  GameMapManager::getInstance()->doLoadGameMap(tmxMapFileName);
+}
+
+int HeadlessSimulation::spawnNpcs(const string& npcJsonFileName, int count) {
+  GameMapManager* gmMgr = GameMapManager::getInstance();
+  if (!gmMgr->getGameMap() || !gmMgr->getPlayer()) {
+    VGLOG(LOG_ERR, "Cannot spawn npcs before a GameMap has been loaded.");
+    return 0;
+  }
+
+  const b2Vec2& spawnPos = gmMgr->getPlayer()->getBody()->GetPosition();
+  int spawned = 0;
+
+  for (int i = 0; i < count; i++) {
+    float x = spawnPos.x * kPpm + (i % NPCS_PER_ROW - NPCS_PER_ROW / 2) * NPC_SPACING_X;
+    float y = spawnPos.y * kPpm + (i / NPCS_PER_ROW) * NPC_SPACING_Y;
+    auto npc = std::make_shared<Npc>(npcJsonFileName);
+    if (gmMgr->getGameMap()->showDynamicActor(npc, x, y)) {
+      _spawnedNpcs.push_back(npc);
+      spawned++;
+    }
+  }
+
+  return spawned;
+}
+
+void HeadlessSimulation::tick() {
+  GameMapManager* gmMgr = GameMapManager::getInstance();
+  profiler::collect();
+
+  // Director::drawScene() isn't running either, so this is what
+  // its EVENT_BEFORE_UPDATE and EVENT_AFTER_UPDATE would do
+  // (see GameMapManager::stepWorld()).
+  gmMgr->joinWorldStep();
+
+  // Runs the ActionManager, hence animations and CallbackManager's callbacks.
+  // GameScene::update() is scheduled, so it runs here as well.
+  Director::getInstance()->getScheduler()->update(kTickDelta);
+
+  if (!_isGameScene) {
+    gmMgr->stepWorld(kTickDelta);
+    gmMgr->update(kTickDelta);
+  }
+
+  gmMgr->startPendingWorldStep();
+
+  // Director::mainLoop() isn't running, so drain the autorelease pool ourselves.
+  PoolManager::getInstance()->getCurrentPool()->clear();
+}
+
+void HeadlessSimulation::churnAnimations() {
+  // Only the Characters' flags are changed, which the physics thread never reads.
+  _isChurnCrouching = !_isChurnCrouching;
+
+  for (const auto& weakNpc : _spawnedNpcs) {
+    shared_ptr<Npc> npc = weakNpc.lock();
+    if (!npc || npc->isKilled()) {
+      continue;
+    }
+    if (_isChurnCrouching) {
+      npc->crouch();
+    } else {
+      npc->getUp();
+    }
+  }
+}
+
+void HeadlessSimulation::setSpritesheetLoadingSerial(bool isSpritesheetLoadingSerial) {
+  _isSpritesheetLoadingSerial = isSpritesheetLoadingSerial;
+}
+
+}  // namespace vigilante
@@ -0,0 +1,69 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_HEADLESS_SIMULATION_H_
+#define VIGILANTE_HEADLESS_SIMULATION_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cocos2d.h>
+
+namespace vigilante {
+
+// Forward Declaration
+class Npc;
+
+// HeadlessSimulation drives the game logic (b2World stepping, GameMapManager,
+// Npc::act, quests and CallbackManager) on fixed ticks without rendering.
+//
+// Nothing is ever drawn. However, cocos2d-x still needs an OpenGL context
+// to create textures (sprites, labels, ...), so a hidden 1x1 window is created
+// solely to own that context. On a CI machine without a GPU, run it under
+// Xvfb with Mesa's software rasterizer.
+class HeadlessSimulation {
+ public:
+  HeadlessSimulation();
+  virtual ~HeadlessSimulation();
+
+  // Runs GameMapManager on its own, without GameScene (and hence without UI).
+  bool init(unsigned int seed);
+
+  // Runs the real GameScene (e.g., to replay a recorded session, see InputRecorder).
+  // loadGameMap() and spawnNpcs() are not needed, since GameScene starts a new game.
+  bool initWithGameScene();
+
+  // Unlike GameMapManager::loadGameMap(), the GameMap is loaded synchronously
+  // and there's no Shade transition.
+  void loadGameMap(const std::string& tmxMapFileName);
+
+  // Spawns `count` copies of the given npc around the player's spawn point.
+  // @return the number of npcs actually spawned.
+  int spawnNpcs(const std::string& npcJsonFileName, int count);
+
+  // Advances the simulation by exactly one fixed tick (1 / kFps).
+  void tick();
+
+  // Makes each spawned npc crouch or get up, so that all of them switch
+  // to another animation on the next tick.
+  void churnAnimations();
+
+  // Call it before init() to load the spritesheets with
+  // asset_manager::loadSpritesheetsSerially() instead.
+  void setSpritesheetLoadingSerial(bool isSpritesheetLoadingSerial);
+
+  static const float kTickDelta;
+
+ private:
+  bool initDirector();
+  void enterScene(cocos2d::Scene* scene);
+
+  cocos2d::Scene* _scene;
+  bool _isGameScene;
+  bool _isSpritesheetLoadingSerial;
+  std::vector<std::weak_ptr<Npc>> _spawnedNpcs;
+  bool _isChurnCrouching;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_HEADLESS_SIMULATION_H_
@@ -0,0 +1,103 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "NavBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <cocos2d.h>
+#include "../src/map/NavGraph.h"
+#include "../src/util/RandUtil.h"
+#include "../src/util/Logger.h"
+
+// Roughly how high the characters in the game can jump (in meters).
+#define MAX_JUMP_HEIGHT 1.2f
+// Must be less than NavGraph's path cache capacity.
+#define CACHED_QUERY_CHUNK_SIZE 1024
+
+using std::pair;
+using std::string;
+using std::vector;
+using cocos2d::TMXTiledMap;
+
+namespace vigilante {
+
+namespace nav_benchmark {
+
+namespace {
+
+// @return the number of paths found in [begin, end)
+int query(NavGraph* navGraph,
+          vector<pair<uint32_t, uint32_t>>::const_iterator begin,
+          vector<pair<uint32_t, uint32_t>>::const_iterator end,
+          double* sec) {
+  int found = 0;
+  auto beginTime = std::chrono::steady_clock::now();
+  for (auto it = begin; it != end; it++) {
+    found += !navGraph->findPath(it->first, it->second, MAX_JUMP_HEIGHT)->empty();
+  }
+  *sec += std::chrono::duration<double>(std::chrono::steady_clock::now() - beginTime).count();
+  return found;
+}
+
+}  // namespace
+
+
+int run(const string& tmxMapFileName, int queryCount, unsigned int seed) {
+  TMXTiledMap* tmxTiledMap = TMXTiledMap::create(tmxMapFileName);
+  if (!tmxTiledMap) {
+    VGLOG(LOG_ERR, "Failed to load %s", tmxMapFileName.c_str());
+    return EXIT_FAILURE;
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  std::shared_ptr<NavGraph> navGraph = NavGraph::get(tmxMapFileName, tmxTiledMap);
+  const double bakeMs = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - begin).count();
+
+  if (navGraph->getNodeCount() == 0) {
+    VGLOG(LOG_ERR, "%s has no walkable surface", tmxMapFileName.c_str());
+    return EXIT_FAILURE;
+  }
+
+  rand_util::Generator rng(seed);
+  vector<pair<uint32_t, uint32_t>> pairs(queryCount);
+  for (auto& p : pairs) {
+    p.first = rng.nextUInt(navGraph->getNodeCount());
+    p.second = rng.nextUInt(navGraph->getNodeCount());
+  }
+
+  double uncachedSec = 0;
+  const int found = query(navGraph.get(), pairs.begin(), pairs.end(), &uncachedSec);
+
+  // The path cache is bounded, so query the pairs again in chunks which
+  // fit in it. Each chunk is queried once more (untimed) to cache it first.
+  double cachedSec = 0;
+  for (size_t i = 0; i < pairs.size(); i += CACHED_QUERY_CHUNK_SIZE) {
+    auto chunkBegin = pairs.cbegin() + i;
+    auto chunkEnd = pairs.cbegin() + std::min(pairs.size(), i + CACHED_QUERY_CHUNK_SIZE);
+    double unused = 0;
+    query(navGraph.get(), chunkBegin, chunkEnd, &unused);
+    query(navGraph.get(), chunkBegin, chunkEnd, &cachedSec);
+  }
+
+  const double uncachedQps = queryCount / uncachedSec;
+  const double cachedQps = queryCount / cachedSec;
+
+  printf("map: %s\n", tmxMapFileName.c_str());
+  printf("nodes: %d\n", static_cast<int>(navGraph->getNodeCount()));
+  printf("links: %d\n", static_cast<int>(navGraph->getLinkCount()));
+  printf("bake_ms: %.4f\n", bakeMs);
+  printf("queries: %d (%d reachable)\n", queryCount, found);
+  printf("uncached_queries_per_sec: %.1f\n", uncachedQps);
+  printf("cached_queries_per_sec: %.1f\n", cachedQps);
+  return EXIT_SUCCESS;
+}
+
+}  // namespace nav_benchmark
+
+}  // namespace vigilante
@@ -0,0 +1,22 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_NAV_BENCHMARK_H_
+#define VIGILANTE_NAV_BENCHMARK_H_
+
+#include <string>
+
+namespace vigilante {
+
+namespace nav_benchmark {
+
+// Bakes the navigation graph of the given .tmx, and then runs `queryCount`
+// path queries between random pairs of nodes, first with an empty path cache
+// and then again with all of them cached. The bake time and the number of
+// queries per second are printed.
+// @return EXIT_SUCCESS or EXIT_FAILURE
+int run(const std::string& tmxMapFileName, int queryCount, unsigned int seed);
+
+}  // namespace nav_benchmark
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_NAV_BENCHMARK_H_
@@ -0,0 +1,203 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "PhysicsBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <Box2D/Box2D.h>
+#include "../src/Constants.h"
+#include "../src/map/PhysicsProfile.h"
+#include "../src/util/RandUtil.h"
+
+// The projectiles of each lane, fired every VOLLEY_INTERVAL ticks.
+#define PROJECTILE_COUNT 8
+#define PROJECTILE_RADIUS .05f
+#define PROJECTILE_SPEED 60.0f  // i.e., 1m per tick, ten times the barriers' width
+#define VOLLEY_INTERVAL 60
+#define BARRIER_HALF_WIDTH .05f
+#define CRATE_HALF_SIZE .125f
+
+using std::unique_ptr;
+using std::vector;
+
+namespace vigilante {
+
+namespace physics_benchmark {
+
+namespace {
+
+// The projectiles of the lower lane are fired at the plank,
+// and those of the upper lane at the wall.
+const float kPlankLaneY = 1.0f;
+const float kWallLaneY = 4.0f;
+const float kLaneHeight = 2.0f;
+const float kFiringX = 0;
+const float kPlankX = 5.0f;
+const float kWallX = 8.0f;
+
+struct Scene final {
+  unique_ptr<b2World> world;
+  b2Body* plank;
+  vector<b2Body*> plankLaneProjectiles;
+  vector<b2Body*> wallLaneProjectiles;
+};
+
+b2Body* createBox(b2World* world, b2BodyType type, float x, float y,
+                  float halfWidth, float halfHeight, float density) {
+  b2BodyDef bodyDef;
+  bodyDef.type = type;
+  bodyDef.position.Set(x, y);
+  b2Body* body = world->CreateBody(&bodyDef);
+
+  b2PolygonShape shape;
+  shape.SetAsBox(halfWidth, halfHeight);
+  b2FixtureDef fixtureDef;
+  fixtureDef.shape = &shape;
+  fixtureDef.density = density;
+  fixtureDef.friction = .5f;
+  body->CreateFixture(&fixtureDef);
+  return body;
+}
+
+vector<b2Body*> createProjectiles(b2World* world) {
+  vector<b2Body*> projectiles(PROJECTILE_COUNT);
+  for (auto& projectile : projectiles) {
+    b2BodyDef bodyDef;
+    bodyDef.type = b2BodyType::b2_dynamicBody;
+    bodyDef.gravityScale = 0;
+    projectile = world->CreateBody(&bodyDef);
+
+    b2CircleShape shape;
+    shape.m_radius = PROJECTILE_RADIUS;
+    b2FixtureDef fixtureDef;
+    fixtureDef.shape = &shape;
+    fixtureDef.density = 1.0f;
+    fixtureDef.filter.groupIndex = -1;  // never collide with each other
+    projectile->CreateFixture(&fixtureDef);
+  }
+  return projectiles;
+}
+
+Scene createScene(int bodyCount, unsigned int seed) {
+  Scene scene;
+  scene.world = std::make_unique<b2World>(b2Vec2(0, kGravity));
+
+  b2BodyDef groundDef;
+  b2Body* ground = scene.world->CreateBody(&groundDef);
+  b2EdgeShape groundShape;
+  groundShape.Set({-50.0f, 0}, {50.0f, 0});
+  ground->CreateFixture(&groundShape, 0);
+
+  // The crates are piled up behind the firing line, out of the projectiles' way.
+  rand_util::Generator rng(seed);
+  for (int i = 0; i < bodyCount; i++) {
+    createBox(scene.world.get(), b2BodyType::b2_dynamicBody,
+              rng.nextFloat(-30.0f, -5.0f), rng.nextFloat(1.0f, 20.0f),
+              CRATE_HALF_SIZE, CRATE_HALF_SIZE, 1.0f);
+  }
+
+  scene.plank = createBox(scene.world.get(), b2BodyType::b2_dynamicBody,
+                          kPlankX, kPlankLaneY + kLaneHeight / 2,
+                          BARRIER_HALF_WIDTH, kLaneHeight / 2, 1000.0f);
+  scene.plank->SetGravityScale(0);
+  createBox(scene.world.get(), b2BodyType::b2_staticBody,
+            kWallX, kWallLaneY + kLaneHeight / 2,
+            BARRIER_HALF_WIDTH, kLaneHeight / 2, 0);
+
+  scene.plankLaneProjectiles = createProjectiles(scene.world.get());
+  scene.wallLaneProjectiles = createProjectiles(scene.world.get());
+  return scene;
+}
+
+void fire(const vector<b2Body*>& projectiles, float laneY) {
+  const float spacing = kLaneHeight / (projectiles.size() + 1);
+  for (size_t i = 0; i < projectiles.size(); i++) {
+    projectiles[i]->SetTransform({kFiringX, laneY + spacing * (i + 1)}, 0);
+    projectiles[i]->SetLinearVelocity({PROJECTILE_SPEED, 0});
+    projectiles[i]->SetAngularVelocity(0);
+    projectiles[i]->SetAwake(true);
+  }
+}
+
+void fire(Scene* scene) {
+  scene->plank->SetTransform({kPlankX, kPlankLaneY + kLaneHeight / 2}, 0);
+  scene->plank->SetLinearVelocity({0, 0});
+  scene->plank->SetAngularVelocity(0);
+  fire(scene->plankLaneProjectiles, kPlankLaneY);
+  fire(scene->wallLaneProjectiles, kWallLaneY);
+}
+
+// @return the number of projectiles which have got past `barrierX`
+int countTunnelled(const vector<b2Body*>& projectiles, float barrierX) {
+  return static_cast<int>(std::count_if(projectiles.begin(), projectiles.end(),
+                                        [barrierX](const b2Body* projectile) {
+    return projectile->GetPosition().x > barrierX;
+  }));
+}
+
+}  // namespace
+
+
+int run(int bodyCount, int tickCount, unsigned int seed) {
+  const float timeStep = 1 / kFps;
+  const int volleyCount = (tickCount + VOLLEY_INTERVAL - 1) / VOLLEY_INTERVAL;
+
+  printf("crates: %d\n", bodyCount);
+  printf("ticks: %d (%d volleys of %d + %d projectiles)\n",
+         tickCount, volleyCount, PROJECTILE_COUNT, PROJECTILE_COUNT);
+  printf("seed: %u\n", seed);
+
+  for (const auto& profile : physics_profiles::getAll()) {
+    Scene scene = createScene(bodyCount, seed);
+    scene.world->SetContinuousPhysics(profile.isContinuousPhysicsEnabled);
+    for (auto projectile : scene.plankLaneProjectiles) {
+      projectile->SetBullet(profile.isBulletEnabled);
+    }
+    for (auto projectile : scene.wallLaneProjectiles) {
+      projectile->SetBullet(profile.isBulletEnabled);
+    }
+
+    vector<double> stepTimesMs(tickCount);
+    int plankTunnelled = 0;
+    int wallTunnelled = 0;
+
+    for (int i = 0; i < tickCount; i++) {
+      if (i % VOLLEY_INTERVAL == 0) {
+        if (i > 0) {
+          plankTunnelled += countTunnelled(scene.plankLaneProjectiles, scene.plank->GetPosition().x);
+          wallTunnelled += countTunnelled(scene.wallLaneProjectiles, kWallX);
+        }
+        fire(&scene);
+      }
+      auto begin = std::chrono::steady_clock::now();
+      profile.step(scene.world.get(), timeStep);
+      auto end = std::chrono::steady_clock::now();
+      stepTimesMs[i] = std::chrono::duration<double, std::milli>(end - begin).count();
+    }
+    plankTunnelled += countTunnelled(scene.plankLaneProjectiles, scene.plank->GetPosition().x);
+    wallTunnelled += countTunnelled(scene.wallLaneProjectiles, kWallX);
+
+    double totalMs = 0;
+    for (auto t : stepTimesMs) {
+      totalMs += t;
+    }
+    size_t p99Idx = static_cast<size_t>(tickCount * .99);
+    p99Idx = std::min(p99Idx, stepTimesMs.size() - 1);
+    std::nth_element(stepTimesMs.begin(), stepTimesMs.begin() + p99Idx, stepTimesMs.end());
+
+    printf("\nphysics_profile: %s\n", profile.name.c_str());
+    printf("step_mean_ms: %.4f\n", totalMs / tickCount);
+    printf("step_p99_ms: %.4f\n", stepTimesMs[p99Idx]);
+    printf("tunnelled_through_plank: %d/%d\n", plankTunnelled, volleyCount * PROJECTILE_COUNT);
+    printf("tunnelled_through_wall: %d/%d\n", wallTunnelled, volleyCount * PROJECTILE_COUNT);
+  }
+  return EXIT_SUCCESS;
+}
+
+}  // namespace physics_benchmark
+
+}  // namespace vigilante
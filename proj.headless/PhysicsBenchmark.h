@@ -0,0 +1,20 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_PHYSICS_BENCHMARK_H_
+#define VIGILANTE_PHYSICS_BENCHMARK_H_
+
+namespace vigilante {
+
+namespace physics_benchmark {
+
+// Steps the same scene with each PhysicsProfile for `tickCount` ticks: a pile
+// of `bodyCount` crates, and volleys of fast projectiles fired at a heavy thin
+// plank (dynamic) and a thin wall (static). The step time and the number of
+// projectiles which tunnelled through the plank and the wall are printed.
+// @return EXIT_SUCCESS or EXIT_FAILURE
+int run(int bodyCount, int tickCount, unsigned int seed);
+
+}  // namespace physics_benchmark
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_PHYSICS_BENCHMARK_H_
@@ -0,0 +1,119 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "QuestBenchmark.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <cocos2d.h>
+#include "../src/quest/KillTargetObjective.h"
+#include "../src/quest/QuestBook.h"
+#include "../src/util/StringUtil.h"
+#include "../src/util/Logger.h"
+
+// Each target is waited for by questCount / TARGET_COUNT quests.
+#define TARGET_COUNT 100
+// Large enough that no quest is ever completed during the benchmark.
+#define TARGET_AMOUNT 1000000000
+
+using std::string;
+using std::vector;
+using std::ofstream;
+using cocos2d::FileUtils;
+
+namespace vigilante {
+
+namespace quest_benchmark {
+
+namespace {
+
+string getTargetName(int i) {
+  return string_util::format("Benchmark Target %d", i % TARGET_COUNT);
+}
+
+bool writeQuests(const string& dir, int questCount, string* questsListFileName) {
+  *questsListFileName = dir + "quests_list.txt";
+  ofstream list(*questsListFileName);
+
+  for (int i = 0; i < questCount; i++) {
+    const string questJsonFileName = string_util::format("%squest_%d.json", dir.c_str(), i);
+    ofstream fout(questJsonFileName);
+    fout << "{\"title\": \"Benchmark Quest " << i << "\", \"desc\": \"\", \"stages\": [{"
+         << "\"objective\": {\"objectiveType\": " << Quest::Objective::Type::KILL << ", "
+         << "\"desc\": \"\", \"characterName\": \"" << getTargetName(i) << "\", "
+         << "\"targetAmount\": " << TARGET_AMOUNT << "}, \"exec\": []}]}";
+    if (!fout) {
+      return false;
+    }
+    list << questJsonFileName << (i + 1 < questCount ? "\n" : "");
+  }
+  return static_cast<bool>(list);
+}
+
+// What QuestBook::update() used to do for each kill.
+int fullScan(const QuestBook& questBook, const string& characterName) {
+  int matches = 0;
+  for (auto quest : questBook.getInProgressQuests()) {
+    auto o = dynamic_cast<KillTargetObjective*>(quest->getCurrentStage().objective.get());
+    if (o && o->getCharacterName() == characterName) {
+      matches++;
+    }
+  }
+  return matches;
+}
+
+}  // namespace
+
+
+int run(int questCount, int eventCount) {
+  const string dir = FileUtils::getInstance()->getWritablePath() + "quest_benchmark/";
+  FileUtils::getInstance()->createDirectory(dir);
+
+  string questsListFileName;
+  if (!writeQuests(dir, questCount, &questsListFileName)) {
+    VGLOG(LOG_ERR, "Failed to write the benchmark quests to %s", dir.c_str());
+    return EXIT_FAILURE;
+  }
+
+  QuestBook questBook(questsListFileName);
+  for (int i = 0; i < questCount; i++) {
+    questBook.startQuest(string_util::format("%squest_%d.json", dir.c_str(), i));
+  }
+
+  vector<string> targetNames;
+  for (int i = 0; i < TARGET_COUNT; i++) {
+    targetNames.push_back(getTargetName(i));
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < eventCount; i++) {
+    questBook.update(Quest::Objective::Type::KILL, targetNames[i % TARGET_COUNT]);
+  }
+  const double indexedUs = std::chrono::duration<double, std::micro>(
+      std::chrono::steady_clock::now() - begin).count() / eventCount;
+
+  int matches = 0;
+  begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < eventCount; i++) {
+    matches += fullScan(questBook, targetNames[i % TARGET_COUNT]);
+  }
+  const double fullScanUs = std::chrono::duration<double, std::micro>(
+      std::chrono::steady_clock::now() - begin).count() / eventCount;
+
+  FileUtils::getInstance()->removeDirectory(dir);
+
+  printf("quests: %d (%d in progress)\n", questCount,
+         static_cast<int>(questBook.getInProgressQuests().size()));
+  printf("targets: %d\n", TARGET_COUNT);
+  printf("events: %d\n", eventCount);
+  printf("indexed_update_us: %.4f\n", indexedUs);
+  printf("full_scan_us: %.4f (%d matches)\n", fullScanUs, matches);
+  return EXIT_SUCCESS;
+}
+
+}  // namespace quest_benchmark
+
+}  // namespace vigilante
@@ -0,0 +1,20 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_QUEST_BENCHMARK_H_
+#define VIGILANTE_QUEST_BENCHMARK_H_
+
+namespace vigilante {
+
+namespace quest_benchmark {
+
+// Starts `questCount` generated quests, each waiting for one of a fixed set
+// of characters to be killed, and then dispatches `eventCount` kill events
+// through QuestBook::update(). The result is printed along with the time
+// a full scan of the in-progress quests (the old QuestBook::update()) takes.
+// @return EXIT_SUCCESS or EXIT_FAILURE
+int run(int questCount, int eventCount);
+
+}  // namespace quest_benchmark
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_QUEST_BENCHMARK_H_
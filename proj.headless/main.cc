@@ -0,0 +1,479 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+//
+// Headless simulation benchmark.
+//
+// Usage: VigilanteHeadless --npc <json> [--map <tmx>] [--count N]
+//                          [--ticks M] [--warmup W] [--seed S]
+//                          [--max-mean-ms X] [--max-p99-ms Y] [--ai parallel|serial]
+//                          [--animator frames|actions] [--animation-churn on|off]
+//                          [--composite on|off] [--physics serial|pipelined]
+//                          [--physics-profile performance|balanced|quality]
+//        VigilanteHeadless --replay <file> [--baseline <file>] [--histogram <file>]
+//        VigilanteHeadless --quests <count> [--events E]
+//        VigilanteHeadless --nav-queries <count> [--map <tmx>] [--seed S]
+//        VigilanteHeadless --startup serial|pipelined [--texture-cache on|off]
+//        VigilanteHeadless --physics-bench <count> [--ticks M] [--seed S]
+//
+// Loads the given .tmx, spawns N npcs, runs M fixed ticks and reports the
+// mean/p99 tick time, the number of heap allocations per tick and (on Linux)
+// the number of hardware cache misses per tick (on the main thread).
+// If a threshold is given and exceeded, the exit status is EXIT_FAILURE,
+// so that CI can catch performance regressions in the simulation.
+// --ai selects how the npcs think (see GameMapManager::setNpcAiParallel()),
+// so that both paths can be compared on the same workload.
+// Likewise, --animator selects how the characters are animated (see
+// GameMapManager::setSpriteAnimatorEnabled()). With --animation-churn on,
+// every npc switches to another animation on every tick, e.g.,
+// `--count 200 --animation-churn on --animator frames|actions`, where
+// allocs_per_tick and tick_mean_ms tell the two paths apart.
+// --composite flattens each npc's body and equipment into one sprite (see
+// CompositeSpriteCache). Nothing is drawn here, so only the cost of syncing
+// the sprites shows up in tick_mean_ms. The warmup ticks should be enough
+// for the composites to be built.
+// --physics pipelined steps the b2World on the physics thread (see
+// GameMapManager::stepWorld()), which in the game overlaps with the rendering.
+// Nothing is rendered here, so the step has nothing to overlap with, and
+// physics_wait_mean_ms is how long each tick still waits for it, i.e., the
+// upper bound of what the rendering can hide. Compare tick_mean_ms with
+// --physics serial on a crowded map (e.g., `--count 300`) to see what
+// the thread handoff and the queued contacts cost.
+// --physics-profile selects how accurately the b2World is stepped (see
+// PhysicsProfile).
+//
+// With --replay, a session recorded with `Vigilante --record <file>` is replayed
+// through the real GameScene instead, and its frame time histogram is compared
+// against the baseline (see input/InputRecorder.h).
+//
+// With --quests, QuestBook's objective event dispatching is benchmarked
+// with the given number of in-progress quests (see QuestBenchmark.h).
+//
+// With --nav-queries, the navigation graph of the given .tmx is baked and
+// the throughput of its path queries is measured (see NavBenchmark.h).
+// Use the largest map, since that's where path queries cost the most.
+//
+// With --startup, only the startup is timed, i.e., until the spritesheets are
+// loaded and the main menu could be shown, either serially (as before) or with
+// the SpritesheetLoader's pipeline. For a cold start, drop the page cache first
+// (e.g., `echo 3 | sudo tee /proc/sys/vm/drop_caches`).
+// --texture-cache selects whether the PNGs are loaded from DecodedImageCache,
+// which is populated by the first run with it on.
+//
+// With --physics-bench, a scene of the given number of crates and fast
+// projectiles is stepped with each PhysicsProfile, and their step times and
+// tunnelling projectiles are compared (see PhysicsBenchmark.h).
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "HeadlessSimulation.h"
+#include "NavBenchmark.h"
+#include "PhysicsBenchmark.h"
+#include "QuestBenchmark.h"
+#include "../src/AssetManager.h"
+#include "../src/CompositeSpriteCache.h"
+#include "../src/DecodedImageCache.h"
+#include "../src/input/InputRecorder.h"
+#include "../src/map/GameMapManager.h"
+#include "../src/map/PhysicsProfile.h"
+#include "../src/util/JobSystem.h"
+#include "../src/util/Logger.h"
+
+#define DEFAULT_NPC_COUNT 50
+#define DEFAULT_TICK_COUNT 3600
+#define DEFAULT_WARMUP_TICK_COUNT 60
+#define DEFAULT_SEED 0
+#define DEFAULT_QUEST_EVENT_COUNT 100000
+
+using std::string;
+using std::vector;
+
+namespace {
+
+std::atomic<size_t> allocCount(0);
+std::atomic<size_t> allocBytes(0);
+
+// Counts the hardware cache misses of the main thread (Linux only),
+// i.e., those of the JobSystem's workers are not included.
+// isAvailable() is false if perf events are unsupported or not permitted
+// (see /proc/sys/kernel/perf_event_paranoid).
+class CacheMissCounter {
+ public:
+  CacheMissCounter() : _fd(-1) {
+#ifdef __linux__
+    perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    _fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+
+  ~CacheMissCounter() {
+#ifdef __linux__
+    if (_fd >= 0) {
+      close(_fd);
+    }
+#endif
+  }
+
+  bool isAvailable() const {
+    return _fd >= 0;
+  }
+
+  void start() {
+#ifdef __linux__
+    if (_fd >= 0) {
+      ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  uint64_t stop() {
+    uint64_t count = 0;
+#ifdef __linux__
+    if (_fd >= 0) {
+      ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(_fd, &count, sizeof(count)) != sizeof(count)) {
+        count = 0;
+      }
+    }
+#endif
+    return count;
+  }
+
+ private:
+  int _fd;
+};
+
+struct Options {
+  string tmxMapFileName = vigilante::asset_manager::kNewGameInitialMap;
+  string npcJsonFileName;
+  int npcCount = DEFAULT_NPC_COUNT;
+  int tickCount = DEFAULT_TICK_COUNT;
+  int warmupTickCount = DEFAULT_WARMUP_TICK_COUNT;
+  unsigned int seed = DEFAULT_SEED;
+  double maxMeanMs = 0;  // 0 means no threshold
+  double maxP99Ms = 0;  // 0 means no threshold
+  string replayFileName;
+  string baselineFileName;
+  string histogramFileName;
+  int questCount = 0;  // 0 means no quest benchmark
+  int questEventCount = DEFAULT_QUEST_EVENT_COUNT;
+  int navQueryCount = 0;  // 0 means no navigation benchmark
+  bool isNpcAiParallel = true;
+  string startupMode;  // empty means no startup benchmark
+  bool isTextureCacheEnabled = true;
+  bool isSpriteAnimatorEnabled = true;
+  bool isAnimationChurnEnabled = false;
+  bool isCompositeEnabled = false;
+  bool isPhysicsPipelined = false;
+  string physicsProfileName = "balanced";
+  int physicsBenchBodyCount = 0;  // 0 means no physics benchmark
+};
+
+Options parseOptions(int argc, char* args[]) {
+  Options options;
+
+  for (int i = 1; i < argc; i++) {
+    const string arg = args[i];
+    if (i + 1 >= argc) {
+      throw std::runtime_error("Missing value for option: " + arg);
+    }
+    const string val = args[++i];
+
+    if (arg == "--map") {
+      options.tmxMapFileName = val;
+    } else if (arg == "--npc") {
+      options.npcJsonFileName = val;
+    } else if (arg == "--count") {
+      options.npcCount = std::stoi(val);
+    } else if (arg == "--ticks") {
+      options.tickCount = std::stoi(val);
+    } else if (arg == "--warmup") {
+      options.warmupTickCount = std::stoi(val);
+    } else if (arg == "--seed") {
+      options.seed = static_cast<unsigned int>(std::stoul(val));
+    } else if (arg == "--max-mean-ms") {
+      options.maxMeanMs = std::stod(val);
+    } else if (arg == "--max-p99-ms") {
+      options.maxP99Ms = std::stod(val);
+    } else if (arg == "--replay") {
+      options.replayFileName = val;
+    } else if (arg == "--baseline") {
+      options.baselineFileName = val;
+    } else if (arg == "--histogram") {
+      options.histogramFileName = val;
+    } else if (arg == "--quests") {
+      options.questCount = std::stoi(val);
+    } else if (arg == "--events") {
+      options.questEventCount = std::stoi(val);
+    } else if (arg == "--nav-queries") {
+      options.navQueryCount = std::stoi(val);
+    } else if (arg == "--ai") {
+      if (val != "parallel" && val != "serial") {
+        throw std::runtime_error("--ai must be either parallel or serial");
+      }
+      options.isNpcAiParallel = val == "parallel";
+    } else if (arg == "--startup") {
+      if (val != "serial" && val != "pipelined") {
+        throw std::runtime_error("--startup must be either serial or pipelined");
+      }
+      options.startupMode = val;
+    } else if (arg == "--texture-cache") {
+      if (val != "on" && val != "off") {
+        throw std::runtime_error("--texture-cache must be either on or off");
+      }
+      options.isTextureCacheEnabled = val == "on";
+    } else if (arg == "--animator") {
+      if (val != "frames" && val != "actions") {
+        throw std::runtime_error("--animator must be either frames or actions");
+      }
+      options.isSpriteAnimatorEnabled = val == "frames";
+    } else if (arg == "--animation-churn") {
+      if (val != "on" && val != "off") {
+        throw std::runtime_error("--animation-churn must be either on or off");
+      }
+      options.isAnimationChurnEnabled = val == "on";
+    } else if (arg == "--composite") {
+      if (val != "on" && val != "off") {
+        throw std::runtime_error("--composite must be either on or off");
+      }
+      options.isCompositeEnabled = val == "on";
+    } else if (arg == "--physics") {
+      if (val != "serial" && val != "pipelined") {
+        throw std::runtime_error("--physics must be either serial or pipelined");
+      }
+      options.isPhysicsPipelined = val == "pipelined";
+    } else if (arg == "--physics-profile") {
+      if (!vigilante::physics_profiles::find(val)) {
+        throw std::runtime_error("--physics-profile must be performance, balanced or quality");
+      }
+      options.physicsProfileName = val;
+    } else if (arg == "--physics-bench") {
+      options.physicsBenchBodyCount = std::stoi(val);
+    } else {
+      throw std::runtime_error("Unknown option: " + arg);
+    }
+  }
+
+  if (options.npcJsonFileName.empty() && options.replayFileName.empty() &&
+      options.questCount <= 0 && options.navQueryCount <= 0 && options.startupMode.empty() &&
+      options.physicsBenchBodyCount <= 0) {
+    throw std::runtime_error("--npc is required");
+  }
+  if (options.tickCount <= 0) {
+    throw std::runtime_error("--ticks must be positive");
+  }
+  if (options.questEventCount <= 0) {
+    throw std::runtime_error("--events must be positive");
+  }
+  return options;
+}
+
+int replay(const Options& options) {
+  vigilante::InputRecorder* recorder = vigilante::InputRecorder::getInstance();
+  if (!recorder->startReplaying(options.replayFileName)) {
+    return EXIT_FAILURE;
+  }
+  recorder->setBaselineFileName(options.baselineFileName);
+  recorder->setHistogramFileName(options.histogramFileName);
+
+  vigilante::HeadlessSimulation sim;
+  if (!sim.initWithGameScene()) {
+    return EXIT_FAILURE;
+  }
+
+  while (!recorder->isReplayFinished()) {
+    sim.tick();
+  }
+  return (recorder->hasPassedBaseline()) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int startup(const Options& options) {
+  auto begin = std::chrono::steady_clock::now();
+
+  vigilante::DecodedImageCache* decodedImageCache = vigilante::DecodedImageCache::getInstance();
+  decodedImageCache->setEnabled(options.isTextureCacheEnabled);
+
+  vigilante::HeadlessSimulation sim;
+  sim.setSpritesheetLoadingSerial(options.startupMode == "serial");
+  if (!sim.init(options.seed)) {
+    return EXIT_FAILURE;
+  }
+  // Same as LoadingScene.
+  for (const auto& fileName : vigilante::asset_manager::kPreloadedImages) {
+    decodedImageCache->addImage(fileName);
+  }
+
+  const double timeToMainMenuMs = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - begin).count();
+  printf("spritesheet_loading: %s\n", options.startupMode.c_str());
+  printf("texture_cache: %s\n", (decodedImageCache->isEnabled()) ? "on" : "off");
+  printf("images_decoded: %zu\n", decodedImageCache->getMissCount());
+  printf("images_from_cache: %zu\n", decodedImageCache->getHitCount());
+  printf("time_to_main_menu_ms: %.1f\n", timeToMainMenuMs);
+  return EXIT_SUCCESS;
+}
+
+int run(const Options& options) {
+  if (!options.replayFileName.empty()) {
+    return replay(options);
+  }
+
+  if (!options.startupMode.empty()) {
+    return startup(options);
+  }
+
+  if (options.physicsBenchBodyCount > 0) {
+    return vigilante::physics_benchmark::run(options.physicsBenchBodyCount, options.tickCount, options.seed);
+  }
+
+  vigilante::HeadlessSimulation sim;
+  if (!sim.init(options.seed)) {
+    return EXIT_FAILURE;
+  }
+
+  if (options.questCount > 0) {
+    return vigilante::quest_benchmark::run(options.questCount, options.questEventCount);
+  }
+
+  if (options.navQueryCount > 0) {
+    return vigilante::nav_benchmark::run(options.tmxMapFileName, options.navQueryCount, options.seed);
+  }
+
+  vigilante::GameMapManager::getInstance()->setNpcAiParallel(options.isNpcAiParallel);
+  vigilante::GameMapManager::getInstance()->setSpriteAnimatorEnabled(options.isSpriteAnimatorEnabled);
+  vigilante::GameMapManager::getInstance()->setCompositeEnabled(options.isCompositeEnabled);
+  vigilante::GameMapManager::getInstance()->setPhysicsPipelined(options.isPhysicsPipelined);
+  vigilante::GameMapManager::getInstance()->setPhysicsProfile(options.physicsProfileName);
+  sim.loadGameMap(options.tmxMapFileName);
+  int spawned = sim.spawnNpcs(options.npcJsonFileName, options.npcCount);
+
+  for (int i = 0; i < options.warmupTickCount; i++) {
+    if (options.isAnimationChurnEnabled) {
+      sim.churnAnimations();
+    }
+    sim.tick();
+  }
+
+  vector<double> tickTimesMs(options.tickCount);
+  double physicsWaitTotalMs = 0;
+  size_t allocCountBegin = allocCount;
+  size_t allocBytesBegin = allocBytes;
+  CacheMissCounter cacheMissCounter;
+  cacheMissCounter.start();
+
+  for (int i = 0; i < options.tickCount; i++) {
+    if (options.isAnimationChurnEnabled) {
+      sim.churnAnimations();
+    }
+    auto begin = std::chrono::steady_clock::now();
+    sim.tick();
+    auto end = std::chrono::steady_clock::now();
+    tickTimesMs[i] = std::chrono::duration<double, std::milli>(end - begin).count();
+    physicsWaitTotalMs += vigilante::GameMapManager::getInstance()->getLastWorldStepWaitMs();
+  }
+
+  const uint64_t cacheMisses = cacheMissCounter.stop();
+
+  double totalMs = 0;
+  for (auto t : tickTimesMs) {
+    totalMs += t;
+  }
+  double meanMs = totalMs / options.tickCount;
+
+  size_t p99Idx = static_cast<size_t>(options.tickCount * .99);
+  p99Idx = std::min(p99Idx, tickTimesMs.size() - 1);
+  std::nth_element(tickTimesMs.begin(), tickTimesMs.begin() + p99Idx, tickTimesMs.end());
+  double p99Ms = tickTimesMs[p99Idx];
+
+  double allocsPerTick = double(allocCount - allocCountBegin) / options.tickCount;
+  double bytesPerTick = double(allocBytes - allocBytesBegin) / options.tickCount;
+
+  printf("map: %s\n", options.tmxMapFileName.c_str());
+  printf("npcs: %d (%d requested)\n", spawned, options.npcCount);
+  printf("ticks: %d (+%d warmup)\n", options.tickCount, options.warmupTickCount);
+  printf("seed: %u\n", options.seed);
+  printf("npc_ai: %s (%zu job workers)\n", (options.isNpcAiParallel) ? "parallel" : "serial",
+         vigilante::JobSystem::getInstance()->getWorkerCount());
+  printf("animator: %s\n", (options.isSpriteAnimatorEnabled) ? "frames" : "actions");
+  printf("animation_churn: %s\n", (options.isAnimationChurnEnabled) ? "on" : "off");
+  printf("composite: %s (%zu composites, %.1f MB)\n", (options.isCompositeEnabled) ? "on" : "off",
+         vigilante::CompositeSpriteCache::getInstance()->getCompositeCount(),
+         vigilante::CompositeSpriteCache::getInstance()->getResidentSize() / (1024.0 * 1024.0));
+  printf("physics: %s\n", (options.isPhysicsPipelined) ? "pipelined" : "serial");
+  printf("physics_profile: %s\n", options.physicsProfileName.c_str());
+  if (options.isPhysicsPipelined) {
+    printf("physics_wait_mean_ms: %.4f\n", physicsWaitTotalMs / options.tickCount);
+  }
+  printf("tick_mean_ms: %.4f\n", meanMs);
+  printf("tick_p99_ms: %.4f\n", p99Ms);
+  printf("allocs_per_tick: %.2f\n", allocsPerTick);
+  printf("alloc_bytes_per_tick: %.2f\n", bytesPerTick);
+  if (cacheMissCounter.isAvailable()) {
+    printf("cache_misses_per_tick: %.1f\n", double(cacheMisses) / options.tickCount);
+  } else {
+    printf("cache_misses_per_tick: n/a\n");
+  }
+
+  if ((options.maxMeanMs > 0 && meanMs > options.maxMeanMs) ||
+      (options.maxP99Ms > 0 && p99Ms > options.maxP99Ms)) {
+    fprintf(stderr, "Tick time threshold exceeded.\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+}  // namespace
+
+
+// Count every heap allocation made by the process.
+void* operator new(size_t size) {
+  allocCount++;
+  allocBytes += size;
+  if (void* p = malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+
+int main(int argc, char* args[]) {
+  // Install SIGSEGV handler. See util/Logger.cc
+  signal(SIGSEGV, &vigilante::logger::segvHandler);
+
+  try {
+    return run(parseOptions(argc, args));
+  } catch (const std::exception& ex) {
+    std::cerr << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+}
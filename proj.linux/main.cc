@@ -1,11 +1,98 @@
 // Copyright (c) 2019 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+//
+// Usage: Vigilante [--record <file>]
+//                  [--replay <file> [--baseline <file>] [--histogram <file>]]
+//
+// --record: records the key events (and the rand_util seed) of this session.
+// --replay: replays a recorded session as fast as possible, then writes
+//           the frame time histogram and compares it against the baseline.
+//           The main menu is skipped, and the game is started (or loaded)
+//           the same way as in the recorded session.
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <stdexcept>
+#include <thread>
 
 #include "../src/AppDelegate.h"
+#include "../src/Constants.h"
+#include "../src/input/InputRecorder.h"
 #include "../src/util/Logger.h"
 
+using std::string;
+using vigilante::InputRecorder;
+
+namespace {
+
+void parseOptions(int argc, char* args[]) {
+  InputRecorder* recorder = InputRecorder::getInstance();
+
+  for (int i = 1; i < argc; i++) {
+    const string arg = args[i];
+    if (i + 1 >= argc) {
+      throw std::runtime_error("Missing value for option: " + arg);
+    }
+    const string val = args[++i];
+
+    if (arg == "--record") {
+      recorder->startRecording(val);
+    } else if (arg == "--replay") {
+      if (!recorder->startReplaying(val)) {
+        throw std::runtime_error("Unable to load input recording: " + val);
+      }
+    } else if (arg == "--baseline") {
+      recorder->setBaselineFileName(val);
+    } else if (arg == "--histogram") {
+      recorder->setHistogramFileName(val);
+    } else {
+      throw std::runtime_error("Unknown option: " + arg);
+    }
+  }
+}
+
+// Same as cocos2d::Application::run() on linux, except that every frame
+// advances the game by exactly 1 / kFps, no matter how long it actually takes.
+// While recording, frames are paced to kFps. While replaying, they are not.
+int runOnFixedTicks(AppDelegate& app) {
+  app.initGLContextAttrs();
+  if (!app.applicationDidFinishLaunching()) {
+    return EXIT_FAILURE;
+  }
+
+  cocos2d::Director* director = cocos2d::Director::getInstance();
+  cocos2d::GLView* glview = director->getOpenGLView();
+  glview->retain();
+
+  InputRecorder* recorder = InputRecorder::getInstance();
+  const auto tickDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<float>(1 / vigilante::kFps));
+  auto nextTickTime = std::chrono::steady_clock::now();
+
+  while (!glview->windowShouldClose() && !recorder->isReplayFinished()) {
+    director->mainLoop(1 / vigilante::kFps);
+    glview->pollEvents();
+
+    if (recorder->isRecording()) {
+      nextTickTime += tickDuration;
+      std::this_thread::sleep_until(nextTickTime);
+    }
+  }
+
+  if (glview->isOpenGLReady()) {
+    director->end();
+    director->mainLoop();
+  }
+  glview->release();
+
+  if (recorder->isRecording()) {
+    recorder->stopRecording();
+  }
+  return (recorder->hasPassedBaseline()) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+}  // namespace
+
+
 int main(int argc, char* args[]) {
   // Install SIGSEGV handler. See util/Logger.cc
   signal(SIGSEGV, &vigilante::logger::segvHandler);
@@ -14,6 +101,11 @@ int main(int argc, char* args[]) {
   AppDelegate app;
 
   try {
+    parseOptions(argc, args);
+
+    if (InputRecorder::getInstance()->isActive()) {
+      return runOnFixedTicks(app);
+    }
     return cocos2d::Application::getInstance()->run();
   } catch (const std::exception& ex) {
     std::cerr << ex.what() << std::endl;
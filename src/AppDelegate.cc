@@ -3,10 +3,10 @@
 
 #include <string>
 
-#include "AssetManager.h"
 #include "Constants.h"
+#include "gameplay/GameState.h"
 #include "scene/SceneManager.h"
-#include "scene/MainMenuScene.h"
+#include "scene/LoadingScene.h"
 
 //#define USE_AUDIO_ENGINE 1
 #define USE_SIMPLE_AUDIO_ENGINE 1
@@ -35,6 +35,9 @@ static cocos2d::Size mediumResolutionSize = cocos2d::Size(1024, 768);
 static cocos2d::Size largeResolutionSize = cocos2d::Size(2048, 1536);
 
 AppDelegate::~AppDelegate() {
+  // The saves are written by detached threads, which must finish before exit.
+  vigilante::GameState::waitForPendingWrites();
+
 #if USE_AUDIO_ENGINE
   AudioEngine::end();
 #elif USE_SIMPLE_AUDIO_ENGINE
@@ -75,11 +78,9 @@ bool AppDelegate::applicationDidFinishLaunching() {
   // set FPS. the default value is 1.0/60 if you don't call this
   director->setAnimationInterval(1.0f / 60);
 
-  // Load resources
-  vigilante::asset_manager::loadSpritesheets(vigilante::asset_manager::kSpritesheetsList);
-
-  // Create a scene (auto-release object).
-  vigilante::SceneManager::getInstance()->runWithScene(vigilante::MainMenuScene::create());
+  // Create a scene (auto-release object). It loads the resources
+  // and then proceeds to the main menu.
+  vigilante::SceneManager::getInstance()->runWithScene(vigilante::LoadingScene::create());
 
   return true;
 }
@@ -7,38 +7,106 @@ extern "C" {
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <sstream>
 #include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <cocos2d.h>
+#include "SpritesheetLoader.h"
+#include "TextureResidencyManager.h"
 #include "util/Logger.h"
 
 using std::string;
+using std::vector;
 using std::ifstream;
+using std::istringstream;
 using std::runtime_error;
+using std::unordered_map;
+using std::unordered_set;
 using cocos2d::SpriteFrameCache;
 
 namespace vigilante {
 
 namespace asset_manager {
 
+namespace {
+
+// textureResDir -> the plist of its atlas.
+unordered_map<string, string> atlasPlists;
+
+}  // namespace
+
 void loadSpritesheets(const string& spritesheetsListFileName) {
+  VGLOG(LOG_INFO, "Loading textures...");
+  SpritesheetLoader(spritesheetsListFileName).finish();
+  TextureResidencyManager::getInstance()->evictUnreferenced();
+}
+
+void loadSpritesheetsSerially(const string& spritesheetsListFileName) {
   char buf[256] = {0};
   getcwd(buf, 256);
   std::cout << buf << std::endl;
 
+  VGLOG(LOG_INFO, "Loading textures...");
+  SpriteFrameCache* frameCache = SpriteFrameCache::getInstance();
+  for (const auto& plistFileName : readSpritesheetsList(spritesheetsListFileName)) {
+    frameCache->addSpriteFramesWithFile(plistFileName);
+    TextureResidencyManager::getInstance()->onSpritesheetLoaded(plistFileName);
+  }
+}
+
+vector<string> readSpritesheetsList(const string& spritesheetsListFileName) {
   ifstream fin(spritesheetsListFileName);
   if (!fin.is_open()) {
     throw runtime_error("Failed to load spritesheets from " + spritesheetsListFileName);
   }
 
-  VGLOG(LOG_INFO, "Loading textures...");
-  SpriteFrameCache* frameCache = SpriteFrameCache::getInstance();
+  vector<string> plistFileNames;
+  unordered_set<string> listed;
   string line;
   while (std::getline(fin, line)) {
-    if (!line.empty()) {
-      frameCache->addSpriteFramesWithFile(line);
+    if (line.empty()) {
+      continue;
+    }
+    const string plistFileName = getSpritesheetPlist(line.substr(0, line.find_last_of('/')));
+    if (listed.insert(plistFileName).second) {
+      plistFileNames.push_back(plistFileName);
     }
   }
+  return plistFileNames;
+}
+
+
+void loadAtlasManifest(const string& manifestFileName) {
+  atlasPlists.clear();
+
+  ifstream fin(manifestFileName);
+  if (!fin.is_open()) {
+    return;
+  }
+
+  string line;
+  while (std::getline(fin, line)) {
+    istringstream iss(line);
+    string textureResDir;
+    string plistFileName;
+    if (iss >> textureResDir >> plistFileName) {
+      atlasPlists[textureResDir] = plistFileName;
+    }
+  }
+  VGLOG(LOG_INFO, "Using atlases for %zu spritesheets", atlasPlists.size());
+}
+
+string getSpritesheetPlist(const string& textureResDir) {
+  auto it = atlasPlists.find(textureResDir);
+  return (it != atlasPlists.end()) ? it->second : textureResDir + "/spritesheet.plist";
+}
+
+string getSpritesheetTexture(const string& textureResDir) {
+  const string plistFileName = getSpritesheetPlist(textureResDir);
+  return plistFileName.substr(0, plistFileName.rfind('.')) + ".png";
 }
 
 }  // namespace asset_manager
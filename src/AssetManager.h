@@ -3,6 +3,7 @@
 #define VIGILANTE_ASSET_MANAGER_H_
 
 #include <string>
+#include <vector>
 
 namespace vigilante {
 
@@ -12,12 +13,14 @@ namespace asset_manager {
 const std::string kExpPointTable = "Resources/Gameplay/exp_point_table.txt";
 const std::string kItemPriceTable = "Resources/Gameplay/item_price_table.txt";
 const std::string kSpritesheetsList = "Resources/Texture/spritesheets.txt";
+const std::string kAtlasManifest = "Resources/Texture/atlas/manifest.txt";
 const std::string kQuestsList = "Resources/Gameplay/quests_list.txt";
 const std::string kPlayerJson = "Resources/Database/character/vlad.json";
 #else
 const std::string kExpPointTable = "Gameplay/exp_point_table.txt";
 const std::string kItemPriceTable = "Gameplay/item_price_table.txt";
 const std::string kSpritesheetsList = "Texture/spritesheets.txt";
+const std::string kAtlasManifest = "Texture/atlas/manifest.txt";
 const std::string kQuestsList = "Gameplay/quests_list.txt";
 const std::string kPlayerJson = "Database/character/vlad.json";
 #endif
@@ -97,6 +100,21 @@ const std::string kTradeBg = kTrade + "trade_bg.png";
 // Control Hints
 const std::string kControlHints = "Texture/ui/control_hints/";
 
+// The images shown by the ui, which LoadingScene loads in advance
+// (see DecodedImageCache).
+const std::vector<std::string> kPreloadedImages = {
+  kMainMenuBg, kShade,
+  kBarLeftPadding, kBarRightPadding, kHealthBar, kMagickaBar, kStaminaBar,
+  kEquippedWeaponBg, kEquippedWeaponDescBg,
+  kDialogueMenuBg, kDialogueTriangle,
+  kPauseMenuBg, kStatsBg, kInventoryBg, kTabRegular, kTabHighlighted,
+  kItemRegular, kItemHighlighted, kScrollBar, kEquipmentRegular, kEquipmentHighlighted,
+  kEmptyImage,
+  kWindowContentBg, kWindowTopLeftBg, kWindowTopRightBg, kWindowBottomLeftBg,
+  kWindowBottomRightBg, kWindowTopBg, kWindowLeftBg, kWindowRightBg, kWindowBottomBg,
+  kTextFieldBg, kTradeBg,
+};
+
 // Important items
 const std::string kGoldCoin = "Database/item/misc/gold_coin.json";
 
@@ -105,7 +123,25 @@ const std::string kBgm = "Music/";
 const std::string kMainThemeBgm = kBgm + "main_theme.mp3";
 
 // Spritesheets
+// Loads the spritesheets with a SpritesheetLoader, and blocks until it's done.
+// Use a SpritesheetLoader directly to keep rendering meanwhile (see LoadingScene).
 void loadSpritesheets(const std::string& spritesheetsListFileName);
+// Loads the spritesheets one after another on the calling thread.
+void loadSpritesheetsSerially(const std::string& spritesheetsListFileName);
+
+// The plists listed in `spritesheetsListFileName`, with those packed into
+// atlases replaced by their atlases (each atlas is listed only once).
+// @throw std::runtime_error if the list cannot be opened
+std::vector<std::string> readSpritesheetsList(const std::string& spritesheetsListFileName);
+
+// Atlases
+// Maps the textureResDirs packed by proj.atlas_packer to their atlases.
+// If there's no manifest, every textureResDir keeps using its own spritesheet.
+void loadAtlasManifest(const std::string& manifestFileName);
+// The spritesheet which contains the frames of `textureResDir`,
+// e.g., Texture/character/vlad/spritesheet.plist or Texture/atlas/atlas_0.plist.
+std::string getSpritesheetPlist(const std::string& textureResDir);
+std::string getSpritesheetTexture(const std::string& textureResDir);
 
 }  // namespace asset_manager
 
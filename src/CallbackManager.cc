@@ -3,6 +3,8 @@
 
 #include <atomic>
 
+#include "util/Profiler.h"
+
 using std::atomic;
 using std::function;
 using cocos2d::Scene;
@@ -26,6 +28,7 @@ void CallbackManager::runAfter(const function<void ()>& userCallback, float dela
   // If the specified delay is 0 second, then we can
   // simply invoke `userCallback` and return early.
   if (delay == 0) {
+    VGPROFILE_SCOPE("CallbackManager::callback");
     userCallback();
     return;
   }
@@ -33,7 +36,10 @@ void CallbackManager::runAfter(const function<void ()>& userCallback, float dela
   _scene->runAction(Sequence::create(
       CallFunc::create([=]() { ++(this->_pendingCount); }),
       DelayTime::create(delay),
-      CallFunc::create(userCallback),
+      CallFunc::create([userCallback]() {
+        VGPROFILE_SCOPE("CallbackManager::callback");
+        userCallback();
+      }),
       CallFunc::create([=]() { --(this->_pendingCount); }),
       nullptr
     )
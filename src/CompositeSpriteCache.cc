@@ -0,0 +1,470 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "CompositeSpriteCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <new>
+
+#include "AssetManager.h"
+#include "DecodedImageCache.h"
+#include "util/Logger.h"
+
+#define DEFAULT_BUDGET_MB 32
+#define BYTES_PER_MB (1024 * 1024)
+#define CELL_PADDING 1
+
+using std::map;
+using std::mutex;
+using std::lock_guard;
+using std::string;
+using std::thread;
+using std::unique_lock;
+using std::unique_ptr;
+using std::vector;
+using cocos2d::Animation;
+using cocos2d::AnimationFrame;
+using cocos2d::Configuration;
+using cocos2d::FileUtils;
+using cocos2d::Image;
+using cocos2d::Rect;
+using cocos2d::SpriteFrame;
+using cocos2d::Texture2D;
+using cocos2d::ValueMap;
+
+namespace vigilante {
+
+namespace {
+
+// @return the index of the frame shown `elapsed` seconds into `animation`,
+//         without looping (same as cocos2d::Animate).
+size_t getFrameIdx(const Animation* animation, float elapsed) {
+  const auto& frames = animation->getFrames();
+  float frameEnd = 0;
+  for (size_t i = 0; i < frames.size(); i++) {
+    frameEnd += frames.at(i)->getDelayUnits() * animation->getDelayPerUnit();
+    if (elapsed < frameEnd) {
+      return i;
+    }
+  }
+  return frames.size() - 1;
+}
+
+// x * y / 255, rounded.
+inline unsigned int mul255(unsigned int x, unsigned int y) {
+  const unsigned int t = x * y + 128;
+  return (t + (t >> 8)) >> 8;
+}
+
+}  // namespace
+
+
+CompositeSpriteCache* CompositeSpriteCache::getInstance() {
+  static CompositeSpriteCache instance;
+  return &instance;
+}
+
+CompositeSpriteCache::CompositeSpriteCache()
+    : _isEnabled(),
+      _residentSize(),
+      _budget(static_cast<size_t>(DEFAULT_BUDGET_MB) * BYTES_PER_MB),
+      _composites(),
+      _lru(),
+      _buildingKeys(),
+      _failedKeys(),
+      _worker(),
+      _mutex(),
+      _hasJobsCv(),
+      _pending(),
+      _built(),
+      _isShuttingDown() {}
+
+CompositeSpriteCache::~CompositeSpriteCache() {
+  {
+    lock_guard<mutex> lock(_mutex);
+    _isShuttingDown = true;
+  }
+  _hasJobsCv.notify_all();
+  if (_worker.joinable()) {
+    _worker.join();
+  }
+
+  for (auto& job : _built) {
+    CC_SAFE_RELEASE(job->image);
+  }
+}
+
+
+void CompositeSpriteCache::request(const string& key,
+                                   const vector<vector<CompositeSpriteCache::Layer>>& animations) {
+  if (_composites.count(key) || _buildingKeys.count(key) || _failedKeys.count(key)) {
+    return;
+  }
+
+  FileUtils* fileUtils = FileUtils::getInstance();
+  unique_ptr<CompositeSpriteCache::Job> job(new CompositeSpriteCache::Job());
+  job->key = key;
+  job->cellWidth = 0;
+  job->cellHeight = 0;
+  job->image = nullptr;
+
+  // The source frames, deduplicated, since most states fall back to the same animations.
+  map<string, size_t> imageIndices;
+  map<SpriteFrame*, size_t> frameIndices;
+  map<vector<size_t>, size_t> cellIndices;
+
+  for (const auto& layers : animations) {
+    CompositeSpriteCache::CellAnimation compositeAnimation;
+    compositeAnimation.delayPerUnit = 0;
+    if (layers.empty() || !layers.front().animation) {
+      job->animations.push_back(std::move(compositeAnimation));
+      continue;
+    }
+
+    const Animation* bottom = layers.front().animation;
+    compositeAnimation.delayPerUnit = bottom->getDelayPerUnit();
+    float frameBegin = 0;
+
+    for (const auto* bottomFrame : bottom->getFrames()) {
+      vector<size_t> cell;
+      for (const auto& layer : layers) {
+        if (!layer.animation || layer.animation->getFrames().empty()) {
+          continue;
+        }
+
+        // The layers may have fewer or more frames than the bottom one,
+        // so each shows whichever frame it would have shown at that time.
+        SpriteFrame* spriteFrame = layer.animation->getFrames().at(
+            getFrameIdx(layer.animation, frameBegin))->getSpriteFrame();
+
+        auto frameIt = frameIndices.find(spriteFrame);
+        if (frameIt == frameIndices.end()) {
+          const string imageFullPath = fileUtils->fullPathForFilename(
+              asset_manager::getSpritesheetTexture(layer.textureResDir));
+          auto imageIt = imageIndices.insert({imageFullPath, imageIndices.size()}).first;
+          if (imageIt->second == job->imageFullPaths.size()) {
+            job->imageFullPaths.push_back(imageFullPath);
+          }
+
+          CompositeSpriteCache::Frame frame;
+          frame.imageIdx = imageIt->second;
+          frame.rect = spriteFrame->getRectInPixels();
+          frame.isRotated = spriteFrame->isRotated();
+          frame.offset = spriteFrame->getOffsetInPixels();
+          frame.originalSize = spriteFrame->getOriginalSizeInPixels();
+          job->cellWidth = std::max(job->cellWidth, static_cast<int>(std::ceil(frame.originalSize.width)));
+          job->cellHeight = std::max(job->cellHeight, static_cast<int>(std::ceil(frame.originalSize.height)));
+
+          frameIt = frameIndices.insert({spriteFrame, job->frames.size()}).first;
+          job->frames.push_back(frame);
+        }
+        cell.push_back(frameIt->second);
+      }
+
+      auto cellIt = cellIndices.find(cell);
+      if (cellIt == cellIndices.end()) {
+        cellIt = cellIndices.insert({cell, job->cells.size()}).first;
+        job->cells.push_back(std::move(cell));
+      }
+      compositeAnimation.frames.push_back({cellIt->second, bottomFrame->getDelayUnits()});
+      frameBegin += bottomFrame->getDelayUnits() * bottom->getDelayPerUnit();
+    }
+    job->animations.push_back(std::move(compositeAnimation));
+  }
+
+  // Lay the cells out in as square a grid as the maximum texture size allows.
+  const int maxTextureSize = Configuration::getInstance()->getMaxTextureSize();
+  const int cellCount = static_cast<int>(job->cells.size());
+  const int paddedCellWidth = job->cellWidth + CELL_PADDING;
+  const int paddedCellHeight = job->cellHeight + CELL_PADDING;
+  job->columnCount = std::min(static_cast<int>(std::ceil(std::sqrt(cellCount))),
+                              (paddedCellWidth > 0) ? maxTextureSize / paddedCellWidth : 0);
+  job->rowCount = (job->columnCount > 0) ? (cellCount + job->columnCount - 1) / job->columnCount : 0;
+
+  if (cellCount == 0 || job->columnCount <= 0 || job->rowCount * paddedCellHeight > maxTextureSize) {
+    VGLOG(LOG_ERR, "Cannot composite %s into a %dx%d texture", key.c_str(), maxTextureSize, maxTextureSize);
+    _failedKeys.insert(key);
+    return;
+  }
+
+  // Constructed on the main thread, in case nobody has used it yet.
+  DecodedImageCache::getInstance();
+
+  _buildingKeys.insert(key);
+  {
+    lock_guard<mutex> lock(_mutex);
+    _pending.push_back(std::move(job));
+  }
+  if (!_worker.joinable()) {
+    _worker = thread(&CompositeSpriteCache::runWorker, this);
+  }
+  _hasJobsCv.notify_one();
+}
+
+CompositeSpriteCache::Composite* CompositeSpriteCache::acquire(const string& key) {
+  auto it = _composites.find(key);
+  if (it == _composites.end()) {
+    return nullptr;
+  }
+
+  CompositeSpriteCache::Composite& composite = it->second;
+  composite.refCount++;
+  _lru.splice(_lru.begin(), _lru, composite.lruIt);
+  return &composite;
+}
+
+void CompositeSpriteCache::release(CompositeSpriteCache::Composite* composite) {
+  if (--composite->refCount == 0) {
+    evictUnreferenced();
+  }
+}
+
+bool CompositeSpriteCache::isBuilding(const string& key) const {
+  return _buildingKeys.count(key) > 0;
+}
+
+void CompositeSpriteCache::update() {
+  if (_buildingKeys.empty()) {
+    return;
+  }
+
+  while (true) {
+    unique_ptr<CompositeSpriteCache::Job> job;
+    {
+      lock_guard<mutex> lock(_mutex);
+      if (_built.empty()) {
+        return;
+      }
+      job = std::move(_built.front());
+      _built.pop_front();
+    }
+    upload(job.get());
+  }
+}
+
+bool CompositeSpriteCache::isEnabled() const {
+  return _isEnabled;
+}
+
+void CompositeSpriteCache::setEnabled(bool enabled) {
+  _isEnabled = enabled;
+}
+
+size_t CompositeSpriteCache::getBudget() const {
+  return _budget;
+}
+
+void CompositeSpriteCache::setBudget(size_t budget) {
+  _budget = budget;
+  evictUnreferenced();
+}
+
+size_t CompositeSpriteCache::getResidentSize() const {
+  return _residentSize;
+}
+
+size_t CompositeSpriteCache::getCompositeCount() const {
+  return _composites.size();
+}
+
+
+void CompositeSpriteCache::runWorker() {
+  while (true) {
+    unique_ptr<CompositeSpriteCache::Job> job;
+    {
+      unique_lock<mutex> lock(_mutex);
+      _hasJobsCv.wait(lock, [this]() { return _isShuttingDown || !_pending.empty(); });
+      if (_isShuttingDown) {
+        return;
+      }
+      job = std::move(_pending.front());
+      _pending.pop_front();
+    }
+
+    build(job.get());
+
+    lock_guard<mutex> lock(_mutex);
+    _built.push_back(std::move(job));
+  }
+}
+
+void CompositeSpriteCache::build(CompositeSpriteCache::Job* job) const {
+  vector<Image*> images(job->imageFullPaths.size());
+  for (size_t i = 0; i < images.size(); i++) {
+    images[i] = DecodedImageCache::getInstance()->loadImage(job->imageFullPaths[i]);
+    if (!images[i] || images[i]->getRenderFormat() != Texture2D::PixelFormat::RGBA8888) {
+      job->error = "Failed to load " + job->imageFullPaths[i] + " as RGBA8888";
+      break;
+    }
+  }
+
+  const int width = job->columnCount * (job->cellWidth + CELL_PADDING);
+  const int height = job->rowCount * (job->cellHeight + CELL_PADDING);
+  vector<unsigned char> pixels;
+  if (job->error.empty()) {
+    pixels.resize(static_cast<size_t>(width) * height * 4);
+  }
+
+  for (size_t cellIdx = 0; job->error.empty() && cellIdx < job->cells.size(); cellIdx++) {
+    const int cellX = static_cast<int>(cellIdx % job->columnCount) * (job->cellWidth + CELL_PADDING);
+    const int cellY = static_cast<int>(cellIdx / job->columnCount) * (job->cellHeight + CELL_PADDING);
+
+    for (size_t frameIdx : job->cells[cellIdx]) {
+      const CompositeSpriteCache::Frame& frame = job->frames[frameIdx];
+      Image* image = images[frame.imageIdx];
+      const unsigned char* src = image->getData();
+      const int srcWidth = image->getWidth();
+      const int srcHeight = image->getHeight();
+      const bool isPremultiplied = image->hasPremultipliedAlpha();
+
+      // Where the sprite would have drawn its trimmed frame (see Sprite::setTextureRect()),
+      // with the untrimmed frame centered in the cell. y points down here.
+      const int w = static_cast<int>(frame.rect.size.width);
+      const int h = static_cast<int>(frame.rect.size.height);
+      const int dstX = cellX + static_cast<int>(std::lround(
+          (job->cellWidth - w) / 2.0f + frame.offset.x));
+      const int dstY = cellY + static_cast<int>(std::lround(
+          (job->cellHeight - h) / 2.0f - frame.offset.y));
+      const int rectX = static_cast<int>(frame.rect.origin.x);
+      const int rectY = static_cast<int>(frame.rect.origin.y);
+
+      for (int y = 0; y < h; y++) {
+        const int py = dstY + y;
+        if (py < cellY || py >= cellY + job->cellHeight) {
+          continue;
+        }
+        for (int x = 0; x < w; x++) {
+          const int px = dstX + x;
+          if (px < cellX || px >= cellX + job->cellWidth) {
+            continue;
+          }
+
+          // A rotated frame is stored rotated 90 degrees clockwise (see Sprite::setTextureCoords()).
+          const int sx = (frame.isRotated) ? rectX + (h - 1 - y) : rectX + x;
+          const int sy = (frame.isRotated) ? rectY + x : rectY + y;
+          if (sx < 0 || sx >= srcWidth || sy < 0 || sy >= srcHeight) {
+            continue;
+          }
+
+          const unsigned char* s = src + (static_cast<size_t>(sy) * srcWidth + sx) * 4;
+          const unsigned int a = s[3];
+          if (a == 0) {
+            continue;
+          }
+          unsigned int r = s[0];
+          unsigned int g = s[1];
+          unsigned int b = s[2];
+          if (!isPremultiplied) {
+            r = mul255(r, a);
+            g = mul255(g, a);
+            b = mul255(b, a);
+          }
+
+          // Premultiplied source-over.
+          unsigned char* d = pixels.data() + (static_cast<size_t>(py) * width + px) * 4;
+          const unsigned int inv = 255 - a;
+          d[0] = static_cast<unsigned char>(r + mul255(d[0], inv));
+          d[1] = static_cast<unsigned char>(g + mul255(d[1], inv));
+          d[2] = static_cast<unsigned char>(b + mul255(d[2], inv));
+          d[3] = static_cast<unsigned char>(a + mul255(d[3], inv));
+        }
+      }
+    }
+  }
+
+  for (auto image : images) {
+    CC_SAFE_RELEASE(image);
+  }
+  if (!job->error.empty()) {
+    return;
+  }
+
+  job->image = new (std::nothrow) Image();
+  if (!job->image || !job->image->initWithRawData(pixels.data(), static_cast<ssize_t>(pixels.size()),
+                                                  width, height, 8, true)) {
+    CC_SAFE_RELEASE_NULL(job->image);
+    job->error = "Failed to create the composite image of " + job->key;
+  }
+}
+
+void CompositeSpriteCache::upload(CompositeSpriteCache::Job* job) {
+  _buildingKeys.erase(job->key);
+
+  Texture2D* texture = nullptr;
+  if (job->error.empty()) {
+    texture = new (std::nothrow) Texture2D();
+    if (!texture || !texture->initWithImage(job->image)) {
+      CC_SAFE_RELEASE_NULL(texture);
+      job->error = "Failed to upload the composite texture of " + job->key;
+    }
+  }
+  CC_SAFE_RELEASE_NULL(job->image);
+
+  if (!texture) {
+    VGLOG(LOG_ERR, "%s", job->error.c_str());
+    _failedKeys.insert(job->key);
+    return;
+  }
+  texture->setAliasTexParameters();  // disable texture antialiasing
+
+  vector<SpriteFrame*> spriteFrames(job->cells.size());
+  for (size_t i = 0; i < spriteFrames.size(); i++) {
+    const Rect rect(static_cast<float>(i % job->columnCount) * (job->cellWidth + CELL_PADDING),
+                    static_cast<float>(i / job->columnCount) * (job->cellHeight + CELL_PADDING),
+                    job->cellWidth, job->cellHeight);
+    spriteFrames[i] = SpriteFrame::createWithTexture(texture, CC_RECT_PIXELS_TO_POINTS(rect));
+  }
+
+  CompositeSpriteCache::Composite composite;
+  composite.key = job->key;
+  composite.texture = texture;
+  composite.size = static_cast<size_t>(texture->getPixelsWide()) * texture->getPixelsHigh() * 4;
+  composite.refCount = 0;
+
+  for (const auto& animation : job->animations) {
+    cocos2d::Vector<AnimationFrame*> frames;
+    for (const auto& frame : animation.frames) {
+      frames.pushBack(AnimationFrame::create(spriteFrames[frame.cellIdx], frame.delayUnits, ValueMap()));
+    }
+    Animation* compositeAnimation = Animation::create(frames, animation.delayPerUnit);
+    compositeAnimation->retain();
+    composite.animations.push_back(compositeAnimation);
+  }
+
+  _lru.push_front(job->key);
+  composite.lruIt = _lru.begin();
+  _residentSize += composite.size;
+  _composites.insert({job->key, std::move(composite)});
+  evictUnreferenced();
+}
+
+void CompositeSpriteCache::evictUnreferenced() {
+  // `it` is the composite right after the next candidate,
+  // so it remains valid when the candidate is evicted.
+  auto it = _lru.end();
+  while (_residentSize > _budget && it != _lru.begin()) {
+    auto candidateIt = std::prev(it);
+    CompositeSpriteCache::Composite& composite = _composites[*candidateIt];
+    if (composite.refCount > 0) {
+      it = candidateIt;
+      continue;
+    }
+    evict(&composite);
+  }
+}
+
+void CompositeSpriteCache::evict(CompositeSpriteCache::Composite* composite) {
+  for (auto animation : composite->animations) {
+    animation->release();
+  }
+  composite->texture->release();
+  _residentSize -= composite->size;
+  _lru.erase(composite->lruIt);
+
+  // Erasing it destroys `composite`.
+  const string key = composite->key;
+  _composites.erase(key);
+}
+
+}  // namespace vigilante
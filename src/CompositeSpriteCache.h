@@ -0,0 +1,150 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_COMPOSITE_SPRITE_CACHE_H_
+#define VIGILANTE_COMPOSITE_SPRITE_CACHE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <cocos2d.h>
+
+namespace vigilante {
+
+// Flattens a character's body and equipment animations into one texture per
+// (character, loadout), so that a fully equipped character is drawn as a single
+// sprite, rather than its body plus one sprite per piece of gear, each with
+// its own SpriteBatchNode (see Character::updateComposite()).
+//
+// The frames are composited on the CPU by a worker thread, from the PNGs of
+// the spritesheets (loaded with DecodedImageCache), and only uploaded by the
+// main thread in update(). Each frame of a composite animation is a cell of
+// the composite texture, where the layers' untrimmed frames are centered and
+// drawn in order, i.e., exactly where their sprites would have been drawn.
+//
+// The composites nobody has acquired are evicted, the least recently used
+// one first, once the composite textures exceed the memory budget.
+class CompositeSpriteCache {
+ public:
+  // One of the layers to be flattened, e.g., the body or a piece of gear.
+  struct Layer final {
+    std::string textureResDir;
+    cocos2d::Animation* animation;
+  };
+
+  struct Composite final {
+    std::string key;
+    cocos2d::Texture2D* texture;
+    // Parallel to the animations requested, each of which
+    // is timed like the animation of its first layer.
+    std::vector<cocos2d::Animation*> animations;
+    size_t size;  // in bytes
+    int refCount;
+    std::list<std::string>::iterator lruIt;
+  };
+
+  static CompositeSpriteCache* getInstance();
+  virtual ~CompositeSpriteCache();
+
+  // Builds the composite identified by `key` in the background, unless it has
+  // been built (or failed to be built) already, or is being built. Each element
+  // of `animations` lists the layers of one animation, from the bottom up.
+  // Main thread only.
+  void request(const std::string& key,
+               const std::vector<std::vector<CompositeSpriteCache::Layer>>& animations);
+
+  // @return the composite identified by `key` if it has been built, or nullptr.
+  //         It won't be evicted until it's released.
+  CompositeSpriteCache::Composite* acquire(const std::string& key);
+  void release(CompositeSpriteCache::Composite* composite);
+
+  // @return true if the composite identified by `key` has been requested,
+  //         but not yet built.
+  bool isBuilding(const std::string& key) const;
+
+  // Uploads the composites which have been built. Main thread only.
+  void update();
+
+  // If false (default), the characters draw their body and equipment separately.
+  bool isEnabled() const;
+  void setEnabled(bool enabled);
+
+  size_t getBudget() const;  // in bytes
+  void setBudget(size_t budget);
+  size_t getResidentSize() const;  // in bytes
+  size_t getCompositeCount() const;
+
+ private:
+  // A frame of a spritesheet, in pixels.
+  struct Frame final {
+    size_t imageIdx;
+    cocos2d::Rect rect;
+    bool isRotated;
+    cocos2d::Vec2 offset;
+    cocos2d::Size originalSize;
+  };
+
+  // A frame of a composite animation.
+  struct CellFrame final {
+    size_t cellIdx;
+    float delayUnits;
+  };
+
+  struct CellAnimation final {
+    std::vector<CompositeSpriteCache::CellFrame> frames;
+    float delayPerUnit;
+  };
+
+  // Everything the worker needs, so that it never touches cocos2d-x's caches.
+  struct Job final {
+    std::string key;
+    std::vector<std::string> imageFullPaths;
+    std::vector<CompositeSpriteCache::Frame> frames;
+    std::vector<std::vector<size_t>> cells;  // the frames of each cell, from the bottom up
+    std::vector<CompositeSpriteCache::CellAnimation> animations;
+    int cellWidth;
+    int cellHeight;
+    int columnCount;
+    int rowCount;
+
+    cocos2d::Image* image;  // composited by the worker
+    std::string error;  // empty if it has been composited successfully
+  };
+
+  CompositeSpriteCache();
+
+  void runWorker();
+  void build(CompositeSpriteCache::Job* job) const;
+  void upload(CompositeSpriteCache::Job* job);
+  void evictUnreferenced();
+  void evict(CompositeSpriteCache::Composite* composite);
+
+  bool _isEnabled;
+  size_t _residentSize;
+  size_t _budget;
+
+  // Keyed by Composite::key.
+  std::unordered_map<std::string, CompositeSpriteCache::Composite> _composites;
+  // The keys of the composites, the most recently used one first.
+  std::list<std::string> _lru;
+  std::unordered_set<std::string> _buildingKeys;
+  std::unordered_set<std::string> _failedKeys;
+
+  std::thread _worker;
+  std::mutex _mutex;
+  std::condition_variable _hasJobsCv;
+  std::deque<std::unique_ptr<CompositeSpriteCache::Job>> _pending;  // guarded by `_mutex`
+  std::deque<std::unique_ptr<CompositeSpriteCache::Job>> _built;  // guarded by `_mutex`
+  std::atomic<bool> _isShuttingDown;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_COMPOSITE_SPRITE_CACHE_H_
@@ -67,6 +67,8 @@ const int kShade = 96;
 const int kPauseMenu = 98;
 const int kControlHints = 99;
 const int kConsole = 100;
+const int kProfilerOverlay = 101;
+const int kPhysicsOverlay = 102;
 
 }  // namespace graphical_layers
 
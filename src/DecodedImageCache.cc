@@ -0,0 +1,269 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "DecodedImageCache.h"
+
+#include <sys/stat.h>
+#if defined(__linux__) || defined(__APPLE__)
+extern "C" {
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+}
+#define VIGILANTE_HAS_MMAP 1
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <thread>
+
+#include "util/Logger.h"
+
+#define CACHE_DIR_NAME "texture_cache/"
+#define CACHE_FILE_EXTENSION ".rgba"
+#define CACHE_FORMAT_VERSION 1
+
+using std::string;
+using cocos2d::Data;
+using cocos2d::Director;
+using cocos2d::FileUtils;
+using cocos2d::Image;
+using cocos2d::Texture2D;
+
+namespace vigilante {
+
+namespace {
+
+// Followed by width * height * 4 bytes of RGBA8888 pixels.
+struct Header final {
+  char magic[4];
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  uint32_t isPremultiplied;
+  uint32_t reserved;
+  int64_t sourceMtime;
+  uint64_t sourceSize;
+  uint64_t sourceHash;
+};
+
+const char kMagic[4] = {'V', 'G', 'I', 'C'};
+
+// FNV-1a
+uint64_t hash(const unsigned char* data, size_t size) {
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < size; i++) {
+    h = (h ^ data[i]) * 1099511628211ull;
+  }
+  return h;
+}
+
+}  // namespace
+
+
+DecodedImageCache* DecodedImageCache::getInstance() {
+  static DecodedImageCache instance;
+  return &instance;
+}
+
+DecodedImageCache::DecodedImageCache()
+    : _cacheDir(),
+#ifdef VIGILANTE_HAS_MMAP
+      _isEnabled(true),
+#else
+      _isEnabled(false),
+#endif
+      _hitCount(),
+      _missCount() {
+  FileUtils* fileUtils = FileUtils::getInstance();
+  _cacheDir = fileUtils->getWritablePath() + CACHE_DIR_NAME;
+  if (!fileUtils->isDirectoryExist(_cacheDir) && !fileUtils->createDirectory(_cacheDir)) {
+    VGLOG(LOG_ERR, "Failed to create %s, decoded images won't be cached", _cacheDir.c_str());
+    _cacheDir.clear();
+  }
+}
+
+
+Texture2D* DecodedImageCache::addImage(const string& fileName) {
+  cocos2d::TextureCache* textureCache = Director::getInstance()->getTextureCache();
+  FileUtils* fileUtils = FileUtils::getInstance();
+
+  const string fullPath = fileUtils->fullPathForFilename(fileName);
+  if (fullPath.empty()) {
+    return nullptr;
+  }
+  if (Texture2D* texture = textureCache->getTextureForKey(fullPath)) {
+    return texture;
+  }
+  if (!fileUtils->isAbsolutePath(fullPath)) {
+    // e.g., inside an apk, which cannot be mmap-ed.
+    return textureCache->addImage(fileName);
+  }
+
+  Image* image = loadImage(fullPath);
+  if (!image) {
+    VGLOG(LOG_ERR, "Failed to load %s", fullPath.c_str());
+    return nullptr;
+  }
+  Texture2D* texture = textureCache->addImage(image, fullPath);
+  image->release();
+  return texture;
+}
+
+Image* DecodedImageCache::loadImage(const string& fullPath) {
+  if (!_isEnabled || _cacheDir.empty()) {
+    _missCount++;
+    return decodeImage(fullPath, "");
+  }
+
+  const string cacheFileName = getCacheFileName(fullPath);
+  if (Image* image = loadCachedImage(fullPath, cacheFileName)) {
+    _hitCount++;
+    return image;
+  }
+  _missCount++;
+  return decodeImage(fullPath, cacheFileName);
+}
+
+bool DecodedImageCache::isEnabled() const {
+  return _isEnabled;
+}
+
+void DecodedImageCache::setEnabled(bool enabled) {
+#ifdef VIGILANTE_HAS_MMAP
+  _isEnabled = enabled;
+#endif
+}
+
+size_t DecodedImageCache::getHitCount() const {
+  return _hitCount;
+}
+
+size_t DecodedImageCache::getMissCount() const {
+  return _missCount;
+}
+
+
+Image* DecodedImageCache::loadCachedImage(const string& fullPath, const string& cacheFileName) {
+#ifndef VIGILANTE_HAS_MMAP
+  return nullptr;
+#else
+  struct stat sourceStat;
+  if (stat(fullPath.c_str(), &sourceStat) != 0) {
+    return nullptr;
+  }
+
+  const int fd = open(cacheFileName.c_str(), O_RDWR);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat cacheStat;
+  if (fstat(fd, &cacheStat) != 0 || cacheStat.st_size < static_cast<off_t>(sizeof(Header))) {
+    close(fd);
+    return nullptr;
+  }
+
+  const size_t size = static_cast<size_t>(cacheStat.st_size);
+  void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED) {
+    close(fd);
+    return nullptr;
+  }
+
+  Header header;
+  memcpy(&header, addr, sizeof(header));
+  const size_t pixelsSize = static_cast<size_t>(header.width) * header.height * 4;
+  bool isValid = !memcmp(header.magic, kMagic, sizeof(kMagic)) &&
+                 header.version == CACHE_FORMAT_VERSION &&
+                 size == sizeof(header) + pixelsSize &&
+                 header.sourceSize == static_cast<uint64_t>(sourceStat.st_size);
+
+  // If only the mtime has changed (e.g., after a fresh checkout), the PNG is
+  // hashed instead, which is still much cheaper than decoding it.
+  if (isValid && header.sourceMtime != static_cast<int64_t>(sourceStat.st_mtime)) {
+    Data data = FileUtils::getInstance()->getDataFromFile(fullPath);
+    isValid = !data.isNull() && hash(data.getBytes(), data.getSize()) == header.sourceHash;
+    if (isValid) {
+      header.sourceMtime = static_cast<int64_t>(sourceStat.st_mtime);
+      if (pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+        VGLOG(LOG_ERR, "Failed to update %s", cacheFileName.c_str());
+      }
+    }
+  }
+
+  Image* image = nullptr;
+  if (isValid) {
+    image = new (std::nothrow) Image();
+    const unsigned char* pixels = static_cast<const unsigned char*>(addr) + sizeof(header);
+    if (image && !image->initWithRawData(pixels, static_cast<ssize_t>(pixelsSize),
+                                         header.width, header.height, 8, header.isPremultiplied)) {
+      CC_SAFE_RELEASE_NULL(image);
+    }
+  }
+
+  munmap(addr, size);
+  close(fd);
+  return image;
+#endif
+}
+
+Image* DecodedImageCache::decodeImage(const string& fullPath, const string& cacheFileName) {
+  struct stat sourceStat;
+  if (stat(fullPath.c_str(), &sourceStat) != 0) {
+    return nullptr;
+  }
+
+  Data data = FileUtils::getInstance()->getDataFromFile(fullPath);
+  Image* image = new (std::nothrow) Image();
+  if (!image || data.isNull() || !image->initWithImageData(data.getBytes(), data.getSize())) {
+    CC_SAFE_RELEASE(image);
+    return nullptr;
+  }
+
+  // Only RGBA8888 is cached, which is what most of our PNGs decode to.
+  if (cacheFileName.empty() ||
+      image->getRenderFormat() != Texture2D::PixelFormat::RGBA8888 ||
+      image->getDataLen() != static_cast<ssize_t>(image->getWidth()) * image->getHeight() * 4) {
+    return image;
+  }
+
+  Header header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = CACHE_FORMAT_VERSION;
+  header.width = image->getWidth();
+  header.height = image->getHeight();
+  header.isPremultiplied = image->hasPremultipliedAlpha();
+  header.reserved = 0;
+  header.sourceMtime = static_cast<int64_t>(sourceStat.st_mtime);
+  header.sourceSize = data.getSize();
+  header.sourceHash = hash(data.getBytes(), data.getSize());
+
+  // Written to a temporary file first, so that a crash (or another thread
+  // caching the same image) never leaves a truncated cache file behind.
+  const string tmpFileName = cacheFileName + "." +
+      std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+  FILE* fp = fopen(tmpFileName.c_str(), "wb");
+  bool isWritten = fp &&
+                   fwrite(&header, sizeof(header), 1, fp) == 1 &&
+                   fwrite(image->getData(), image->getDataLen(), 1, fp) == 1;
+  if (fp) {
+    isWritten &= fclose(fp) == 0;
+  }
+  if (!isWritten || rename(tmpFileName.c_str(), cacheFileName.c_str()) != 0) {
+    VGLOG(LOG_ERR, "Failed to cache %s", fullPath.c_str());
+    remove(tmpFileName.c_str());
+  }
+  return image;
+}
+
+string DecodedImageCache::getCacheFileName(const string& fullPath) const {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%016llx",
+           static_cast<unsigned long long>(hash(reinterpret_cast<const unsigned char*>(fullPath.data()),
+                                                fullPath.size())));
+  return _cacheDir + buf + CACHE_FILE_EXTENSION;
+}
+
+}  // namespace vigilante
@@ -0,0 +1,61 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_DECODED_IMAGE_CACHE_H_
+#define VIGILANTE_DECODED_IMAGE_CACHE_H_
+
+#include <atomic>
+#include <string>
+
+#include <cocos2d.h>
+
+namespace vigilante {
+
+// An on-disk cache of decoded images, so that the PNGs are decoded only once
+// rather than every time the game starts or a map is entered.
+//
+// Each image is cached as a small header followed by its raw RGBA8888 pixels
+// (premultiplied if the PNG decoder premultiplied them) under the writable path,
+// and is mmap-ed from there. A cached image is used as long as its PNG has the
+// same size and either the same mtime or the same hash. Otherwise it's decoded
+// and cached again.
+//
+// On the platforms without mmap, the PNGs are always decoded.
+class DecodedImageCache {
+ public:
+  // Constructs it on the first call, which must be made from the main thread.
+  static DecodedImageCache* getInstance();
+  virtual ~DecodedImageCache() = default;
+
+  // Same as cocos2d::TextureCache::addImage(fileName), but the image is loaded
+  // with loadImage(), so the later TextureCache::addImage(fileName) calls
+  // (e.g., by Sprite::create()) will find it. Main thread only.
+  // @return nullptr if it cannot be loaded
+  cocos2d::Texture2D* addImage(const std::string& fileName);
+
+  // Loads the image at `fullPath` (which must be absolute), from the cache
+  // if possible. Thread-safe.
+  // @return a retained image which the caller has to release, or nullptr
+  cocos2d::Image* loadImage(const std::string& fullPath);
+
+  bool isEnabled() const;
+  void setEnabled(bool enabled);
+
+  // The number of images loaded from the cache, and decoded from their PNGs.
+  size_t getHitCount() const;
+  size_t getMissCount() const;
+
+ private:
+  DecodedImageCache();
+
+  cocos2d::Image* loadCachedImage(const std::string& fullPath, const std::string& cacheFileName);
+  cocos2d::Image* decodeImage(const std::string& fullPath, const std::string& cacheFileName);
+  std::string getCacheFileName(const std::string& fullPath) const;
+
+  std::string _cacheDir;
+  std::atomic<bool> _isEnabled;
+  std::atomic<size_t> _hitCount;
+  std::atomic<size_t> _missCount;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_DECODED_IMAGE_CACHE_H_
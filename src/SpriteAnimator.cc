@@ -0,0 +1,129 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "SpriteAnimator.h"
+
+#include <cmath>
+
+using cocos2d::Animation;
+using cocos2d::AnimationFrame;
+using cocos2d::Sprite;
+
+namespace vigilante {
+
+double SpriteAnimator::_clock = 0;
+
+SpriteAnimator::SpriteAnimator(size_t layerCount)
+    : _layers(layerCount, {nullptr, nullptr, -1}),
+      _startTime(),
+      _tag(),
+      _isLooping(),
+      _isPlaying(),
+      _finishedCallback() {}
+
+
+void SpriteAnimator::advanceClock(float delta) {
+  _clock += delta;
+}
+
+double SpriteAnimator::getClock() {
+  return _clock;
+}
+
+
+void SpriteAnimator::setAnimation(size_t layer, Sprite* sprite, Animation* animation) {
+  SpriteAnimator::Layer& l = _layers[layer];
+  l.sprite = sprite;
+  l.animation = (sprite) ? animation : nullptr;
+  l.frameIdx = -1;
+}
+
+void SpriteAnimator::play(int tag, bool loop) {
+  _startTime = _clock;
+  _tag = tag;
+  _isLooping = loop;
+  _isPlaying = true;
+
+  // Shows the first frames right away, as Character::update() may have
+  // already updated this animator during the current frame.
+  for (auto& layer : _layers) {
+    layer.frameIdx = -1;
+    if (layer.animation && !layer.animation->getFrames().empty()) {
+      layer.sprite->setSpriteFrame(layer.animation->getFrames().front()->getSpriteFrame());
+      layer.frameIdx = 0;
+    }
+  }
+}
+
+void SpriteAnimator::stop() {
+  _isPlaying = false;
+  for (auto& layer : _layers) {
+    layer = {nullptr, nullptr, -1};
+  }
+}
+
+void SpriteAnimator::update() {
+  if (!_isPlaying) {
+    return;
+  }
+
+  const float elapsed = static_cast<float>(_clock - _startTime);
+  for (auto& layer : _layers) {
+    if (!layer.animation || layer.animation->getFrames().empty()) {
+      continue;
+    }
+    const ssize_t frameIdx = getFrameIdx(layer.animation, elapsed, _isLooping);
+    if (frameIdx != layer.frameIdx) {
+      layer.sprite->setSpriteFrame(layer.animation->getFrames().at(frameIdx)->getSpriteFrame());
+      layer.frameIdx = frameIdx;
+    }
+  }
+
+  // Same as the Action-based path, where the first layer (e.g., the body)
+  // decides when the whole animation has finished.
+  const Animation* animation = _layers.front().animation;
+  if (!_isLooping && (!animation || elapsed >= animation->getDuration())) {
+    _isPlaying = false;
+    if (_finishedCallback) {
+      _finishedCallback(_tag);
+    }
+  }
+}
+
+bool SpriteAnimator::isPlaying() const {
+  return _isPlaying;
+}
+
+int SpriteAnimator::getTag() const {
+  return _tag;
+}
+
+void SpriteAnimator::setFinishedCallback(const SpriteAnimator::FinishedCallback& finishedCallback) {
+  _finishedCallback = finishedCallback;
+}
+
+
+ssize_t SpriteAnimator::getFrameIdx(const Animation* animation, float elapsed, bool loop) {
+  const auto& frames = animation->getFrames();
+  const float duration = animation->getDuration();
+  if (duration <= 0) {
+    return 0;
+  }
+
+  if (loop) {
+    elapsed = std::fmod(elapsed, duration);
+  } else if (elapsed >= duration) {
+    return frames.size() - 1;
+  }
+
+  // Same as cocos2d::Animate, where each frame lasts for its delay units.
+  const float delayPerUnit = animation->getDelayPerUnit();
+  float frameEndTime = 0;
+  for (ssize_t i = 0; i < frames.size(); i++) {
+    frameEndTime += frames.at(i)->getDelayUnits() * delayPerUnit;
+    if (elapsed < frameEndTime) {
+      return i;
+    }
+  }
+  return frames.size() - 1;
+}
+
+}  // namespace vigilante
@@ -0,0 +1,71 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_SPRITE_ANIMATOR_H_
+#define VIGILANTE_SPRITE_ANIMATOR_H_
+
+#include <functional>
+#include <vector>
+
+#include <cocos2d.h>
+
+namespace vigilante {
+
+// Plays cocos2d::Animations on several sprite layers (e.g., a Character's body
+// and its equipment) in lockstep, without running any cocos2d::Action.
+//
+// Each layer shows the frame of its animation which corresponds to the time
+// elapsed since play(), according to a clock shared by all animators, which
+// advanceClock() advances once per frame (see GameMapManager::update()).
+// Switching animations only overwrites a few fields, so it allocates nothing.
+class SpriteAnimator {
+ public:
+  // Called with the tag passed to play() once a non-looping animation has finished.
+  using FinishedCallback = std::function<void (int tag)>;
+
+  explicit SpriteAnimator(size_t layerCount);
+  virtual ~SpriteAnimator() = default;
+
+  static void advanceClock(float delta);
+  static double getClock();
+
+  // Shows `animation` on `sprite` from the next update(), in lockstep with the
+  // other layers. Pass nullptr to leave the layer alone, e.g., before its sprite
+  // is destroyed. The animator retains neither of them.
+  void setAnimation(size_t layer, cocos2d::Sprite* sprite, cocos2d::Animation* animation);
+
+  // Restarts all layers from their first frames, which are shown immediately.
+  void play(int tag, bool loop);
+
+  // Stops playing and detaches all layers.
+  void stop();
+
+  // Shows the current frame on each layer, and calls the FinishedCallback
+  // if the animation of the first layer has just finished.
+  void update();
+
+  bool isPlaying() const;
+  int getTag() const;
+  void setFinishedCallback(const SpriteAnimator::FinishedCallback& finishedCallback);
+
+ private:
+  struct Layer final {
+    cocos2d::Sprite* sprite;
+    cocos2d::Animation* animation;
+    ssize_t frameIdx;  // which has been shown, or -1 if none yet
+  };
+
+  // @return the index of the frame shown `elapsed` seconds into `animation`.
+  static ssize_t getFrameIdx(const cocos2d::Animation* animation, float elapsed, bool loop);
+
+  static double _clock;
+
+  std::vector<SpriteAnimator::Layer> _layers;
+  double _startTime;
+  int _tag;
+  bool _isLooping;
+  bool _isPlaying;
+  SpriteAnimator::FinishedCallback _finishedCallback;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_SPRITE_ANIMATOR_H_
@@ -0,0 +1,278 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "SpritesheetLoader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+
+#include "AssetManager.h"
+#include "DecodedImageCache.h"
+#include "TextureResidencyManager.h"
+#include "util/Logger.h"
+
+using std::mutex;
+using std::string;
+using std::thread;
+using std::vector;
+using std::lock_guard;
+using cocos2d::Data;
+using cocos2d::Director;
+using cocos2d::FileUtils;
+using cocos2d::Image;
+using cocos2d::Rect;
+using cocos2d::Size;
+using cocos2d::SpriteFrame;
+using cocos2d::SpriteFrameCache;
+using cocos2d::Texture2D;
+using cocos2d::ValueMap;
+using cocos2d::ValueVector;
+using cocos2d::Vec2;
+
+namespace vigilante {
+
+SpritesheetLoader::SpritesheetLoader(const string& spritesheetsListFileName)
+    : SpritesheetLoader(asset_manager::readSpritesheetsList(spritesheetsListFileName)) {}
+
+SpritesheetLoader::SpritesheetLoader(const vector<string>& plistFileNames)
+    : _plistFileNames(plistFileNames),
+      _plistFullPaths(),
+      _loadedCount(),
+      _isSerial(),
+      _nextDecodeIdx(0),
+      _isShuttingDown(false),
+      _decodedMutex(),
+      _decoded(),
+      _workers() {
+  start();
+}
+
+SpritesheetLoader::~SpritesheetLoader() {
+  _isShuttingDown = true;
+  for (auto& worker : _workers) {
+    worker.join();
+  }
+
+  for (auto& spritesheet : _decoded) {
+    CC_SAFE_RELEASE(spritesheet.image);
+  }
+}
+
+
+void SpritesheetLoader::start() {
+  // FileUtils caches the full paths it has resolved, and the cache isn't
+  // synchronized, so the paths are resolved here on the main thread. The workers
+  // only pass absolute paths to FileUtils, which never go through the cache.
+  FileUtils* fileUtils = FileUtils::getInstance();
+  DecodedImageCache::getInstance();  // which must be constructed on the main thread.
+  _plistFullPaths.clear();
+  for (const auto& plistFileName : _plistFileNames) {
+    string fullPath = fileUtils->fullPathForFilename(plistFileName);
+    _isSerial |= !fileUtils->isAbsolutePath(fullPath);
+    _plistFullPaths.push_back(fullPath);
+  }
+
+  if (_isSerial || _plistFileNames.empty()) {
+    return;
+  }
+
+  // The main thread has to keep rendering the loading screen.
+  const size_t workerCount = std::min<size_t>(std::max(thread::hardware_concurrency(), 2u) - 1,
+                                              _plistFileNames.size());
+  for (size_t i = 0; i < workerCount; i++) {
+    _workers.push_back(thread(&SpritesheetLoader::runWorker, this));
+  }
+}
+
+void SpritesheetLoader::update(float budget) {
+  auto begin = std::chrono::steady_clock::now();
+
+  while (!isDone()) {
+    string plistFileName;
+    if (_isSerial) {
+      plistFileName = _plistFileNames[_loadedCount];
+      SpriteFrameCache::getInstance()->addSpriteFramesWithFile(plistFileName);
+    } else {
+      SpritesheetLoader::Spritesheet spritesheet;
+      {
+        lock_guard<mutex> lock(_decodedMutex);
+        if (_decoded.empty()) {
+          return;  // the workers are still decoding.
+        }
+        spritesheet = std::move(_decoded.front());
+        _decoded.pop_front();
+      }
+      upload(&spritesheet);
+      plistFileName = std::move(spritesheet.plistFileName);
+    }
+    _loadedCount++;
+    TextureResidencyManager::getInstance()->onSpritesheetLoaded(plistFileName);
+
+    if (std::chrono::duration<float>(std::chrono::steady_clock::now() - begin).count() >= budget) {
+      return;
+    }
+  }
+}
+
+void SpritesheetLoader::finish() {
+  while (!isDone()) {
+    update(std::numeric_limits<float>::max());
+    std::this_thread::yield();
+  }
+}
+
+bool SpritesheetLoader::isDone() const {
+  return _loadedCount == _plistFileNames.size();
+}
+
+float SpritesheetLoader::getProgress() const {
+  return (_plistFileNames.empty()) ? 1.0f : static_cast<float>(_loadedCount) / _plistFileNames.size();
+}
+
+size_t SpritesheetLoader::getLoadedCount() const {
+  return _loadedCount;
+}
+
+size_t SpritesheetLoader::getTotalCount() const {
+  return _plistFileNames.size();
+}
+
+
+void SpritesheetLoader::runWorker() {
+  while (!_isShuttingDown) {
+    const size_t idx = _nextDecodeIdx++;
+    if (idx >= _plistFileNames.size()) {
+      return;
+    }
+
+    SpritesheetLoader::Spritesheet spritesheet;
+    decode(_plistFileNames[idx], _plistFullPaths[idx], &spritesheet);
+
+    lock_guard<mutex> lock(_decodedMutex);
+    _decoded.push_back(std::move(spritesheet));
+  }
+}
+
+void SpritesheetLoader::decode(const string& plistFileName, const string& plistFullPath,
+                               SpritesheetLoader::Spritesheet* spritesheet) const {
+  FileUtils* fileUtils = FileUtils::getInstance();
+  spritesheet->plistFileName = plistFileName;
+  spritesheet->image = nullptr;
+
+  Data plistData = fileUtils->getDataFromFile(plistFullPath);
+  if (plistData.isNull()) {
+    spritesheet->error = "Failed to read " + plistFullPath;
+    return;
+  }
+
+  ValueMap dict = fileUtils->getValueMapFromData(reinterpret_cast<const char*>(plistData.getBytes()),
+                                                 static_cast<int>(plistData.getSize()));
+  if (!parseFrames(dict, &spritesheet->frames)) {
+    spritesheet->error = "Unsupported spritesheet format: " + plistFullPath;
+    return;
+  }
+
+  // Resolve the texture's path the same way as SpriteFrameCache::addSpriteFramesWithFile().
+  string textureFileName;
+  auto metadataIt = dict.find("metadata");
+  if (metadataIt != dict.end()) {
+    textureFileName = metadataIt->second.asValueMap()["textureFileName"].asString();
+  }
+  if (!textureFileName.empty()) {
+    spritesheet->textureFullPath = plistFullPath.substr(0, plistFullPath.rfind('/') + 1) + textureFileName;
+  } else {
+    spritesheet->textureFullPath = plistFullPath.substr(0, plistFullPath.rfind('.')) + ".png";
+  }
+
+  spritesheet->image = DecodedImageCache::getInstance()->loadImage(spritesheet->textureFullPath);
+  if (!spritesheet->image) {
+    spritesheet->error = "Failed to decode " + spritesheet->textureFullPath;
+  }
+}
+
+void SpritesheetLoader::upload(SpritesheetLoader::Spritesheet* spritesheet) const {
+  if (!spritesheet->error.empty()) {
+    VGLOG(LOG_ERR, "%s", spritesheet->error.c_str());
+    return;
+  }
+
+  // The texture is keyed by its full path, so that the later
+  // TextureCache::addImage(path) calls will find it.
+  Texture2D* texture = Director::getInstance()->getTextureCache()->addImage(
+      spritesheet->image, spritesheet->textureFullPath);
+  spritesheet->image->release();
+  spritesheet->image = nullptr;
+
+  if (!texture) {
+    VGLOG(LOG_ERR, "Failed to upload %s", spritesheet->textureFullPath.c_str());
+    return;
+  }
+
+  SpriteFrameCache* frameCache = SpriteFrameCache::getInstance();
+  for (const auto& frame : spritesheet->frames) {
+    SpriteFrame* spriteFrame = SpriteFrame::createWithTexture(texture, frame.rect, frame.isRotated,
+                                                              frame.offset, frame.originalSize);
+    frameCache->addSpriteFrame(spriteFrame, frame.name);
+    for (const auto& alias : frame.aliases) {
+      frameCache->addSpriteFrame(spriteFrame, alias);
+    }
+  }
+}
+
+bool SpritesheetLoader::parseFrames(ValueMap& dict, vector<SpritesheetLoader::Frame>* frames) {
+  int format = 0;
+  auto metadataIt = dict.find("metadata");
+  if (metadataIt != dict.end()) {
+    format = metadataIt->second.asValueMap()["format"].asInt();
+  }
+  if (format < 0 || format > 3) {
+    return false;
+  }
+
+  auto framesIt = dict.find("frames");
+  if (framesIt == dict.end()) {
+    return false;
+  }
+
+  ValueMap& framesDict = framesIt->second.asValueMap();
+  frames->reserve(framesDict.size());
+
+  for (auto& it : framesDict) {
+    ValueMap& frameDict = it.second.asValueMap();
+    SpritesheetLoader::Frame frame;
+    frame.name = it.first;
+
+    if (format == 0) {
+      frame.rect = Rect(frameDict["x"].asFloat(), frameDict["y"].asFloat(),
+                        frameDict["width"].asFloat(), frameDict["height"].asFloat());
+      frame.isRotated = false;
+      frame.offset = Vec2(frameDict["offsetX"].asFloat(), frameDict["offsetY"].asFloat());
+      frame.originalSize = Size(std::abs(frameDict["originalWidth"].asInt()),
+                                std::abs(frameDict["originalHeight"].asInt()));
+    } else if (format == 1 || format == 2) {
+      frame.rect = cocos2d::RectFromString(frameDict["frame"].asString());
+      frame.isRotated = format == 2 && frameDict["rotated"].asBool();
+      frame.offset = cocos2d::PointFromString(frameDict["offset"].asString());
+      frame.originalSize = cocos2d::SizeFromString(frameDict["sourceSize"].asString());
+    } else {
+      const Size spriteSize = cocos2d::SizeFromString(frameDict["spriteSize"].asString());
+      const Rect textureRect = cocos2d::RectFromString(frameDict["textureRect"].asString());
+      frame.rect = Rect(textureRect.origin.x, textureRect.origin.y, spriteSize.width, spriteSize.height);
+      frame.isRotated = frameDict["textureRotated"].asBool();
+      frame.offset = cocos2d::PointFromString(frameDict["spriteOffset"].asString());
+      frame.originalSize = cocos2d::SizeFromString(frameDict["spriteSourceSize"].asString());
+      auto aliasesIt = frameDict.find("aliases");
+      if (aliasesIt != frameDict.end()) {
+        const ValueVector& aliases = aliasesIt->second.asValueVector();
+        for (const auto& alias : aliases) {
+          frame.aliases.push_back(alias.asString());
+        }
+      }
+    }
+
+    frames->push_back(std::move(frame));
+  }
+  return true;
+}
+
+}  // namespace vigilante
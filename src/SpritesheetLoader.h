@@ -0,0 +1,91 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_SPRITESHEET_LOADER_H_
+#define VIGILANTE_SPRITESHEET_LOADER_H_
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cocos2d.h>
+
+namespace vigilante {
+
+// Loads spritesheets (e.g., those listed in asset_manager::kSpritesheetsList)
+// as a pipeline. The worker threads read the files, parse the plists and
+// decode the PNGs (or load them from DecodedImageCache) concurrently, while
+// the main thread only uploads the textures and registers the sprite frames
+// in update(), a few spritesheets per call, so that a loading screen can keep
+// rendering meanwhile (see LoadingScene).
+// TextureResidencyManager is notified of each spritesheet loaded.
+//
+// If the resources aren't plain files on this platform (e.g., they're inside
+// an apk), the spritesheets are loaded serially by update() instead.
+class SpritesheetLoader {
+ public:
+  // @throw std::runtime_error if the list cannot be opened
+  explicit SpritesheetLoader(const std::string& spritesheetsListFileName);
+  explicit SpritesheetLoader(const std::vector<std::string>& plistFileNames);
+  virtual ~SpritesheetLoader();
+
+  // Uploads and registers the decoded spritesheets until `budget` seconds have
+  // passed or there are none left to be uploaded. At least one spritesheet is
+  // uploaded per call, if there's any. Main thread only.
+  void update(float budget);
+
+  // Blocks until all of the spritesheets have been loaded. Main thread only.
+  void finish();
+
+  bool isDone() const;
+  float getProgress() const;  // [0, 1]
+  size_t getLoadedCount() const;
+  size_t getTotalCount() const;
+
+ private:
+  struct Frame final {
+    std::string name;
+    std::vector<std::string> aliases;
+    cocos2d::Rect rect;
+    bool isRotated;
+    cocos2d::Vec2 offset;
+    cocos2d::Size originalSize;
+  };
+
+  // What the workers hand over to the main thread.
+  struct Spritesheet final {
+    std::string plistFileName;
+    std::string textureFullPath;
+    cocos2d::Image* image;  // decoded, but not yet uploaded
+    std::vector<SpritesheetLoader::Frame> frames;
+    std::string error;  // empty if it has been decoded successfully
+  };
+
+  void start();
+  void runWorker();
+  void decode(const std::string& plistFileName, const std::string& plistFullPath,
+              SpritesheetLoader::Spritesheet* spritesheet) const;
+  void upload(SpritesheetLoader::Spritesheet* spritesheet) const;
+
+  // Same as cocos2d::SpriteFrameCache::addSpriteFramesWithDictionary(),
+  // but without a texture yet.
+  static bool parseFrames(cocos2d::ValueMap& dict, std::vector<SpritesheetLoader::Frame>* frames);
+
+  std::vector<std::string> _plistFileNames;
+  std::vector<std::string> _plistFullPaths;
+  size_t _loadedCount;
+  bool _isSerial;
+
+  // The workers take the spritesheets in order by `_nextDecodeIdx`,
+  // and push them to `_decoded` once they're decoded.
+  std::atomic<size_t> _nextDecodeIdx;
+  std::atomic<bool> _isShuttingDown;
+  std::mutex _decodedMutex;
+  std::deque<SpritesheetLoader::Spritesheet> _decoded;
+  std::vector<std::thread> _workers;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_SPRITESHEET_LOADER_H_
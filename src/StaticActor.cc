@@ -4,6 +4,7 @@
 #include <stdexcept>
 
 #include "Constants.h"
+#include "TextureResidencyManager.h"
 #include "map/GameMapManager.h"
 
 using std::string;
@@ -34,8 +35,7 @@ bool StaticActor::showOnMap(float x, float y) {
   _isShownOnMap = true;
 
   _bodySprite->setPosition(x, y);
-  GameMapManager::getInstance()->getLayer()->addChild(_bodySprite,
-                                                      graphical_layers::kDefault);
+  GameMapManager::getInstance()->getGraphicalLayer(graphical_layers::kDefault)->addChild(_bodySprite);
   return true;
 }
 
@@ -47,9 +47,7 @@ bool StaticActor::removeFromMap() {
   _isShownOnMap = false;
 
   // If _bodySpritesheet exists, we should remove it instead of _bodySprite.
-  GameMapManager::getInstance()->getLayer()->removeChild(
-    (_bodySpritesheet) ? ((Node*) _bodySpritesheet) : ((Node*) _bodySprite)
-  );
+  ((_bodySpritesheet) ? ((Node*) _bodySpritesheet) : ((Node*) _bodySprite))->removeFromParent();
   _bodySpritesheet = nullptr;
   _bodySprite = nullptr;
   return true;
@@ -76,6 +74,9 @@ Animation* StaticActor::createAnimation(const string& textureResDir,
   FileUtils* fileUtils = FileUtils::getInstance();
   SpriteFrameCache* frameCache = SpriteFrameCache::getInstance();
 
+  // The spritesheet may have been evicted.
+  TextureResidencyManager::getInstance()->ensureResident(textureResDir);
+
   // The texture resources under Resources/Texture/ has the following rules:
   //
   // Texture/character/player/player_attacking0/0.png
@@ -0,0 +1,223 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "TextureResidencyManager.h"
+
+#include <cstdio>
+#include <iterator>
+
+#include "AssetManager.h"
+#include "SpritesheetLoader.h"
+#include "util/Logger.h"
+
+#define DEFAULT_BUDGET_MB 256
+#define BYTES_PER_MB (1024 * 1024)
+
+using std::string;
+using std::vector;
+using std::unordered_set;
+using cocos2d::Director;
+using cocos2d::SpriteFrameCache;
+using cocos2d::Texture2D;
+
+namespace vigilante {
+
+TextureResidencyManager* TextureResidencyManager::getInstance() {
+  static TextureResidencyManager instance;
+  return &instance;
+}
+
+TextureResidencyManager::TextureResidencyManager()
+    : _spritesheets(),
+      _lru(),
+      _residentSize(),
+      _budget(static_cast<size_t>(DEFAULT_BUDGET_MB) * BYTES_PER_MB),
+      _mapPlistFileNames(),
+      _currentTmxMapFileName() {}
+
+
+void TextureResidencyManager::onSpritesheetLoaded(const string& plistFileName) {
+  Texture2D* texture = Director::getInstance()->getTextureCache()->getTextureForKey(
+      plistFileName.substr(0, plistFileName.rfind('.')) + ".png");
+  if (!texture) {
+    return;
+  }
+
+  auto it = _spritesheets.find(plistFileName);
+  if (it == _spritesheets.end()) {
+    TextureResidencyManager::Spritesheet spritesheet;
+    spritesheet.plistFileName = plistFileName;
+    spritesheet.texture = nullptr;
+    spritesheet.size = 0;
+    spritesheet.refCount = 0;
+    it = _spritesheets.insert({plistFileName, spritesheet}).first;
+  }
+
+  TextureResidencyManager::Spritesheet& spritesheet = it->second;
+  if (spritesheet.texture) {
+    touch(&spritesheet);
+    return;
+  }
+
+  spritesheet.texture = texture;
+  spritesheet.texture->retain();
+  spritesheet.size = texture->getPixelsWide() * texture->getPixelsHigh() *
+                     texture->getBitsPerPixelForFormat() / 8;
+  _residentSize += spritesheet.size;
+  _lru.push_front(plistFileName);
+  spritesheet.lruIt = _lru.begin();
+}
+
+void TextureResidencyManager::ensureResident(const string& textureResDir) {
+  auto it = _spritesheets.find(asset_manager::getSpritesheetPlist(textureResDir));
+  if (it == _spritesheets.end()) {
+    return;
+  }
+
+  if (it->second.texture) {
+    touch(&it->second);
+  } else {
+    load({it->second.plistFileName});
+  }
+}
+
+void TextureResidencyManager::retain(const string& textureResDir) {
+  auto it = _spritesheets.find(asset_manager::getSpritesheetPlist(textureResDir));
+  if (it != _spritesheets.end()) {
+    it->second.refCount++;
+  }
+}
+
+void TextureResidencyManager::release(const string& textureResDir) {
+  releaseSpritesheet(asset_manager::getSpritesheetPlist(textureResDir));
+}
+
+void TextureResidencyManager::enterMap(const string& tmxMapFileName,
+                                       const unordered_set<string>& textureResDirs) {
+  // Copied, since it's overwritten below if the same map is re-entered.
+  unordered_set<string> prevPlistFileNames;
+  auto prevIt = _mapPlistFileNames.find(_currentTmxMapFileName);
+  if (prevIt != _mapPlistFileNames.end()) {
+    prevPlistFileNames = prevIt->second;
+  }
+
+  // Several textureResDirs may share an atlas, which is referenced only once.
+  unordered_set<string> plistFileNames;
+  vector<string> nonResidentPlistFileNames;
+  for (const auto& textureResDir : textureResDirs) {
+    const string plistFileName = asset_manager::getSpritesheetPlist(textureResDir);
+    auto it = _spritesheets.find(plistFileName);
+    if (it == _spritesheets.end() || !plistFileNames.insert(plistFileName).second) {
+      continue;
+    }
+    it->second.refCount++;
+    if (it->second.texture) {
+      touch(&it->second);
+    } else {
+      nonResidentPlistFileNames.push_back(plistFileName);
+    }
+  }
+  load(nonResidentPlistFileNames);
+
+  for (const auto& plistFileName : prevPlistFileNames) {
+    releaseSpritesheet(plistFileName);
+  }
+
+  _mapPlistFileNames[tmxMapFileName] = std::move(plistFileNames);
+  _currentTmxMapFileName = tmxMapFileName;
+  evictUnreferenced();
+}
+
+void TextureResidencyManager::evictUnreferenced() {
+  // `it` is the spritesheet right after the next candidate,
+  // so it remains valid when the candidate is evicted.
+  auto it = _lru.end();
+  while (_residentSize > _budget && it != _lru.begin()) {
+    auto candidateIt = std::prev(it);
+    TextureResidencyManager::Spritesheet& spritesheet = _spritesheets[*candidateIt];
+    if (spritesheet.refCount > 0) {
+      it = candidateIt;
+      continue;
+    }
+    evict(&spritesheet);
+  }
+}
+
+size_t TextureResidencyManager::getBudget() const {
+  return _budget;
+}
+
+void TextureResidencyManager::setBudget(size_t budget) {
+  _budget = budget;
+  evictUnreferenced();
+}
+
+size_t TextureResidencyManager::getResidentSize() const {
+  return _residentSize;
+}
+
+string TextureResidencyManager::getReport() const {
+  char buf[256];
+  snprintf(buf, sizeof(buf), "resident: %.1f / %.1f MB (%zu of %zu spritesheets)\n",
+           static_cast<double>(_residentSize) / BYTES_PER_MB,
+           static_cast<double>(_budget) / BYTES_PER_MB,
+           _lru.size(), _spritesheets.size());
+  string report = buf;
+
+  for (const auto& map : _mapPlistFileNames) {
+    size_t count = 0;
+    size_t size = 0;
+    size_t residentSize = 0;
+    for (const auto& plistFileName : map.second) {
+      auto it = _spritesheets.find(plistFileName);
+      if (it == _spritesheets.end()) {
+        continue;
+      }
+      count++;
+      size += it->second.size;
+      residentSize += (it->second.texture) ? it->second.size : 0;
+    }
+
+    snprintf(buf, sizeof(buf), "%s: %.1f MB in %zu spritesheets (%.1f MB resident)%s\n",
+             map.first.c_str(),
+             static_cast<double>(size) / BYTES_PER_MB, count,
+             static_cast<double>(residentSize) / BYTES_PER_MB,
+             (map.first == _currentTmxMapFileName) ? " [current]" : "");
+    report += buf;
+  }
+  return report;
+}
+
+
+void TextureResidencyManager::load(const vector<string>& plistFileNames) {
+  if (plistFileNames.empty()) {
+    return;
+  }
+  // The loader calls onSpritesheetLoaded() for each of them.
+  SpritesheetLoader(plistFileNames).finish();
+}
+
+void TextureResidencyManager::releaseSpritesheet(const string& plistFileName) {
+  auto it = _spritesheets.find(plistFileName);
+  if (it != _spritesheets.end() && it->second.refCount > 0) {
+    it->second.refCount--;
+  }
+}
+
+void TextureResidencyManager::evict(TextureResidencyManager::Spritesheet* spritesheet) {
+  VGLOG(LOG_INFO, "Evicting %s", spritesheet->plistFileName.c_str());
+
+  // Unlike removeSpriteFramesFromTexture(), this also lets
+  // addSpriteFramesWithFile() load the plist again later.
+  SpriteFrameCache::getInstance()->removeSpriteFramesFromFile(spritesheet->plistFileName);
+  Director::getInstance()->getTextureCache()->removeTexture(spritesheet->texture);
+  spritesheet->texture->release();
+  spritesheet->texture = nullptr;
+
+  _residentSize -= spritesheet->size;
+  _lru.erase(spritesheet->lruIt);
+}
+
+void TextureResidencyManager::touch(TextureResidencyManager::Spritesheet* spritesheet) {
+  _lru.splice(_lru.begin(), _lru, spritesheet->lruIt);
+}
+
+}  // namespace vigilante
@@ -0,0 +1,92 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_TEXTURE_RESIDENCY_MANAGER_H_
+#define VIGILANTE_TEXTURE_RESIDENCY_MANAGER_H_
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <cocos2d.h>
+
+namespace vigilante {
+
+// Keeps track of which spritesheets are resident in cocos2d::TextureCache
+// and cocos2d::SpriteFrameCache, and evicts the least recently used ones
+// that nobody references once they exceed the memory budget.
+//
+// A spritesheet is identified by its plist, i.e., the spritesheet.plist in its
+// textureResDir (e.g., Texture/character/vlad), or the atlas it has been packed
+// into (see asset_manager::getSpritesheetPlist()), in which case it's shared
+// by all the textureResDirs in that atlas. The textureResDirs without
+// a spritesheet (e.g., those of consumables) are ignored.
+//
+// Each GameMap references the spritesheets of its npcs, chest items and
+// equipped gear (see GameMapManager::doLoadGameMap()), which are loaded in
+// parallel upon entering it. Anything else is loaded on demand by
+// ensureResident(). An evicted spritesheet's frames stay valid for the
+// animations that still retain them, since cocos2d-x refcounts them.
+class TextureResidencyManager {
+ public:
+  static TextureResidencyManager* getInstance();
+  virtual ~TextureResidencyManager() = default;
+
+  // Called by SpritesheetLoader each time it has loaded a spritesheet.
+  void onSpritesheetLoaded(const std::string& plistFileName);
+
+  // Loads the spritesheet of `textureResDir` if it has been evicted,
+  // and marks it as the most recently used one.
+  void ensureResident(const std::string& textureResDir);
+
+  // A referenced spritesheet is never evicted.
+  void retain(const std::string& textureResDir);
+  void release(const std::string& textureResDir);
+
+  // References the spritesheets needed by `tmxMapFileName` and loads them,
+  // and then releases those of the previous map and evicts what exceeds the budget.
+  void enterMap(const std::string& tmxMapFileName,
+                const std::unordered_set<std::string>& textureResDirs);
+
+  // Evicts the least recently used unreferenced spritesheets
+  // until the resident ones fit in the budget.
+  void evictUnreferenced();
+
+  size_t getBudget() const;  // in bytes
+  void setBudget(size_t budget);
+  size_t getResidentSize() const;  // in bytes
+
+  // The texture memory needed by each map entered so far, one map per line.
+  std::string getReport() const;
+
+ private:
+  struct Spritesheet final {
+    std::string plistFileName;
+    cocos2d::Texture2D* texture;  // nullptr if it's not resident
+    size_t size;  // in bytes, as of the last time it was resident
+    int refCount;
+    std::list<std::string>::iterator lruIt;  // only valid if it's resident
+  };
+
+  TextureResidencyManager();
+
+  void load(const std::vector<std::string>& plistFileNames);
+  void releaseSpritesheet(const std::string& plistFileName);
+  void evict(TextureResidencyManager::Spritesheet* spritesheet);
+  void touch(TextureResidencyManager::Spritesheet* spritesheet);
+
+  // Keyed by plistFileName.
+  std::unordered_map<std::string, TextureResidencyManager::Spritesheet> _spritesheets;
+  // The plists of the resident spritesheets, the most recently used one first.
+  std::list<std::string> _lru;
+  size_t _residentSize;
+  size_t _budget;
+
+  // The spritesheets referenced by each map entered so far.
+  std::unordered_map<std::string, std::unordered_set<std::string>> _mapPlistFileNames;
+  std::string _currentTmxMapFileName;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_TEXTURE_RESIDENCY_MANAGER_H_
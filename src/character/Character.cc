@@ -7,9 +7,11 @@
 #include <json/document.h>
 #include "AssetManager.h"
 #include "CallbackManager.h"
+#include "CompositeSpriteCache.h"
 #include "Constants.h"
 #include "Player.h"
 #include "gameplay/ExpPointTable.h"
+#include "gameplay/SaveJournal.h"
 #include "map/GameMapManager.h"
 #include "ui/hud/Hud.h"
 #include "ui/floating_damages/FloatingDamages.h"
@@ -22,6 +24,7 @@ using std::set;
 using std::array;
 using std::unordered_set;
 using std::string;
+using std::vector;
 using std::function;
 using std::unique_ptr;
 using std::shared_ptr;
@@ -36,6 +39,7 @@ using cocos2d::Action;
 using cocos2d::Sprite;
 using cocos2d::FileUtils;
 using cocos2d::SpriteBatchNode;
+using cocos2d::SpriteFrame;
 using rapidjson::Document;
 
 namespace vigilante {
@@ -60,27 +64,15 @@ const array<string, Character::State::STATE_SIZE> Character::_kCharacterStateStr
 Character::Character(const string& jsonFileName)
     : DynamicActor(State::STATE_SIZE, FixtureType::FIXTURE_SIZE),
       _characterProfile(jsonFileName),
-      _statsRegenTimer(),
+      _store(GameMapManager::getInstance()->getCharacterStore()),
+      _storeIdx(_store->add(this)),
       _baseRegenDeltaHealth(5),
       _baseRegenDeltaMagicka(5),
       _baseRegenDeltaStamina(5),
-      _currentState(State::IDLE_SHEATHED),
-      _previousState(State::IDLE_SHEATHED),
-      _isFacingRight(true),
-      _isWeaponSheathed(true),
-      _isSheathingWeapon(),
-      _isUnsheathingWeapon(),
       _isJumpingDisallowed(),
-      _isJumping(),
       _isDoubleJumping(),
       _isOnPlatform(),
-      _isAttacking(),
-      _isUsingSkill(),
-      _isCrouching(),
       _isInvincible(),
-      _isTakingDamage(),
-      _isKilled(),
-      _isSetToKill(),
       _inRangeTargets(),
       _lockedOnTarget(),
       _isAlerted(),
@@ -101,7 +93,21 @@ Character::Character(const string& jsonFileName)
       _equipmentSpritesheets(),
       _equipmentAnimations(),
       _skillBodyAnimations(),
+      _animator(1 + Equipment::Type::SIZE),
+      _onAnimationFinished(),
+      _composite(),
+      _compositeKey(),
+      _isCompositeDirty(),
       _party() {
+  _animator.setFinishedCallback([this](int) {
+    if (_onAnimationFinished) {
+      // Moved out first, since it may run another animation.
+      function<void ()> onAnimationFinished = std::move(_onAnimationFinished);
+      _onAnimationFinished = nullptr;
+      onAnimationFinished();
+    }
+  });
+
   // Resize each vector in _equipmentExtraAttackAnimations to match
   // the size of _bodyExtraAttackAnimations.
   for (auto& animationVector : _equipmentExtraAttackAnimations) {
@@ -118,59 +124,83 @@ Character::Character(const string& jsonFileName)
   }
 }
 
+Character::~Character() {
+  _store->remove(_storeIdx);
+}
+
 
 bool Character::removeFromMap() {
   if (!StaticActor::removeFromMap()) {
     return false;
   }
 
-  if (!_isKilled) {
+  if (!isKilled()) {
     destroyBody();
   }
+  _animator.stop();
+  if (_composite) {
+    CompositeSpriteCache::getInstance()->release(_composite);
+    _composite = nullptr;
+  }
+  _compositeKey.clear();
+  _isCompositeDirty = false;
+  _store->setBody(_storeIdx, nullptr);
+  _store->setBodySprite(_storeIdx, nullptr, cocos2d::Vec2::ZERO);
 
   // Remove _equipmentSpritesheets
   for (auto equipment : _equipmentSlots) {
     if (equipment) {
-      GameMapManager::getInstance()->getLayer()->removeChild(
-          _equipmentSpritesheets[equipment->getEquipmentProfile().equipmentType]
-      );
+      _equipmentSpritesheets[equipment->getEquipmentProfile().equipmentType]->removeFromParent();
     }
   }
 
   return true;
 }
 
-void Character::update(float delta) {
-  if (!_isShownOnMap || _isKilled) {
+void Character::update(float) {
+  if (!_isShownOnMap || isKilled()) {
+    return;
+  }
+
+  // This may finish the KILLED animation, and hence call onKilled().
+  _animator.update();
+  if (isKilled()) {
     return;
   }
 
+  // The body sprite has been synced with its b2body, and the state has been
+  // evaluated, by CharacterStore::update() already.
+  const uint8_t events = _store->getEvents(_storeIdx);
+  _store->clearEvents(_storeIdx);
+
+  // Only switched when the current animation can be restarted.
+  if (_isCompositeDirty && !isUsingSkill() &&
+      _store->getCurrentState(_storeIdx) != State::KILLED) {
+    syncComposite();
+  }
+
   // Flip the sprite if needed.
-  if (!_isFacingRight && !_bodySprite->isFlippedX()) {
+  if (!isFacingRight() && !_bodySprite->isFlippedX()) {
     _bodySprite->setFlippedX(true);
     auto shape = dynamic_cast<b2CircleShape*>(_fixtures[FixtureType::WEAPON]->GetShape());
     shape->m_p = {-_characterProfile.attackRange / kPpm, 0};
-  } else if (_isFacingRight && _bodySprite->isFlippedX()) {
+  } else if (isFacingRight() && _bodySprite->isFlippedX()) {
     _bodySprite->setFlippedX(false);
     auto shape = dynamic_cast<b2CircleShape*>(_fixtures[FixtureType::WEAPON]->GetShape());
     shape->m_p = {_characterProfile.attackRange / kPpm, 0};
   }
 
-  const b2Vec2& b2bodyPos = _body->GetPosition();
+  const b2Vec2& b2bodyPos = _store->getPosition(_storeIdx);
 
-  // Sync the body sprite with its b2body.
-   _bodySprite->setPosition(_body->GetPosition().x * kPpm + _characterProfile.spriteOffsetX,
-                            _body->GetPosition().y * kPpm + _characterProfile.spriteOffsetY);
-
-  // Sync the equipment sprites with its b2body.
+  // Sync the equipment sprites with its b2body, unless they're hidden in the composite.
   for (int type = 0; type < static_cast<int>(Equipment::Type::SIZE); type++) {
-    if (!_equipmentSlots[type]) {
+    if (!_equipmentSlots[type] || _composite) {
       continue;
     }
 
-    if (!_isFacingRight && !_equipmentSprites[type]->isFlippedX()) {
+    if (!isFacingRight() && !_equipmentSprites[type]->isFlippedX()) {
       _equipmentSprites[type]->setFlippedX(true);
-    } else if (_isFacingRight && _equipmentSprites[type]->isFlippedX()) {
+    } else if (isFacingRight() && _equipmentSprites[type]->isFlippedX()) {
       _equipmentSprites[type]->setFlippedX(false);
     }
     _equipmentSprites[type]->setPosition(b2bodyPos.x * kPpm + _characterProfile.spriteOffsetX,
@@ -178,9 +208,7 @@ void Character::update(float delta) {
   }
 
   // Handle stats regeneration.
-  _statsRegenTimer += delta;
-  if (_statsRegenTimer >= 5.0f) {
-    _statsRegenTimer = 0;
+  if (events & CharacterStore::Event::STATS_REGEN_DUE) {
     regenHealth(_baseRegenDeltaHealth);
     regenMagicka(_baseRegenDeltaMagicka);
     regenStamina(_baseRegenDeltaStamina);
@@ -188,16 +216,13 @@ void Character::update(float delta) {
   }
 
   // Don't update character's state if he/she is using skill.
-  if (_isUsingSkill) {
+  if (isUsingSkill()) {
     return;
   }
 
-  _previousState = _currentState;
-  _currentState = getState();
-  
   // If there's a change in character's state, run the corresponding animation.
-  if (_previousState != _currentState) {
-    switch(_currentState) {
+  if (events & CharacterStore::Event::STATE_CHANGED) {
+    switch(_store->getCurrentState(_storeIdx)) {
       case State::RUNNING_SHEATHED:
         runAnimation(State::RUNNING_SHEATHED, true);
         break;
@@ -309,11 +334,16 @@ void Character::defineBody(b2BodyType bodyType,
     .setSensor(true)
     .setUserData(this)
     .buildFixture();
+
+  _store->setBody(_storeIdx, _body);
 }
 
 void Character::defineTexture(const string& bodyTextureResDir, float x, float y) {
   loadBodyAnimations(bodyTextureResDir);
   _bodySprite->setPosition(x * kPpm, y * kPpm + _characterProfile.spriteOffsetY);
+  _store->setBodySprite(_storeIdx, _bodySprite,
+                        {_characterProfile.spriteOffsetX, _characterProfile.spriteOffsetY});
+  updateComposite();
 
   runAnimation(State::IDLE_SHEATHED);
 }
@@ -361,7 +391,7 @@ void Character::loadBodyAnimations(const string& bodyTextureResDir) {
   _bodySprite->setScale(_characterProfile.spriteScaleX,
                         _characterProfile.spriteScaleY);
 
-  _bodySpritesheet = SpriteBatchNode::create(bodyTextureResDir + "/spritesheet.png");
+  _bodySpritesheet = SpriteBatchNode::create(asset_manager::getSpritesheetTexture(bodyTextureResDir));
   _bodySpritesheet->getTexture()->setAliasTexParameters();  // disable texture antialiasing
   _bodySpritesheet->addChild(_bodySprite);
 }
@@ -412,7 +442,7 @@ void Character::loadEquipmentAnimations(Equipment* equipment) {
   _equipmentSprites[type]->setScale(_characterProfile.spriteScaleX,
                                     _characterProfile.spriteScaleY);
 
-  _equipmentSpritesheets[type] = SpriteBatchNode::create(textureResDir + "/spritesheet.png");
+  _equipmentSpritesheets[type] = SpriteBatchNode::create(asset_manager::getSpritesheetTexture(textureResDir));
   _equipmentSpritesheets[type]->getTexture()->setAliasTexParameters();
   _equipmentSpritesheets[type]->addChild(_equipmentSprites[type]);
 }
@@ -446,28 +476,53 @@ Animation* Character::getEquipmentAttackAnimation(const Equipment::Type type) co
                                       _equipmentExtraAttackAnimations[type][_attackAnimationIdx - 1];
 }
 
+Animation* Character::getBodyAnimation(const State state) const {
+  if (!_composite) {
+    return (state != State::ATTACKING) ? _bodyAnimations[state] : getBodyAttackAnimation();
+  }
 
-void Character::runAnimation(State state, bool loop) {
-  // Update body animation.
-  Animate* animate = Animate::create((state != State::ATTACKING) ? _bodyAnimations[state] :
-                                                                   getBodyAttackAnimation());
-  _bodySprite->stopAllActions();
-  _bodySprite->runAction((loop) ? dynamic_cast<Action*>(RepeatForever::create(animate)) :
-                                  dynamic_cast<Action*>(Repeat::create(animate, 1)));
+  // See getCompositeLayers() for the order of the composite animations.
+  return (state != State::ATTACKING || _attackAnimationIdx == 0) ?
+      _composite->animations[state] :
+      _composite->animations[State::FORCE_UPDATE + _attackAnimationIdx - 1];
+}
 
-  // Update equipment animation.
-  for (int type = 0; type < static_cast<int>(Equipment::Type::SIZE); type++) {
-    if (!_equipmentSlots[type]) {
-      continue;
+
+void Character::runAnimation(State state, bool loop) {
+  if (GameMapManager::getInstance()->isSpriteAnimatorEnabled()) {
+    _animator.setAnimation(0, _bodySprite, getBodyAnimation(state));
+    for (int type = 0; type < static_cast<int>(Equipment::Type::SIZE); type++) {
+      _animator.setAnimation(1 + type,
+                             (_equipmentSlots[type] && !_composite) ? _equipmentSprites[type] : nullptr,
+                             (state != State::ATTACKING) ? _equipmentAnimations[type][state] :
+                             getEquipmentAttackAnimation(static_cast<Equipment::Type>(type)));
     }
+    stopSpriteActions();
+    _onAnimationFinished = nullptr;
+    _animator.play(state, loop);
+  } else {
+    _animator.stop();
+
+    // Update body animation.
+    Animate* animate = Animate::create(getBodyAnimation(state));
+    _bodySprite->stopAllActions();
+    _bodySprite->runAction((loop) ? dynamic_cast<Action*>(RepeatForever::create(animate)) :
+                                    dynamic_cast<Action*>(Repeat::create(animate, 1)));
+
+    // Update equipment animation.
+    for (int type = 0; type < static_cast<int>(Equipment::Type::SIZE); type++) {
+      if (!_equipmentSlots[type] || _composite) {
+        continue;
+      }
 
-    Animate* animate = Animate::create((state != State::ATTACKING) ?
-        _equipmentAnimations[type][state] :
-        getEquipmentAttackAnimation(static_cast<Equipment::Type>(type)));
+      Animate* animate = Animate::create((state != State::ATTACKING) ?
+          _equipmentAnimations[type][state] :
+          getEquipmentAttackAnimation(static_cast<Equipment::Type>(type)));
 
-    _equipmentSprites[type]->stopAllActions();
-    _equipmentSprites[type]->runAction((loop) ? dynamic_cast<Action*>(RepeatForever::create(animate)) :
-                                                dynamic_cast<Action*>(Repeat::create(animate, 1)));
+      _equipmentSprites[type]->stopAllActions();
+      _equipmentSprites[type]->runAction((loop) ? dynamic_cast<Action*>(RepeatForever::create(animate)) :
+                                                  dynamic_cast<Action*>(Repeat::create(animate, 1)));
+    }
   }
 
   // If `state` is ATTACKING, then increment `_attackAnimationIdx` 
@@ -477,15 +532,21 @@ void Character::runAnimation(State state, bool loop) {
   }
 }
 
-void Character::runAnimation(State state, const function<void ()>& func) const {
-  auto animate = Animate::create(_bodyAnimations[state]);
+void Character::runAnimation(State state, const function<void ()>& func) {
+  if (GameMapManager::getInstance()->isSpriteAnimatorEnabled()) {
+    runAnimation(state, false);
+    _onAnimationFinished = func;
+    return;
+  }
+
+  auto animate = Animate::create(getBodyAnimation(state));
   auto callback = CallFunc::create(func);
   _bodySprite->stopAllActions();
   _bodySprite->runAction(Sequence::createWithTwoActions(animate, callback));
 
   // Update equipment animation.
   for (int type = 0; type < static_cast<int>(Equipment::Type::SIZE); type++) {
-    if (!_equipmentSlots[type]) {
+    if (!_equipmentSlots[type] || _composite) {
       continue;
     }
 
@@ -509,12 +570,29 @@ void Character::runAnimation(const string& framesName, float interval) {
     _skillBodyAnimations.insert({framesName, bodyAnimation});
   }
 
-  _bodySprite->stopAllActions();
-  _bodySprite->runAction(Repeat::create(Animate::create(bodyAnimation), 1));
+  // The skill animations aren't composited, so the layers are drawn
+  // separately until the skill is over (see syncComposite()).
+  if (_composite) {
+    showComposite(nullptr);
+    _isCompositeDirty = true;
+  }
+
+  const bool isSpriteAnimatorEnabled = GameMapManager::getInstance()->isSpriteAnimatorEnabled();
+  if (isSpriteAnimatorEnabled) {
+    stopSpriteActions();
+    _animator.setAnimation(0, _bodySprite, bodyAnimation);
+  } else {
+    _animator.stop();
+    _bodySprite->stopAllActions();
+    _bodySprite->runAction(Repeat::create(Animate::create(bodyAnimation), 1));
+  }
 
   // Update equipment animation.
   for (int type = 0; type < static_cast<int>(Equipment::Type::SIZE); type++) {
     if (!_equipmentSlots[type]) {
+      if (isSpriteAnimatorEnabled) {
+        _animator.setAnimation(1 + type, nullptr, nullptr);
+      }
       continue;
     }
 
@@ -523,50 +601,175 @@ void Character::runAnimation(const string& framesName, float interval) {
 
     // TODO: cache these equipment skill animation
     Animation* animation = createAnimation(textureResDir, framesName, interval, fallback);
-    _equipmentSprites[type]->stopAllActions();
-    _equipmentSprites[type]->runAction(Animate::create(animation));
+    if (isSpriteAnimatorEnabled) {
+      _animator.setAnimation(1 + type, _equipmentSprites[type], animation);
+    } else {
+      _equipmentSprites[type]->stopAllActions();
+      _equipmentSprites[type]->runAction(Animate::create(animation));
+    }
+  }
+
+  if (isSpriteAnimatorEnabled) {
+    _onAnimationFinished = nullptr;
+    _animator.play(State::FORCE_UPDATE, false);
   }
 }
 
+void Character::stopSpriteActions() {
+  // In case the animations have been run with cocos2d::Actions before.
+  if (_bodySprite->getNumberOfRunningActions() > 0) {
+    _bodySprite->stopAllActions();
+  }
+  for (int type = 0; type < static_cast<int>(Equipment::Type::SIZE); type++) {
+    if (_equipmentSlots[type] && _equipmentSprites[type]->getNumberOfRunningActions() > 0) {
+      _equipmentSprites[type]->stopAllActions();
+    }
+  }
+}
 
-// FIXME: Maybe clean up this method...
-Character::State Character::getState() const {
-  if (_isSetToKill) {
-    return State::KILLED;
-  } else if (_isAttacking) {
-    return State::ATTACKING;
-  } else if (_isSheathingWeapon) {
-    return State::SHEATHING_WEAPON;
-  } else if (_isUnsheathingWeapon) {
-    return State::UNSHEATHING_WEAPON;
-  } else if (_isJumping) {
-    return (_isWeaponSheathed) ? State::JUMPING_SHEATHED : State::JUMPING_UNSHEATHED;
-  } else if (_body->GetLinearVelocity().y < -2.0f && !_isTakingDamage) {
-    return (_isWeaponSheathed) ? State::FALLING_SHEATHED : State::FALLING_UNSHEATHED;
-  } else if (_isCrouching) {
-    return (_isWeaponSheathed) ? State::CROUCHING_SHEATHED : State::CROUCHING_UNSHEATHED;
-  } else if (std::abs(_body->GetLinearVelocity().x) > .01f && !_isTakingDamage) {
-    return (_isWeaponSheathed) ? State::RUNNING_SHEATHED : State::RUNNING_UNSHEATHED;
-  // This one makes platform jumping animation smoother...
-  // but the code looks more ugly :(
-  } else if (std::abs(_body->GetLinearVelocity().y) > .01f && !_isTakingDamage) {
-    return (_isWeaponSheathed) ? State::IDLE_SHEATHED : State::IDLE_UNSHEATHED;
-  } else {
-    return (_isWeaponSheathed) ? State::IDLE_SHEATHED : State::IDLE_UNSHEATHED;
+
+void Character::updateComposite() {
+  CompositeSpriteCache* compositeSpriteCache = CompositeSpriteCache::getInstance();
+
+  // e.g., Resources/Database/character/vlad.json|Texture/equipment/short_sword|...
+  string key;
+  if (compositeSpriteCache->isEnabled() && _bodySpritesheet) {
+    bool hasEquipment = false;
+    key = _characterProfile.jsonFileName;
+    for (int type = 0; type < static_cast<int>(Equipment::Type::SIZE); type++) {
+      key += '|';
+      if (_equipmentSlots[type]) {
+        key += _equipmentSlots[type]->getItemProfile().textureResDir;
+        hasEquipment = true;
+      }
+    }
+    if (!hasEquipment) {
+      key.clear();  // nothing to flatten
+    }
+  }
+
+  if (key == _compositeKey) {
+    return;
+  }
+
+  _compositeKey = std::move(key);
+  _isCompositeDirty = true;
+  if (!_compositeKey.empty()) {
+    compositeSpriteCache->request(_compositeKey, getCompositeLayers());
+  }
+}
+
+void Character::refreshComposite() {
+  updateComposite();
+  // Unlike a loadout change, this doesn't wait until the skill is over,
+  // so that the cache can evict the composite right away.
+  if (_composite && _compositeKey.empty()) {
+    showComposite(nullptr);
+    _isCompositeDirty = false;
+  }
+}
+
+void Character::syncComposite() {
+  CompositeSpriteCache* compositeSpriteCache = CompositeSpriteCache::getInstance();
+
+  if (_composite && _composite->key != _compositeKey) {
+    showComposite(nullptr);  // the loadout has changed
+  }
+  if (_composite || _compositeKey.empty()) {
+    _isCompositeDirty = false;
+    return;
+  }
+
+  CompositeSpriteCache::Composite* composite = compositeSpriteCache->acquire(_compositeKey);
+  if (composite) {
+    showComposite(composite);
+    _isCompositeDirty = false;
+    return;
+  }
+
+  if (compositeSpriteCache->isBuilding(_compositeKey)) {
+    return;
+  }
+
+  // It may have been evicted meanwhile (e.g., during a skill animation).
+  compositeSpriteCache->request(_compositeKey, getCompositeLayers());
+  if (!compositeSpriteCache->isBuilding(_compositeKey)) {
+    _compositeKey.clear();  // it cannot be built
+    _isCompositeDirty = false;
   }
 }
 
+void Character::showComposite(CompositeSpriteCache::Composite* composite) {
+  _animator.stop();
+  _onAnimationFinished = nullptr;
+  stopSpriteActions();
+
+  // A sprite must use the same texture as its SpriteBatchNode.
+  Animation* idleAnimation = (composite) ? composite->animations[State::IDLE_SHEATHED] :
+                                           _bodyAnimations[State::IDLE_SHEATHED];
+  SpriteFrame* idleFrame = idleAnimation->getFrames().front()->getSpriteFrame();
+  _bodySpritesheet->setTexture(idleFrame->getTexture());
+  _bodySprite->setSpriteFrame(idleFrame);
+
+  for (int type = 0; type < static_cast<int>(Equipment::Type::SIZE); type++) {
+    if (!_equipmentSlots[type]) {
+      continue;
+    }
+    _equipmentSpritesheets[type]->setVisible(!composite);
+    _equipmentSprites[type]->setFlippedX(_bodySprite->isFlippedX());
+    _equipmentSprites[type]->setPosition(_bodySprite->getPosition());
+  }
 
+  if (_composite) {
+    CompositeSpriteCache::getInstance()->release(_composite);
+  }
+  _composite = composite;
+
+  // Set the current state to FORCE_UPDATE so that next time in
+  // CharacterStore::update the animation is restarted with the new sprites.
+  _store->setCurrentState(_storeIdx, State::FORCE_UPDATE);
+}
+
+vector<vector<CompositeSpriteCache::Layer>> Character::getCompositeLayers() const {
+  // The animations of each state, followed by the extra attack animations.
+  // The body is at the bottom, with the equipment drawn in the order of their
+  // graphical layers (i.e., graphical_layers::kEquipment - type) above it.
+  const size_t animationCount = State::FORCE_UPDATE + _bodyExtraAttackAnimations.size();
+  vector<vector<CompositeSpriteCache::Layer>> layers(animationCount);
+
+  for (size_t i = 0; i < animationCount; i++) {
+    const bool isExtraAttack = i >= State::FORCE_UPDATE;
+    const size_t extraAttackIdx = i - State::FORCE_UPDATE;
+
+    layers[i].push_back({_characterProfile.textureResDir,
+                         (isExtraAttack) ? _bodyExtraAttackAnimations[extraAttackIdx] :
+                                           _bodyAnimations[i]});
+
+    for (int type = static_cast<int>(Equipment::Type::SIZE) - 1; type >= 0; type--) {
+      if (!_equipmentSlots[type]) {
+        continue;
+      }
+      layers[i].push_back({_equipmentSlots[type]->getItemProfile().textureResDir,
+                           (isExtraAttack) ? _equipmentExtraAttackAnimations[type][extraAttackIdx] :
+                                             _equipmentAnimations[type][i]});
+    }
+  }
+  return layers;
+}
+
+
+// FIXME: Maybe clean up this method...
 void Character::onKilled() {
-  _isKilled = true;
+  setFlag(CharacterStore::Flag::KILLED, true);
   GameMapManager::getInstance()->getWorld()->DestroyBody(_body);
+  _store->setBody(_storeIdx, nullptr);
 }
 
 
 void Character::moveLeft() {
-  _isFacingRight = false;
+  setFlag(CharacterStore::Flag::FACING_RIGHT, false);
 
-  if (_isCrouching) {
+  if (isCrouching()) {
     return;
   }
 
@@ -576,9 +779,9 @@ void Character::moveLeft() {
 }
 
 void Character::moveRight() {
-  _isFacingRight = true;
+  setFlag(CharacterStore::Flag::FACING_RIGHT, true);
 
-  if (_isCrouching) {
+  if (isCrouching()) {
     return;
   }
 
@@ -593,14 +796,14 @@ void Character::jump() {
   // 2. This character cannot double jump, and it has already jumped.
   // 3. This character can double jump, and it has already double jumped.
   if (_isJumpingDisallowed ||
-      (!_characterProfile.canDoubleJump && _isJumping) ||
+      (!_characterProfile.canDoubleJump && isJumping()) ||
       (_characterProfile.canDoubleJump && _isDoubleJumping)) {
     return;
   }
 
-  if (_isJumping) {
+  if (isJumping()) {
     _isDoubleJumping = true;
-    runAnimation((_isWeaponSheathed) ? State::JUMPING_SHEATHED : State::JUMPING_UNSHEATHED, false);
+    runAnimation((isWeaponSheathed()) ? State::JUMPING_SHEATHED : State::JUMPING_UNSHEATHED, false);
     // Set velocity.y to 0.
     const b2Vec2& velocity = _body->GetLinearVelocity();
     _body->SetLinearVelocity({velocity.x, 0});
@@ -611,7 +814,7 @@ void Character::jump() {
       _isJumpingDisallowed = false;
   }, .2f);
 
-  _isJumping = true;
+  setFlag(CharacterStore::Flag::JUMPING, true);
   _body->ApplyLinearImpulse({0, _characterProfile.jumpHeight}, _body->GetWorldCenter(), true);
 }
 
@@ -636,29 +839,29 @@ void Character::jumpDown() {
 }
 
 void Character::crouch() {
-  _isCrouching = true;
+  setFlag(CharacterStore::Flag::CROUCHING, true);
 }
 
 void Character::getUp() {
-  _isCrouching = false;
+  setFlag(CharacterStore::Flag::CROUCHING, false);
 }
 
 
 void Character::sheathWeapon() {
-  _isSheathingWeapon = true;
+  setFlag(CharacterStore::Flag::SHEATHING_WEAPON, true);
 
   CallbackManager::getInstance()->runAfter([this]() {
-    _isSheathingWeapon = false;
-    _isWeaponSheathed = true;
+    setFlag(CharacterStore::Flag::SHEATHING_WEAPON, false);
+    setFlag(CharacterStore::Flag::WEAPON_SHEATHED, true);
   }, .8f);
 }
 
 void Character::unsheathWeapon() {
-  _isUnsheathingWeapon = true;
+  setFlag(CharacterStore::Flag::UNSHEATHING_WEAPON, true);
 
   CallbackManager::getInstance()->runAfter([this]() {
-    _isUnsheathingWeapon = false;
-    _isWeaponSheathed = false;
+    setFlag(CharacterStore::Flag::UNSHEATHING_WEAPON, false);
+    setFlag(CharacterStore::Flag::WEAPON_SHEATHED, false);
   }, .8f);
 }
 
@@ -666,18 +869,18 @@ void Character::attack() {
   // If character is still attacking, block this attack request.
   // The latter condition prevents the character from being stucked in an
   // attack animation when the user calls Character::attack() too frequently.
-  if (_isAttacking || _currentState == State::ATTACKING) {
+  if (isAttacking() || _store->getCurrentState(_storeIdx) == State::ATTACKING) {
     return;
   }
-  if (_isWeaponSheathed) {
+  if (isWeaponSheathed()) {
     unsheathWeapon();
     return;
   }
 
-  _isAttacking = true;
+  setFlag(CharacterStore::Flag::ATTACKING, true);
 
   CallbackManager::getInstance()->runAfter([this]() {
-    _isAttacking = false;
+    setFlag(CharacterStore::Flag::ATTACKING, false);
   }, _characterProfile.attackTime);
 
 
@@ -691,7 +894,7 @@ void Character::attack() {
 
       CallbackManager::getInstance()->runAfter([this]() {
           inflictDamage(_lockedOnTarget, getDamageOutput());
-          float knockBackForceX = (_isFacingRight) ? .5f : -.5f; // temporary
+          float knockBackForceX = (isFacingRight()) ? .5f : -.5f; // temporary
           float knockBackForceY = 1.0f; // temporary
           knockBack(_lockedOnTarget, knockBackForceX, knockBackForceY);
       }, damageDelay);
@@ -703,18 +906,18 @@ void Character::activateSkill(Skill* skill) {
   // If this character is still using another skill, or
   // if it doesn't meet the criteria of activating this skill,
   // then return at once.
-  if (_isUsingSkill || !skill->canActivate()) {
+  if (isUsingSkill() || !skill->canActivate()) {
     return;
   }
 
-  _isUsingSkill = true;
+  setFlag(CharacterStore::Flag::USING_SKILL, true);
   _currentlyUsedSkill = skill;
 
   CallbackManager::getInstance()->runAfter([this]() {
-    _isUsingSkill = false;
-    // Set _currentState to FORCE_UPDATE so that next time in
-    // Character::update the animation is guaranteed to be updated.
-    _currentState = State::FORCE_UPDATE;
+    setFlag(CharacterStore::Flag::USING_SKILL, false);
+    // Set the current state to FORCE_UPDATE so that next time in
+    // CharacterStore::update the animation is guaranteed to be updated.
+    _store->setCurrentState(_storeIdx, State::FORCE_UPDATE);
   }, skill->getSkillProfile().framesDuration);
 
   if (skill->getSkillProfile().characterFramesName != "") {
@@ -754,9 +957,9 @@ void Character::receiveDamage(Character* source, int damage) {
 
   _characterProfile.health -= damage;
 
-  _isTakingDamage = true;
+  setFlag(CharacterStore::Flag::TAKING_DAMAGE, true);
   CallbackManager::getInstance()->runAfter([this]() {
-    _isTakingDamage = false;
+    setFlag(CharacterStore::Flag::TAKING_DAMAGE, false);
   }, .25f);
   
   if (_characterProfile.health <= 0) {
@@ -771,7 +974,7 @@ void Character::receiveDamage(Character* source, int damage) {
     }
 
     DynamicActor::setCategoryBits(_fixtures[FixtureType::BODY], category_bits::kDestroyed);
-    _isSetToKill = true;
+    setFlag(CharacterStore::Flag::SET_TO_KILL, true);
     // TODO: play killed sound.
   } else {
     // TODO: play hurt sound.
@@ -805,6 +1008,10 @@ void Character::addItem(shared_ptr<Item> item, int amount) {
   }
 
   _inventory[existingItemObj->getItemProfile().itemType].insert(existingItemObj);
+
+  if (this == GameMapManager::getInstance()->getPlayer()) {
+    SaveJournal::getInstance()->recordItemAdded(existingItemObj->getItemProfile().jsonFileName, amount);
+  }
 }
 
 void Character::removeItem(Item* item, int amount) {
@@ -815,6 +1022,10 @@ void Character::removeItem(Item* item, int amount) {
     return;
   }
 
+  if (this == GameMapManager::getInstance()->getPlayer()) {
+    SaveJournal::getInstance()->recordItemRemoved(existingItemObj->getItemProfile().jsonFileName, amount);
+  }
+
   existingItemObj->setAmount(existingItemObj->getAmount() - amount);
 
   if (existingItemObj->getAmount() <= 0) {
@@ -871,6 +1082,11 @@ void Character::useItem(Consumable* consumable) {
 }
 
 void Character::equip(Equipment* equipment) {
+  if (this == GameMapManager::getInstance()->getPlayer()) {
+    SaveJournal::getInstance()->recordItemEquipped(equipment->getItemProfile().jsonFileName);
+  }
+  SaveJournal::ScopedSuppression suppression;
+
   // If there's already an equipment in that slot, unequip it first.
   Equipment::Type type = equipment->getEquipmentProfile().equipmentType;
   if (_equipmentSlots[type]) {
@@ -881,7 +1097,9 @@ void Character::equip(Equipment* equipment) {
 
   // Load equipment animations.
   loadEquipmentAnimations(equipment);
-  GameMapManager::getInstance()->getLayer()->addChild(_equipmentSpritesheets[type], graphical_layers::kEquipment - type);
+  GameMapManager::getInstance()->getGraphicalLayer(graphical_layers::kEquipment - type)->addChild(
+      _equipmentSpritesheets[type]);
+  updateComposite();
 }
 
 void Character::unequip(Equipment::Type equipmentType) {
@@ -891,14 +1109,21 @@ void Character::unequip(Equipment::Type equipmentType) {
     return;
   }
 
+  if (this == GameMapManager::getInstance()->getPlayer()) {
+    SaveJournal::getInstance()->recordItemUnequipped(equipmentType);
+  }
+  SaveJournal::ScopedSuppression suppression;
+
   if (equipmentType == Equipment::Type::WEAPON) {
     sheathWeapon();
   }
 
   Equipment* e = _equipmentSlots[equipmentType];
   _equipmentSlots[equipmentType] = nullptr;
+  _animator.setAnimation(1 + equipmentType, nullptr, nullptr);
   addItem(_itemMapper.find(e->getItemProfile().name)->second, 1);
-  GameMapManager::getInstance()->getLayer()->removeChild(_equipmentSpritesheets[equipmentType]);
+  _equipmentSpritesheets[equipmentType]->removeFromParent();
+  updateComposite();
 }
 
 void Character::pickupItem(Item* item) {
@@ -972,11 +1197,11 @@ void Character::removeGold(const int amount) {
 
 
 bool Character::isFacingRight() const {
-  return _isFacingRight;
+  return hasFlag(CharacterStore::Flag::FACING_RIGHT);
 }
 
 bool Character::isJumping() const {
-  return _isJumping;
+  return hasFlag(CharacterStore::Flag::JUMPING);
 }
 
 bool Character::isDoubleJumping() const {
@@ -988,15 +1213,15 @@ bool Character::isOnPlatform() const {
 }
 
 bool Character::isAttacking() const {
-  return _isAttacking;
+  return hasFlag(CharacterStore::Flag::ATTACKING);
 }
 
 bool Character::isUsingSkill() const {
-  return _isUsingSkill;
+  return hasFlag(CharacterStore::Flag::USING_SKILL);
 }
 
 bool Character::isCrouching() const {
-  return _isCrouching;
+  return hasFlag(CharacterStore::Flag::CROUCHING);
 }
 
 bool Character::isInvincible() const {
@@ -1004,28 +1229,28 @@ bool Character::isInvincible() const {
 }
 
 bool Character::isKilled() const {
-  return _isKilled;
+  return hasFlag(CharacterStore::Flag::KILLED);
 }
 
 bool Character::isSetToKill() const {
-  return _isSetToKill;
+  return hasFlag(CharacterStore::Flag::SET_TO_KILL);
 }
 
 bool Character::isWeaponSheathed() const {
-  return _isWeaponSheathed;
+  return hasFlag(CharacterStore::Flag::WEAPON_SHEATHED);
 }
 
 bool Character::isSheathingWeapon() const {
-  return _isSheathingWeapon;
+  return hasFlag(CharacterStore::Flag::SHEATHING_WEAPON);
 }
 
 bool Character::isUnsheathingWeapon() const {
-  return _isUnsheathingWeapon;
+  return hasFlag(CharacterStore::Flag::UNSHEATHING_WEAPON);
 }
 
 
 void Character::setJumping(bool jumping) {
-  _isJumping = jumping;
+  setFlag(CharacterStore::Flag::JUMPING, jumping);
 }
 
 void Character::setDoubleJumping(bool doubleJumping) {
@@ -1037,15 +1262,15 @@ void Character::setOnPlatform(bool onPlatform) {
 }
 
 void Character::setAttacking(bool attacking) {
-  _isAttacking = attacking;
+  setFlag(CharacterStore::Flag::ATTACKING, attacking);
 }
 
 void Character::setUsingSkill(bool usingSkill) {
-  _isUsingSkill = usingSkill;
+  setFlag(CharacterStore::Flag::USING_SKILL, usingSkill);
 }
 
 void Character::setCrouching(bool crouching) {
-  _isCrouching = crouching;
+  setFlag(CharacterStore::Flag::CROUCHING, crouching);
 }
 
 void Character::setInvincible(bool invincible) {
@@ -1053,6 +1278,15 @@ void Character::setInvincible(bool invincible) {
 }
 
 
+bool Character::hasFlag(CharacterStore::Flag flag) const {
+  return _store->hasFlag(_storeIdx, flag);
+}
+
+void Character::setFlag(CharacterStore::Flag flag, bool value) {
+  _store->setFlag(_storeIdx, flag, value);
+}
+
+
 Character::Profile& Character::getCharacterProfile() {
   return _characterProfile;
 }
@@ -1179,7 +1413,7 @@ int Character::getDamageOutput() const {
     output += weapon->getEquipmentProfile().bonusPhysicalDamage;
   }
 
-  return output + rand_util::randInt(-5, 5); // temporary
+  return output + rand_util::randInt(rand_util::COMBAT, -5, 5); // temporary
 }
 
 
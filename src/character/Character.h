@@ -15,8 +15,11 @@
 #include <Box2D/Box2D.h>
 #include "DynamicActor.h"
 #include "Importable.h"
+#include "CompositeSpriteCache.h"
 #include "Interactable.h"
+#include "SpriteAnimator.h"
 #include "character/Party.h"
+#include "CharacterStore.h"
 #include "item/Item.h"
 #include "item/Equipment.h"
 #include "item/Consumable.h"
@@ -84,7 +87,7 @@ class Character : public DynamicActor, public Importable {
     FIXTURE_SIZE
   };
 
-  virtual ~Character() = default;
+  virtual ~Character();
 
   virtual bool showOnMap(float x, float y) override = 0;  // DynamicActor
   virtual bool removeFromMap() override;  // DynamicActor
@@ -180,6 +183,10 @@ class Character : public DynamicActor, public Importable {
   void setParty(std::shared_ptr<Party> party);
 
   int getDamageOutput() const;
+
+  // Re-evaluates the composite after CompositeSpriteCache has been
+  // enabled or disabled. Disabling it releases the composite right away.
+  void refreshComposite();
   
 
  protected:
@@ -227,43 +234,46 @@ class Character : public DynamicActor, public Importable {
   cocos2d::Animation* getBodyAttackAnimation() const;
   cocos2d::Animation* getEquipmentAttackAnimation(const Equipment::Type type) const;
 
+  // Either with `_animator`, or with cocos2d::Actions as before
+  // (see GameMapManager::setSpriteAnimatorEnabled()).
   void runAnimation(Character::State state, bool loop=true);
-  void runAnimation(Character::State state, const std::function<void ()>& func) const;
+  void runAnimation(Character::State state, const std::function<void ()>& func);
   void runAnimation(const std::string& framesName, float interval);
+  void stopSpriteActions();
+  // The body animation of `state`, or its composite if the equipment is flattened into it.
+  cocos2d::Animation* getBodyAnimation(Character::State state) const;
+
+  // Requests the composite of the current loadout (see CompositeSpriteCache),
+  // which syncComposite() switches to once it has been built.
+  void updateComposite();
+  void syncComposite();
+  void showComposite(CompositeSpriteCache::Composite* composite);
+  std::vector<std::vector<CompositeSpriteCache::Layer>> getCompositeLayers() const;
 
-  Character::State getState() const;
+  // The flags which have no public setters. See CharacterStore::Flag.
+  bool hasFlag(CharacterStore::Flag flag) const;
+  void setFlag(CharacterStore::Flag flag, bool value);
 
 
   // Characater data.
   Character::Profile _characterProfile;
 
-  // Stats regen timer
-  float _statsRegenTimer;
+  // The hot per-frame state of this character, i.e., most of its flags, its
+  // state and its stats regen timer, lives in `_store` at `_storeIdx`.
+  // Please see CharacterStore::update() and Character::update() for the logic.
+  CharacterStore* _store;
+  size_t _storeIdx;  // updated by CharacterStore::remove()
+
+  // Stats regen
   const int _baseRegenDeltaHealth;
   const int _baseRegenDeltaMagicka;
   const int _baseRegenDeltaStamina;
 
-  // The following variables are used to determine the character's state
-  // and run the corresponding animations. Please see Character::update()
-  // for the logic.
-  Character::State _currentState;
-  Character::State _previousState;
-
-  bool _isFacingRight;
-  bool _isWeaponSheathed;
-  bool _isSheathingWeapon;
-  bool _isUnsheathingWeapon;
+  // The flags which aren't needed by CharacterStore::update().
   bool _isJumpingDisallowed;
-  bool _isJumping;
   bool _isDoubleJumping;
   bool _isOnPlatform;
-  bool _isAttacking;
-  bool _isUsingSkill;
-  bool _isCrouching;
   bool _isInvincible;
-  bool _isTakingDamage;
-  bool _isKilled;
-  bool _isSetToKill;
 
   // The following variables are used to determine combat targets.
   // A character can only inflict damage to another iff the target is
@@ -319,11 +329,25 @@ class Character : public DynamicActor, public Importable {
   // Skill animations
   std::unordered_map<std::string, cocos2d::Animation*> _skillBodyAnimations;
 
+  // Plays the animations of the body (layer 0) and equipment (layer 1 + type) in lockstep.
+  SpriteAnimator _animator;
+  // Called once the current non-looping animation has finished (e.g., KILLED).
+  std::function<void ()> _onAnimationFinished;
+
+  // The body and equipment flattened into one sprite,
+  // or nullptr if they're drawn separately.
+  CompositeSpriteCache::Composite* _composite;
+  std::string _compositeKey;  // of the composite to be shown, or empty
+  bool _isCompositeDirty;  // if `_composite` doesn't match `_compositeKey` yet
+
   // Party
   // A character can either:
   // (1) be a leader who has a set of allies/followers, or
   // (2) be a follower of other character
   std::shared_ptr<Party> _party;
+
+  // Evaluates the state machine, and updates `_storeIdx`.
+  friend class CharacterStore;
 };
 
 }  // namespace vigilante
@@ -0,0 +1,193 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "CharacterStore.h"
+
+#include <cmath>
+
+#include "Character.h"
+#include "Constants.h"
+
+#define STATS_REGEN_INTERVAL 5.0f
+
+using cocos2d::Vec2;
+using cocos2d::Sprite;
+
+namespace vigilante {
+
+CharacterStore::CharacterStore()
+    : _owners(),
+      _bodies(),
+      _positions(),
+      _velocities(),
+      _bodySprites(),
+      _spriteOffsets(),
+      _flags(),
+      _currentStates(),
+      _statsRegenTimers(),
+      _events() {}
+
+
+void CharacterStore::update(float delta) {
+  const size_t size = _owners.size();
+
+  // Read the b2bodies once, so that the loops below
+  // don't have to chase the pointers again.
+  for (size_t i = 0; i < size; i++) {
+    if (_bodies[i]) {
+      _positions[i] = _bodies[i]->GetPosition();
+      _velocities[i] = _bodies[i]->GetLinearVelocity();
+    }
+  }
+
+  // Sync the body sprites with their b2bodies.
+  for (size_t i = 0; i < size; i++) {
+    if (_bodies[i] && _bodySprites[i]) {
+      _bodySprites[i]->setPosition(_positions[i].x * kPpm + _spriteOffsets[i].x,
+                                   _positions[i].y * kPpm + _spriteOffsets[i].y);
+    }
+  }
+
+  // Handle stats regeneration.
+  for (size_t i = 0; i < size; i++) {
+    if (!_bodies[i] || (_flags[i] & Flag::KILLED)) {
+      continue;
+    }
+    _statsRegenTimers[i] += delta;
+    if (_statsRegenTimers[i] >= STATS_REGEN_INTERVAL) {
+      _statsRegenTimers[i] = 0;
+      _events[i] |= Event::STATS_REGEN_DUE;
+    }
+  }
+
+  // Evaluate the state machines. A Character's state is frozen while it's using a skill.
+  for (size_t i = 0; i < size; i++) {
+    if (!_bodies[i] || (_flags[i] & (Flag::KILLED | Flag::USING_SKILL))) {
+      continue;
+    }
+    const uint8_t state = evaluateState(_flags[i], _velocities[i]);
+    if (state != _currentStates[i]) {
+      _currentStates[i] = state;
+      _events[i] |= Event::STATE_CHANGED;
+    }
+  }
+}
+
+uint8_t CharacterStore::evaluateState(uint16_t flags, const b2Vec2& velocity) {
+  const bool isWeaponSheathed = flags & Flag::WEAPON_SHEATHED;
+  const bool isTakingDamage = flags & Flag::TAKING_DAMAGE;
+
+  if (flags & Flag::SET_TO_KILL) {
+    return Character::State::KILLED;
+  } else if (flags & Flag::ATTACKING) {
+    return Character::State::ATTACKING;
+  } else if (flags & Flag::SHEATHING_WEAPON) {
+    return Character::State::SHEATHING_WEAPON;
+  } else if (flags & Flag::UNSHEATHING_WEAPON) {
+    return Character::State::UNSHEATHING_WEAPON;
+  } else if (flags & Flag::JUMPING) {
+    return (isWeaponSheathed) ? Character::State::JUMPING_SHEATHED : Character::State::JUMPING_UNSHEATHED;
+  } else if (velocity.y < -2.0f && !isTakingDamage) {
+    return (isWeaponSheathed) ? Character::State::FALLING_SHEATHED : Character::State::FALLING_UNSHEATHED;
+  } else if (flags & Flag::CROUCHING) {
+    return (isWeaponSheathed) ? Character::State::CROUCHING_SHEATHED : Character::State::CROUCHING_UNSHEATHED;
+  } else if (std::abs(velocity.x) > .01f && !isTakingDamage) {
+    return (isWeaponSheathed) ? Character::State::RUNNING_SHEATHED : Character::State::RUNNING_UNSHEATHED;
+  } else {
+    return (isWeaponSheathed) ? Character::State::IDLE_SHEATHED : Character::State::IDLE_UNSHEATHED;
+  }
+}
+
+
+size_t CharacterStore::add(Character* owner) {
+  _owners.push_back(owner);
+  _bodies.push_back(nullptr);
+  _positions.push_back({0, 0});
+  _velocities.push_back({0, 0});
+  _bodySprites.push_back(nullptr);
+  _spriteOffsets.push_back(Vec2::ZERO);
+  _flags.push_back(Flag::FACING_RIGHT | Flag::WEAPON_SHEATHED);
+  _currentStates.push_back(Character::State::IDLE_SHEATHED);
+  _statsRegenTimers.push_back(0);
+  _events.push_back(0);
+  return _owners.size() - 1;
+}
+
+void CharacterStore::remove(size_t idx) {
+  const size_t last = _owners.size() - 1;
+
+  if (idx != last) {
+    _owners[idx] = _owners[last];
+    _bodies[idx] = _bodies[last];
+    _positions[idx] = _positions[last];
+    _velocities[idx] = _velocities[last];
+    _bodySprites[idx] = _bodySprites[last];
+    _spriteOffsets[idx] = _spriteOffsets[last];
+    _flags[idx] = _flags[last];
+    _currentStates[idx] = _currentStates[last];
+    _statsRegenTimers[idx] = _statsRegenTimers[last];
+    _events[idx] = _events[last];
+    _owners[idx]->_storeIdx = idx;
+  }
+
+  _owners.pop_back();
+  _bodies.pop_back();
+  _positions.pop_back();
+  _velocities.pop_back();
+  _bodySprites.pop_back();
+  _spriteOffsets.pop_back();
+  _flags.pop_back();
+  _currentStates.pop_back();
+  _statsRegenTimers.pop_back();
+  _events.pop_back();
+}
+
+
+void CharacterStore::setBody(size_t idx, b2Body* body) {
+  _bodies[idx] = body;
+  if (body) {
+    _positions[idx] = body->GetPosition();
+    _velocities[idx] = body->GetLinearVelocity();
+  }
+}
+
+void CharacterStore::setBodySprite(size_t idx, Sprite* bodySprite, const Vec2& spriteOffset) {
+  _bodySprites[idx] = bodySprite;
+  _spriteOffsets[idx] = spriteOffset;
+}
+
+bool CharacterStore::hasFlag(size_t idx, CharacterStore::Flag flag) const {
+  return _flags[idx] & flag;
+}
+
+void CharacterStore::setFlag(size_t idx, CharacterStore::Flag flag, bool value) {
+  _flags[idx] = (value) ? (_flags[idx] | flag) : (_flags[idx] & ~flag);
+}
+
+uint8_t CharacterStore::getCurrentState(size_t idx) const {
+  return _currentStates[idx];
+}
+
+void CharacterStore::setCurrentState(size_t idx, uint8_t state) {
+  _currentStates[idx] = state;
+}
+
+uint8_t CharacterStore::getEvents(size_t idx) const {
+  return _events[idx];
+}
+
+void CharacterStore::clearEvents(size_t idx) {
+  _events[idx] = 0;
+}
+
+const b2Vec2& CharacterStore::getPosition(size_t idx) const {
+  return _positions[idx];
+}
+
+Character* CharacterStore::getOwner(size_t idx) const {
+  return _owners[idx];
+}
+
+size_t CharacterStore::getSize() const {
+  return _owners.size();
+}
+
+}  // namespace vigilante
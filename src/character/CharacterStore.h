@@ -0,0 +1,97 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_CHARACTER_STORE_H_
+#define VIGILANTE_CHARACTER_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <cocos2d.h>
+#include <Box2D/Box2D.h>
+
+namespace vigilante {
+
+class Character;
+
+// The hot per-frame state of all Characters, stored as a structure of arrays.
+//
+// Every frame, update() syncs the body sprites with the b2bodies, advances
+// the stats regen timers and evaluates the state machines in tight loops over
+// these arrays, instead of visiting each Character (and its strings, maps
+// and sprites) in turn. Character::update() then only has to handle the
+// Characters whose state has changed or whose stats are due to regenerate.
+//
+// Character remains the gameplay-facing API: its getters and setters
+// (e.g., isJumping(), setAttacking()) read and write the arrays here.
+class CharacterStore {
+ public:
+  // The boolean state of a Character, packed into one word per Character.
+  enum Flag : uint16_t {
+    FACING_RIGHT       = 1 << 0,
+    WEAPON_SHEATHED    = 1 << 1,
+    SHEATHING_WEAPON   = 1 << 2,
+    UNSHEATHING_WEAPON = 1 << 3,
+    JUMPING            = 1 << 4,
+    ATTACKING          = 1 << 5,
+    USING_SKILL        = 1 << 6,
+    CROUCHING          = 1 << 7,
+    TAKING_DAMAGE      = 1 << 8,
+    SET_TO_KILL        = 1 << 9,
+    KILLED             = 1 << 10
+  };
+
+  // What update() has found out about a Character. Events stay pending
+  // until Character::update() handles them and calls clearEvents().
+  enum Event : uint8_t {
+    STATE_CHANGED = 1 << 0,
+    STATS_REGEN_DUE = 1 << 1
+  };
+
+  CharacterStore();
+  virtual ~CharacterStore() = default;
+
+  void update(float delta);
+
+  // @return the index of the new entry. The entry of the last Character
+  //         is moved into the removed one's slot, so a Character's index
+  //         may change (see Character::_storeIdx).
+  size_t add(Character* owner);
+  void remove(size_t idx);
+
+  // The body sprite is synced with `body` only if both are set.
+  void setBody(size_t idx, b2Body* body);
+  void setBodySprite(size_t idx, cocos2d::Sprite* bodySprite, const cocos2d::Vec2& spriteOffset);
+
+  bool hasFlag(size_t idx, CharacterStore::Flag flag) const;
+  void setFlag(size_t idx, CharacterStore::Flag flag, bool value);
+
+  uint8_t getCurrentState(size_t idx) const;
+  void setCurrentState(size_t idx, uint8_t state);
+
+  uint8_t getEvents(size_t idx) const;
+  void clearEvents(size_t idx);
+
+  // The position of the b2body as of the last update().
+  const b2Vec2& getPosition(size_t idx) const;
+
+  Character* getOwner(size_t idx) const;
+  size_t getSize() const;
+
+ private:
+  static uint8_t evaluateState(uint16_t flags, const b2Vec2& velocity);
+
+  std::vector<Character*> _owners;
+  std::vector<b2Body*> _bodies;
+  std::vector<b2Vec2> _positions;
+  std::vector<b2Vec2> _velocities;
+  std::vector<cocos2d::Sprite*> _bodySprites;
+  std::vector<cocos2d::Vec2> _spriteOffsets;
+  std::vector<uint16_t> _flags;
+  std::vector<uint8_t> _currentStates;  // Character::State
+  std::vector<float> _statsRegenTimers;
+  std::vector<uint8_t> _events;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_CHARACTER_STORE_H_
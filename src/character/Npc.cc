@@ -9,9 +9,11 @@
 #include "CallbackManager.h"
 #include "Constants.h"
 #include "character/Player.h"
+#include "gameplay/SaveJournal.h"
 #include "item/Item.h"
 #include "map/GameMapManager.h"
 #include "map/FxManager.h"
+#include "map/NavGraph.h"
 #include "quest/KillTargetObjective.h"
 #include "quest/CollectItemObjective.h"
 #include "ui/WindowManager.h"
@@ -35,6 +37,11 @@
 
 #define ALLY_FOLLOW_DISTANCE .75f
 
+// How close (horizontally) an Npc has to be to the next node of its path.
+#define PATH_NODE_ARRIVAL_DISTANCE .1f
+// Leave some margin, since Npcs don't always jump at the very edge.
+#define JUMP_HEIGHT_SAFETY_FACTOR .9f
+
 using std::atomic;
 using std::string;
 using std::vector;
@@ -80,6 +87,9 @@ Npc::Npc(const string& jsonFileName)
       _disposition(_npcProfile.disposition),
       _isSandboxing(_npcProfile.shouldSandbox),
       _hintBubbleFxSprite(),
+      _intent(),
+      _hasIntent(),
+      _aiRng(rand_util::fork(rand_util::AI)),
       _isMovingRight(),
       _moveDuration(),
       _moveTimer(),
@@ -95,7 +105,7 @@ Npc::Npc(const string& jsonFileName)
 void Npc::update(float delta) {
   Character::update(delta);
 
-  if (!_isShownOnMap || _isKilled) {
+  if (!_isShownOnMap || isKilled()) {
     return;
   }
 
@@ -107,12 +117,16 @@ void Npc::update(float delta) {
   }
 
   if (_areNpcsAllowedToAct) {
-    act(delta);
+    // Unless GameMapManager has made all Npcs think in parallel already.
+    if (!_hasIntent) {
+      think(delta);
+    }
+    act();
   }
 }
 
 bool Npc::showOnMap(float x, float y) {
-  if (_isShownOnMap || _isKilled) {
+  if (_isShownOnMap || isKilled()) {
     return false;
   }
 
@@ -127,11 +141,11 @@ bool Npc::showOnMap(float x, float y) {
   // Load sprites, spritesheets, and animations, and then add them to GameMapManager layer.
   defineTexture(_characterProfile.textureResDir, x, y);
   GameMapManager* gmMgr = GameMapManager::getInstance();
-  gmMgr->getLayer()->addChild(_bodySpritesheet, graphical_layers::kNpcBody);
+  gmMgr->getGraphicalLayer(graphical_layers::kNpcBody)->addChild(_bodySpritesheet);
   for (auto equipment : _equipmentSlots) {
     if (equipment) {
       Equipment::Type type = equipment->getEquipmentProfile().equipmentType;
-      gmMgr->getLayer()->addChild(_equipmentSpritesheets[type], graphical_layers::kEquipment - type);
+      gmMgr->getGraphicalLayer(graphical_layers::kEquipment - type)->addChild(_equipmentSpritesheets[type]);
     }
   }
 
@@ -180,6 +194,8 @@ void Npc::onKilled() {
   if (!_npcProfile.isRespawnable) {
     Npc::setNpcAllowedToSpawn(_characterProfile.jsonFileName, false);
   }
+  SaveJournal::getInstance()->recordNpcKilled(_characterProfile.jsonFileName,
+                                              !_npcProfile.isRespawnable);
 }
 
 
@@ -201,7 +217,7 @@ void Npc::receiveDamage(Character* source, int damage) {
   _isAlerted = true;
 
 
-  if (!_isSetToKill) {
+  if (!isSetToKill()) {
     return;
   }
 
@@ -216,11 +232,11 @@ void Npc::receiveDamage(Character* source, int damage) {
       const string& itemJson = i.first;
       float dropChance = i.second.chance;
 
-      float randChance = rand_util::randInt(0, 100);
+      float randChance = rand_util::randInt(rand_util::LOOT, 0, 100);
       if (randChance <= dropChance) {
         float x = _body->GetPosition().x;
         float y = _body->GetPosition().y;
-        int amount = rand_util::randInt(i.second.minAmount, i.second.maxAmount);
+        int amount = rand_util::randInt(rand_util::LOOT, i.second.minAmount, i.second.maxAmount);
         GameMapManager::getInstance()->getGameMap()->createItem(itemJson, x * kPpm, y * kPpm, amount);
       }
     }
@@ -282,7 +298,11 @@ void Npc::updateDialogueTreeIfNeeded() {
   string latestDialogueTreeJsonFileName
     = DialogueTree::getLatestNpcDialogueTree(_characterProfile.jsonFileName);
 
+  // If there's none (e.g., an update has been rolled back), use the original one.
   if (latestDialogueTreeJsonFileName.empty()) {
+    latestDialogueTreeJsonFileName = _npcProfile.dialogueTreeJsonFile;
+  }
+  if (latestDialogueTreeJsonFileName == _dialogueTree.getJsonFileName()) {
     return;
   }
 
@@ -300,6 +320,15 @@ void Npc::beginDialogue() {
 
   auto dialogueMgr = DialogueManager::getInstance();
   dialogueMgr->setTargetNpc(this);
+  if (!_dialogueTree.getCurrentNode()) {
+    _dialogueTree.resetCurrentNode();
+  }
+
+  // Load the quests this dialogue may start while its lines are being shown.
+  if (auto player = GameMapManager::getInstance()->getPlayer()) {
+    player->getQuestBook().preloadInBackground(_dialogueTree.getQuestJsonFileNames());
+  }
+
   for (const auto& line : _dialogueTree.getCurrentNode()->getLines()) {
     dialogueMgr->getSubtitles()->addSubtitle(line);
   }
@@ -323,10 +352,14 @@ void Npc::onDialogueEnd() {
 }
 
 
-void Npc::act(float delta) {
-  if (_isKilled || _isSetToKill || _isAttacking) {
+void Npc::think(float delta) {
+  _intent = Npc::Intent();
+  _hasIntent = false;
+
+  if (!_areNpcsAllowedToAct || !_isShownOnMap || isKilled() || isSetToKill() || isAttacking()) {
     return;
   }
+  _hasIntent = true;
 
 
   // This Npc may perform one of the following actions:
@@ -342,15 +375,13 @@ void Npc::act(float delta) {
   if (_lockedOnTarget && !_lockedOnTarget->isSetToKill()) {
 
     if (!_inRangeTargets.empty()) {  // target is within attack range
-      attack();
+      _intent.shouldAttack = true;
     } else {  // target not within attack range
       moveToTarget(delta, _lockedOnTarget, _characterProfile.attackRange / kPpm);
     }
 
   } else if (_lockedOnTarget && _lockedOnTarget->isSetToKill()) {
-    Character* killedTarget = _lockedOnTarget;
-    setLockedOnTarget(nullptr);
-    findNewLockedOnTargetFromParty(killedTarget);
+    _intent.shouldFindNewLockedOnTarget = true;
   } else if (_party && !isWaitingForPlayer()) {
     moveToTarget(delta, _party->getLeader(), ALLY_FOLLOW_DISTANCE);
   } else if (_isSandboxing) {
@@ -358,6 +389,41 @@ void Npc::act(float delta) {
   }
 }
 
+void Npc::act() {
+  if (!_hasIntent) {
+    return;
+  }
+  _hasIntent = false;
+
+  if (_intent.shouldFindNewLockedOnTarget) {
+    Character* killedTarget = _lockedOnTarget;
+    setLockedOnTarget(nullptr);
+    findNewLockedOnTargetFromParty(killedTarget);
+  }
+
+  if (_intent.shouldAttack) {
+    attack();
+  }
+
+  if (_intent.faceDirection != 0) {
+    setFlag(CharacterStore::Flag::FACING_RIGHT, _intent.faceDirection > 0);
+  }
+
+  if (_intent.shouldJumpDown) {
+    jumpDown();
+  } else if (_intent.shouldDoubleJump) {
+    doubleJump();
+  } else if (_intent.shouldJump) {
+    jump();
+  }
+
+  if (_intent.moveDirection < 0) {
+    moveLeft();
+  } else if (_intent.moveDirection > 0) {
+    moveRight();
+  }
+}
+
 void Npc::findNewLockedOnTargetFromParty(Character* killedTarget) {
   if (!killedTarget->getParty()) {
     return;
@@ -392,10 +458,60 @@ void Npc::moveToTarget(float delta, Character* target, float followDistance) {
   // Sometimes when Npcs are too close to each other,
   // they will stuck in the same place, unable to attack each other.
   // This is most likely because they are facing at the wrong direction.
-  _isFacingRight = targetPos.x - thisPos.x > 0;
+  _intent.faceDirection = (targetPos.x - thisPos.x > 0) ? 1 : -1;
+
+  // If there's no path (e.g., the target is in mid-air), walk towards
+  // the target and hope for the best.
+  if (!moveAlongPath(targetPos)) {
+    _intent.moveDirection = (thisPos.x > targetPos.x) ? -1 : 1;
+    jumpIfStucked(delta, /*checkInterval=*/.5f);
+  }
+}
+
+bool Npc::moveAlongPath(const b2Vec2& targetPos) {
+  NavGraph* navGraph = GameMapManager::getInstance()->getGameMap()->getNavGraph();
+  if (!navGraph) {
+    return false;
+  }
+
+  const b2Vec2& thisPos = _body->GetPosition();
+  const int from = navGraph->findNearestNode(thisPos);
+  const int to = navGraph->findNearestNode(targetPos);
+  if (from < 0 || to < 0) {
+    return false;
+  }
+
+  // On the same surface, nothing is in the way.
+  if (navGraph->getNode(from).surfaceIdx == navGraph->getNode(to).surfaceIdx) {
+    _intent.moveDirection = (thisPos.x > targetPos.x) ? -1 : 1;
+    return true;
+  }
 
-  (thisPos.x > targetPos.x) ? moveLeft() : moveRight();
-  jumpIfStucked(delta, /*checkInterval=*/.5f);
+  // The path is re-queried from the nearest node every time (it's cached
+  // by NavGraph), so only the first link of the path matters.
+  NavGraph::Path path = navGraph->findPath(from, to, getMaxJumpHeight());
+  if (path->size() < 2) {
+    return false;
+  }
+
+  const NavGraph::Node& next = navGraph->getNode(path->at(1));
+  const NavGraph::Link* link = navGraph->getLink(from, path->at(1));
+
+  if (link->type == NavGraph::LinkType::JUMP && !isJumping()) {
+    if (link->height > getMaxJumpHeight() / 2 && _characterProfile.canDoubleJump) {
+      _intent.shouldDoubleJump = true;
+    } else {
+      _intent.shouldJump = true;
+    }
+  } else if (link->type == NavGraph::LinkType::DROP && _isOnPlatform &&
+             std::abs(next.pos.x - thisPos.x) <= PATH_NODE_ARRIVAL_DISTANCE) {
+    _intent.shouldJumpDown = true;
+  }
+
+  if (std::abs(next.pos.x - thisPos.x) > PATH_NODE_ARRIVAL_DISTANCE) {
+    _intent.moveDirection = (thisPos.x > next.pos.x) ? -1 : 1;
+  }
+  return true;
 }
 
 void Npc::moveRandomly(float delta,
@@ -404,9 +520,9 @@ void Npc::moveRandomly(float delta,
   // If the character has finished moving and waiting, regenerate random values for
   // _moveDuration and _waitDuration within the specified range.
   if (_moveTimer >= _moveDuration && _waitTimer >= _waitDuration) {
-    _isMovingRight = static_cast<bool>(rand_util::randInt(0, 1));
-    _moveDuration = rand_util::randInt(minMoveDuration, maxMoveDuration);
-    _waitDuration = rand_util::randInt(minWaitDuration, maxWaitDuration);
+    _isMovingRight = static_cast<bool>(_aiRng.nextInt(0, 1));
+    _moveDuration = _aiRng.nextInt(minMoveDuration, maxMoveDuration);
+    _waitDuration = _aiRng.nextInt(minWaitDuration, maxWaitDuration);
     _moveTimer = 0;
     _waitTimer = 0;
   }
@@ -415,7 +531,7 @@ void Npc::moveRandomly(float delta,
     _waitTimer += delta;
   } else {
     _moveTimer += delta;
-    (_isMovingRight) ? moveRight() : moveLeft();
+    _intent.moveDirection = (_isMovingRight) ? 1 : -1;
     jumpIfStucked(delta, /*checkInterval=*/.5f);
   }
 }
@@ -431,7 +547,7 @@ void Npc::jumpIfStucked(float delta, float checkInterval) {
   // We've reached checkInterval, so we can make this character jump
   // if it hasn't moved at all, and then reset the timer.
   if (std::abs(_body->GetPosition().x - _lastStoppedPosition.x) == 0) {
-    jump();
+    _intent.shouldJump = true;
   }
   _lastStoppedPosition = {_body->GetPosition().x, _body->GetPosition().y};
   _calculateDistanceTimer = 0;
@@ -441,6 +557,14 @@ void Npc::reverseDirection() {
   _isMovingRight = !_isMovingRight;
 }
 
+float Npc::getMaxJumpHeight() const {
+  // Character::jump() applies an impulse of `jumpHeight`, so the initial
+  // velocity is jumpHeight / mass, and h = v^2 / 2g.
+  const float v = _characterProfile.jumpHeight / _body->GetMass();
+  const float h = v * v / (2 * std::abs(kGravity)) * JUMP_HEIGHT_SAFETY_FACTOR;
+  return (_characterProfile.canDoubleJump) ? 2 * h : h;
+}
+
 
 bool Npc::isInPlayerParty() const {
   return (_party) ? dynamic_cast<Player*>(_party->getLeader()) != nullptr : false;
@@ -539,4 +663,14 @@ Npc::Profile::Profile(const string& jsonFileName) {
   shouldSandbox = json["shouldSandbox"].GetBool();
 }
 
+
+Npc::Intent::Intent()
+    : moveDirection(),
+      faceDirection(),
+      shouldAttack(),
+      shouldJump(),
+      shouldDoubleJump(),
+      shouldJumpDown(),
+      shouldFindNewLockedOnTarget() {}
+
 }  // namespace vigilante
@@ -11,6 +11,7 @@
 #include "Character.h"
 #include "Interactable.h"
 #include "gameplay/DialogueTree.h"
+#include "util/RandUtil.h"
 
 namespace vigilante {
 
@@ -46,6 +47,20 @@ class Npc : public Character, public Interactable {
     bool shouldSandbox;
   };
 
+  // What an Npc has decided to do during the current frame.
+  // It's produced by Npc::think() and carried out by Npc::act().
+  struct Intent final {
+    Intent();
+
+    int moveDirection;  // -1: left, 0: none, 1: right
+    int faceDirection;  // -1: left, 0: unchanged, 1: right
+    bool shouldAttack;
+    bool shouldJump;
+    bool shouldDoubleJump;
+    bool shouldJumpDown;
+    bool shouldFindNewLockedOnTarget;  // `_lockedOnTarget` has been killed
+  };
+
   // In addition to Character::FixtureType, the new version defined in Npc.h
   // has the fourth fixture type.
   enum FixtureType {
@@ -83,15 +98,25 @@ class Npc : public Character, public Interactable {
   void onDialogueEnd();
 
 
-  void act(float delta);
+  // The Npc's AI runs in two phases. think() only reads the world
+  // (and this Npc's own AI state), so the Npcs can think in parallel
+  // as long as nothing else is running (see GameMapManager::update()).
+  // act() then carries out the intent on the main thread.
+  void think(float delta);
+  void act();
+
   void findNewLockedOnTargetFromParty(Character* killedTarget);
   void moveToTarget(float delta, Character* target, float followDistance);
+  bool moveAlongPath(const b2Vec2& targetPos);
   void moveRandomly(float delta,
                     int minMoveDuration, int maxMoveDuration,
                     int minWaitDuration, int maxWaitDuration);
   void jumpIfStucked(float delta, float checkInterval);
   void reverseDirection();
 
+  // How high this Npc can get by jumping (and double jumping), in meters.
+  float getMaxJumpHeight() const;
+
   bool isInPlayerParty() const;
   bool isWaitingForPlayer() const;
 
@@ -130,6 +155,9 @@ class Npc : public Character, public Interactable {
   // will be inserted into this unordered_set.
   static std::unordered_set<std::string> _npcSpawningBlacklist;
 
+  // Saves and restores `_npcSpawningBlacklist`.
+  friend class GameState;
+
   Npc::Profile _npcProfile;
   DialogueTree _dialogueTree;
   Npc::Disposition _disposition;
@@ -137,6 +165,12 @@ class Npc : public Character, public Interactable {
 
   cocos2d::Sprite* _hintBubbleFxSprite;
 
+  Npc::Intent _intent;
+  bool _hasIntent;  // whether think() has been called since the last act()
+
+  // Npcs may think in parallel, so each of them has its own generator.
+  rand_util::Generator _aiRng;
+
   // The following variables are used in Npc::moveRandomly()
   bool _isMovingRight;
   float _moveDuration;
@@ -53,6 +53,9 @@ class Party {
   Character* _leader;
   std::unordered_set<std::shared_ptr<Character>> _members;
   std::unordered_map<std::string, Party::WaitingLocationInfo> _waitingMembersLocationInfo;
+
+  // Restores the party members without showing notifications.
+  friend class GameState;
 };
 
 }  // namespace vigilante
@@ -16,7 +16,6 @@
 #include "skill/BackDash.h"
 #include "skill/ForwardSlash.h"
 #include "skill/MagicalMissile.h"
-#include "quest/KillTargetObjective.h"
 #include "ui/Shade.h"
 #include "ui/hud/Hud.h"
 #include "ui/notifications/Notifications.h"
@@ -71,7 +70,7 @@ Player::Player(const std::string& jsonFileName)
 
 
 bool Player::showOnMap(float x, float y) {
-  if (_isShownOnMap || _isKilled) {
+  if (_isShownOnMap || isKilled()) {
     return false;
   }
 
@@ -87,11 +86,11 @@ bool Player::showOnMap(float x, float y) {
   // Load sprites, spritesheets, and animations, and then add them to GameMapManager layer.
   defineTexture(_characterProfile.textureResDir, x, y);
   GameMapManager* gmMgr = GameMapManager::getInstance();
-  gmMgr->getLayer()->addChild(_bodySpritesheet, graphical_layers::kPlayerBody);
+  gmMgr->getGraphicalLayer(graphical_layers::kPlayerBody)->addChild(_bodySpritesheet);
   for (auto equipment : _equipmentSlots) {
     if (equipment) {
       Equipment::Type type = equipment->getEquipmentProfile().equipmentType;
-      gmMgr->getLayer()->addChild(_equipmentSpritesheets[type], graphical_layers::kEquipment - type);
+      gmMgr->getGraphicalLayer(graphical_layers::kEquipment - type)->addChild(_equipmentSpritesheets[type]);
     }
   }
 
@@ -157,8 +156,10 @@ void Player::unequip(Equipment::Type equipmentType) {
 }
 
 void Player::pickupItem(Item* item) {
+  // `item` may be deleted if the player already has the same item.
+  const string itemName = item->getItemProfile().name;
   Character::pickupItem(item);
-  _questBook.update(Quest::Objective::Type::COLLECT);
+  _questBook.update(Quest::Objective::Type::COLLECT, itemName);
 }
 
 void Player::addExp(const int exp) {
@@ -173,7 +174,7 @@ void Player::addExp(const int exp) {
 
 
 void Player::handleInput() {
-  if (_isSetToKill || _isAttacking || _isUsingSkill || _isSheathingWeapon || _isUnsheathingWeapon) {
+  if (isSetToKill() || isAttacking() || isUsingSkill() || isSheathingWeapon() || isUnsheathingWeapon()) {
     return;
   }
 
@@ -198,7 +199,7 @@ void Player::handleInput() {
   }
 
   if (IS_KEY_JUST_PRESSED(EventKeyboard::KeyCode::KEY_LEFT_CTRL)) {
-    if (!_isWeaponSheathed) {
+    if (!isWeaponSheathed()) {
       attack();
     }
   }
@@ -211,9 +212,9 @@ void Player::handleInput() {
 
   if (IS_KEY_JUST_PRESSED(EventKeyboard::KeyCode::KEY_R)) {
     if (_equipmentSlots[Equipment::Type::WEAPON]
-        && _isWeaponSheathed && !_isUnsheathingWeapon) {
+        && isWeaponSheathed() && !isUnsheathingWeapon()) {
       unsheathWeapon();
-    } else if (!_isWeaponSheathed && !_isSheathingWeapon) {
+    } else if (!isWeaponSheathed() && !isSheathingWeapon()) {
       sheathWeapon();
     }
   }
@@ -240,7 +241,7 @@ void Player::handleInput() {
     jump();
   }
 
-  if (_isCrouching && !IS_KEY_PRESSED(EventKeyboard::KeyCode::KEY_DOWN_ARROW)) {
+  if (isCrouching() && !IS_KEY_PRESSED(EventKeyboard::KeyCode::KEY_DOWN_ARROW)) {
     getUp();
   }
 }
@@ -251,13 +252,7 @@ void Player::updateKillTargetObjectives(Character* killedCharacter) {
     return;
   }
 
-  for (auto quest : _questBook.getInProgressQuests()) {
-    auto ko = dynamic_cast<KillTargetObjective*>(quest->getCurrentStage().objective.get());
-    if (ko && ko->getCharacterName() == killedCharacter->getCharacterProfile().name) {
-      ko->incrementCurrentAmount();
-    }
-  }
-  _questBook.update(Quest::Objective::Type::KILL);
+  _questBook.update(Quest::Objective::Type::KILL, killedCharacter->getCharacterProfile().name);
 }
 
 
@@ -0,0 +1,325 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "DialogueGraph.h"
+
+#include <utility>
+
+#include "util/JsonUtil.h"
+#include "util/Logger.h"
+
+// Upper bound of `childrenRef` -> `childrenRef` -> ... chains.
+#define MAX_CHILDREN_REF_DEPTH 16
+
+using std::pair;
+using std::string;
+using std::vector;
+using std::shared_ptr;
+using std::unique_ptr;
+using std::unordered_map;
+using rapidjson::Document;
+
+namespace vigilante {
+
+// Builds a DialogueGraph from a dialogue tree json.
+class DialogueGraph::Compiler final {
+ public:
+  explicit Compiler(DialogueGraph* graph) : _graph(graph), _stringIdxMapper() {}
+
+  void compile(const Document& json, const string& jsonFileName);
+  void compileBuiltinOptions(const vector<pair<string, string>>& options);
+
+ private:
+  uint32_t addNode();
+  uint32_t intern(const string& s);
+  void resolveChildrenRefs(const unordered_map<uint32_t, string>& childrenRefs,
+                           const unordered_map<string, uint32_t>& nodeNames);
+
+  DialogueGraph* _graph;
+  unordered_map<string, uint32_t> _stringIdxMapper;
+};
+
+void DialogueGraph::Compiler::compile(const Document& json, const string& jsonFileName) {
+  unordered_map<string, uint32_t> nodeNames;  // <nodeName, node idx>
+  unordered_map<uint32_t, string> childrenRefs;  // <node idx, childrenRef>
+
+  // Tree DFS. A node's children are allocated all at once when the node
+  // is visited, so that they occupy a contiguous range of `_childIdxs`.
+  vector<pair<const rapidjson::Value*, uint32_t>> st;  // <jsonObject, node idx>
+  st.push_back({&json, addNode()});
+
+  while (!st.empty()) {
+    const rapidjson::Value& jsonNode = *st.back().first;
+    const uint32_t nodeIdx = st.back().second;
+    st.pop_back();
+
+    if (jsonNode.HasMember("nodeName")) {
+      nodeNames.insert({jsonNode["nodeName"].GetString(), nodeIdx});
+    }
+
+    const uint32_t linesBegin = _graph->_stringIdxs.size();
+    for (const auto& line : jsonNode["lines"].GetArray()) {
+      _graph->_stringIdxs.push_back(intern(line.GetString()));
+    }
+    const uint32_t linesEnd = _graph->_stringIdxs.size();
+
+    vector<string> cmds;
+    for (const auto& cmd : jsonNode["exec"].GetArray()) {
+      cmds.push_back(cmd.GetString());
+    }
+    const uint32_t cmdsBegin = _graph->_cmds.size();
+    for (auto& instruction : CommandParser::compileAll(cmds, jsonFileName)) {
+      _graph->_cmds.push_back(std::move(instruction));
+    }
+    const uint32_t childrenBegin = _graph->_childIdxs.size();
+
+    if (jsonNode.HasMember("childrenRef")) {
+      childrenRefs.insert({nodeIdx, jsonNode["childrenRef"].GetString()});
+    } else {
+      const auto& children = jsonNode["children"].GetArray();
+      for (size_t i = 0; i < children.Size(); i++) {
+        _graph->_childIdxs.push_back(addNode());
+      }
+      // Push the children onto the stack in reverse order.
+      for (int i = children.Size() - 1; i >= 0; i--) {
+        st.push_back({&children[i], _graph->_childIdxs[childrenBegin + i]});
+      }
+    }
+
+    DialogueGraph::Node& node = _graph->_nodes[nodeIdx];
+    node._linesBegin = linesBegin;
+    node._linesEnd = linesEnd;
+    node._cmdsBegin = cmdsBegin;
+    node._cmdsEnd = _graph->_cmds.size();
+    node._childrenBegin = childrenBegin;
+    node._childrenEnd = _graph->_childIdxs.size();
+  }
+
+  resolveChildrenRefs(childrenRefs, nodeNames);
+
+  // What's the effect of a "QuestDialogueTree"?
+  // e.g., if `_isQuestDialogueTree` == true, then the dialogue to
+  //       toggle following/dismiss won't be present.
+  _graph->_isQuestDialogueTree = json["isQuestDialogueTree"].GetBool();
+}
+
+void DialogueGraph::Compiler::compileBuiltinOptions(const vector<pair<string, string>>& options) {
+  const uint32_t rootIdx = addNode();
+  const uint32_t childrenBegin = _graph->_childIdxs.size();
+
+  for (const auto& option : options) {
+    const uint32_t nodeIdx = addNode();
+    _graph->_childIdxs.push_back(nodeIdx);
+
+    DialogueGraph::Node& node = _graph->_nodes[nodeIdx];
+    node._linesBegin = _graph->_stringIdxs.size();
+    _graph->_stringIdxs.push_back(intern(option.first));
+    node._linesEnd = _graph->_stringIdxs.size();
+    node._cmdsBegin = _graph->_cmds.size();
+    _graph->_cmds.push_back(CommandParser::compile(option.second));
+    node._cmdsEnd = _graph->_cmds.size();
+  }
+
+  DialogueGraph::Node& root = _graph->_nodes[rootIdx];
+  root._childrenBegin = childrenBegin;
+  root._childrenEnd = _graph->_childIdxs.size();
+}
+
+uint32_t DialogueGraph::Compiler::addNode() {
+  DialogueGraph::Node node;
+  node._graph = _graph;
+  node._linesBegin = node._linesEnd = 0;
+  node._cmdsBegin = node._cmdsEnd = 0;
+  node._childrenBegin = node._childrenEnd = 0;
+  _graph->_nodes.push_back(node);
+  return _graph->_nodes.size() - 1;
+}
+
+uint32_t DialogueGraph::Compiler::intern(const string& s) {
+  auto it = _stringIdxMapper.find(s);
+  if (it != _stringIdxMapper.end()) {
+    return it->second;
+  }
+  _graph->_strings.push_back(s);
+  _stringIdxMapper.insert({s, _graph->_strings.size() - 1});
+  return _graph->_strings.size() - 1;
+}
+
+void DialogueGraph::Compiler::resolveChildrenRefs(const unordered_map<uint32_t, string>& childrenRefs,
+                                                  const unordered_map<string, uint32_t>& nodeNames) {
+  for (const auto& ref : childrenRefs) {
+    // Follow the chain until we reach a node which actually has children.
+    uint32_t targetIdx = ref.first;
+    auto refIt = childrenRefs.find(targetIdx);
+
+    for (int depth = 0; refIt != childrenRefs.end(); depth++) {
+      auto nodeIt = nodeNames.find(refIt->second);
+      if (nodeIt == nodeNames.end() || depth >= MAX_CHILDREN_REF_DEPTH) {
+        VGLOG(LOG_ERR, "Unable to resolve childrenRef: %s", ref.second.c_str());
+        targetIdx = ref.first;
+        break;
+      }
+      targetIdx = nodeIt->second;
+      refIt = childrenRefs.find(targetIdx);
+    }
+
+    DialogueGraph::Node& node = _graph->_nodes[ref.first];
+    node._childrenBegin = _graph->_nodes[targetIdx]._childrenBegin;
+    node._childrenEnd = _graph->_nodes[targetIdx]._childrenEnd;
+  }
+}
+
+
+
+unordered_map<string, shared_ptr<const DialogueGraph>> DialogueGraph::_cache;
+
+shared_ptr<const DialogueGraph> DialogueGraph::get(const string& jsonFileName) {
+  auto it = _cache.find(jsonFileName);
+  if (it != _cache.end()) {
+    return it->second;
+  }
+
+  VGLOG(LOG_INFO, "Compiling dialogue tree: %s", jsonFileName.c_str());
+  shared_ptr<DialogueGraph> graph(new DialogueGraph());
+  Compiler(graph.get()).compile(json_util::parseJson(jsonFileName), jsonFileName);
+
+  _cache.insert({jsonFileName, graph});
+  return graph;
+}
+
+const DialogueGraph::Node* DialogueGraph::getBuiltinOption(DialogueGraph::BuiltinOption option) {
+  static const unique_ptr<DialogueGraph> builtinOptions = []() {
+    unique_ptr<DialogueGraph> graph(new DialogueGraph());
+    // Must be in the same order as DialogueGraph::BuiltinOption.
+    Compiler(graph.get()).compileBuiltinOptions({
+      {"Follow me.", "joinPlayerParty"},
+      {"It's time for us to part ways", "leavePlayerParty"},
+      {"Wait here.", "playerPartyMemberWait"},
+      {"Continue to follow me.", "playerPartyMemberFollow"},
+      {"Let's trade.", "tradeWithPlayer"}
+    });
+    return graph;
+  }();
+
+  return &builtinOptions->_nodes[1 + option];
+}
+
+DialogueGraph::DialogueGraph()
+    : _nodes(),
+      _stringIdxs(),
+      _cmds(),
+      _childIdxs(),
+      _strings(),
+      _isQuestDialogueTree() {}
+
+
+const DialogueGraph::Node* DialogueGraph::getRootNode() const {
+  return &_nodes.front();
+}
+
+bool DialogueGraph::isQuestDialogueTree() const {
+  return _isQuestDialogueTree;
+}
+
+size_t DialogueGraph::getNodeCount() const {
+  return _nodes.size();
+}
+
+vector<string> DialogueGraph::getQuestJsonFileNames() const {
+  vector<string> questJsonFileNames;
+  for (const auto& cmd : _cmds) {
+    if (cmd.opcode == CommandParser::Opcode::START_QUEST && cmd.args.size() > 1) {
+      questJsonFileNames.push_back(cmd.args[1]);
+    }
+  }
+  return questJsonFileNames;
+}
+
+
+
+DialogueGraph::StringRange DialogueGraph::Node::getLines() const {
+  const uint32_t* idxs = _graph->_stringIdxs.data();
+  return StringRange(&_graph->_strings, idxs + _linesBegin, idxs + _linesEnd);
+}
+
+DialogueGraph::CmdRange DialogueGraph::Node::getCmds() const {
+  const CommandParser::Instruction* cmds = _graph->_cmds.data();
+  return CmdRange(cmds + _cmdsBegin, cmds + _cmdsEnd);
+}
+
+vector<const DialogueGraph::Node*> DialogueGraph::Node::getChildren() const {
+  vector<const DialogueGraph::Node*> children;
+  children.reserve(_childrenEnd - _childrenBegin);
+  for (uint32_t i = _childrenBegin; i < _childrenEnd; i++) {
+    children.push_back(&_graph->_nodes[_graph->_childIdxs[i]]);
+  }
+  return children;
+}
+
+bool DialogueGraph::Node::hasSameChildrenAs(const DialogueGraph::Node* other) const {
+  return _graph == other->_graph &&
+         _childrenBegin == other->_childrenBegin &&
+         _childrenEnd == other->_childrenEnd;
+}
+
+
+
+DialogueGraph::StringRange::StringRange(const vector<string>* strings,
+                                        const uint32_t* begin,
+                                        const uint32_t* end)
+    : _strings(strings), _begin(begin), _end(end) {}
+
+DialogueGraph::StringRange::Iterator DialogueGraph::StringRange::begin() const {
+  return Iterator(_strings, _begin);
+}
+
+DialogueGraph::StringRange::Iterator DialogueGraph::StringRange::end() const {
+  return Iterator(_strings, _end);
+}
+
+bool DialogueGraph::StringRange::empty() const {
+  return _begin == _end;
+}
+
+size_t DialogueGraph::StringRange::size() const {
+  return _end - _begin;
+}
+
+const string& DialogueGraph::StringRange::front() const {
+  return (*_strings)[*_begin];
+}
+
+
+DialogueGraph::StringRange::Iterator::Iterator(const vector<string>* strings, const uint32_t* p)
+    : _strings(strings), _p(p) {}
+
+const string& DialogueGraph::StringRange::Iterator::operator*() const {
+  return (*_strings)[*_p];
+}
+
+DialogueGraph::StringRange::Iterator& DialogueGraph::StringRange::Iterator::operator++() {
+  ++_p;
+  return *this;
+}
+
+bool DialogueGraph::StringRange::Iterator::operator!=(const Iterator& other) const {
+  return _p != other._p;
+}
+
+
+
+DialogueGraph::CmdRange::CmdRange(const CommandParser::Instruction* begin,
+                                  const CommandParser::Instruction* end)
+    : _begin(begin), _end(end) {}
+
+const CommandParser::Instruction* DialogueGraph::CmdRange::begin() const {
+  return _begin;
+}
+
+const CommandParser::Instruction* DialogueGraph::CmdRange::end() const {
+  return _end;
+}
+
+bool DialogueGraph::CmdRange::empty() const {
+  return _begin == _end;
+}
+
+}  // namespace vigilante
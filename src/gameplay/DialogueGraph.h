@@ -0,0 +1,141 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_DIALOGUE_GRAPH_H_
+#define VIGILANTE_DIALOGUE_GRAPH_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ui/console/CommandParser.h"
+
+namespace vigilante {
+
+// The compiled, immutable form of a dialogue tree json.
+//
+// All nodes live in one flat array. A node's lines, commands and children
+// are index ranges into shared arrays, and each distinct string is stored
+// only once per graph. Commands are compiled by CommandParser, and `childrenRef`
+// is resolved at compile time, so a node referencing another node's children
+// simply shares its children range.
+//
+// Graphs are compiled on first use and cached by file, so all Npcs using
+// the same dialogue tree share a single copy (see DialogueTree for the
+// per-Npc state).
+class DialogueGraph {
+ public:
+  // A read-only view of some of the graph's strings.
+  class StringRange {
+   public:
+    class Iterator {
+     public:
+      Iterator(const std::vector<std::string>* strings, const uint32_t* p);
+
+      const std::string& operator*() const;
+      Iterator& operator++();
+      bool operator!=(const Iterator& other) const;
+
+     private:
+      const std::vector<std::string>* _strings;
+      const uint32_t* _p;
+    };
+
+    StringRange(const std::vector<std::string>* strings, const uint32_t* begin, const uint32_t* end);
+
+    Iterator begin() const;
+    Iterator end() const;
+    bool empty() const;
+    size_t size() const;
+    const std::string& front() const;
+
+   private:
+    const std::vector<std::string>* _strings;
+    const uint32_t* _begin;
+    const uint32_t* _end;
+  };
+
+
+  // A read-only view of some of the graph's compiled commands.
+  class CmdRange {
+   public:
+    CmdRange(const CommandParser::Instruction* begin, const CommandParser::Instruction* end);
+
+    const CommandParser::Instruction* begin() const;
+    const CommandParser::Instruction* end() const;
+    bool empty() const;
+
+   private:
+    const CommandParser::Instruction* _begin;
+    const CommandParser::Instruction* _end;
+  };
+
+
+  class Node final {
+   public:
+    DialogueGraph::StringRange getLines() const;
+    DialogueGraph::CmdRange getCmds() const;  // the commands to execute after all lines are shown.
+    std::vector<const DialogueGraph::Node*> getChildren() const;
+
+    // Whether this node has the same children as `other` (e.g., via `childrenRef`).
+    bool hasSameChildrenAs(const DialogueGraph::Node* other) const;
+
+   private:
+    const DialogueGraph* _graph;
+    uint32_t _linesBegin;
+    uint32_t _linesEnd;
+    uint32_t _cmdsBegin;
+    uint32_t _cmdsEnd;
+    uint32_t _childrenBegin;
+    uint32_t _childrenEnd;
+
+    friend class DialogueGraph;
+  };
+
+
+  // @return the compiled graph of the given dialogue tree json.
+  //         It's compiled upon the first call and cached afterwards.
+  static std::shared_ptr<const DialogueGraph> get(const std::string& jsonFileName);
+
+  // The options which DialogueTree adds to the root of recruitable
+  // and tradable Npcs' dialogues.
+  enum BuiltinOption {
+    JOIN_PARTY,
+    LEAVE_PARTY,
+    WAIT,
+    FOLLOW,
+    TRADE,
+    SIZE
+  };
+
+  static const DialogueGraph::Node* getBuiltinOption(DialogueGraph::BuiltinOption option);
+
+  DialogueGraph(const DialogueGraph&) = delete;
+  DialogueGraph& operator=(const DialogueGraph&) = delete;
+  virtual ~DialogueGraph() = default;
+
+  const DialogueGraph::Node* getRootNode() const;
+  bool isQuestDialogueTree() const;
+  size_t getNodeCount() const;
+
+  // The quests which the commands of this graph may start.
+  std::vector<std::string> getQuestJsonFileNames() const;
+
+ private:
+  class Compiler;
+
+  DialogueGraph();
+
+  std::vector<DialogueGraph::Node> _nodes;  // _nodes[0] is the root node
+  std::vector<uint32_t> _stringIdxs;  // the lines of all nodes
+  std::vector<CommandParser::Instruction> _cmds;  // the commands of all nodes
+  std::vector<uint32_t> _childIdxs;  // the children of all nodes
+  std::vector<std::string> _strings;
+  bool _isQuestDialogueTree;
+
+  static std::unordered_map<std::string, std::shared_ptr<const DialogueGraph>> _cache;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_DIALOGUE_GRAPH_H_
@@ -7,87 +7,57 @@
 #include <memory>
 #include <unordered_map>
 
-#include "Importable.h"
+#include "DialogueGraph.h"
 
 namespace vigilante {
 
 class Npc;
 
-class DialogueTree : public Importable {
+// An Npc's position in its dialogue. The dialogue itself is a DialogueGraph
+// shared by all Npcs using the same json, which is compiled (or fetched
+// from the cache) upon the first resetCurrentNode(), i.e., when the
+// conversation actually begins.
+class DialogueTree {
  public:
+  using Node = DialogueGraph::Node;
+
   DialogueTree(const std::string& jsonFileName, Npc* owner);
-  DialogueTree(const DialogueTree&) = delete;
-  DialogueTree(DialogueTree&& other) noexcept;
-  DialogueTree& operator=(const DialogueTree&) = delete;
-  DialogueTree& operator=(DialogueTree&& other) noexcept;
   virtual ~DialogueTree() = default;
 
-  virtual void update();
-
-
-  class Node final {
-   public:
-    explicit Node(DialogueTree* tree);
-    ~Node() = default;
-
-    const std::string& getNodeName() const;
-    const std::vector<std::string>& getLines() const;
-    const std::vector<std::string>& getCmds() const;
-    const std::string& getChildrenRef() const;
-    std::vector<Node*> getChildren() const;
-
-   private:
-    DialogueTree* _tree;
-
-    std::string _nodeName;  // only required when `childrenRef` exists. See comment below.
-    std::vector<std::string> _lines;
-    std::vector<std::string> _cmds;  // the command to execute after all lines are shown.
+  // The children of `node`. The root's children also include the options
+  // for recruitable and tradable Npcs, depending on the owner's current state.
+  std::vector<const DialogueTree::Node*> getChildren(const DialogueTree::Node* node) const;
 
-    // We have two (mutually exclusive) methods for keeping children:
-    //
-    // (a) childrenRef: we reference another node's children by its `nodeName`.
-    //                               ~~~~~~~~~~~~               ~~~
-    //                                    |______________________|
-    // (b) children: we actually keep unique_ptr<Node> to the nodes.
-    std::string _childrenRef;
-    std::vector<std::unique_ptr<Node>> _children;
-
-    friend class DialogueTree;
-  };
+  const DialogueTree::Node* getCurrentNode() const;
+  void setCurrentNode(const DialogueTree::Node* node);
+  void resetCurrentNode();
 
+  const std::string& getJsonFileName() const;
 
-  virtual void import(const std::string& jsonFileName) override;  // Importable
-
-  DialogueTree::Node* getNode(const std::string& nodeName) const;
-  
-  DialogueTree::Node* getRootNode() const;
-  DialogueTree::Node* getCurrentNode() const;
-  void setCurrentNode(DialogueTree::Node* node);
-  void resetCurrentNode();
+  // The quests which this dialogue may start, or none before the first resetCurrentNode().
+  std::vector<std::string> getQuestJsonFileNames() const;
 
   static std::string getLatestNpcDialogueTree(const std::string& npcJsonFileName);
   static void setLatestNpcDialogueTree(const std::string& npcJsonFileName,
                                        const std::string& dialogueTreeJsonFileName);
+  // Reverts the Npc to the dialogue tree in its profile.
+  static void clearLatestNpcDialogueTree(const std::string& npcJsonFileName);
 
  private:
   static std::unordered_map<std::string, std::string> _latestNpcDialogueTree;
 
-  // <nodeName, DialogueTree::Node*>
-  std::unordered_map<std::string, DialogueTree::Node*> _nodeMapper;
-  std::unique_ptr<DialogueTree::Node> _rootNode;
-  DialogueTree::Node* _currentNode;
-
-  DialogueTree::Node* _toggleJoinPartyNode;
-  DialogueTree::Node* _toggleWaitNode;
-  DialogueTree::Node* _tradeNode;
+  // Saves and restores `_latestNpcDialogueTree`.
+  friend class GameState;
 
-  bool _isQuestDialogueTree;
+  std::string _jsonFileName;
+  std::shared_ptr<const DialogueGraph> _graph;  // nullptr until the first resetCurrentNode()
+  const DialogueTree::Node* _currentNode;
   Npc* _owner;
 };
 
 
 // This alias improves code readability in ui/pause_menu/DialogueListView.cc
-using Dialogue = DialogueTree::Node;
+using Dialogue = const DialogueTree::Node;
 
 }  // namespace vigilante
 
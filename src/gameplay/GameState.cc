@@ -1,35 +1,821 @@
 // Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
 #include "GameState.h"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
 #include <fstream>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <thread>
 
-using std::endl;
+#include <zlib.h>
+#include <cocos2d.h>
+#include "Constants.h"
+#include "character/Npc.h"
+#include "character/Party.h"
+#include "character/Player.h"
+#include "gameplay/DialogueTree.h"
+#include "map/GameMap.h"
+#include "map/GameMapManager.h"
+#include "quest/KillTargetObjective.h"
+#include "ui/hud/Hud.h"
+#include "util/BinaryStream.h"
+#include "util/Logger.h"
+#include "util/Profiler.h"
+
+extern "C" {
+#include <unistd.h> // fsync
+}
+
+#define SAVE_FILENAME "save.dat"
+// deflate cannot compress anything by more than this (about 1032:1).
+#define MAX_COMPRESSION_RATIO 1032
+
+using std::pair;
+using std::mutex;
 using std::string;
+using std::thread;
+using std::vector;
 using std::ifstream;
-using std::ofstream;
+using std::lock_guard;
+using std::unique_lock;
+using std::shared_ptr;
+using std::unordered_map;
+using cocos2d::FileUtils;
 
 namespace vigilante {
 
-GameState::GameState() {}
+namespace {
 
+// Saves are written by worker threads one at a time. If another save
+// of the same file is requested while one is waiting for its turn,
+// the older one is skipped.
+mutex writeMutex;
+mutex pendingWritesMutex;
+std::condition_variable pendingWritesCv;
+int pendingWritesCount = 0;
+uint64_t nextSaveId = 0;
+unordered_map<string, uint64_t> latestSaveIds;
+
+// Generations only need to be unique among the files of a save,
+// so they aren't drawn from the game's (seedable) rand_util streams.
+uint64_t newGeneration() {
+  std::random_device rd;
+  return (static_cast<uint64_t>(rd()) << 32) | rd();
+}
+
+Item* findInventoryItem(Player* player, const string& jsonFileName) {
+  for (const auto& items : player->getInventory()) {
+    for (auto item : items) {
+      if (item->getItemProfile().jsonFileName == jsonFileName) {
+        return item;
+      }
+    }
+  }
+  return nullptr;
+}
 
-void GameState::load() {
-  ifstream fin(_filePath);
-  fin >> *this;
+GameState::QuestProgress getQuestProgress(const Quest* quest) {
+  int objectiveProgress = 0;
+  if (quest->getCurrentStageIdx() >= 0 && !quest->isCompleted()) {
+    auto o = dynamic_cast<const KillTargetObjective*>(quest->getCurrentStage().objective.get());
+    if (o) {
+      objectiveProgress = o->getCurrentAmount();
+    }
+  }
+  return {quest->getQuestProfile().jsonFileName, quest->isUnlocked(),
+          quest->getCurrentStageIdx(), objectiveProgress};
+}
+
+void restoreQuestProgress(Quest* quest, const GameState::QuestProgress& progress) {
+  quest->restoreProgress(progress.isUnlocked, progress.currentStageIdx);
+  if (quest->getCurrentStageIdx() >= 0 && !quest->isCompleted()) {
+    auto o = dynamic_cast<KillTargetObjective*>(quest->getCurrentStage().objective.get());
+    if (o) {
+      o->setCurrentAmount(progress.objectiveProgress);
+    }
+  }
+}
+
+BinaryWriter& operator<<(BinaryWriter& writer, const GameState::QuestProgress& q) {
+  writer.writeString(q.jsonFileName);
+  writer.writeBool(q.isUnlocked);
+  writer.writeI32(q.currentStageIdx);
+  writer.writeI32(q.objectiveProgress);
+  return writer;
+}
+
+BinaryReader& operator>>(BinaryReader& reader, GameState::QuestProgress& q) {
+  q.jsonFileName = reader.readString();
+  q.isUnlocked = reader.readBool();
+  q.currentStageIdx = reader.readI32();
+  q.objectiveProgress = reader.readI32();
+  return reader;
+}
+
+BinaryWriter& operator<<(BinaryWriter& writer, const GameState::PartyMember& m) {
+  writer.writeString(m.jsonFileName);
+  writer.writeBool(m.isWaiting);
+  writer.writeString(m.waitingTmxMapFileName);
+  writer.writeFloat(m.waitingX);
+  writer.writeFloat(m.waitingY);
+  return writer;
+}
+
+BinaryReader& operator>>(BinaryReader& reader, GameState::PartyMember& m) {
+  m.jsonFileName = reader.readString();
+  m.isWaiting = reader.readBool();
+  m.waitingTmxMapFileName = reader.readString();
+  m.waitingX = reader.readFloat();
+  m.waitingY = reader.readFloat();
+  return reader;
+}
+
+template <typename T>
+void writeVector(BinaryWriter& writer, const vector<T>& v) {
+  writer.writeU32(v.size());
+  for (const auto& e : v) {
+    writer << e;
+  }
+}
+
+template <typename T>
+void readVector(BinaryReader& reader, vector<T>& v) {
+  v.clear();
+  const uint32_t size = reader.readU32();
+  for (uint32_t i = 0; i < size && reader.good(); i++) {
+    T e;
+    reader >> e;
+    v.push_back(std::move(e));
+  }
+}
+
+}  // namespace
+
+
+const uint32_t GameState::_kMagic = 0x56475356;  // "VSGV"
+const uint32_t GameState::_kVersion = 2;
+const int GameState::_kCompressionLevel = Z_BEST_SPEED;
+
+GameState::GameState(const string& filePath) : _filePath(filePath) {}
+
+
+bool GameState::load() {
+  // Otherwise a save still being written may be read half-replaced.
+  waitForPendingWrites();
+  SaveJournal::getInstance()->close();
+
+  auto snapshot = std::make_shared<GameState::Snapshot>();
+  if (!read(_filePath, *snapshot)) {
+    return false;
+  }
+
+  // Collect the changes made after the snapshot was taken.
+  auto records = std::make_shared<vector<SaveJournal::Record>>();
+  const uint64_t generation = SaveJournal::readChain(_filePath, snapshot->generation, *records);
+  VGLOG(LOG_INFO, "Replaying %u save journal records", static_cast<unsigned>(records->size()));
+
+  // These are looked up while the GameMap's objects are being created,
+  // so they have to be restored first.
+  restoreGlobalStates(*snapshot);
+  replayGlobalStates(*records);
+
+  const string filePath = _filePath;
+  GameMapManager::getInstance()->loadGameMap(snapshot->tmxMapFileName,
+                                             [filePath, snapshot, records, generation]() {
+    restorePlayer(*snapshot);
+    replayPlayer(*records);
+    GameMapManager::getInstance()->getPlayer()->getQuestBook().rebuildIndices();
+    Hud::getInstance()->updateStatusBars();
+    Hud::getInstance()->updateEquippedWeapon();
+
+    // Keep journaling from where the last session left off.
+    SaveJournal::getInstance()->open(filePath, generation, true);
+  });
+  return true;
 }
 
 void GameState::save() {
-  ofstream fout(_filePath);
-  fout << *this;
+  auto snapshot = std::make_shared<GameState::Snapshot>();
+
+  const auto captureBeginTime = std::chrono::steady_clock::now();
+  {
+    VGPROFILE_SCOPE("GameState::capture");
+    if (!GameMapManager::getInstance()->getPlayer()) {
+      VGLOG(LOG_ERR, "Unable to save the game: the player hasn't been spawned yet.");
+      return;
+    }
+    capture(*snapshot);
+  }
+  // Changes made from now on belong to the new snapshot.
+  snapshot->generation = newGeneration();
+  SaveJournal::getInstance()->open(_filePath, snapshot->generation, false);
+
+  VGLOG(LOG_INFO, "Saving game to %s (captured in %lld us)", _filePath.c_str(),
+        static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - captureBeginTime).count()));
+
+  uint64_t saveId = 0;
+  {
+    lock_guard<mutex> lock(pendingWritesMutex);
+    saveId = ++nextSaveId;
+    latestSaveIds[_filePath] = saveId;
+    pendingWritesCount++;
+  }
+
+  const string filePath = _filePath;
+  thread([filePath, snapshot, saveId]() {
+    {
+      lock_guard<mutex> lock(writeMutex);
+
+      bool isSuperseded = false;
+      {
+        lock_guard<mutex> lock(pendingWritesMutex);
+        isSuperseded = latestSaveIds[filePath] != saveId;
+      }
+      if (!isSuperseded && !write(filePath, *snapshot)) {
+        VGLOG(LOG_ERR, "Failed to save game to %s", filePath.c_str());
+      }
+    }
+
+    lock_guard<mutex> lock(pendingWritesMutex);
+    pendingWritesCount--;
+    pendingWritesCv.notify_all();
+  }).detach();
+}
+
+void GameState::waitForPendingWrites() {
+  unique_lock<mutex> lock(pendingWritesMutex);
+  pendingWritesCv.wait(lock, []() { return pendingWritesCount == 0; });
+}
+
+
+string GameState::getDefaultFilePath() {
+  return FileUtils::getInstance()->getWritablePath() + SAVE_FILENAME;
+}
+
+bool GameState::exists(const string& filePath) {
+  return FileUtils::getInstance()->isFileExist(filePath);
+}
+
+const string& GameState::getFilePath() const {
+  return _filePath;
+}
+
+void GameState::setFilePath(const string& filePath) {
+  _filePath = filePath;
+}
+
+
+void GameState::capture(GameState::Snapshot& snapshot) {
+  GameMapManager* gmMgr = GameMapManager::getInstance();
+  Player* player = gmMgr->getPlayer();
+
+  snapshot.tmxMapFileName = gmMgr->getGameMap()->getTmxTiledMapFileName();
+  const b2Vec2& playerPos = player->getBody()->GetPosition();
+  snapshot.playerX = playerPos.x;
+  snapshot.playerY = playerPos.y;
+
+  const Character::Profile& profile = player->getCharacterProfile();
+  snapshot.level = profile.level;
+  snapshot.exp = profile.exp;
+  snapshot.fullHealth = profile.fullHealth;
+  snapshot.fullStamina = profile.fullStamina;
+  snapshot.fullMagicka = profile.fullMagicka;
+  snapshot.health = profile.health;
+  snapshot.stamina = profile.stamina;
+  snapshot.magicka = profile.magicka;
+  snapshot.strength = profile.strength;
+  snapshot.dexterity = profile.dexterity;
+  snapshot.intelligence = profile.intelligence;
+  snapshot.luck = profile.luck;
+  snapshot.baseMeleeDamage = profile.baseMeleeDamage;
+  snapshot.moveSpeed = profile.moveSpeed;
+  snapshot.jumpHeight = profile.jumpHeight;
+
+  for (const auto& items : player->getInventory()) {
+    for (const auto item : items) {
+      snapshot.inventory.push_back({item->getItemProfile().jsonFileName, item->getAmount()});
+    }
+  }
+
+  for (const auto equipment : player->getEquipmentSlots()) {
+    snapshot.equipment.push_back((equipment) ? equipment->getItemProfile().jsonFileName : "");
+  }
+
+  for (const auto& skills : player->getSkillBook()) {
+    for (const auto skill : skills) {
+      snapshot.skills.push_back(skill->getSkillProfile().jsonFileName);
+    }
+  }
+
+  const QuestBook& questBook = player->getQuestBook();
+  for (const auto quest : questBook.getInProgressQuests()) {
+    snapshot.inProgressQuests.push_back(getQuestProgress(quest));
+  }
+  for (const auto quest : questBook.getCompletedQuests()) {
+    snapshot.completedQuests.push_back(getQuestProgress(quest));
+  }
+  for (const auto& q : questBook._questMapper) {
+    if (q.second && q.second->isUnlocked() && q.second->getCurrentStageIdx() < 0) {
+      snapshot.unlockedQuests.push_back(getQuestProgress(q.second.get()));
+    }
+  }
+
+  const Party* party = player->getParty().get();
+  for (const auto& member : party->getMembers()) {
+    const string& jsonFileName = member->getCharacterProfile().jsonFileName;
+    GameState::PartyMember m = {jsonFileName, party->hasWaitingMember(jsonFileName), "", 0, 0};
+    if (m.isWaiting) {
+      Party::WaitingLocationInfo location = party->getWaitingMemberLocationInfo(jsonFileName);
+      m.waitingTmxMapFileName = location.tmxMapFileName;
+      m.waitingX = location.x;
+      m.waitingY = location.y;
+    }
+    snapshot.partyMembers.push_back(std::move(m));
+  }
+
+  snapshot.portalStates = GameMap::Portal::_allPortalStates;
+  snapshot.latestNpcDialogueTrees = DialogueTree::_latestNpcDialogueTree;
+  snapshot.npcSpawningBlacklist = Npc::_npcSpawningBlacklist;
+}
+
+void GameState::restoreGlobalStates(const GameState::Snapshot& snapshot) {
+  GameMap::Portal::_allPortalStates = snapshot.portalStates;
+  DialogueTree::_latestNpcDialogueTree = snapshot.latestNpcDialogueTrees;
+  Npc::_npcSpawningBlacklist = snapshot.npcSpawningBlacklist;
 }
 
+void GameState::restorePlayer(const GameState::Snapshot& snapshot) {
+  Player* player = GameMapManager::getInstance()->getPlayer();
+  Party* party = player->getParty().get();
+
+  // Disband the current party. GameMap::createNpcs() may have shown
+  // some of its waiting members on the new GameMap already.
+  for (const auto& member : party->getMembers()) {
+    member->removeFromMap();
+    member->setParty(nullptr);
+  }
+  party->_members.clear();
+  party->_waitingMembersLocationInfo.clear();
+
+  Character::Profile& profile = player->getCharacterProfile();
+  profile.level = snapshot.level;
+  profile.exp = snapshot.exp;
+  profile.fullHealth = snapshot.fullHealth;
+  profile.fullStamina = snapshot.fullStamina;
+  profile.fullMagicka = snapshot.fullMagicka;
+  profile.health = snapshot.health;
+  profile.stamina = snapshot.stamina;
+  profile.magicka = snapshot.magicka;
+  profile.strength = snapshot.strength;
+  profile.dexterity = snapshot.dexterity;
+  profile.intelligence = snapshot.intelligence;
+  profile.luck = snapshot.luck;
+  profile.baseMeleeDamage = snapshot.baseMeleeDamage;
+  profile.moveSpeed = snapshot.moveSpeed;
+  profile.jumpHeight = snapshot.jumpHeight;
+
+  // Restore the inventory and equipment slots. The items are added and removed
+  // with Character's methods instead of Player's, so that no notification is
+  // shown for each item. The equipment is re-equipped with Player's methods,
+  // which load its animations and update the HUD.
+  for (int type = 0; type < Equipment::Type::SIZE; type++) {
+    player->unequip(static_cast<Equipment::Type>(type));
+  }
+  for (const auto& items : player->getInventory()) {
+    const vector<Item*> itemsCopy(items.begin(), items.end());
+    for (auto item : itemsCopy) {
+      player->Character::removeItem(item, item->getAmount());
+    }
+  }
+  for (const auto& p : snapshot.inventory) {
+    player->Character::addItem(Item::create(p.first), p.second);
+  }
+  for (const auto& jsonFileName : snapshot.equipment) {
+    if (jsonFileName.empty()) {
+      continue;
+    }
+    shared_ptr<Item> item = Item::create(jsonFileName);
+    const string itemName = item->getItemProfile().name;
+    player->Character::addItem(std::move(item), 1);
+
+    for (auto i : player->getInventory()[Item::Type::EQUIPMENT]) {
+      if (i->getItemProfile().name == itemName) {
+        player->equip(dynamic_cast<Equipment*>(i));
+        break;
+      }
+    }
+  }
+
+  // Restore the skills. Skills which the player already has are kept as is.
+  for (const auto& skills : player->getSkillBook()) {
+    const vector<Skill*> skillsCopy(skills.begin(), skills.end());
+    for (auto skill : skillsCopy) {
+      if (std::find(snapshot.skills.begin(), snapshot.skills.end(),
+                    skill->getSkillProfile().jsonFileName) == snapshot.skills.end()) {
+        player->removeSkill(skill);
+      }
+    }
+  }
+  for (const auto& jsonFileName : snapshot.skills) {
+    bool hasSkill = false;
+    for (const auto& skills : player->getSkillBook()) {
+      for (auto skill : skills) {
+        hasSkill |= skill->getSkillProfile().jsonFileName == jsonFileName;
+      }
+    }
+    if (!hasSkill) {
+      player->addSkill(Skill::create(jsonFileName, player));
+    }
+  }
+
+  player->setPosition(snapshot.playerX, snapshot.playerY);
+
+  // Restore quest progress.
+  QuestBook& questBook = player->getQuestBook();
+  for (auto& q : questBook._questMapper) {
+    if (q.second) {
+      q.second->restoreProgress(false, -1);
+    }
+  }
+  questBook._inProgressQuests.clear();
+  questBook._completedQuests.clear();
+
+  auto restoreQuests = [&questBook](const vector<GameState::QuestProgress>& quests,
+                                    vector<Quest*>* questList) {
+    for (const auto& progress : quests) {
+      Quest* quest = questBook.getQuest(progress.jsonFileName);
+      if (!quest) {
+        VGLOG(LOG_WARN, "Unknown quest in save file: %s", progress.jsonFileName.c_str());
+        continue;
+      }
+      restoreQuestProgress(quest, progress);
+      if (questList) {
+        questList->push_back(quest);
+      }
+    }
+  };
+  restoreQuests(snapshot.inProgressQuests, &questBook._inProgressQuests);
+  restoreQuests(snapshot.completedQuests, &questBook._completedQuests);
+  restoreQuests(snapshot.unlockedQuests, nullptr);
 
-ifstream& operator>>(ifstream& ifs, GameState& state) {
-  return ifs;
+  // Restore the party. Members that are waiting in other maps
+  // will be shown by GameMap::createNpcs() once the player gets there.
+  const string& tmxMapFileName = GameMapManager::getInstance()->getGameMap()->getTmxTiledMapFileName();
+  for (const auto& m : snapshot.partyMembers) {
+    auto npc = std::make_shared<Npc>(m.jsonFileName);
+    party->addMember(npc);
+
+    if (!m.isWaiting) {
+      npc->showOnMap(snapshot.playerX * kPpm, snapshot.playerY * kPpm);
+      continue;
+    }
+
+    party->addWaitingMember(m.jsonFileName, m.waitingTmxMapFileName, m.waitingX, m.waitingY);
+    if (m.waitingTmxMapFileName == tmxMapFileName) {
+      npc->showOnMap(m.waitingX * kPpm, m.waitingY * kPpm);
+    }
+  }
+}
+
+void GameState::replayGlobalStates(const vector<SaveJournal::Record>& records) {
+  for (const auto& r : records) {
+    switch (r.type) {
+      case SaveJournal::Record::Type::PORTAL_STATE_CHANGED:
+        GameMap::Portal::setLocked(r.target, r.value, r.flag);
+        break;
+      case SaveJournal::Record::Type::NPC_KILLED:
+        if (r.flag) {
+          Npc::setNpcAllowedToSpawn(r.target, false);
+        }
+        break;
+      case SaveJournal::Record::Type::DIALOGUE_TREE_UPDATED:
+        DialogueTree::_latestNpcDialogueTree[r.target] = r.extra;
+        break;
+      case SaveJournal::Record::Type::DIALOGUE_TREE_CLEARED:
+        DialogueTree::_latestNpcDialogueTree.erase(r.target);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+void GameState::replayPlayer(const vector<SaveJournal::Record>& records) {
+  Player* player = GameMapManager::getInstance()->getPlayer();
+  QuestBook& questBook = player->getQuestBook();
+
+  auto findQuest = [&questBook](const string& jsonFileName) -> Quest* {
+    Quest* quest = questBook.getQuest(jsonFileName);
+    if (!quest) {
+      VGLOG(LOG_WARN, "Unknown quest in save journal: %s", jsonFileName.c_str());
+    }
+    return quest;
+  };
+
+  for (const auto& r : records) {
+    switch (r.type) {
+      case SaveJournal::Record::Type::ITEM_ADDED:
+        player->Character::addItem(Item::create(r.target), r.value);
+        break;
+      case SaveJournal::Record::Type::ITEM_REMOVED: {
+        Item* item = findInventoryItem(player, r.target);
+        if (item) {
+          player->Character::removeItem(item, r.value);
+        }
+        break;
+      }
+      case SaveJournal::Record::Type::ITEM_EQUIPPED: {
+        Equipment* equipment = dynamic_cast<Equipment*>(findInventoryItem(player, r.target));
+        if (equipment) {
+          player->equip(equipment);
+        }
+        break;
+      }
+      case SaveJournal::Record::Type::ITEM_UNEQUIPPED:
+        player->unequip(static_cast<Equipment::Type>(r.value));
+        break;
+      case SaveJournal::Record::Type::QUEST_STAGE_ADVANCED: {
+        Quest* quest = findQuest(r.target);
+        if (!quest) {
+          break;
+        }
+        quest->restoreProgress(true, r.value);
+
+        vector<Quest*>& inProgressQuests = questBook._inProgressQuests;
+        auto it = std::find(inProgressQuests.begin(), inProgressQuests.end(), quest);
+        if (!quest->isCompleted()) {
+          if (it == inProgressQuests.end()) {
+            inProgressQuests.push_back(quest);
+          }
+        } else {
+          if (it != inProgressQuests.end()) {
+            inProgressQuests.erase(it);
+          }
+          questBook._completedQuests.push_back(quest);
+        }
+        break;
+      }
+      case SaveJournal::Record::Type::QUEST_OBJECTIVE_UPDATED: {
+        Quest* quest = findQuest(r.target);
+        if (!quest || quest->getCurrentStageIdx() < 0 || quest->isCompleted()) {
+          break;
+        }
+        auto o = dynamic_cast<KillTargetObjective*>(quest->getCurrentStage().objective.get());
+        if (o) {
+          o->setCurrentAmount(r.value);
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
 }
 
-ofstream& operator<<(ofstream& ofs, const GameState& state) {
-  return ofs;
+
+bool GameState::write(const string& filePath, const GameState::Snapshot& snapshot) {
+  VGPROFILE_SCOPE("GameState::write");
+
+  BinaryWriter payload;
+  payload << snapshot;
+  const string& data = payload.getBuffer();
+
+  uLongf compressedSize = compressBound(data.size());
+  vector<Bytef> compressed(compressedSize);
+  if (compress2(compressed.data(), &compressedSize,
+                reinterpret_cast<const Bytef*>(data.data()), data.size(),
+                _kCompressionLevel) != Z_OK) {
+    return false;
+  }
+
+  BinaryWriter header;
+  header.writeU32(_kMagic);
+  header.writeU32(_kVersion);
+  header.writeU64(snapshot.generation);
+  header.writeU32(data.size());
+  header.writeU32(crc32(0, reinterpret_cast<const Bytef*>(data.data()), data.size()));
+  header.writeU32(compressedSize);
+
+  // Write to a temporary file first, and then replace the old save with it.
+  // rename() is atomic, so there will always be a complete save file.
+  const string tmpFilePath = filePath + ".tmp";
+  FILE* fp = fopen(tmpFilePath.c_str(), "wb");
+  if (!fp) {
+    return false;
+  }
+
+  const string& h = header.getBuffer();
+  bool ok = fwrite(h.data(), 1, h.size(), fp) == h.size() &&
+            fwrite(compressed.data(), 1, compressedSize, fp) == compressedSize &&
+            fflush(fp) == 0 &&
+            fsync(fileno(fp)) == 0;
+  ok &= fclose(fp) == 0;
+
+  // The journals of the snapshot being replaced are no longer needed
+  // once it's gone (see SaveJournal).
+  uint64_t oldGeneration = 0;
+  const bool hasOldSnapshot = readGeneration(filePath, &oldGeneration);
+
+  if (!ok || std::rename(tmpFilePath.c_str(), filePath.c_str()) != 0) {
+    std::remove(tmpFilePath.c_str());
+    return false;
+  }
+
+  if (hasOldSnapshot) {
+    SaveJournal::remove(filePath, oldGeneration, snapshot.generation);
+  }
+
+  VGLOG(LOG_INFO, "Saved game to %s (%u bytes, %u compressed)",
+        filePath.c_str(), static_cast<unsigned>(data.size()), static_cast<unsigned>(compressedSize));
+  return true;
+}
+
+bool GameState::read(const string& filePath, GameState::Snapshot& snapshot) {
+  ifstream fin(filePath, std::ios::binary);
+  if (!fin.is_open()) {
+    VGLOG(LOG_ERR, "Unable to open save file: %s", filePath.c_str());
+    return false;
+  }
+  const string content((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+  BinaryReader header(content.data(), content.size());
+  const uint32_t magic = header.readU32();
+  const uint32_t version = header.readU32();
+  snapshot.generation = (version >= 2) ? header.readU64() : 0;  // v1 has no journal
+  const uint32_t size = header.readU32();
+  const uint32_t checksum = header.readU32();
+  const uint32_t compressedSize = header.readU32();
+
+  if (!header.good() || magic != _kMagic) {
+    VGLOG(LOG_ERR, "Not a save file: %s", filePath.c_str());
+    return false;
+  }
+  if (version < 1 || version > _kVersion) {
+    VGLOG(LOG_ERR, "Unsupported save file version: %u (expected <= %u)", version, _kVersion);
+    return false;
+  }
+  if (compressedSize != content.size() - header.getOffset()) {
+    VGLOG(LOG_ERR, "Truncated save file: %s", filePath.c_str());
+    return false;
+  }
+
+  // Bounded before it's allocated, since it hasn't been checked against anything yet.
+  if (static_cast<uint64_t>(size) > static_cast<uint64_t>(compressedSize) * MAX_COMPRESSION_RATIO) {
+    VGLOG(LOG_ERR, "Corrupted save file: %s (claims %u bytes from %u compressed)",
+          filePath.c_str(), size, compressedSize);
+    return false;
+  }
+
+  vector<char> data(size);
+  uLongf dataSize = size;
+  if (uncompress(reinterpret_cast<Bytef*>(data.data()), &dataSize,
+                 reinterpret_cast<const Bytef*>(content.data() + header.getOffset()),
+                 compressedSize) != Z_OK ||
+      dataSize != size ||
+      crc32(0, reinterpret_cast<const Bytef*>(data.data()), size) != checksum) {
+    VGLOG(LOG_ERR, "Corrupted save file: %s", filePath.c_str());
+    return false;
+  }
+
+  BinaryReader payload(data.data(), data.size());
+  payload >> snapshot;
+  if (!payload.good()) {
+    VGLOG(LOG_ERR, "Corrupted save file: %s", filePath.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool GameState::readGeneration(const string& filePath, uint64_t* generation) {
+  ifstream fin(filePath, std::ios::binary);
+  char buf[16];
+  if (!fin.is_open() || !fin.read(buf, sizeof(buf))) {
+    return false;
+  }
+
+  BinaryReader header(buf, sizeof(buf));
+  const uint32_t magic = header.readU32();
+  const uint32_t version = header.readU32();
+  if (magic != _kMagic) {
+    return false;
+  }
+  *generation = (version >= 2) ? header.readU64() : 0;
+  return true;
+}
+
+
+BinaryWriter& operator<<(BinaryWriter& writer, const GameState::Snapshot& snapshot) {
+  writer.writeString(snapshot.tmxMapFileName);
+  writer.writeFloat(snapshot.playerX);
+  writer.writeFloat(snapshot.playerY);
+
+  for (int val : {snapshot.level, snapshot.exp,
+                  snapshot.fullHealth, snapshot.fullStamina, snapshot.fullMagicka,
+                  snapshot.health, snapshot.stamina, snapshot.magicka,
+                  snapshot.strength, snapshot.dexterity, snapshot.intelligence, snapshot.luck,
+                  snapshot.baseMeleeDamage}) {
+    writer.writeI32(val);
+  }
+  writer.writeFloat(snapshot.moveSpeed);
+  writer.writeFloat(snapshot.jumpHeight);
+
+  writer.writeU32(snapshot.inventory.size());
+  for (const auto& p : snapshot.inventory) {
+    writer.writeString(p.first);
+    writer.writeI32(p.second);
+  }
+  writer.writeU32(snapshot.equipment.size());
+  for (const auto& e : snapshot.equipment) {
+    writer.writeString(e);
+  }
+  writer.writeU32(snapshot.skills.size());
+  for (const auto& s : snapshot.skills) {
+    writer.writeString(s);
+  }
+
+  writeVector(writer, snapshot.inProgressQuests);
+  writeVector(writer, snapshot.completedQuests);
+  writeVector(writer, snapshot.unlockedQuests);
+  writeVector(writer, snapshot.partyMembers);
+
+  writer.writeU32(snapshot.portalStates.size());
+  for (const auto& p : snapshot.portalStates) {
+    writer.writeString(p.first);
+    writer.writeU32(p.second.size());
+    for (const auto& portal : p.second) {
+      writer.writeI32(portal.first);
+      writer.writeBool(portal.second);
+    }
+  }
+  writer.writeU32(snapshot.latestNpcDialogueTrees.size());
+  for (const auto& p : snapshot.latestNpcDialogueTrees) {
+    writer.writeString(p.first);
+    writer.writeString(p.second);
+  }
+  writer.writeU32(snapshot.npcSpawningBlacklist.size());
+  for (const auto& s : snapshot.npcSpawningBlacklist) {
+    writer.writeString(s);
+  }
+  return writer;
+}
+
+BinaryReader& operator>>(BinaryReader& reader, GameState::Snapshot& snapshot) {
+  snapshot.tmxMapFileName = reader.readString();
+  snapshot.playerX = reader.readFloat();
+  snapshot.playerY = reader.readFloat();
+
+  for (int* val : {&snapshot.level, &snapshot.exp,
+                   &snapshot.fullHealth, &snapshot.fullStamina, &snapshot.fullMagicka,
+                   &snapshot.health, &snapshot.stamina, &snapshot.magicka,
+                   &snapshot.strength, &snapshot.dexterity, &snapshot.intelligence, &snapshot.luck,
+                   &snapshot.baseMeleeDamage}) {
+    *val = reader.readI32();
+  }
+  snapshot.moveSpeed = reader.readFloat();
+  snapshot.jumpHeight = reader.readFloat();
+
+  snapshot.inventory.clear();
+  for (uint32_t i = 0, size = reader.readU32(); i < size && reader.good(); i++) {
+    string jsonFileName = reader.readString();
+    snapshot.inventory.push_back({std::move(jsonFileName), reader.readI32()});
+  }
+  snapshot.equipment.clear();
+  for (uint32_t i = 0, size = reader.readU32(); i < size && reader.good(); i++) {
+    snapshot.equipment.push_back(reader.readString());
+  }
+  snapshot.skills.clear();
+  for (uint32_t i = 0, size = reader.readU32(); i < size && reader.good(); i++) {
+    snapshot.skills.push_back(reader.readString());
+  }
+
+  readVector(reader, snapshot.inProgressQuests);
+  readVector(reader, snapshot.completedQuests);
+  readVector(reader, snapshot.unlockedQuests);
+  readVector(reader, snapshot.partyMembers);
+
+  snapshot.portalStates.clear();
+  for (uint32_t i = 0, size = reader.readU32(); i < size && reader.good(); i++) {
+    auto& portals = snapshot.portalStates[reader.readString()];
+    for (uint32_t j = 0, portalsSize = reader.readU32(); j < portalsSize && reader.good(); j++) {
+      int portalId = reader.readI32();
+      portals.push_back({portalId, reader.readBool()});
+    }
+  }
+  snapshot.latestNpcDialogueTrees.clear();
+  for (uint32_t i = 0, size = reader.readU32(); i < size && reader.good(); i++) {
+    string npcJsonFileName = reader.readString();
+    snapshot.latestNpcDialogueTrees[npcJsonFileName] = reader.readString();
+  }
+  snapshot.npcSpawningBlacklist.clear();
+  for (uint32_t i = 0, size = reader.readU32(); i < size && reader.good(); i++) {
+    snapshot.npcSpawningBlacklist.insert(reader.readString());
+  }
+  return reader;
 }
 
 }  // namespace vigilante
@@ -2,25 +2,130 @@
 #ifndef VIGILANTE_GAME_STATE_H_
 #define VIGILANTE_GAME_STATE_H_
 
+#include <array>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "gameplay/SaveJournal.h"
 
 namespace vigilante {
 
+class BinaryReader;
+class BinaryWriter;
+
+// A save file is a compressed, versioned binary snapshot of everything
+// that outlives a GameMap: the player (and its party), quest progress,
+// and the global portal/dialogue/npc spawning states.
+//
+// save() only copies the current state into a Snapshot on the calling
+// (main) thread. Serialization, compression and the actual file write
+// happen on a worker thread, and the file is replaced atomically,
+// so a crash in the middle of a save never corrupts the previous one.
+//
+// Changes made after a snapshot is taken go into its SaveJournal,
+// which is replayed on top of the snapshot by load().
 class GameState {
  public:
-  explicit GameState();
+  struct QuestProgress {
+    std::string jsonFileName;
+    bool isUnlocked;
+    int currentStageIdx;
+    int objectiveProgress;
+  };
+
+  struct PartyMember {
+    std::string jsonFileName;
+    bool isWaiting;
+    std::string waitingTmxMapFileName;
+    float waitingX;
+    float waitingY;
+  };
+
+  struct Snapshot {
+    // Identifies this snapshot and its journal. Stored in the file header.
+    uint64_t generation;
+
+    std::string tmxMapFileName;
+    float playerX;
+    float playerY;
+
+    // The parts of Character::Profile which may change during the game.
+    int level;
+    int exp;
+    int fullHealth;
+    int fullStamina;
+    int fullMagicka;
+    int health;
+    int stamina;
+    int magicka;
+    int strength;
+    int dexterity;
+    int intelligence;
+    int luck;
+    int baseMeleeDamage;
+    float moveSpeed;
+    float jumpHeight;
+
+    std::vector<std::pair<std::string, int>> inventory;  // item json, amount
+    std::vector<std::string> equipment;  // item json (or "") of each slot
+    std::vector<std::string> skills;
+
+    std::vector<QuestProgress> inProgressQuests;
+    std::vector<QuestProgress> completedQuests;
+    std::vector<QuestProgress> unlockedQuests;  // unlocked, but not started yet
+
+    std::vector<PartyMember> partyMembers;
+
+    std::unordered_map<std::string, std::vector<std::pair<int, bool>>> portalStates;
+    std::unordered_map<std::string, std::string> latestNpcDialogueTrees;
+    std::unordered_set<std::string> npcSpawningBlacklist;
+  };
+
+  explicit GameState(const std::string& filePath=getDefaultFilePath());
   virtual ~GameState() = default;
 
-  virtual void load();
+  // Reads the save file, then restores the game from it. The GameMap
+  // is loaded asynchronously (see GameMapManager::loadGameMap()).
+  // @return false if the save file is missing, corrupted or incompatible.
+  virtual bool load();
+
+  // Captures the current game and writes it in background.
   virtual void save();
 
+  // Blocks until all pending writes have finished. Called by load(), and
+  // before quitting to the main menu or exiting (see AppDelegate).
+  static void waitForPendingWrites();
+
+  static std::string getDefaultFilePath();
+  static bool exists(const std::string& filePath);
+
   const std::string& getFilePath() const;
   void setFilePath(const std::string& filePath);
 
-  friend std::ifstream& operator>>(std::ifstream& is, GameState& state);
-  friend std::ofstream& operator<<(std::ofstream& os, const GameState& state);
+  friend BinaryReader& operator>>(BinaryReader& reader, GameState::Snapshot& snapshot);
+  friend BinaryWriter& operator<<(BinaryWriter& writer, const GameState::Snapshot& snapshot);
 
  private:
+  // Main thread only.
+  static void capture(GameState::Snapshot& snapshot);
+  static void restoreGlobalStates(const GameState::Snapshot& snapshot);
+  static void restorePlayer(const GameState::Snapshot& snapshot);
+  static void replayGlobalStates(const std::vector<SaveJournal::Record>& records);
+  static void replayPlayer(const std::vector<SaveJournal::Record>& records);
+
+  // Any thread.
+  static bool write(const std::string& filePath, const GameState::Snapshot& snapshot);
+  static bool read(const std::string& filePath, GameState::Snapshot& snapshot);
+  static bool readGeneration(const std::string& filePath, uint64_t* generation);
+
+  static const uint32_t _kMagic;
+  static const uint32_t _kVersion;
+  static const int _kCompressionLevel;
+
   std::string _filePath;
 };
 
@@ -0,0 +1,283 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "SaveJournal.h"
+
+#include <fstream>
+#include <iterator>
+
+extern "C" {
+#include <unistd.h> // truncate
+}
+
+#include <zlib.h>
+#include "gameplay/GameState.h"
+#include "util/BinaryStream.h"
+#include "util/Logger.h"
+
+// A chain can't possibly be longer than this, unless the files are corrupted.
+#define MAX_CHAIN_LENGTH 4096
+
+using std::string;
+using std::vector;
+using std::ifstream;
+
+namespace vigilante {
+
+const uint32_t SaveJournal::_kMagic = 0x4e4a4756;  // "VGJN"
+const uint32_t SaveJournal::_kVersion = 1;
+const int SaveJournal::_kCompactionThreshold = 256;
+
+SaveJournal* SaveJournal::getInstance() {
+  static SaveJournal instance;
+  return &instance;
+}
+
+SaveJournal::SaveJournal()
+    : _saveFilePath(),
+      _generation(),
+      _file(),
+      _recordCount(),
+      _suppressionDepth() {}
+
+SaveJournal::~SaveJournal() {
+  close();
+}
+
+
+bool SaveJournal::open(const string& saveFilePath, uint64_t generation, bool append) {
+  // Link the current journal to the new one before closing it.
+  if (_file && !append && _saveFilePath == saveFilePath) {
+    record({Record::Type::NEXT_JOURNAL, "", "", 0, false, generation});
+  }
+  close();
+
+  const string filePath = getFilePath(saveFilePath, generation);
+  vector<Record> records;
+  size_t validSize = 0;
+  const bool resume = append && read(saveFilePath, generation, records, &validSize);
+  if (resume) {
+    // Drop the torn record (if any), or nothing appended after it could be read.
+    truncate(filePath.c_str(), validSize);
+  }
+
+  _file = fopen(filePath.c_str(), (resume) ? "ab" : "wb");
+  if (!_file) {
+    VGLOG(LOG_ERR, "Unable to open save journal: %s", filePath.c_str());
+    return false;
+  }
+
+  _saveFilePath = saveFilePath;
+  _generation = generation;
+  _recordCount = records.size();
+
+  if (ftell(_file) == 0) {
+    BinaryWriter header;
+    header.writeU32(_kMagic);
+    header.writeU32(_kVersion);
+    header.writeU64(generation);
+    const string& h = header.getBuffer();
+    fwrite(h.data(), 1, h.size(), _file);
+    fflush(_file);
+  }
+  return true;
+}
+
+void SaveJournal::close() {
+  if (_file) {
+    fclose(_file);
+    _file = nullptr;
+  }
+}
+
+void SaveJournal::update() {
+  if (_file && _recordCount >= _kCompactionThreshold) {
+    VGLOG(LOG_INFO, "Compacting save journal (%d records)", _recordCount);
+    GameState(_saveFilePath).save();
+  }
+}
+
+
+void SaveJournal::recordItemAdded(const string& itemJsonFileName, int amount) {
+  record({Record::Type::ITEM_ADDED, itemJsonFileName, "", amount, false, 0});
+}
+
+void SaveJournal::recordItemRemoved(const string& itemJsonFileName, int amount) {
+  record({Record::Type::ITEM_REMOVED, itemJsonFileName, "", amount, false, 0});
+}
+
+void SaveJournal::recordItemEquipped(const string& itemJsonFileName) {
+  record({Record::Type::ITEM_EQUIPPED, itemJsonFileName, "", 0, false, 0});
+}
+
+void SaveJournal::recordItemUnequipped(int equipmentType) {
+  record({Record::Type::ITEM_UNEQUIPPED, "", "", equipmentType, false, 0});
+}
+
+void SaveJournal::recordQuestStageAdvanced(const string& questJsonFileName, int currentStageIdx) {
+  record({Record::Type::QUEST_STAGE_ADVANCED, questJsonFileName, "", currentStageIdx, false, 0});
+}
+
+void SaveJournal::recordQuestObjectiveUpdated(const string& questJsonFileName, int currentAmount) {
+  record({Record::Type::QUEST_OBJECTIVE_UPDATED, questJsonFileName, "", currentAmount, false, 0});
+}
+
+void SaveJournal::recordPortalStateChanged(const string& tmxMapFileName, int portalId, bool isLocked) {
+  record({Record::Type::PORTAL_STATE_CHANGED, tmxMapFileName, "", portalId, isLocked, 0});
+}
+
+void SaveJournal::recordNpcKilled(const string& npcJsonFileName, bool isBlacklisted) {
+  record({Record::Type::NPC_KILLED, npcJsonFileName, "", 0, isBlacklisted, 0});
+}
+
+void SaveJournal::recordDialogueTreeUpdated(const string& npcJsonFileName,
+                                            const string& dialogueTreeJsonFileName) {
+  record({Record::Type::DIALOGUE_TREE_UPDATED, npcJsonFileName, dialogueTreeJsonFileName, 0, false, 0});
+}
+
+void SaveJournal::recordDialogueTreeCleared(const string& npcJsonFileName) {
+  record({Record::Type::DIALOGUE_TREE_CLEARED, npcJsonFileName, "", 0, false, 0});
+}
+
+void SaveJournal::record(const SaveJournal::Record& record) {
+  if (!_file || _suppressionDepth > 0) {
+    return;
+  }
+
+  BinaryWriter payload;
+  payload.writeU8(record.type);
+  payload.writeString(record.target);
+  payload.writeString(record.extra);
+  payload.writeI32(record.value);
+  payload.writeBool(record.flag);
+  payload.writeU64(record.generation);
+  const string& p = payload.getBuffer();
+
+  BinaryWriter entry;
+  entry.writeU32(p.size());
+  entry.writeU32(crc32(0, reinterpret_cast<const Bytef*>(p.data()), p.size()));
+  entry.getBuffer().append(p);
+  const string& e = entry.getBuffer();
+
+  // Flushing hands the record over to the OS, so it survives a crash of the game.
+  if (fwrite(e.data(), 1, e.size(), _file) != e.size() || fflush(_file) != 0) {
+    VGLOG(LOG_ERR, "Failed to write to save journal of %s", _saveFilePath.c_str());
+    return;
+  }
+  _recordCount++;
+}
+
+
+bool SaveJournal::isOpen() const {
+  return _file != nullptr;
+}
+
+uint64_t SaveJournal::getGeneration() const {
+  return _generation;
+}
+
+
+bool SaveJournal::read(const string& saveFilePath, uint64_t generation,
+                       vector<SaveJournal::Record>& records, size_t* validSize) {
+  ifstream fin(getFilePath(saveFilePath, generation), std::ios::binary);
+  if (!fin.is_open()) {
+    return false;
+  }
+  const string content((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+  BinaryReader reader(content.data(), content.size());
+  if (reader.readU32() != _kMagic || reader.readU32() != _kVersion ||
+      reader.readU64() != generation || !reader.good()) {
+    VGLOG(LOG_ERR, "Invalid save journal: %s", getFilePath(saveFilePath, generation).c_str());
+    return false;
+  }
+
+  size_t intactSize = reader.getOffset();
+  while (!reader.eof()) {
+    const uint32_t size = reader.readU32();
+    const uint32_t checksum = reader.readU32();
+    const size_t offset = reader.getOffset();
+    if (!reader.good() || size > content.size() - offset ||
+        crc32(0, reinterpret_cast<const Bytef*>(content.data() + offset), size) != checksum) {
+      VGLOG(LOG_WARN, "Ignoring the torn record at the end of the save journal.");
+      break;
+    }
+
+    BinaryReader payload(content.data() + offset, size);
+    Record record;
+    record.type = static_cast<Record::Type>(payload.readU8());
+    record.target = payload.readString();
+    record.extra = payload.readString();
+    record.value = payload.readI32();
+    record.flag = payload.readBool();
+    record.generation = payload.readU64();
+    if (!payload.good() || record.type >= Record::Type::SIZE) {
+      VGLOG(LOG_WARN, "Ignoring the malformed record at the end of the save journal.");
+      break;
+    }
+    records.push_back(std::move(record));
+    reader.skip(size);
+    intactSize = reader.getOffset();
+  }
+
+  if (validSize) {
+    *validSize = intactSize;
+  }
+  return true;
+}
+
+uint64_t SaveJournal::readChain(const string& saveFilePath, uint64_t generation,
+                                vector<SaveJournal::Record>& records) {
+  for (int i = 0; i < MAX_CHAIN_LENGTH; i++) {
+    vector<Record> journalRecords;
+    if (!read(saveFilePath, generation, journalRecords)) {
+      break;
+    }
+
+    const bool hasNext = !journalRecords.empty() &&
+                         journalRecords.back().type == Record::Type::NEXT_JOURNAL;
+    const uint64_t nextGeneration = (hasNext) ? journalRecords.back().generation : 0;
+    if (hasNext) {
+      journalRecords.pop_back();
+    }
+    records.insert(records.end(),
+                   std::make_move_iterator(journalRecords.begin()),
+                   std::make_move_iterator(journalRecords.end()));
+    if (!hasNext) {
+      break;
+    }
+    generation = nextGeneration;
+  }
+  return generation;
+}
+
+void SaveJournal::remove(const string& saveFilePath,
+                         uint64_t fromGeneration, uint64_t toGeneration) {
+  uint64_t generation = fromGeneration;
+  for (int i = 0; i < MAX_CHAIN_LENGTH && generation != toGeneration; i++) {
+    vector<Record> records;
+    if (!read(saveFilePath, generation, records)) {
+      return;
+    }
+    std::remove(getFilePath(saveFilePath, generation).c_str());
+
+    if (records.empty() || records.back().type != Record::Type::NEXT_JOURNAL) {
+      return;
+    }
+    generation = records.back().generation;
+  }
+}
+
+string SaveJournal::getFilePath(const string& saveFilePath, uint64_t generation) {
+  return saveFilePath + "." + std::to_string(generation) + ".journal";
+}
+
+
+
+SaveJournal::ScopedSuppression::ScopedSuppression() {
+  SaveJournal::getInstance()->_suppressionDepth++;
+}
+
+SaveJournal::ScopedSuppression::~ScopedSuppression() {
+  SaveJournal::getInstance()->_suppressionDepth--;
+}
+
+}  // namespace vigilante
@@ -0,0 +1,119 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_SAVE_JOURNAL_H_
+#define VIGILANTE_SAVE_JOURNAL_H_
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vigilante {
+
+// An append-only log of the changes made to the game since the last
+// full snapshot (see GameState). Each change is appended and flushed as it
+// happens, so a crash loses at most the change being written.
+//
+// Every snapshot starts a new journal named after the snapshot's generation.
+// When the journal is rotated, a NEXT_JOURNAL record pointing to the new one
+// is appended, so that GameState::load() can replay the whole chain even if
+// the newer snapshot never made it to disk.
+class SaveJournal {
+ public:
+  struct Record {
+    enum Type : uint8_t {
+      ITEM_ADDED,  // target: item json, value: amount
+      ITEM_REMOVED,  // target: item json, value: amount
+      ITEM_EQUIPPED,  // target: item json
+      ITEM_UNEQUIPPED,  // value: equipment type
+      QUEST_STAGE_ADVANCED,  // target: quest json, value: current stage idx
+      QUEST_OBJECTIVE_UPDATED,  // target: quest json, value: current amount
+      PORTAL_STATE_CHANGED,  // target: tmx, value: portal id, flag: is locked
+      NPC_KILLED,  // target: npc json, flag: is blacklisted
+      DIALOGUE_TREE_UPDATED,  // target: npc json, extra: dialogue tree json
+      NEXT_JOURNAL,  // generation: the next journal's generation
+      DIALOGUE_TREE_CLEARED,  // target: npc json
+      SIZE
+    };
+
+    Record::Type type;
+    std::string target;
+    std::string extra;
+    int value;
+    bool flag;
+    uint64_t generation;
+  };
+
+  // Suppresses recording within its scope. Used by compound operations
+  // which are recorded as a whole, e.g. equip() calls removeItem().
+  class ScopedSuppression final {
+   public:
+    ScopedSuppression();
+    ~ScopedSuppression();
+  };
+
+  static SaveJournal* getInstance();
+  virtual ~SaveJournal();
+
+  // Starts the journal of a new snapshot (truncating any existing file),
+  // or resumes an existing one if `append` is true. If another journal
+  // of the same save is open, it is linked to the new one.
+  bool open(const std::string& saveFilePath, uint64_t generation, bool append);
+  void close();
+
+  // Compacts the journal into a full snapshot if it has grown too long.
+  // Called once per frame.
+  void update();
+
+  void recordItemAdded(const std::string& itemJsonFileName, int amount);
+  void recordItemRemoved(const std::string& itemJsonFileName, int amount);
+  void recordItemEquipped(const std::string& itemJsonFileName);
+  void recordItemUnequipped(int equipmentType);
+  void recordQuestStageAdvanced(const std::string& questJsonFileName, int currentStageIdx);
+  void recordQuestObjectiveUpdated(const std::string& questJsonFileName, int currentAmount);
+  void recordPortalStateChanged(const std::string& tmxMapFileName, int portalId, bool isLocked);
+  void recordNpcKilled(const std::string& npcJsonFileName, bool isBlacklisted);
+  void recordDialogueTreeUpdated(const std::string& npcJsonFileName,
+                                 const std::string& dialogueTreeJsonFileName);
+  void recordDialogueTreeCleared(const std::string& npcJsonFileName);
+
+  bool isOpen() const;
+  uint64_t getGeneration() const;
+
+  // Reads the journal of the given generation. A torn record at the end
+  // (e.g. the game crashed while writing it) and everything after it is ignored.
+  // @param validSize (optional) receives the size of the intact part of the file.
+  // @return false if there's no such journal.
+  static bool read(const std::string& saveFilePath, uint64_t generation,
+                   std::vector<SaveJournal::Record>& records, size_t* validSize=nullptr);
+
+  // Reads the chain of journals starting at `generation`.
+  // NEXT_JOURNAL records are followed, and not included in `records`.
+  // @return the generation of the last journal in the chain.
+  static uint64_t readChain(const std::string& saveFilePath, uint64_t generation,
+                            std::vector<SaveJournal::Record>& records);
+
+  // Removes the chain of journals starting at `fromGeneration`,
+  // up to (but not including) `toGeneration`.
+  static void remove(const std::string& saveFilePath,
+                     uint64_t fromGeneration, uint64_t toGeneration);
+
+  static std::string getFilePath(const std::string& saveFilePath, uint64_t generation);
+
+ private:
+  SaveJournal();
+  void record(const SaveJournal::Record& record);
+
+  static const uint32_t _kMagic;
+  static const uint32_t _kVersion;
+  static const int _kCompactionThreshold;
+
+  std::string _saveFilePath;
+  uint64_t _generation;
+  FILE* _file;
+  int _recordCount;
+  int _suppressionDepth;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_SAVE_JOURNAL_H_
@@ -20,151 +20,95 @@
  */
 #include "GLESDebugDraw.h"
 
-#include <cstdio>
-#include <cstdarg>
-#include <cstring>
-#include <memory>
+#include <cmath>
 
-#include "std/make_unique.h"
+#define CIRCLE_SEGMENT_COUNT 16
+#define FILL_ALPHA .2f
 
-using std::unique_ptr;
+using cocos2d::Color4B;
+using cocos2d::Color4F;
 using cocos2d::GLProgram;
 using cocos2d::GLProgramCache;
 
+namespace {
 
-GLESDebugDraw::GLESDebugDraw() : _ratio(1.0f) {
+Color4B toColor4B(const b2Color& color, float alpha) {
+  return Color4B(Color4F(color.r, color.g, color.b, alpha));
+}
+
+Color4B toFillColor4B(const b2Color& color) {
+  return Color4B(Color4F(color.r * .5f, color.g * .5f, color.b * .5f, FILL_ALPHA));
+}
+
+}  // namespace
+
+
+GLESDebugDraw::GLESDebugDraw()
+    : _ratio(1.0f),
+      _shaderProgram(),
+      _lineVertices(),
+      _triangleVertices() {
   initShader();
 }
 
-GLESDebugDraw::GLESDebugDraw(float32 ratio) : _ratio(ratio) {
+GLESDebugDraw::GLESDebugDraw(float32 ratio)
+    : _ratio(ratio),
+      _shaderProgram(),
+      _lineVertices(),
+      _triangleVertices() {
   initShader();
 }
 
 
 void GLESDebugDraw::initShader() {
-  _shaderProgram = GLProgramCache::getInstance()->getGLProgram(GLProgram::SHADER_NAME_POSITION_U_COLOR);
-  _colorLocation = glGetUniformLocation(_shaderProgram->getProgram(), "u_color");
+  _shaderProgram = GLProgramCache::getInstance()->getGLProgram(GLProgram::SHADER_NAME_POSITION_COLOR);
 }
 
-void GLESDebugDraw::DrawPolygon(const b2Vec2* old_vertices, int vertexCount, const b2Color& color) {
-  _shaderProgram->use();
-  _shaderProgram->setUniformsForBuiltins();
+void GLESDebugDraw::DrawPolygon(const b2Vec2* vertices, int vertexCount, const b2Color& color) {
+  const Color4B lineColor = toColor4B(color, 1);
 
-  unique_ptr<b2Vec2[]> vertices = std::make_unique<b2Vec2[]>(vertexCount);
-  
   for (int i = 0; i < vertexCount; i++) {
-    vertices[i] = old_vertices[i];
-    vertices[i] *= _ratio;
+    addLine(vertices[i], vertices[(i + 1) % vertexCount], lineColor);
   }
-
-  _shaderProgram->setUniformLocationWith4f(_colorLocation, color.r, color.g, color.b, 1);
-
-  glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0, vertices.get());
-  glDrawArrays(GL_LINE_LOOP, 0, vertexCount);
-
-  CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, vertexCount);
-  CHECK_GL_ERROR_DEBUG();
 }
 
-void GLESDebugDraw::DrawSolidPolygon(const b2Vec2* old_vertices, int vertexCount, const b2Color& color) {
-  _shaderProgram->use();
-  _shaderProgram->setUniformsForBuiltins();
+void GLESDebugDraw::DrawSolidPolygon(const b2Vec2* vertices, int vertexCount, const b2Color& color) {
+  const Color4B fillColor = toFillColor4B(color);
 
-  unique_ptr<b2Vec2[]> vertices = std::make_unique<b2Vec2[]>(vertexCount);
-
-  for (int i = 0; i < vertexCount; i++) {
-    vertices[i] = old_vertices[i];
-    vertices[i] *= _ratio;
+  // Box2D's polygons are convex, so they can be drawn as triangle fans.
+  for (int i = 1; i < vertexCount - 1; i++) {
+    addTriangle(vertices[0], vertices[i], vertices[i + 1], fillColor);
   }
-
-  _shaderProgram->setUniformLocationWith4f(_colorLocation, color.r * .5f, color.g * .5f, color.b * .5f, .2f);
-
-  glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0, vertices.get());
-  glDrawArrays(GL_TRIANGLE_FAN, 0, vertexCount);
-
-  _shaderProgram->setUniformLocationWith4f(_colorLocation, color.r, color.g, color.b, 1);
-  glDrawArrays(GL_LINE_LOOP, 0, vertexCount);
-
-  CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(2, vertexCount * 2);
-  CHECK_GL_ERROR_DEBUG();
+  DrawPolygon(vertices, vertexCount, color);
 }
 
 void GLESDebugDraw::DrawCircle(const b2Vec2& center, float32 radius, const b2Color& color) {
-  _shaderProgram->use();
-  _shaderProgram->setUniformsForBuiltins();
-
-  const float32 k_segments = 16.0f;
-  int vertexCount = 16;
-  const float32 k_increment = 2.0f * b2_pi / k_segments;
-  float32 theta = 0.0f;
+  const float32 k_increment = 2.0f * b2_pi / CIRCLE_SEGMENT_COUNT;
+  b2Vec2 vertices[CIRCLE_SEGMENT_COUNT];
 
-  unique_ptr<GLfloat[]> glVertices = std::make_unique<GLfloat[]>(vertexCount * 2);
-
-  for (int i = 0; i < k_segments; ++i) {
-    b2Vec2 v = center + radius * b2Vec2(cosf(theta), sinf(theta));
-    glVertices[i * 2] = v.x * _ratio;
-    glVertices[i * 2 + 1] = v.y * _ratio;
-    theta += k_increment;
+  for (int i = 0; i < CIRCLE_SEGMENT_COUNT; i++) {
+    const float32 theta = i * k_increment;
+    vertices[i] = center + radius * b2Vec2(cosf(theta), sinf(theta));
   }
-
-  _shaderProgram->setUniformLocationWith4f(_colorLocation, color.r, color.g, color.b, 1);
-  glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0, glVertices.get());
-  glDrawArrays(GL_LINE_LOOP, 0, vertexCount);
-
-  CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1,vertexCount);
-  CHECK_GL_ERROR_DEBUG();
+  DrawPolygon(vertices, CIRCLE_SEGMENT_COUNT, color);
 }
 
 void GLESDebugDraw::DrawSolidCircle(const b2Vec2& center, float32 radius, const b2Vec2& axis, const b2Color& color) {
-  _shaderProgram->use();
-  _shaderProgram->setUniformsForBuiltins();
-
-  const float32 k_segments = 16.0f;
-  int vertexCount = 16;
-  const float32 k_increment = 2.0f * b2_pi / k_segments;
-  float32 theta = 0.0f;
+  const float32 k_increment = 2.0f * b2_pi / CIRCLE_SEGMENT_COUNT;
+  b2Vec2 vertices[CIRCLE_SEGMENT_COUNT];
 
-  unique_ptr<GLfloat[]> glVertices = std::make_unique<GLfloat[]>(vertexCount * 2);
-
-  for (int i = 0; i < k_segments; ++i) {
-    b2Vec2 v = center + radius * b2Vec2(cosf(theta), sinf(theta));
-    glVertices[i * 2] = v.x * _ratio;
-    glVertices[i * 2 + 1] = v.y * _ratio;
-    theta += k_increment;
+  for (int i = 0; i < CIRCLE_SEGMENT_COUNT; i++) {
+    const float32 theta = i * k_increment;
+    vertices[i] = center + radius * b2Vec2(cosf(theta), sinf(theta));
   }
-
-  _shaderProgram->setUniformLocationWith4f(_colorLocation, color.r * .5f, color.g * .5f, color.b * .5f, .2f);
-  glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0, glVertices.get());
-  glDrawArrays(GL_TRIANGLE_FAN, 0, vertexCount);
-
-  _shaderProgram->setUniformLocationWith4f(_colorLocation, color.r, color.g, color.b, 1);
-  glDrawArrays(GL_LINE_LOOP, 0, vertexCount);
+  DrawSolidPolygon(vertices, CIRCLE_SEGMENT_COUNT, color);
 
   // Draw the axis line
-  DrawSegment(center,center+radius*axis,color);
-
-  CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(2, vertexCount * 2);
-  CHECK_GL_ERROR_DEBUG();
+  DrawSegment(center, center + radius * axis, color);
 }
 
 void GLESDebugDraw::DrawSegment(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color) {
-  _shaderProgram->use();
-  _shaderProgram->setUniformsForBuiltins();
-
-  _shaderProgram->setUniformLocationWith4f(_colorLocation, color.r, color.g, color.b, 1);
-
-  GLfloat glVertices[] = {
-    p1.x * _ratio,
-    p1.y * _ratio,
-    p2.x * _ratio,
-    p2.y * _ratio
-  };
-
-  glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0, glVertices);
-  glDrawArrays(GL_LINES, 0, 2);
-
-  CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1,2);
-  CHECK_GL_ERROR_DEBUG();
+  addLine(p1, p2, toColor4B(color, 1));
 }
 
 void GLESDebugDraw::DrawTransform(const b2Transform& xf) {
@@ -179,43 +123,74 @@ void GLESDebugDraw::DrawTransform(const b2Transform& xf) {
 }
 
 void GLESDebugDraw::DrawPoint(const b2Vec2& p, float32 size, const b2Color& color) {
-  _shaderProgram->use();
-  _shaderProgram->setUniformsForBuiltins();
-
-  _shaderProgram->setUniformLocationWith4f(_colorLocation, color.r, color.g, color.b, 1);
+  // Drawn as a `size` x `size` (in pixels) quad, so that
+  // points don't need a draw call (nor a shader) of their own.
+  const float32 halfSize = size / 2 / _ratio;
+  const b2Vec2 bottomLeft(p.x - halfSize, p.y - halfSize);
+  const b2Vec2 bottomRight(p.x + halfSize, p.y - halfSize);
+  const b2Vec2 topRight(p.x + halfSize, p.y + halfSize);
+  const b2Vec2 topLeft(p.x - halfSize, p.y + halfSize);
+  const Color4B pointColor = toColor4B(color, 1);
+
+  addTriangle(bottomLeft, bottomRight, topRight, pointColor);
+  addTriangle(bottomLeft, topRight, topLeft, pointColor);
+}
 
-  GLfloat glVertices[] = {
-    p.x * _ratio,
-    p.y * _ratio
+void GLESDebugDraw::DrawAABB(b2AABB* aabb, const b2Color& color) {
+  const b2Vec2 vertices[] = {
+    aabb->lowerBound,
+    b2Vec2(aabb->upperBound.x, aabb->lowerBound.y),
+    aabb->upperBound,
+    b2Vec2(aabb->lowerBound.x, aabb->upperBound.y)
   };
-
-  glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0, glVertices);
-  glDrawArrays(GL_POINTS, 0, 1);
-
-  CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1,1);
-  CHECK_GL_ERROR_DEBUG();
+  DrawPolygon(vertices, 4, color);
 }
 
-void GLESDebugDraw::DrawAABB(b2AABB* aabb, const b2Color& color) {
+void GLESDebugDraw::flush() {
+  if (_lineVertices.empty() && _triangleVertices.empty()) {
+    return;
+  }
+
   _shaderProgram->use();
   _shaderProgram->setUniformsForBuiltins();
+  cocos2d::GL::enableVertexAttribs(cocos2d::GL::VERTEX_ATTRIB_FLAG_POSITION |
+                                   cocos2d::GL::VERTEX_ATTRIB_FLAG_COLOR);
+  cocos2d::GL::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  // The fills go first, so that the outlines are drawn on top of them.
+  const std::vector<GLESDebugDraw::Vertex>* buffers[] = {&_triangleVertices, &_lineVertices};
+  const GLenum modes[] = {GL_TRIANGLES, GL_LINES};
+
+  for (size_t i = 0; i < 2; i++) {
+    const std::vector<GLESDebugDraw::Vertex>& vertices = *buffers[i];
+    if (vertices.empty()) {
+      continue;
+    }
+
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE,
+                          sizeof(GLESDebugDraw::Vertex), &vertices[0].position);
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                          sizeof(GLESDebugDraw::Vertex), &vertices[0].color);
+    glDrawArrays(modes[i], 0, static_cast<GLsizei>(vertices.size()));
+
+    CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, vertices.size());
+  }
+  CHECK_GL_ERROR_DEBUG();
 
-  _shaderProgram->setUniformLocationWith4f(_colorLocation, color.r, color.g, color.b, 1);
-
-  GLfloat glVertices[] = {
-    aabb->lowerBound.x * _ratio,
-    aabb->lowerBound.y * _ratio,
-    aabb->upperBound.x * _ratio,
-    aabb->lowerBound.y * _ratio,
-    aabb->upperBound.x * _ratio,
-    aabb->upperBound.y * _ratio,
-    aabb->lowerBound.x * _ratio,
-    aabb->upperBound.y * _ratio
-  };
+  // clear() keeps their capacity, so nothing is allocated in the next frames.
+  _lineVertices.clear();
+  _triangleVertices.clear();
+}
 
-  glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0, glVertices);
-  glDrawArrays(GL_LINE_LOOP, 0, 4);
 
-  CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1,4);
-  CHECK_GL_ERROR_DEBUG();
+void GLESDebugDraw::addLine(const b2Vec2& p1, const b2Vec2& p2, const Color4B& color) {
+  _lineVertices.push_back({_ratio * p1, color});
+  _lineVertices.push_back({_ratio * p2, color});
+}
+
+void GLESDebugDraw::addTriangle(const b2Vec2& p1, const b2Vec2& p2, const b2Vec2& p3,
+                                const Color4B& color) {
+  _triangleVertices.push_back({_ratio * p1, color});
+  _triangleVertices.push_back({_ratio * p2, color});
+  _triangleVertices.push_back({_ratio * p3, color});
 }
@@ -21,13 +21,20 @@
 #ifndef VIGILANTE_RENDER_H_
 #define VIGILANTE_RENDER_H_
 
+#include <vector>
+
 #include <cocos2d.h>
 #include <Box2D/Box2D.h>
 
 struct b2AABB;
 
 // This class implements debug drawing callbacks that are invoked
-// inside b2World::Step.
+// inside b2World::DrawDebugData.
+//
+// The callbacks only append the shapes' lines and triangles (with per-vertex
+// colors) to two vertex buffers, which flush() draws with one glDrawArrays()
+// each, so drawing a large map costs two draw calls rather than a couple per
+// fixture. The buffers are reused across frames.
 class GLESDebugDraw : public b2Draw {
  public:
   GLESDebugDraw();
@@ -43,12 +50,25 @@ class GLESDebugDraw : public b2Draw {
   virtual void DrawPoint(const b2Vec2& p, float32 size, const b2Color& color) override;
   virtual void DrawAABB(b2AABB* aabb, const b2Color& color);
 
+  // Draws everything appended since the last flush() with the current
+  // modelview matrix, and empties the vertex buffers.
+  void flush();
+
  private:
+  struct Vertex final {
+    b2Vec2 position;  // already scaled by `_ratio`
+    cocos2d::Color4B color;
+  };
+
   void initShader();
+  void addLine(const b2Vec2& p1, const b2Vec2& p2, const cocos2d::Color4B& color);
+  void addTriangle(const b2Vec2& p1, const b2Vec2& p2, const b2Vec2& p3, const cocos2d::Color4B& color);
 
   float32 _ratio;
   cocos2d::GLProgram* _shaderProgram;
-  GLint _colorLocation;
+
+  std::vector<GLESDebugDraw::Vertex> _lineVertices;  // GL_LINES
+  std::vector<GLESDebugDraw::Vertex> _triangleVertices;  // GL_TRIANGLES
 };
 
 #endif // VIGILANTE_RENDERER_H_
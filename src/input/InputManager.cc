@@ -1,6 +1,8 @@
 // Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
 #include "input/InputManager.h"
 
+#include "input/InputRecorder.h"
+#include "map/GameMapManager.h"
 #include "ui/TextField.h"
 #include "util/Logger.h"
 
@@ -34,28 +36,22 @@ void InputManager::activate(Scene* scene) {
   _keyboardEvLstnr = EventListenerKeyboard::create();
 
   // Capture "this" by value.
+  // While a recorded session is being replayed, the keyboard is ignored.
   _keyboardEvLstnr->onKeyPressed = [this](EventKeyboard::KeyCode keyCode, Event* e) {
-    if (keyCode == EventKeyboard::KeyCode::KEY_CAPS_LOCK) {
-      _isCapsLocked = !_isCapsLocked;
+    InputRecorder* recorder = InputRecorder::getInstance();
+    if (!recorder->isReplaying()) {
+      recorder->onKeyEvent(/*isPressed=*/true, keyCode, onKeyPressed(keyCode, e));
     }
+  };
 
-    if (!_specialOnKeyPressed) {
-      // We keep track of which keys have been pressed
-      // only when there is no active _specialOnKeyPressed event listener,
-      // because _specialOnKeyPressed will do whatever it needs to do
-      // with these keys.
-      _pressedKeys.insert(keyCode);
-    } else {
-      // Execute the additional onKeyPressed handler for special events.
-      // (e.g., prompting for a hotkey, receiving TextField input, etc)
-      _specialOnKeyPressed(keyCode, e);
+  _keyboardEvLstnr->onKeyReleased = [this](EventKeyboard::KeyCode keyCode, Event* e) {
+    InputRecorder* recorder = InputRecorder::getInstance();
+    if (!recorder->isReplaying()) {
+      onKeyReleased(keyCode, e);
+      recorder->onKeyEvent(/*isPressed=*/false, keyCode, false);
     }
   };
 
-  _keyboardEvLstnr->onKeyReleased = [this](EventKeyboard::KeyCode keyCode, Event*) {
-    _pressedKeys.erase(keyCode);
-  };
-  
   _scene->getEventDispatcher()->addEventListenerWithSceneGraphPriority(_keyboardEvLstnr, scene);
 }
 
@@ -66,6 +62,41 @@ void InputManager::deactivate() {
 }
 
 
+bool InputManager::onKeyPressed(EventKeyboard::KeyCode keyCode, Event* e) {
+  if (keyCode == EventKeyboard::KeyCode::KEY_CAPS_LOCK) {
+    _isCapsLocked = !_isCapsLocked;
+  }
+
+  if (!_specialOnKeyPressed) {
+    // We keep track of which keys have been pressed
+    // only when there is no active _specialOnKeyPressed event listener,
+    // because _specialOnKeyPressed will do whatever it needs to do
+    // with these keys.
+    _pressedKeys.insert(keyCode);
+    return false;
+  }
+
+  // Execute the additional onKeyPressed handler for special events.
+  // (e.g., prompting for a hotkey, receiving TextField input, etc)
+  // It may run a console command, which may touch the b2World.
+  GameMapManager::getInstance()->joinWorldStep();
+  _specialOnKeyPressed(keyCode, e);
+  return true;
+}
+
+void InputManager::onKeyReleased(EventKeyboard::KeyCode keyCode, Event*) {
+  _pressedKeys.erase(keyCode);
+}
+
+bool InputManager::injectKeyEvent(bool isPressed, EventKeyboard::KeyCode keyCode) {
+  if (isPressed) {
+    return onKeyPressed(keyCode, nullptr);
+  }
+  onKeyReleased(keyCode, nullptr);
+  return false;
+}
+
+
 bool InputManager::isKeyPressed(EventKeyboard::KeyCode keyCode) const {
   return _pressedKeys.find(keyCode) != _pressedKeys.end();
 }
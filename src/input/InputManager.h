@@ -41,9 +41,18 @@ class InputManager {
   void setSpecialOnKeyPressed(const OnKeyPressedEvLstnr& onKeyPressed);
   void clearSpecialOnKeyPressed();
 
+  // Feeds a key event as if it were received from the keyboard.
+  // Used by InputRecorder to replay recorded sessions.
+  // @return true if the event has been routed to _specialOnKeyPressed.
+  bool injectKeyEvent(bool isPressed, cocos2d::EventKeyboard::KeyCode keyCode);
+
  private:
   InputManager();
 
+  // @return true if the event has been routed to _specialOnKeyPressed.
+  bool onKeyPressed(cocos2d::EventKeyboard::KeyCode keyCode, cocos2d::Event* e);
+  void onKeyReleased(cocos2d::EventKeyboard::KeyCode keyCode, cocos2d::Event* e);
+
   cocos2d::Scene* _scene;
   cocos2d::EventListenerKeyboard* _keyboardEvLstnr;
 
@@ -0,0 +1,270 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "InputRecorder.h"
+
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+
+#include "input/InputManager.h"
+#include "util/Logger.h"
+#include "util/StringUtil.h"
+
+#define RECORDING_HEADER "vigilante-input-recording"
+#define RECORDING_VERSION 2
+
+using std::string;
+using std::ifstream;
+using std::ofstream;
+using cocos2d::EventKeyboard;
+
+namespace vigilante {
+
+const float InputRecorder::_kBaselineTolerance = .1f;
+
+InputRecorder* InputRecorder::getInstance() {
+  static InputRecorder instance;
+  return &instance;
+}
+
+InputRecorder::InputRecorder()
+    : _mode(Mode::NONE),
+      _recording(),
+      _recordingFileName(),
+      _baselineFileName(),
+      _histogramFileName(),
+      _currentTick(),
+      _nextKeyEventIdx(),
+      _firstTickTime(),
+      _lastTickTime(),
+      _frameTimeHistogram(),
+      _hasPassedBaseline(true) {}
+
+
+void InputRecorder::startRecording(const string& recordingFileName) {
+  _mode = Mode::RECORDING;
+  _recordingFileName = recordingFileName;
+  _recording = {static_cast<unsigned int>(time(nullptr)), 0, "", {}};
+  _currentTick = 0;
+  VGLOG(LOG_INFO, "Recording input to %s (seed: %u)", recordingFileName.c_str(), _recording.seed);
+}
+
+bool InputRecorder::stopRecording() {
+  if (_mode != Mode::RECORDING) {
+    return false;
+  }
+
+  _mode = Mode::NONE;
+  _recording.tickCount = _currentTick;
+
+  if (!_recording.save(_recordingFileName)) {
+    VGLOG(LOG_ERR, "Failed to save input recording to %s", _recordingFileName.c_str());
+    return false;
+  }
+  VGLOG(LOG_INFO, "Saved %u ticks of input to %s", _currentTick, _recordingFileName.c_str());
+  return true;
+}
+
+
+bool InputRecorder::startReplaying(const string& recordingFileName) {
+  if (!_recording.load(recordingFileName)) {
+    VGLOG(LOG_ERR, "Failed to load input recording from %s", recordingFileName.c_str());
+    return false;
+  }
+
+  _mode = Mode::REPLAYING;
+  _recordingFileName = recordingFileName;
+  _currentTick = 0;
+  _nextKeyEventIdx = 0;
+  _frameTimeHistogram.clear();
+  VGLOG(LOG_INFO, "Replaying %u ticks of input from %s (seed: %u)",
+        _recording.tickCount, recordingFileName.c_str(), _recording.seed);
+  return true;
+}
+
+void InputRecorder::setBaselineFileName(const string& baselineFileName) {
+  _baselineFileName = baselineFileName;
+}
+
+void InputRecorder::setHistogramFileName(const string& histogramFileName) {
+  _histogramFileName = histogramFileName;
+}
+
+
+void InputRecorder::beginTick() {
+  if (_mode != Mode::RECORDING && _mode != Mode::REPLAYING) {
+    return;
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  if (_currentTick == 0) {
+    _firstTickTime = now;
+  } else if (_mode == Mode::REPLAYING) {
+    _frameTimeHistogram.add(
+        std::chrono::duration<float, std::milli>(now - _lastTickTime).count());
+  }
+  _lastTickTime = now;
+  _currentTick++;
+
+  if (_mode != Mode::REPLAYING) {
+    return;
+  }
+
+  if (_currentTick > _recording.tickCount) {
+    finishReplay();
+    return;
+  }
+
+  const auto& keyEvents = _recording.keyEvents;
+  for (; _nextKeyEventIdx < keyEvents.size() &&
+         keyEvents[_nextKeyEventIdx].tick <= _currentTick; _nextKeyEventIdx++) {
+    const KeyEvent& e = keyEvents[_nextKeyEventIdx];
+    bool isRoutedToSpecialOnKeyPressed
+      = InputManager::getInstance()->injectKeyEvent(e.isPressed, e.keyCode);
+
+    if (isRoutedToSpecialOnKeyPressed != e.isRoutedToSpecialOnKeyPressed) {
+      VGLOG(LOG_WARN, "Replay diverged at tick %u: key %d was %s routed to specialOnKeyPressed",
+            _currentTick, static_cast<int>(e.keyCode),
+            (e.isRoutedToSpecialOnKeyPressed) ? "not" : "unexpectedly");
+    }
+  }
+}
+
+void InputRecorder::onGameStarted(const string& gameSaveFilePath) {
+  if (_mode != Mode::RECORDING || _currentTick > 0) {
+    return;
+  }
+  _recording.gameSaveFilePath = gameSaveFilePath;
+}
+
+void InputRecorder::onKeyEvent(bool isPressed, EventKeyboard::KeyCode keyCode,
+                               bool isRoutedToSpecialOnKeyPressed) {
+  if (_mode != Mode::RECORDING || _currentTick == 0) {
+    return;
+  }
+
+  // This event arrives between two ticks, so it will be handled by the next one.
+  const float timestamp = std::chrono::duration<float>(
+      std::chrono::steady_clock::now() - _firstTickTime).count();
+  _recording.keyEvents.push_back(
+      {_currentTick + 1, timestamp, isPressed, keyCode, isRoutedToSpecialOnKeyPressed});
+}
+
+void InputRecorder::finishReplay() {
+  _mode = Mode::REPLAY_FINISHED;
+  VGLOG(LOG_INFO, "Replay finished (%d frames, mean: %.2fms, p99: %.2fms)",
+        _frameTimeHistogram.getSampleCount(),
+        _frameTimeHistogram.getMean(),
+        _frameTimeHistogram.getPercentile(99));
+
+  if (!_histogramFileName.empty() && !_frameTimeHistogram.save(_histogramFileName)) {
+    VGLOG(LOG_ERR, "Failed to save frame time histogram to %s", _histogramFileName.c_str());
+  }
+
+  if (_baselineFileName.empty()) {
+    return;
+  }
+
+  FrameTimeHistogram baseline;
+  if (!baseline.load(_baselineFileName)) {
+    VGLOG(LOG_ERR, "Failed to load baseline from %s", _baselineFileName.c_str());
+    _hasPassedBaseline = false;
+    return;
+  }
+
+  string report;
+  _hasPassedBaseline = _frameTimeHistogram.compare(baseline, _kBaselineTolerance, &report);
+  for (const auto& line : string_util::split(report, '\n')) {
+    VGLOG((_hasPassedBaseline) ? LOG_INFO : LOG_WARN, "%s", line.c_str());
+  }
+}
+
+
+bool InputRecorder::isActive() const {
+  return _mode == Mode::RECORDING || _mode == Mode::REPLAYING;
+}
+
+bool InputRecorder::isRecording() const {
+  return _mode == Mode::RECORDING;
+}
+
+bool InputRecorder::isReplaying() const {
+  return _mode == Mode::REPLAYING;
+}
+
+bool InputRecorder::isReplayFinished() const {
+  return _mode == Mode::REPLAY_FINISHED;
+}
+
+bool InputRecorder::hasPassedBaseline() const {
+  return _hasPassedBaseline;
+}
+
+unsigned int InputRecorder::getSeed() const {
+  return _recording.seed;
+}
+
+uint32_t InputRecorder::getCurrentTick() const {
+  return _currentTick;
+}
+
+const string& InputRecorder::getGameSaveFilePath() const {
+  return _recording.gameSaveFilePath;
+}
+
+
+bool InputRecorder::Recording::save(const string& fileName) const {
+  ofstream fout(fileName);
+  if (!fout.is_open()) {
+    return false;
+  }
+
+  fout << RECORDING_HEADER << " " << RECORDING_VERSION << "\n";
+  fout << "seed " << seed << "\n";
+  fout << "ticks " << tickCount << "\n";
+  fout << "save " << std::quoted(gameSaveFilePath) << "\n";
+  for (const auto& e : keyEvents) {
+    fout << e.tick << " "
+         << e.timestamp << " "
+         << ((e.isPressed) ? 'P' : 'R') << " "
+         << static_cast<int>(e.keyCode) << " "
+         << e.isRoutedToSpecialOnKeyPressed << "\n";
+  }
+  return fout.good();
+}
+
+bool InputRecorder::Recording::load(const string& fileName) {
+  ifstream fin(fileName);
+  if (!fin.is_open()) {
+    return false;
+  }
+
+  string header;
+  int version = 0;
+  string key;
+  if (!(fin >> header >> version) || header != RECORDING_HEADER ||
+      version < 1 || version > RECORDING_VERSION ||
+      !(fin >> key >> seed) || key != "seed" ||
+      !(fin >> key >> tickCount) || key != "ticks") {
+    return false;
+  }
+
+  // Version 1 recordings always started a new game.
+  gameSaveFilePath.clear();
+  if (version >= 2 && (!(fin >> key >> std::quoted(gameSaveFilePath)) || key != "save")) {
+    return false;
+  }
+
+  keyEvents.clear();
+
+  KeyEvent e;
+  char type = 0;
+  int keyCode = 0;
+  while (fin >> e.tick >> e.timestamp >> type >> keyCode >> e.isRoutedToSpecialOnKeyPressed) {
+    e.isPressed = (type == 'P');
+    e.keyCode = static_cast<EventKeyboard::KeyCode>(keyCode);
+    keyEvents.push_back(e);
+  }
+  return true;
+}
+
+}  // namespace vigilante
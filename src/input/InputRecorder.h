@@ -0,0 +1,108 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_INPUT_RECORDER_H_
+#define VIGILANTE_INPUT_RECORDER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <cocos2d.h>
+#include "util/FrameTimeHistogram.h"
+
+namespace vigilante {
+
+// InputRecorder records the key events received by InputManager
+// and feeds them back on the same ticks later, so that a play session
+// can be replayed as a reproducible benchmark.
+//
+// A session is only reproducible if it runs on fixed ticks (see GameScene::update()
+// and proj.linux/main.cc) and with the same rand_util seed, which is recorded
+// along with the key events.
+//
+// Key events are captured only after GameScene has started ticking, so the
+// main menu isn't recorded. Instead, the recording keeps the path of the save
+// the session was started from (if any), and a replay goes straight into
+// a GameScene started the same way (see MainMenuScene::startRecordedGame()).
+// The save must still be the same one for the replay to be reproducible.
+class InputRecorder {
+ public:
+  struct KeyEvent {
+    uint32_t tick;
+    float timestamp;  // seconds since the first tick
+    bool isPressed;  // pressed or released
+    cocos2d::EventKeyboard::KeyCode keyCode;
+    bool isRoutedToSpecialOnKeyPressed;
+  };
+
+  struct Recording {
+    bool save(const std::string& fileName) const;
+    bool load(const std::string& fileName);
+
+    unsigned int seed;
+    uint32_t tickCount;
+    std::string gameSaveFilePath;  // empty if a new game was started
+    std::vector<KeyEvent> keyEvents;
+  };
+
+  static InputRecorder* getInstance();
+  virtual ~InputRecorder() = default;
+
+  void startRecording(const std::string& recordingFileName);
+  bool stopRecording();
+
+  bool startReplaying(const std::string& recordingFileName);
+  void setBaselineFileName(const std::string& baselineFileName);
+  void setHistogramFileName(const std::string& histogramFileName);
+
+  // Called by GameScene at the beginning of every tick.
+  // While replaying, the key events of this tick are fed into InputManager.
+  void beginTick();
+
+  // Called by GameScene whenever a game is started or loaded. Only the one
+  // before the first tick is recorded. Pass an empty path for a new game.
+  void onGameStarted(const std::string& gameSaveFilePath);
+
+  // Called by InputManager for every key event it receives.
+  void onKeyEvent(bool isPressed, cocos2d::EventKeyboard::KeyCode keyCode,
+                  bool isRoutedToSpecialOnKeyPressed);
+
+  bool isActive() const;  // recording or replaying?
+  bool isRecording() const;
+  bool isReplaying() const;
+  bool isReplayFinished() const;
+  bool hasPassedBaseline() const;
+  unsigned int getSeed() const;
+  uint32_t getCurrentTick() const;
+  const std::string& getGameSaveFilePath() const;
+
+ private:
+  enum class Mode {
+    NONE,
+    RECORDING,
+    REPLAYING,
+    REPLAY_FINISHED
+  };
+
+  InputRecorder();
+  void finishReplay();
+
+  static const float _kBaselineTolerance;
+
+  Mode _mode;
+  Recording _recording;
+  std::string _recordingFileName;
+  std::string _baselineFileName;
+  std::string _histogramFileName;
+
+  uint32_t _currentTick;
+  size_t _nextKeyEventIdx;
+  std::chrono::steady_clock::time_point _firstTickTime;
+  std::chrono::steady_clock::time_point _lastTickTime;
+  FrameTimeHistogram _frameTimeHistogram;
+  bool _hasPassedBaseline;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_INPUT_RECORDER_H_
@@ -4,6 +4,7 @@
 #include <json/document.h>
 #include "AssetManager.h"
 #include "Constants.h"
+#include "DecodedImageCache.h"
 #include "std/make_unique.h"
 #include "item/Equipment.h"
 #include "item/Consumable.h"
@@ -51,7 +52,7 @@ Item::Item(const string& jsonFileName)
     : DynamicActor(ITEM_NUM_ANIMATIONS, ITEM_NUM_FIXTURES),
       _itemProfile(jsonFileName),
       _amount(1) {
-  _bodySprite = Sprite::create(getIconPath());
+  _bodySprite = Sprite::createWithTexture(DecodedImageCache::getInstance()->addImage(getIconPath()));
   _bodySprite->getTexture()->setAliasTexParameters();
 }
 
@@ -69,10 +70,9 @@ bool Item::showOnMap(float x, float y) {
              ITEM_CATEGORY_BITS,
              ITEM_MASK_BITS);  
 
-  _bodySprite = Sprite::create(getIconPath());
+  _bodySprite = Sprite::createWithTexture(DecodedImageCache::getInstance()->addImage(getIconPath()));
   _bodySprite->getTexture()->setAliasTexParameters();
-  GameMapManager::getInstance()->getLayer()->addChild(_bodySprite,
-                                                      graphical_layers::kItem);
+  GameMapManager::getInstance()->getGraphicalLayer(graphical_layers::kItem)->addChild(_bodySprite);
   return true;
 }
 
@@ -1,15 +1,17 @@
 // Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
 #include "FxManager.h"
 
+#include "AssetManager.h"
 #include "Constants.h"
 #include "StaticActor.h"
 #include "DynamicActor.h"
+#include "TextureResidencyManager.h"
 #include "character/Character.h"
 #include "map/GameMapManager.h"
 
 using std::string;
 using cocos2d::FileUtils;
-using cocos2d::Layer;
+using cocos2d::Node;
 using cocos2d::Vector;
 using cocos2d::Sequence;
 using cocos2d::CallFunc;
@@ -57,7 +59,7 @@ Sprite* FxManager::createFx(const string& textureResDir,
                             unsigned int loopCount,
                             float frameInterval) {
   bool shouldRepeatForever = loopCount == (unsigned int) -1;
-  Layer* gameMapLayer = GameMapManager::getInstance()->getLayer();
+  Node* fxLayer = GameMapManager::getInstance()->getGraphicalLayer(graphical_layers::kFx);
 
   // If the cocos2d::Animation* is not present in cache,
   // then create one and cache this animation object.
@@ -74,6 +76,8 @@ Sprite* FxManager::createFx(const string& textureResDir,
                                                         framesName,
                                                         frameInterval / kPpm);
     _animationCache.insert({cacheKey, animation});
+    // The cached animations live forever, and so must their spritesheet.
+    TextureResidencyManager::getInstance()->retain(textureResDir);
   }
 
   // Select the first frame (e.g., dust_white/0.png) as the default look of the sprite.
@@ -85,7 +89,7 @@ Sprite* FxManager::createFx(const string& textureResDir,
   SpriteBatchNode* spritesheet = SpriteBatchNode::create(spritesheetFileName);
   spritesheet->addChild(sprite);
   spritesheet->getTexture()->setAliasTexParameters();
-  gameMapLayer->addChild(spritesheet, graphical_layers::kFx);
+  fxLayer->addChild(spritesheet);
 
   // Run animation.
   Animate* animate = Animate::create(_animationCache[cacheKey]);
@@ -94,8 +98,8 @@ Sprite* FxManager::createFx(const string& textureResDir,
     sprite->runAction(RepeatForever::create(animate));
 
   } else {
-    auto cleanup = [gameMapLayer, spritesheet]() {
-      gameMapLayer->removeChild(spritesheet);
+    auto cleanup = [fxLayer, spritesheet]() {
+      fxLayer->removeChild(spritesheet);
     };
     sprite->runAction(Sequence::createWithTwoActions(
         Repeat::create(animate, loopCount),
@@ -116,7 +120,8 @@ string FxManager::getSpritesheetFileName(const string& textureResDir) {
   // Example: Texture/fx/dust/spritesheet.png
   //          |_____________| |_____________|
   //           textureResDir
-  return textureResDir + "/spritesheet.png";
+  // unless it has been packed into an atlas.
+  return asset_manager::getSpritesheetTexture(textureResDir);
 }
 
 }  // namespace vigilante
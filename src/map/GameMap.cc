@@ -12,11 +12,14 @@
 #include "character/Player.h"
 #include "character/Npc.h"
 #include "character/Party.h"
+#include "gameplay/GameState.h"
+#include "gameplay/SaveJournal.h"
 #include "item/Equipment.h"
 #include "item/Consumable.h"
 #include "item/Key.h"
 #include "map/FxManager.h"
 #include "map/GameMapManager.h"
+#include "map/NavGraph.h"
 #include "map/object/Chest.h"
 #include "ui/Colorscheme.h"
 #include "ui/Shade.h"
@@ -52,6 +55,7 @@ GameMap::GameMap(b2World* world, const string& tmxMapFileName)
     : _world(world),
       _tmxTiledMap(TMXTiledMap::create(tmxMapFileName)),
       _tmxTiledMapFileName(tmxMapFileName),
+      _navGraph(),
       _dynamicActors(),
       _triggers(),
       _portals() {}
@@ -64,6 +68,7 @@ void GameMap::createObjects() {
   createRectangles("Platform", category_bits::kPlatform, true, kGroundFriction);
   createPolylines("PivotMarker", category_bits::kPivotMarker, false, 0);
   createPolylines("CliffMarker", category_bits::kCliffMarker, false, 0);
+  _navGraph = NavGraph::get(_tmxTiledMapFileName, _tmxTiledMap);
 
   createTriggers();
   createPortals();
@@ -99,7 +104,7 @@ Item* GameMap::createItem(const string& itemJson, float x, float y, int amount)
   Item* item = showDynamicActor<Item>(Item::create(itemJson), x, y);
   item->setAmount(amount);
 
-  float offsetX = rand_util::randFloat(-.3f, .3f);
+  float offsetX = rand_util::randFloat(rand_util::FX, -.3f, .3f);
   float offsetY = 3.0f;
   item->getBody()->ApplyLinearImpulse({offsetX, offsetY},
                                       item->getBody()->GetWorldCenter(),
@@ -107,11 +112,40 @@ Item* GameMap::createItem(const string& itemJson, float x, float y, int amount)
   return item;
 }
 
+unordered_set<string> GameMap::getTextureResDirs() const {
+  unordered_set<string> textureResDirs;
+
+  for (const auto& rectObj : _tmxTiledMap->getObjectGroup("Npcs")->getObjects()) {
+    const string json = rectObj.asValueMap().at("json").asString();
+    if (!Npc::isNpcAllowedToSpawn(json)) {
+      continue;
+    }
+
+    Character::Profile profile(json);
+    textureResDirs.insert(profile.textureResDir);
+    for (const auto& item : profile.defaultInventory) {
+      textureResDirs.insert(Item::Profile(item.first).textureResDir);
+    }
+  }
+
+  for (const auto& rectObj : _tmxTiledMap->getObjectGroup("Chest")->getObjects()) {
+    for (const auto& itemJson : string_util::split(rectObj.asValueMap().at("items").asString())) {
+      textureResDirs.insert(Item::Profile(itemJson).textureResDir);
+    }
+  }
+
+  return textureResDirs;
+}
+
 
 unordered_set<b2Body*>& GameMap::getTmxTiledMapBodies() {
   return _tmxTiledMapBodies;
 }
 
+NavGraph* GameMap::getNavGraph() const {
+  return _navGraph.get();
+}
+
 const string& GameMap::getTmxTiledMapFileName() const {
   return _tmxTiledMapFileName;
 }
@@ -197,7 +231,8 @@ void GameMap::createTriggers() {
     float y = valMap.at("y").asFloat();
     float w = valMap.at("width").asFloat();
     float h = valMap.at("height").asFloat();
-    vector<string> cmds = string_util::split(valMap.at("cmds").asString(), ';');
+    vector<CommandParser::Instruction> cmds = CommandParser::compileAll(
+        string_util::split(valMap.at("cmds").asString(), ';'), _tmxTiledMapFileName);
     bool canBeTriggeredOnlyOnce = valMap.at("canBeTriggeredOnlyOnce").asBool();
     bool canBeTriggeredOnlyByPlayer = valMap.at("canBeTriggeredOnlyByPlayer").asBool();
 
@@ -296,7 +331,7 @@ void GameMap::createChests() {
 
 
 
-GameMap::Trigger::Trigger(const vector<string>& cmds,
+GameMap::Trigger::Trigger(const vector<CommandParser::Instruction>& cmds,
                           const bool canBeTriggeredOnlyOnce,
                           const bool canBeTriggeredOnlyByPlayer,
                           b2Body* body)
@@ -322,9 +357,7 @@ void GameMap::Trigger::onInteract(Character* user) {
 
   _hasTriggered = true;
 
-  for (const auto& cmd : _cmds) {
-    Console::getInstance()->executeCmd(cmd);
-  }
+  Console::getInstance()->executeCmds(_cmds);
 }
 
 bool GameMap::Trigger::willInteractOnContact() const {
@@ -402,6 +435,11 @@ void GameMap::Portal::onInteract(Character* user) {
         ally->removeFromMap();
       }
     }
+
+    // Autosave. Only the snapshot is taken here, the file is written in background.
+    if (user == GameMapManager::getInstance()->getPlayer()) {
+      GameState().save();
+    }
   };
 
   GameMapManager::getInstance()->loadGameMap(newMapFileName,
@@ -573,6 +611,7 @@ void GameMap::Portal::setLocked(const string& tmxMapFileName,
 
 void GameMap::Portal::saveLockUnlockState() const {
   GameMap::Portal::setLocked(_targetTmxMapFileName, _targetPortalId, _isLocked);
+  SaveJournal::getInstance()->recordPortalStateChanged(_targetTmxMapFileName, _targetPortalId, _isLocked);
 }
 
 
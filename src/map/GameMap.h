@@ -12,19 +12,21 @@
 #include "DynamicActor.h"
 #include "Interactable.h"
 #include "item/Item.h"
+#include "ui/console/CommandParser.h"
 #include "util/Logger.h"
 
 namespace vigilante {
 
 class Character;
 class Player;
+class NavGraph;
 
 class GameMap {
  public:
 
   class Trigger : public Interactable {
    public:
-    Trigger(const std::vector<std::string>& cmds,
+    Trigger(const std::vector<CommandParser::Instruction>& cmds,
             const bool canBeTriggeredOnlyOnce,
             const bool canBeTriggeredOnlyByPlayer,
             b2Body* body);
@@ -46,7 +48,7 @@ class GameMap {
     virtual void createHintBubbleFx() override {}  // Interactable
     virtual void removeHintBubbleFx() override {}  // Interactable
 
-    std::vector<std::string> _cmds;
+    std::vector<CommandParser::Instruction> _cmds;
     bool _canBeTriggeredOnlyOnce;
     bool _canBeTriggeredOnlyByPlayer;
     bool _hasTriggered;
@@ -110,6 +112,9 @@ class GameMap {
     bool _isLocked;
     b2Body* _body;
     cocos2d::Sprite* _hintBubbleFxSprite;
+
+    // Saves and restores `_allPortalStates`.
+    friend class GameState;
   };
 
   GameMap(b2World* world, const std::string& tmxMapFileName);
@@ -120,6 +125,10 @@ class GameMap {
   std::unique_ptr<Player> createPlayer() const;
   Item* createItem(const std::string& itemJson, float x, float y, int amount=1);
 
+  // The textureResDirs of the npcs, their default gear and the chest items
+  // of this map, which can be loaded before createObjects() is called.
+  std::unordered_set<std::string> getTextureResDirs() const;
+
 
   template <typename ReturnType = DynamicActor>
   ReturnType* showDynamicActor(std::shared_ptr<DynamicActor> actor, float x, float y);
@@ -129,6 +138,7 @@ class GameMap {
 
 
   std::unordered_set<b2Body*>& getTmxTiledMapBodies();
+  NavGraph* getNavGraph() const;
   cocos2d::TMXTiledMap* getTmxTiledMap() const;
   const std::string& getTmxTiledMapFileName() const;
   float getWidth() const;
@@ -149,6 +159,7 @@ class GameMap {
   std::unordered_set<b2Body*> _tmxTiledMapBodies;
   cocos2d::TMXTiledMap* _tmxTiledMap;
   std::string _tmxTiledMapFileName;
+  std::shared_ptr<NavGraph> _navGraph;  // shared by all GameMaps of the same .tmx
 
   std::unordered_set<std::shared_ptr<DynamicActor>> _dynamicActors;
   std::vector<std::unique_ptr<GameMap::Trigger>> _triggers;
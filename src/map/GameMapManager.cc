@@ -7,7 +7,10 @@
 #include "std/make_unique.h"
 #include "AssetManager.h"
 #include "CallbackManager.h"
+#include "CompositeSpriteCache.h"
 #include "Constants.h"
+#include "SpriteAnimator.h"
+#include "TextureResidencyManager.h"
 #include "character/Npc.h"
 #include "character/Player.h"
 #include "item/Equipment.h"
@@ -15,12 +18,20 @@
 #include "ui/Shade.h"
 #include "ui/pause_menu/PauseMenu.h"
 #include "util/box2d/b2BodyBuilder.h"
+#include "util/JobSystem.h"
+#include "util/Profiler.h"
+
+// How many Npcs a job of the think phase contains.
+#define NPC_THINK_GRAIN_SIZE 8
 
 using std::string;
 using std::thread;
 using std::function;
+using std::unordered_set;
 using cocos2d::Director;
+using cocos2d::EventCustom;
 using cocos2d::Layer;
+using cocos2d::Node;
 using cocos2d::TMXTiledMap;
 using cocos2d::TMXObjectGroup;
 using cocos2d::Sequence;
@@ -37,16 +48,43 @@ GameMapManager* GameMapManager::getInstance() {
 
 GameMapManager::GameMapManager(const b2Vec2& gravity)
     : _layer(Layer::create()),
+      _graphicalLayers(),
       _worldContactListener(std::make_unique<WorldContactListener>()),
       _world(std::make_unique<b2World>(gravity)),
+      _physicsThread(std::make_unique<PhysicsThread>(_world.get())),
+      _characterStore(std::make_unique<CharacterStore>()),
       _gameMap(),
-      _player() {
+      _player(),
+      _isNpcAiParallel(true),
+      _thinkingNpcs(),
+      _isSpriteAnimatorEnabled(true),
+      _isPhysicsPipelined(),
+      _physicsProfile(&physics_profiles::getDefault()),
+      _hasPendingWorldStep(),
+      _pendingWorldTimeStep() {
   _world->SetAllowSleeping(true);
-  _world->SetContinuousPhysics(true);
+  _world->SetContinuousPhysics(_physicsProfile->isContinuousPhysicsEnabled);
   _world->SetContactListener(_worldContactListener.get());
+
+  // See stepWorld().
+  cocos2d::EventDispatcher* eventDispatcher = Director::getInstance()->getEventDispatcher();
+  eventDispatcher->addCustomEventListener(Director::EVENT_BEFORE_UPDATE, [this](EventCustom*) {
+    joinWorldStep();
+  });
+  eventDispatcher->addCustomEventListener(Director::EVENT_AFTER_UPDATE, [this](EventCustom*) {
+    startPendingWorldStep();
+  });
 }
 
 void GameMapManager::update(float delta) {
+  SpriteAnimator::advanceClock(delta);
+  CompositeSpriteCache::getInstance()->update();
+  _characterStore->update(delta);
+
+  if (_isNpcAiParallel) {
+    thinkInParallel(delta);
+  }
+
   for (auto& actor : _gameMap->_dynamicActors) {
     actor->update(delta);
   }
@@ -60,6 +98,68 @@ void GameMapManager::update(float delta) {
   }
 }
 
+void GameMapManager::stepWorld(float timeStep) {
+  _hasPendingWorldStep = true;
+  _pendingWorldTimeStep = timeStep;
+
+  if (!_isPhysicsPipelined) {
+    startPendingWorldStep();
+  }
+}
+
+void GameMapManager::startPendingWorldStep() {
+  if (!_hasPendingWorldStep) {
+    return;
+  }
+  _hasPendingWorldStep = false;
+
+  if (!_isPhysicsPipelined) {
+    VGPROFILE_SCOPE("b2World::Step");
+    _physicsProfile->step(_world.get(), _pendingWorldTimeStep);
+    return;
+  }
+
+  _worldContactListener->setQueueing(true);
+  _physicsThread->start(_pendingWorldTimeStep, _physicsProfile);
+}
+
+void GameMapManager::joinWorldStep() {
+  waitForWorldStep();
+  _worldContactListener->setQueueing(false);
+  _worldContactListener->handleQueuedContacts();
+}
+
+void GameMapManager::waitForWorldStep() {
+  _physicsThread->wait();
+}
+
+void GameMapManager::thinkInParallel(float delta) {
+  VGPROFILE_SCOPE("GameMapManager::thinkInParallel");
+
+  _thinkingNpcs.clear();
+  for (auto& actor : _gameMap->_dynamicActors) {
+    if (Npc* npc = dynamic_cast<Npc*>(actor.get())) {
+      _thinkingNpcs.push_back(npc);
+    }
+  }
+  if (_player) {
+    for (const auto& ally : _player->getAllies()) {
+      if (Npc* npc = dynamic_cast<Npc*>(ally)) {
+        _thinkingNpcs.push_back(npc);
+      }
+    }
+  }
+
+  // Nothing else runs until all of them have finished thinking,
+  // so the world they read stays the same throughout this phase.
+  JobSystem::getInstance()->parallelFor(_thinkingNpcs.size(), NPC_THINK_GRAIN_SIZE,
+                                        [this, delta](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      _thinkingNpcs[i]->think(delta);
+    }
+  });
+}
+
 
 void GameMapManager::loadGameMap(const string& tmxMapFileName,
                                  const function<void ()>& afterLoadingGameMap) {
@@ -95,6 +195,8 @@ void GameMapManager::loadGameMap(const string& tmxMapFileName,
 }
 
 GameMap* GameMapManager::doLoadGameMap(const string& tmxMapFileName) {
+  VGPROFILE_SCOPE("GameMapManager::doLoadGameMap");
+
   // Remove deceased party member from player's party, remove their
   // b2body and texture, and add them to the party's deceasedMember unordered_set.
   if (_player) {
@@ -107,15 +209,45 @@ GameMap* GameMapManager::doLoadGameMap(const string& tmxMapFileName) {
 
   // Clean up previous GameMap.
   if (_gameMap) {
-    _layer->removeChild(_gameMap->getTmxTiledMap());
+    VGPROFILE_SCOPE("GameMap::deleteObjects");
+    _gameMap->getTmxTiledMap()->removeFromParent();
     _gameMap->deleteObjects();
     _gameMap.reset();  // deletes the underlying GameMap object and _gameMap = nullptr.
   }
 
   // Load the new GameMap.
-  _gameMap = std::make_unique<GameMap>(_world.get(), tmxMapFileName);
-  _gameMap->createObjects();
-  _layer->addChild(_gameMap->getTmxTiledMap(), graphical_layers::kTmxTiledMap);
+  {
+    VGPROFILE_SCOPE("GameMap::GameMap");
+    _gameMap = std::make_unique<GameMap>(_world.get(), tmxMapFileName);
+  }
+  {
+    // Load the spritesheets needed by the new GameMap in parallel
+    // before its objects are created, and evict the unneeded ones.
+    VGPROFILE_SCOPE("TextureResidencyManager::enterMap");
+    unordered_set<string> textureResDirs = _gameMap->getTextureResDirs();
+
+    if (_player) {
+      unordered_set<Character*> characters = _player->getAllies();
+      characters.insert(_player.get());
+      for (auto character : characters) {
+        textureResDirs.insert(character->getCharacterProfile().textureResDir);
+        for (auto equipment : character->getEquipmentSlots()) {
+          if (equipment) {
+            textureResDirs.insert(equipment->getItemProfile().textureResDir);
+          }
+        }
+      }
+    } else {
+      textureResDirs.insert(Character::Profile(asset_manager::kPlayerJson).textureResDir);
+    }
+
+    TextureResidencyManager::getInstance()->enterMap(tmxMapFileName, textureResDirs);
+  }
+  {
+    VGPROFILE_SCOPE("GameMap::createObjects");
+    _gameMap->createObjects();
+  }
+  getGraphicalLayer(graphical_layers::kTmxTiledMap)->addChild(_gameMap->getTmxTiledMap());
 
   // If the player object hasn't been created yet, then spawn it.
   if (!_player) {
@@ -130,6 +262,18 @@ Layer* GameMapManager::getLayer() const {
   return _layer;
 }
 
+Node* GameMapManager::getGraphicalLayer(int zOrder) {
+  auto it = _graphicalLayers.find(zOrder);
+  if (it != _graphicalLayers.end()) {
+    return it->second;
+  }
+
+  GraphicalLayer* graphicalLayer = GraphicalLayer::create();
+  _layer->addChild(graphicalLayer, zOrder);
+  _graphicalLayers.insert({zOrder, graphicalLayer});
+  return graphicalLayer;
+}
+
 b2World* GameMapManager::getWorld() const {
   return _world.get();
 }
@@ -142,4 +286,66 @@ Player* GameMapManager::getPlayer() const {
   return _player.get();
 }
 
+CharacterStore* GameMapManager::getCharacterStore() const {
+  return _characterStore.get();
+}
+
+
+bool GameMapManager::isNpcAiParallel() const {
+  return _isNpcAiParallel;
+}
+
+void GameMapManager::setNpcAiParallel(bool npcAiParallel) {
+  _isNpcAiParallel = npcAiParallel;
+}
+
+bool GameMapManager::isSpriteAnimatorEnabled() const {
+  return _isSpriteAnimatorEnabled;
+}
+
+void GameMapManager::setSpriteAnimatorEnabled(bool spriteAnimatorEnabled) {
+  _isSpriteAnimatorEnabled = spriteAnimatorEnabled;
+}
+
+bool GameMapManager::isCompositeEnabled() const {
+  return CompositeSpriteCache::getInstance()->isEnabled();
+}
+
+void GameMapManager::setCompositeEnabled(bool compositeEnabled) {
+  CompositeSpriteCache::getInstance()->setEnabled(compositeEnabled);
+  for (size_t i = 0; i < _characterStore->getSize(); i++) {
+    _characterStore->getOwner(i)->refreshComposite();
+  }
+}
+
+bool GameMapManager::isPhysicsPipelined() const {
+  return _isPhysicsPipelined;
+}
+
+void GameMapManager::setPhysicsPipelined(bool physicsPipelined) {
+  // A pending step will be started synchronously if it's turned off.
+  joinWorldStep();
+  _isPhysicsPipelined = physicsPipelined;
+}
+
+float GameMapManager::getLastWorldStepWaitMs() const {
+  return _physicsThread->getLastWaitMs();
+}
+
+const PhysicsProfile& GameMapManager::getPhysicsProfile() const {
+  return *_physicsProfile;
+}
+
+bool GameMapManager::setPhysicsProfile(const string& profileName) {
+  const PhysicsProfile* profile = physics_profiles::find(profileName);
+  if (!profile) {
+    return false;
+  }
+
+  joinWorldStep();
+  _physicsProfile = profile;
+  _world->SetContinuousPhysics(_physicsProfile->isContinuousPhysicsEnabled);
+  return true;
+}
+
 }  // namespace vigilante
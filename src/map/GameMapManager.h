@@ -6,18 +6,25 @@
 #include <string>
 #include <memory>
 #include <functional>
+#include <unordered_map>
+#include <vector>
 
 #include <cocos2d.h>
 #include <Box2D/Box2D.h>
 #include "GameMap.h"
+#include "GraphicalLayer.h"
+#include "PhysicsProfile.h"
+#include "PhysicsThread.h"
 #include "WorldContactListener.h"
 #include "Controllable.h"
 #include "character/Character.h"
+#include "character/CharacterStore.h"
 #include "item/Item.h"
 
 namespace vigilante {
 
 // Forward Declaration
+class Npc;
 class Player;
 
 class GameMapManager {
@@ -27,6 +34,31 @@ class GameMapManager {
 
   void update(float delta);
 
+  // Steps the b2World by `timeStep`, right away unless the physics is
+  // pipelined (see setPhysicsPipelined()). Otherwise, the step only starts on
+  // the physics thread once the scheduler has updated everything
+  // (Director::EVENT_AFTER_UPDATE), so it runs while the frame is rendered,
+  // and it's joined before the next frame is updated (EVENT_BEFORE_UPDATE).
+  //
+  // That is, the step only overlaps with the rendering, never with the
+  // gameplay code. There's no double buffering of the body transforms and no
+  // queue of impulses: the whole update, including the sprite syncing in
+  // CharacterStore::update() and camera_util::lerpToTarget(), runs after the
+  // join on the world itself, and applies its impulses and velocity changes
+  // to it directly. Meanwhile, the contacts are queued (see
+  // WorldContactListener), and the frame being rendered shows the sprites as
+  // they were synced before the step started.
+  void stepWorld(float timeStep);
+
+  // Blocks until the b2World is no longer being stepped, and handles the
+  // contacts queued meanwhile. Call it before touching the world from outside
+  // the scheduler, e.g., from an input event. Main thread only.
+  void joinWorldStep();
+
+  // Same as joinWorldStep(), but the queued contacts are left for it,
+  // e.g., to draw the world while the frame is being rendered.
+  void waitForWorldStep();
+
   // Safely loads the specified GameMap using a worker thread
   // which executes independently in background.
   //
@@ -59,9 +91,47 @@ class GameMapManager {
                    const std::function<void ()>& afterLoadingGameMap=[]() {});
 
   cocos2d::Layer* getLayer() const;
+  // The container of everything shown at graphical layer `zOrder` (e.g.,
+  // graphical_layers::kNpcBody) under getLayer(), created upon the first call.
+  // Add the nodes shown on the map to it rather than to getLayer().
+  cocos2d::Node* getGraphicalLayer(int zOrder);
   b2World* getWorld() const;
   GameMap* getGameMap() const;
   Player* getPlayer() const;
+  CharacterStore* getCharacterStore() const;
+
+  // If true (default), all Npcs think in parallel on the JobSystem
+  // before the actors are updated. Otherwise each Npc thinks right
+  // before it acts, i.e., the serial path.
+  bool isNpcAiParallel() const;
+  void setNpcAiParallel(bool npcAiParallel);
+
+  // If true (default), the Characters are animated by their SpriteAnimators.
+  // Otherwise each animation transition runs new cocos2d::Actions, i.e.,
+  // the old path. Only affects the animations run after the change.
+  bool isSpriteAnimatorEnabled() const;
+  void setSpriteAnimatorEnabled(bool spriteAnimatorEnabled);
+
+  // If true, the equipment of each Character is flattened into its body
+  // animations (see CompositeSpriteCache). Off by default. Disabling it
+  // switches every Character back to its equipment sprites immediately.
+  bool isCompositeEnabled() const;
+  void setCompositeEnabled(bool compositeEnabled);
+
+  // If true, the b2World is stepped on a thread of its own while the frame is
+  // rendered (see stepWorld()). Off by default, since each step shows up one
+  // frame later, and it only pays off if the rendering takes long enough.
+  bool isPhysicsPipelined() const;
+  void setPhysicsPipelined(bool physicsPipelined);
+  // How long the main thread has been blocked by the last step it has joined.
+  float getLastWorldStepWaitMs() const;
+
+  // physics_profiles::getDefault() unless another one is set. A new profile
+  // takes effect from the next step, except that the bodies which are bullets
+  // already (see PhysicsProfile::isBulletEnabled) stay so until their dashes end.
+  // @return false if there's no profile named `profileName`
+  const PhysicsProfile& getPhysicsProfile() const;
+  bool setPhysicsProfile(const std::string& profileName);
 
  private:
   explicit GameMapManager(const b2Vec2& gravity);
@@ -70,11 +140,34 @@ class GameMapManager {
   // Used by GameMap::loadGameMap().
   GameMap* doLoadGameMap(const std::string& tmxMapFileName);
 
+  // The think phase of all Npcs on the map (see Npc::think()).
+  void thinkInParallel(float delta);
+
+  // Starts the step requested by stepWorld(), if any. Called upon
+  // Director::EVENT_AFTER_UPDATE (or by the headless simulation).
+  void startPendingWorldStep();
+
   cocos2d::Layer* _layer;
+  std::unordered_map<int, GraphicalLayer*> _graphicalLayers;  // keyed by z order
   std::unique_ptr<WorldContactListener> _worldContactListener;
   std::unique_ptr<b2World> _world;
+  std::unique_ptr<PhysicsThread> _physicsThread;  // must be destroyed before `_world`
+  std::unique_ptr<CharacterStore> _characterStore;  // must outlive all Characters
   std::unique_ptr<GameMap> _gameMap;
   std::unique_ptr<Player> _player;
+
+  bool _isNpcAiParallel;
+  std::vector<Npc*> _thinkingNpcs;  // reused by thinkInParallel() every frame
+  bool _isSpriteAnimatorEnabled;
+
+  bool _isPhysicsPipelined;
+  const PhysicsProfile* _physicsProfile;  // one of physics_profiles::getAll()
+  bool _hasPendingWorldStep;
+  float _pendingWorldTimeStep;
+
+  // The headless simulation (see proj.headless/) has no Shade to fade
+  // and loads its GameMap synchronously via doLoadGameMap().
+  friend class HeadlessSimulation;
 };
 
 }  // namespace vigilante
@@ -0,0 +1,22 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "GraphicalLayer.h"
+
+namespace vigilante {
+
+GraphicalLayer::SortStats GraphicalLayer::_sortStats = {0, 0};
+
+void GraphicalLayer::sortAllChildren() {
+  if (_reorderChildDirty) {
+    _sortStats.sortCount++;
+    _sortStats.sortedChildCount += _children.size();
+  }
+  Node::sortAllChildren();
+}
+
+GraphicalLayer::SortStats GraphicalLayer::collectSortStats() {
+  const GraphicalLayer::SortStats sortStats = _sortStats;
+  _sortStats = {0, 0};
+  return sortStats;
+}
+
+}  // namespace vigilante
@@ -0,0 +1,42 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_GRAPHICAL_LAYER_H_
+#define VIGILANTE_GRAPHICAL_LAYER_H_
+
+#include <cstddef>
+
+#include <cocos2d.h>
+
+namespace vigilante {
+
+// The persistent container of everything on the GameMap which is shown
+// at the same graphical layer (see graphical_layers and
+// GameMapManager::getGraphicalLayer()).
+//
+// cocos2d-x re-sorts all the children of a node before drawing it whenever
+// a child has been added to it. If every sprite on the map were a direct child
+// of GameMapManager's layer, each Fx, dropped item or equipment change would
+// re-sort the whole map. With one container per graphical layer, only the
+// siblings on the same graphical layer are re-sorted.
+class GraphicalLayer : public cocos2d::Node {
+ public:
+  // The sorting done by all GraphicalLayers.
+  struct SortStats final {
+    size_t sortCount;  // # of GraphicalLayers re-sorted
+    size_t sortedChildCount;  // # of children in those GraphicalLayers
+  };
+
+  CREATE_FUNC(GraphicalLayer);
+  virtual ~GraphicalLayer() = default;
+
+  virtual void sortAllChildren() override;  // cocos2d::Node
+
+  // @return the sorting done since the last call. Call it once per frame.
+  static GraphicalLayer::SortStats collectSortStats();
+
+ private:
+  static GraphicalLayer::SortStats _sortStats;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_GRAPHICAL_LAYER_H_
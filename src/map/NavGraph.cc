@@ -0,0 +1,382 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "NavGraph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+#include "Constants.h"
+#include "util/Logger.h"
+
+// The distance between two adjacent nodes on the same surface.
+#define NODE_SPACING .32f
+// Height differences up to this much are simply walked over.
+#define STEP_HEIGHT .08f
+// Steeper ground segments (|dy / dx|) are treated as walls.
+#define MAX_WALKABLE_SLOPE 1.0f
+// The upper bounds of the jump and drop links.
+// How high each character can actually jump is given to findPath().
+#define MAX_JUMP_HEIGHT 3.0f
+#define MAX_JUMP_DISTANCE 1.6f
+#define MAX_DROP_HEIGHT 6.0f
+// Prefer walking a bit further over jumping.
+#define JUMP_COST_PENALTY 1.0f
+#define GRID_CELL_SIZE 1.0f
+#define PATH_CACHE_CAPACITY 4096
+
+using std::pair;
+using std::string;
+using std::vector;
+using std::shared_ptr;
+using std::unordered_map;
+using cocos2d::Director;
+using cocos2d::TMXTiledMap;
+using cocos2d::TMXObjectGroup;
+
+namespace vigilante {
+
+unordered_map<string, shared_ptr<NavGraph>> NavGraph::_cache;
+
+shared_ptr<NavGraph> NavGraph::get(const string& tmxMapFileName, TMXTiledMap* tmxTiledMap) {
+  auto it = _cache.find(tmxMapFileName);
+  if (it != _cache.end()) {
+    return it->second;
+  }
+
+  const float scaleFactor = Director::getInstance()->getContentScaleFactor();
+  vector<NavGraph::Surface> surfaces;
+
+  // Split each ground polyline into surfaces at its steep segments.
+  for (const auto& lineObj : tmxTiledMap->getObjectGroup("Ground")->getObjects()) {
+    const auto& valMap = lineObj.asValueMap();
+    float xRef = valMap.at("x").asFloat();
+    float yRef = valMap.at("y").asFloat();
+
+    NavGraph::Surface surface{{}, false};
+    for (const auto& point : valMap.at("polylinePoints").asValueVector()) {
+      float x = point.asValueMap().at("x").asFloat() / scaleFactor;
+      float y = point.asValueMap().at("y").asFloat() / scaleFactor;
+      b2Vec2 vertex((xRef + x) / kPpm, (yRef - y) / kPpm);
+
+      if (!surface.vertices.empty()) {
+        const b2Vec2 d = vertex - surface.vertices.back();
+        if (std::abs(d.y) > std::abs(d.x) * MAX_WALKABLE_SLOPE) {
+          if (surface.vertices.size() >= 2) {
+            surfaces.push_back(std::move(surface));
+          }
+          surface.vertices.clear();
+        }
+      }
+      surface.vertices.push_back(vertex);
+    }
+
+    if (surface.vertices.size() >= 2) {
+      surfaces.push_back(std::move(surface));
+    }
+  }
+
+  // Only the top edge of a platform is walkable.
+  for (const auto& rectObj : tmxTiledMap->getObjectGroup("Platform")->getObjects()) {
+    const auto& valMap = rectObj.asValueMap();
+    float x = valMap.at("x").asFloat();
+    float y = valMap.at("y").asFloat();
+    float w = valMap.at("width").asFloat();
+    float h = valMap.at("height").asFloat();
+    surfaces.push_back({{{x / kPpm, (y + h) / kPpm}, {(x + w) / kPpm, (y + h) / kPpm}}, true});
+  }
+
+  auto graph = std::make_shared<NavGraph>(surfaces);
+  VGLOG(LOG_INFO, "Baked navigation graph of %s: %d surfaces, %d nodes, %d links",
+        tmxMapFileName.c_str(), static_cast<int>(surfaces.size()),
+        static_cast<int>(graph->getNodeCount()), static_cast<int>(graph->getLinkCount()));
+
+  _cache.insert({tmxMapFileName, graph});
+  return graph;
+}
+
+NavGraph::NavGraph(const vector<NavGraph::Surface>& surfaces)
+    : _nodes(),
+      _links(),
+      _isPlatformSurface(),
+      _surfaceEnds(),
+      _grid(),
+      _pathCacheMutex(),
+      _pathCache() {
+  for (size_t i = 0; i < surfaces.size(); i++) {
+    addSurfaceNodes(surfaces[i], i);
+  }
+  for (uint32_t i = 0; i < _nodes.size(); i++) {
+    _grid[getCellKey(getCell(_nodes[i].pos.x), getCell(_nodes[i].pos.y))].push_back(i);
+  }
+  addLinks();
+}
+
+
+int NavGraph::findNearestNode(const b2Vec2& pos) const {
+  const int cellX = getCell(pos.x);
+  const int cellY = getCell(pos.y);
+
+  // Prefer the nodes under `pos`, and among them, the closest ones.
+  // Being a little bit off horizontally is better than being on another surface.
+  int nearestNodeIdx = -1;
+  float minScore = std::numeric_limits<float>::max();
+
+  for (int x = cellX - 1; x <= cellX + 1; x++) {
+    for (int y = cellY - 2; y <= cellY; y++) {
+      auto it = _grid.find(getCellKey(x, y));
+      if (it == _grid.end()) {
+        continue;
+      }
+
+      for (const auto i : it->second) {
+        const b2Vec2& nodePos = _nodes[i].pos;
+        if (nodePos.y > pos.y + STEP_HEIGHT) {
+          continue;
+        }
+        const float score = std::abs(nodePos.x - pos.x) + 2 * (pos.y - nodePos.y);
+        if (score < minScore) {
+          minScore = score;
+          nearestNodeIdx = i;
+        }
+      }
+    }
+  }
+  return nearestNodeIdx;
+}
+
+NavGraph::Path NavGraph::findPath(uint32_t from, uint32_t to, float maxJumpHeight) {
+  const NavGraph::PathKey key{from, to, static_cast<int>(maxJumpHeight * 100)};
+  {
+    std::lock_guard<std::mutex> lock(_pathCacheMutex);
+    auto it = _pathCache.find(key);
+    if (it != _pathCache.end()) {
+      return it->second;
+    }
+  }
+
+  // The search itself only reads the graph, so it can run without the lock.
+  NavGraph::Path path = std::make_shared<const vector<uint32_t>>(search(from, to, maxJumpHeight));
+
+  std::lock_guard<std::mutex> lock(_pathCacheMutex);
+  if (_pathCache.size() >= PATH_CACHE_CAPACITY) {
+    _pathCache.clear();
+  }
+  _pathCache.insert({key, path});
+  return path;
+}
+
+const NavGraph::Link* NavGraph::getLink(uint32_t from, uint32_t to) const {
+  for (uint32_t i = _nodes[from].linksBegin; i < _nodes[from].linksEnd; i++) {
+    if (_links[i].to == to) {
+      return &_links[i];
+    }
+  }
+  return nullptr;
+}
+
+const NavGraph::Node& NavGraph::getNode(uint32_t i) const {
+  return _nodes[i];
+}
+
+size_t NavGraph::getNodeCount() const {
+  return _nodes.size();
+}
+
+size_t NavGraph::getLinkCount() const {
+  return _links.size();
+}
+
+size_t NavGraph::getPathCacheSize() const {
+  std::lock_guard<std::mutex> lock(_pathCacheMutex);
+  return _pathCache.size();
+}
+
+
+void NavGraph::addSurfaceNodes(const NavGraph::Surface& surface, uint32_t surfaceIdx) {
+  const uint32_t begin = _nodes.size();
+
+  // Sample each segment every NODE_SPACING meters.
+  // The last vertex of a segment is the first vertex of the next one.
+  _nodes.push_back({surface.vertices.front(), surfaceIdx, 0, 0});
+  for (size_t i = 1; i < surface.vertices.size(); i++) {
+    const b2Vec2& a = surface.vertices[i - 1];
+    const b2Vec2& b = surface.vertices[i];
+    const int steps = std::max(1, static_cast<int>(std::ceil((b - a).Length() / NODE_SPACING)));
+
+    for (int step = 1; step <= steps; step++) {
+      _nodes.push_back({a + (static_cast<float>(step) / steps) * (b - a), surfaceIdx, 0, 0});
+    }
+  }
+
+  const uint32_t end = _nodes.size() - 1;
+  _isPlatformSurface.push_back(surface.isPlatform);
+  _surfaceEnds.push_back((_nodes[begin].pos.x <= _nodes[end].pos.x) ?
+                         pair<uint32_t, uint32_t>{begin, end} : pair<uint32_t, uint32_t>{end, begin});
+}
+
+void NavGraph::addLinks() {
+  // The best link from the current node to each of the other surfaces.
+  unordered_map<uint32_t, NavGraph::Link> bestLinks;  // <surface idx, link>
+  const int cellRange = static_cast<int>(std::ceil(MAX_JUMP_DISTANCE / GRID_CELL_SIZE));
+
+  for (uint32_t i = 0; i < _nodes.size(); i++) {
+    NavGraph::Node& node = _nodes[i];
+    const uint32_t surfaceIdx = node.surfaceIdx;
+    node.linksBegin = _links.size();
+
+    // Walk to the adjacent nodes on the same surface.
+    for (uint32_t j : {i - 1, i + 1}) {
+      if (j < _nodes.size() && _nodes[j].surfaceIdx == surfaceIdx) {
+        _links.push_back({j, NavGraph::LinkType::WALK, 0, (_nodes[j].pos - node.pos).Length()});
+      }
+    }
+
+    const bool isLeftEnd = _surfaceEnds[surfaceIdx].first == i;
+    const bool isRightEnd = _surfaceEnds[surfaceIdx].second == i;
+    const bool isOnPlatform = _isPlatformSurface[surfaceIdx];
+
+    bestLinks.clear();
+    const int cellX = getCell(node.pos.x);
+    const int minCellY = getCell(node.pos.y - MAX_DROP_HEIGHT);
+    const int maxCellY = getCell(node.pos.y + MAX_JUMP_HEIGHT);
+
+    for (int x = cellX - cellRange; x <= cellX + cellRange; x++) {
+      for (int y = minCellY; y <= maxCellY; y++) {
+        auto it = _grid.find(getCellKey(x, y));
+        if (it == _grid.end()) {
+          continue;
+        }
+
+        for (const auto j : it->second) {
+          const NavGraph::Node& other = _nodes[j];
+          if (other.surfaceIdx == surfaceIdx) {
+            continue;
+          }
+
+          const b2Vec2 d = other.pos - node.pos;
+          const float distance = d.Length();
+          NavGraph::Link link{j, NavGraph::LinkType::WALK, 0, distance};
+
+          if (std::abs(d.y) <= STEP_HEIGHT && std::abs(d.x) <= NODE_SPACING) {
+            // Another surface which joins this one.
+          } else if (d.y > STEP_HEIGHT && d.y <= MAX_JUMP_HEIGHT && std::abs(d.x) <= MAX_JUMP_DISTANCE) {
+            link.type = NavGraph::LinkType::JUMP;
+            link.height = d.y;
+            link.cost += JUMP_COST_PENALTY;
+          } else if (d.y < -STEP_HEIGHT && d.y >= -MAX_DROP_HEIGHT &&
+                     ((isOnPlatform && std::abs(d.x) <= NODE_SPACING / 2) ||
+                      (isLeftEnd && d.x <= 0 && d.x >= -MAX_JUMP_DISTANCE) ||
+                      (isRightEnd && d.x >= 0 && d.x <= MAX_JUMP_DISTANCE))) {
+            link.type = NavGraph::LinkType::DROP;
+          } else {
+            continue;
+          }
+
+          auto bestIt = bestLinks.find(other.surfaceIdx);
+          if (bestIt == bestLinks.end()) {
+            bestLinks.insert({other.surfaceIdx, link});
+          } else if (link.cost < bestIt->second.cost) {
+            bestIt->second = link;
+          }
+        }
+      }
+    }
+
+    for (const auto& bestLink : bestLinks) {
+      _links.push_back(bestLink.second);
+    }
+    node.linksEnd = _links.size();
+  }
+}
+
+vector<uint32_t> NavGraph::search(uint32_t from, uint32_t to, float maxJumpHeight) const {
+  // Per-thread scratch buffers, so that a search doesn't have to clear
+  // (or allocate) an array the size of the graph. An entry is only valid
+  // if its stamp equals the current search's stamp.
+  thread_local vector<float> gScores;
+  thread_local vector<uint32_t> cameFrom;
+  thread_local vector<uint32_t> stamps;
+  thread_local uint32_t currentStamp = 0;
+
+  if (gScores.size() < _nodes.size()) {
+    gScores.resize(_nodes.size());
+    cameFrom.resize(_nodes.size());
+    stamps.resize(_nodes.size(), 0);
+  }
+  if (++currentStamp == 0) {
+    std::fill(stamps.begin(), stamps.end(), 0);
+    currentStamp = 1;
+  }
+
+  auto heuristic = [this, to](uint32_t i) {
+    return (_nodes[to].pos - _nodes[i].pos).Length();
+  };
+
+  using Entry = pair<float, uint32_t>;  // <fScore, node idx>
+  std::priority_queue<Entry, vector<Entry>, std::greater<Entry>> openSet;
+
+  gScores[from] = 0;
+  cameFrom[from] = from;
+  stamps[from] = currentStamp;
+  openSet.push({heuristic(from), from});
+
+  while (!openSet.empty()) {
+    const Entry entry = openSet.top();
+    openSet.pop();
+    const uint32_t current = entry.second;
+
+    if (current == to) {
+      vector<uint32_t> path;
+      for (uint32_t i = to; i != from; i = cameFrom[i]) {
+        path.push_back(i);
+      }
+      path.push_back(from);
+      std::reverse(path.begin(), path.end());
+      return path;
+    }
+
+    // Skip the stale entries.
+    if (entry.first > gScores[current] + heuristic(current)) {
+      continue;
+    }
+
+    for (uint32_t i = _nodes[current].linksBegin; i < _nodes[current].linksEnd; i++) {
+      const NavGraph::Link& link = _links[i];
+      if (link.type == NavGraph::LinkType::JUMP && link.height > maxJumpHeight) {
+        continue;
+      }
+
+      const float gScore = gScores[current] + link.cost;
+      if (stamps[link.to] != currentStamp || gScore < gScores[link.to]) {
+        gScores[link.to] = gScore;
+        cameFrom[link.to] = current;
+        stamps[link.to] = currentStamp;
+        openSet.push({gScore + heuristic(link.to), link.to});
+      }
+    }
+  }
+  return {};
+}
+
+int64_t NavGraph::getCellKey(int cellX, int cellY) {
+  return (static_cast<int64_t>(cellX) << 32) | static_cast<uint32_t>(cellY);
+}
+
+int NavGraph::getCell(float v) {
+  return static_cast<int>(std::floor(v / GRID_CELL_SIZE));
+}
+
+
+bool NavGraph::PathKey::operator==(const PathKey& other) const {
+  return from == other.from && to == other.to && maxJumpHeight == other.maxJumpHeight;
+}
+
+size_t NavGraph::PathKeyHash::operator()(const PathKey& key) const {
+  return (static_cast<size_t>(key.from) * 73856093) ^
+         (static_cast<size_t>(key.to) * 19349663) ^
+         (static_cast<size_t>(key.maxJumpHeight) * 83492791);
+}
+
+}  // namespace vigilante
@@ -0,0 +1,120 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_NAV_GRAPH_H_
+#define VIGILANTE_NAV_GRAPH_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cocos2d.h>
+#include <Box2D/Box2D.h>
+
+namespace vigilante {
+
+// A platformer navigation graph, baked from the "Ground" and "Platform"
+// layers of a .tmx map.
+//
+// The walkable surfaces (the flat enough segments of the ground polylines,
+// and the top edges of the platforms) are sampled into nodes, which are
+// linked by walking along a surface, jumping up onto another surface,
+// or dropping down from a ledge or through a platform. All coordinates
+// are in meters (box2d units).
+//
+// Graphs are baked upon the first use of a map and cached by file.
+// Paths are cached as well, so Npcs chasing the same target share them.
+class NavGraph {
+ public:
+  enum LinkType {
+    WALK,
+    JUMP,
+    DROP
+  };
+
+  struct Node final {
+    b2Vec2 pos;  // on the surface
+    uint32_t surfaceIdx;
+    uint32_t linksBegin;
+    uint32_t linksEnd;
+  };
+
+  struct Link final {
+    uint32_t to;
+    NavGraph::LinkType type;
+    float height;  // how high the character has to jump (JUMP only)
+    float cost;
+  };
+
+  // The node indices from the start node to the goal node (both inclusive).
+  // Empty if the goal is unreachable.
+  using Path = std::shared_ptr<const std::vector<uint32_t>>;
+
+  // A walkable surface in meters, e.g., a ground polyline.
+  struct Surface final {
+    std::vector<b2Vec2> vertices;
+    bool isPlatform;  // can be dropped through
+  };
+
+  // @return the baked graph of the given map.
+  //         It's baked upon the first call and cached afterwards.
+  static std::shared_ptr<NavGraph> get(const std::string& tmxMapFileName,
+                                       cocos2d::TMXTiledMap* tmxTiledMap);
+
+  explicit NavGraph(const std::vector<NavGraph::Surface>& surfaces);
+  NavGraph(const NavGraph&) = delete;
+  NavGraph& operator=(const NavGraph&) = delete;
+  virtual ~NavGraph() = default;
+
+  // @return the index of the node on the surface right under `pos`
+  //         (e.g., the body position of a character), or -1 if none.
+  int findNearestNode(const b2Vec2& pos) const;
+
+  // A* search from node `from` to node `to`, only taking the jump links
+  // which require at most `maxJumpHeight`. Thread-safe.
+  NavGraph::Path findPath(uint32_t from, uint32_t to, float maxJumpHeight);
+
+  // @return the link from node `from` to node `to`, or nullptr if none.
+  const NavGraph::Link* getLink(uint32_t from, uint32_t to) const;
+
+  const NavGraph::Node& getNode(uint32_t i) const;
+  size_t getNodeCount() const;
+  size_t getLinkCount() const;
+  size_t getPathCacheSize() const;
+
+ private:
+  struct PathKey final {
+    bool operator==(const PathKey& other) const;
+
+    uint32_t from;
+    uint32_t to;
+    int maxJumpHeight;  // in centimeters
+  };
+
+  struct PathKeyHash final {
+    size_t operator()(const PathKey& key) const;
+  };
+
+  void addSurfaceNodes(const NavGraph::Surface& surface, uint32_t surfaceIdx);
+  void addLinks();
+  std::vector<uint32_t> search(uint32_t from, uint32_t to, float maxJumpHeight) const;
+
+  static int64_t getCellKey(int cellX, int cellY);
+  static int getCell(float v);
+
+  std::vector<NavGraph::Node> _nodes;
+  std::vector<NavGraph::Link> _links;
+  std::vector<bool> _isPlatformSurface;
+  std::vector<std::pair<uint32_t, uint32_t>> _surfaceEnds;  // <left end node, right end node>
+  std::unordered_map<int64_t, std::vector<uint32_t>> _grid;  // <cell key, node indices>
+
+  mutable std::mutex _pathCacheMutex;
+  std::unordered_map<NavGraph::PathKey, NavGraph::Path, NavGraph::PathKeyHash> _pathCache;
+
+  static std::unordered_map<std::string, std::shared_ptr<NavGraph>> _cache;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_NAV_GRAPH_H_
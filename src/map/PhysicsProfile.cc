@@ -0,0 +1,48 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "PhysicsProfile.h"
+
+#include "Constants.h"
+
+#define DEFAULT_PROFILE_IDX 1
+
+using std::string;
+using std::vector;
+
+namespace vigilante {
+
+void PhysicsProfile::step(b2World* world, float timeStep) const {
+  const float subTimeStep = timeStep / subStepCount;
+  for (int i = 0; i < subStepCount; i++) {
+    world->Step(subTimeStep, velocityIterations, positionIterations);
+  }
+}
+
+
+namespace physics_profiles {
+
+const vector<PhysicsProfile>& getAll() {
+  // name, velocity and position iterations, sub-steps, continuous physics, bullets
+  static const vector<PhysicsProfile> profiles = {
+    {"performance", 4, 1, 1, false, false},
+    {"balanced", kVelocityIterations, kPositionIterations, 1, true, true},
+    {"quality", 8, 3, 2, true, true},
+  };
+  return profiles;
+}
+
+const PhysicsProfile* find(const string& name) {
+  for (const auto& profile : getAll()) {
+    if (profile.name == name) {
+      return &profile;
+    }
+  }
+  return nullptr;
+}
+
+const PhysicsProfile& getDefault() {
+  return getAll()[DEFAULT_PROFILE_IDX];
+}
+
+}  // namespace physics_profiles
+
+}  // namespace vigilante
@@ -0,0 +1,53 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_PHYSICS_PROFILE_H_
+#define VIGILANTE_PHYSICS_PROFILE_H_
+
+#include <string>
+#include <vector>
+
+#include <Box2D/Box2D.h>
+
+namespace vigilante {
+
+// How much accuracy the b2World trades for speed (see GameMapManager::setPhysicsProfile()).
+//
+// Box2D's sleep tolerances (b2_linearSleepTolerance, b2_timeToSleep, ...) are
+// compile-time constants in b2Settings.h, so they can't be part of a profile,
+// and sleeping stays allowed in all of them.
+struct PhysicsProfile final {
+  // Steps `world` by `timeStep` in `subStepCount` equal sub-steps.
+  void step(b2World* world, float timeStep) const;
+
+  std::string name;
+  int velocityIterations;
+  int positionIterations;
+  int subStepCount;
+
+  // Whether the dynamic bodies are kept from tunnelling through the static ones,
+  // i.e., b2World::SetContinuousPhysics(). Without it, the bullets aren't either.
+  bool isContinuousPhysicsEnabled;
+
+  // Whether the fast dynamic bodies (i.e., the Characters rushing with BatForm
+  // or ForwardSlash) are bullets while they're fast, so that they don't tunnel
+  // through the other dynamic bodies either. The rest never pay for it.
+  // MagicalMissile is kinematic, which Box2D never treats as a bullet.
+  bool isBulletEnabled;
+};
+
+namespace physics_profiles {
+
+// From the cheapest to the most accurate.
+const std::vector<PhysicsProfile>& getAll();
+
+// @return the profile named `name`, or nullptr.
+const PhysicsProfile* find(const std::string& name);
+
+// The one used unless another one is set, i.e., kVelocityIterations
+// and kPositionIterations with continuous physics, as before.
+const PhysicsProfile& getDefault();
+
+}  // namespace physics_profiles
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_PHYSICS_PROFILE_H_
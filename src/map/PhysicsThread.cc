@@ -0,0 +1,112 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "PhysicsThread.h"
+
+#include <chrono>
+
+#include "util/Profiler.h"
+
+using std::lock_guard;
+using std::mutex;
+using std::thread;
+using std::unique_lock;
+
+namespace vigilante {
+
+PhysicsThread::PhysicsThread(b2World* world)
+    : _world(world),
+      _isStepping(),
+      _lastWaitMs(),
+      _thread(),
+      _mutex(),
+      _cv(),
+      _timeStep(),
+      _profile(),
+      _hasPendingStep(),
+      _isStepFinished(),
+      _isShuttingDown() {}
+
+PhysicsThread::~PhysicsThread() {
+  wait();
+  {
+    lock_guard<mutex> lock(_mutex);
+    _isShuttingDown = true;
+  }
+  _cv.notify_all();
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+
+
+void PhysicsThread::start(float timeStep, const PhysicsProfile* profile) {
+  wait();
+
+  if (!_thread.joinable()) {
+    _thread = thread(&PhysicsThread::run, this);
+  }
+  {
+    lock_guard<mutex> lock(_mutex);
+    _timeStep = timeStep;
+    _profile = profile;
+    _hasPendingStep = true;
+    _isStepFinished = false;
+  }
+  _cv.notify_all();
+  _isStepping = true;
+}
+
+void PhysicsThread::wait() {
+  if (!_isStepping) {
+    return;
+  }
+
+  VGPROFILE_SCOPE("PhysicsThread::wait");
+  auto begin = std::chrono::steady_clock::now();
+  {
+    unique_lock<mutex> lock(_mutex);
+    _cv.wait(lock, [this]() { return _isStepFinished; });
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  _lastWaitMs = std::chrono::duration<float, std::milli>(end - begin).count();
+  _isStepping = false;
+}
+
+bool PhysicsThread::isStepping() const {
+  return _isStepping;
+}
+
+float PhysicsThread::getLastWaitMs() const {
+  return _lastWaitMs;
+}
+
+
+void PhysicsThread::run() {
+  while (true) {
+    float timeStep;
+    const PhysicsProfile* profile;
+    {
+      unique_lock<mutex> lock(_mutex);
+      _cv.wait(lock, [this]() { return _isShuttingDown || _hasPendingStep; });
+      if (_isShuttingDown) {
+        return;
+      }
+      _hasPendingStep = false;
+      timeStep = _timeStep;
+      profile = _profile;
+    }
+
+    {
+      VGPROFILE_SCOPE("b2World::Step");
+      profile->step(_world, timeStep);
+    }
+
+    {
+      lock_guard<mutex> lock(_mutex);
+      _isStepFinished = true;
+    }
+    _cv.notify_all();
+  }
+}
+
+}  // namespace vigilante
@@ -0,0 +1,54 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_PHYSICS_THREAD_H_
+#define VIGILANTE_PHYSICS_THREAD_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <Box2D/Box2D.h>
+#include "PhysicsProfile.h"
+
+namespace vigilante {
+
+// Steps a b2World on a thread of its own (see GameMapManager::stepWorld()),
+// which only overlaps the step with the rendering.
+//
+// Between start() and wait(), the world belongs to the physics thread,
+// i.e., nothing else may touch it, nor any of its bodies and fixtures.
+class PhysicsThread {
+ public:
+  explicit PhysicsThread(b2World* world);
+  virtual ~PhysicsThread();
+
+  // Starts stepping the world with `profile`, which must outlive the step,
+  // and returns immediately. The thread is created upon the first call.
+  // Main thread only.
+  void start(float timeStep, const PhysicsProfile* profile);
+
+  // Blocks until the step started by start(), if any, has finished. Main thread only.
+  void wait();
+
+  bool isStepping() const;
+  float getLastWaitMs() const;  // how long the last wait() has blocked
+
+ private:
+  void run();
+
+  b2World* _world;
+  bool _isStepping;  // between start() and wait()
+  float _lastWaitMs;
+
+  std::thread _thread;
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  float _timeStep;  // guarded by `_mutex`, as are the fields below
+  const PhysicsProfile* _profile;
+  bool _hasPendingStep;
+  bool _isStepFinished;
+  bool _isShuttingDown;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_PHYSICS_THREAD_H_
@@ -16,15 +16,52 @@
 #include "skill/MagicalMissile.h"
 #include "skill/ForwardSlash.h"
 #include "util/Logger.h"
+#include "util/Profiler.h"
 
 using std::unique_ptr;
 using cocos2d::EventKeyboard;
 
 namespace vigilante {
 
+WorldContactListener::WorldContactListener()
+    : _isQueueing(),
+      _queuedContacts() {}
+
+
 void WorldContactListener::BeginContact(b2Contact* contact) {
-  b2Fixture* fixtureA = contact->GetFixtureA();
-  b2Fixture* fixtureB = contact->GetFixtureB();
+  if (_isQueueing) {
+    _queuedContacts.push_back({contact->GetFixtureA(), contact->GetFixtureB(), /*isBegin=*/true});
+    return;
+  }
+  handleBeginContact(contact->GetFixtureA(), contact->GetFixtureB());
+}
+
+void WorldContactListener::EndContact(b2Contact* contact) {
+  if (_isQueueing) {
+    _queuedContacts.push_back({contact->GetFixtureA(), contact->GetFixtureB(), /*isBegin=*/false});
+    return;
+  }
+  handleEndContact(contact->GetFixtureA(), contact->GetFixtureB());
+}
+
+void WorldContactListener::setQueueing(bool queueing) {
+  _isQueueing = queueing;
+}
+
+void WorldContactListener::handleQueuedContacts() {
+  for (const auto& queuedContact : _queuedContacts) {
+    if (queuedContact.isBegin) {
+      handleBeginContact(queuedContact.fixtureA, queuedContact.fixtureB);
+    } else {
+      handleEndContact(queuedContact.fixtureA, queuedContact.fixtureB);
+    }
+  }
+  _queuedContacts.clear();
+}
+
+
+void WorldContactListener::handleBeginContact(b2Fixture* fixtureA, b2Fixture* fixtureB) {
+  VGPROFILE_SCOPE("WorldContactListener::BeginContact");
 
   int cDef = fixtureA->GetFilterData().categoryBits | fixtureB->GetFilterData().categoryBits;
   switch (cDef) {
@@ -230,9 +267,8 @@ void WorldContactListener::BeginContact(b2Contact* contact) {
   }
 }
 
-void WorldContactListener::EndContact(b2Contact* contact) {
-  b2Fixture* fixtureA = contact->GetFixtureA();
-  b2Fixture* fixtureB = contact->GetFixtureB();
+void WorldContactListener::handleEndContact(b2Fixture* fixtureA, b2Fixture* fixtureB) {
+  VGPROFILE_SCOPE("WorldContactListener::EndContact");
 
   int cDef = fixtureA->GetFilterData().categoryBits | fixtureB->GetFilterData().categoryBits;
   switch (cDef) {
@@ -337,6 +373,8 @@ void WorldContactListener::EndContact(b2Contact* contact) {
 }
 
 void WorldContactListener::PreSolve(b2Contact* contact, const b2Manifold* oldManifold) {
+  VGPROFILE_SCOPE("WorldContactListener::PreSolve");
+
   b2Fixture* fixtureA = contact->GetFixtureA();
   b2Fixture* fixtureB = contact->GetFixtureB();
 
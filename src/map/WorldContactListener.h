@@ -2,13 +2,15 @@
 #ifndef VIGILANTE_WORLD_CONTACT_LISTENER_H_
 #define VIGILANTE_WORLD_CONTACT_LISTENER_H_
 
+#include <vector>
+
 #include <Box2D/Box2D.h>
 
 namespace vigilante {
 
 class WorldContactListener : public b2ContactListener {
  public:
-  WorldContactListener() = default;
+  WorldContactListener();
   virtual ~WorldContactListener() = default;
 
   virtual void BeginContact(b2Contact* contact) override;
@@ -16,8 +18,27 @@ class WorldContactListener : public b2ContactListener {
   virtual void PreSolve(b2Contact* contact, const b2Manifold* oldManifold) override;
   virtual void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse) override;
 
+  // While the world is stepped on the physics thread (see PhysicsThread),
+  // BeginContact() and EndContact() only queue the contacts, which the main
+  // thread handles in order with handleQueuedContacts() once the step has
+  // finished. PreSolve() is always handled right away, since it decides
+  // whether the contact is enabled during this step, and only reads the bodies.
+  void setQueueing(bool queueing);
+  void handleQueuedContacts();
+
  private:
+  struct QueuedContact final {
+    b2Fixture* fixtureA;
+    b2Fixture* fixtureB;
+    bool isBegin;
+  };
+
+  void handleBeginContact(b2Fixture* fixtureA, b2Fixture* fixtureB);
+  void handleEndContact(b2Fixture* fixtureA, b2Fixture* fixtureB);
   b2Fixture* GetTargetFixture(short targetCategoryBits, b2Fixture* f1, b2Fixture* f2) const;
+
+  bool _isQueueing;
+  std::vector<WorldContactListener::QueuedContact> _queuedContacts;  // reused every step
 };
 
 }  // namespace vigilante
@@ -2,6 +2,7 @@
 #include "Chest.h"
 
 #include "Constants.h"
+#include "DecodedImageCache.h"
 #include "map/FxManager.h"
 #include "map/GameMapManager.h"
 #include "ui/control_hints/ControlHints.h"
@@ -52,10 +53,10 @@ bool Chest::showOnMap(float x, float y) {
              ITEM_CATEGORY_BITS,
              ITEM_MASK_BITS);
 
-  _bodySprite = Sprite::create("Texture/interactable_object/chest/chest_close.png");
+  _bodySprite = Sprite::createWithTexture(DecodedImageCache::getInstance()->addImage(
+      "Texture/interactable_object/chest/chest_close.png"));
   _bodySprite->getTexture()->setAliasTexParameters();
-  GameMapManager::getInstance()->getLayer()->addChild(_bodySprite,
-                                                      graphical_layers::kChest);
+  GameMapManager::getInstance()->getGraphicalLayer(graphical_layers::kChest)->addChild(_bodySprite);
   return true;
 }
 
@@ -21,6 +21,10 @@ bool CollectItemObjective::isCompleted() const {
   return GameMapManager::getInstance()->getPlayer()->getItemAmount(_itemName) >= _amount;
 }
 
+const string& CollectItemObjective::getTargetName() const {
+  return _itemName;
+}
+
 const string& CollectItemObjective::getItemName() const {
   return _itemName;
 }
@@ -16,6 +16,7 @@ class CollectItemObjective : public Quest::Objective {
   virtual ~CollectItemObjective() = default;
 
   virtual bool isCompleted() const override;
+  virtual const std::string& getTargetName() const override;
 
   const std::string& getItemName() const;
   int getAmount() const;
@@ -18,6 +18,10 @@ bool KillTargetObjective::isCompleted() const {
   return _currentAmount >= _targetAmount;
 }
 
+const string& KillTargetObjective::getTargetName() const {
+  return _characterName;
+}
+
 
 const string& KillTargetObjective::getCharacterName() const {
   return _characterName;
@@ -35,4 +39,8 @@ void KillTargetObjective::incrementCurrentAmount() {
   _currentAmount++;
 }
 
+void KillTargetObjective::setCurrentAmount(int currentAmount) {
+  _currentAmount = currentAmount;
+}
+
 }  // namespace vigilante
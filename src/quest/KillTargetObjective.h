@@ -16,11 +16,13 @@ class KillTargetObjective : public Quest::Objective {
   virtual ~KillTargetObjective() = default;
 
   virtual bool isCompleted() const override;
+  virtual const std::string& getTargetName() const override;
 
   const std::string& getCharacterName() const;
   int getTargetAmount() const;
   int getCurrentAmount() const;
   void incrementCurrentAmount();
+  void setCurrentAmount(int currentAmount);
 
  private:
   std::string _characterName;
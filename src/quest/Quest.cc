@@ -5,6 +5,7 @@
 
 #include <json/document.h>
 #include "std/make_unique.h"
+#include "gameplay/SaveJournal.h"
 #include "quest/CollectItemObjective.h"
 #include "quest/KillTargetObjective.h"
 #include "ui/console/Console.h"
@@ -40,11 +41,10 @@ void Quest::advanceStage() {
   // Execute the commands that are supposed to run after
   // this stage is completed.
   if (_currentStageIdx >= 0) {
-    for (const auto& cmd : getCurrentStage().cmds) {
-      Console::getInstance()->executeCmd(cmd);
-    }
+    Console::getInstance()->executeCmds(getCurrentStage().cmds);
   }
   ++_currentStageIdx;
+  SaveJournal::getInstance()->recordQuestStageAdvanced(_questProfile.jsonFileName, _currentStageIdx);
 
   // Update quest desc (if provided).
   // We can only update quest desc if it hasn't been completed,
@@ -54,6 +54,22 @@ void Quest::advanceStage() {
   }
 }
 
+void Quest::restoreProgress(bool isUnlocked, int currentStageIdx) {
+  // The quest desc may have been updated by previous stages.
+  if (_currentStageIdx >= 0) {
+    import(_questProfile.jsonFileName);
+  }
+
+  _isUnlocked = isUnlocked;
+  _currentStageIdx = std::min(currentStageIdx, static_cast<int>(_questProfile.stages.size()));
+
+  for (int i = 0; i <= _currentStageIdx && i < (int) _questProfile.stages.size(); i++) {
+    if (!_questProfile.stages[i].questDesc.empty()) {
+      _questProfile.desc = _questProfile.stages[i].questDesc;
+    }
+  }
+}
+
 bool Quest::isUnlocked() const {
   return _isUnlocked;
 }
@@ -70,6 +86,10 @@ const Quest::Stage& Quest::getCurrentStage() const {
   return _questProfile.stages.at(_currentStageIdx);
 }
 
+int Quest::getCurrentStageIdx() const {
+  return _currentStageIdx;
+}
+
 
 
 Quest::Objective::Objective(Objective::Type objectiveType, const string& desc)
@@ -83,6 +103,11 @@ const string& Quest::Objective::getDesc() const {
   return _desc;
 }
 
+const string& Quest::Objective::getTargetName() const {
+  static const string kNone;
+  return kNone;
+}
+
 
 
 string Quest::Stage::getHint() const {
@@ -158,9 +183,11 @@ Quest::Profile::Profile(const string& jsonFileName) : jsonFileName(jsonFileName)
       stage.questDesc = questDesc;
     }
 
+    vector<string> cmds;
     for (const auto& cmd : stageJson["exec"].GetArray()) {
-      stage.cmds.push_back(cmd.GetString());
+      cmds.push_back(cmd.GetString());
     }
+    stage.cmds = CommandParser::compileAll(cmds, jsonFileName);
 
     stages.push_back(std::move(stage));
   }
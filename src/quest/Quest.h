@@ -8,6 +8,7 @@
 #include <unordered_map>
 
 #include "Importable.h"
+#include "ui/console/CommandParser.h"
 
 namespace vigilante {
 
@@ -32,6 +33,10 @@ class Quest : public Importable {
 
     virtual bool isCompleted() const = 0;
 
+    // The name of the character or item this objective is about, if any.
+    // QuestBook indexes the in-progress quests by (type, target name).
+    virtual const std::string& getTargetName() const;
+
     Objective::Type getObjectiveType() const;
     const std::string& getDesc() const;
 
@@ -49,7 +54,7 @@ class Quest : public Importable {
     bool isFinished;
     std::string questDesc;  // optionally update questDesc when this stage is reached.
     std::unique_ptr<Objective> objective; 
-    std::vector<std::string> cmds;
+    std::vector<CommandParser::Instruction> cmds;
   };
 
 
@@ -68,11 +73,16 @@ class Quest : public Importable {
   void unlock();
   void advanceStage();
 
+  // Sets the quest's progress directly, without executing the commands
+  // of the skipped stages. Used when loading a saved game.
+  void restoreProgress(bool isUnlocked, int currentStageIdx);
+
   bool isUnlocked() const;
   bool isCompleted() const;
 
   const Quest::Profile& getQuestProfile() const;
   const Quest::Stage& getCurrentStage() const;
+  int getCurrentStageIdx() const;
 
  private:
   Quest::Profile _questProfile;
@@ -6,22 +6,28 @@
 #include <stdexcept>
 
 #include "std/make_unique.h"
+#include "gameplay/SaveJournal.h"
 #include "quest/KillTargetObjective.h"
 #include "ui/quest_hints/QuestHints.h"
 #include "util/ds/Algorithm.h"
 #include "util/StringUtil.h"
 #include "util/Logger.h"
 
+using std::mutex;
 using std::string;
+using std::thread;
 using std::vector;
 using std::ifstream;
+using std::lock_guard;
 using std::unique_ptr;
 using std::unordered_map;
 using std::runtime_error;
 
 namespace vigilante {
 
-QuestBook::QuestBook(const string& questsListFileName) {
+QuestBook::QuestBook(const string& questsListFileName)
+    : _isPreloadCancelled(),
+      _isPreloadThreadRunning() {
   ifstream fin(questsListFileName);
   if (!fin.is_open()) {
     throw runtime_error("Failed to open quest list: " + questsListFileName);
@@ -29,28 +35,101 @@ QuestBook::QuestBook(const string& questsListFileName) {
 
   string line;
   while (std::getline(fin, line)) {
-    _questMapper[line] = std::make_unique<Quest>(line);
+    _questMapper[line] = nullptr;
   }
 }
 
+QuestBook::~QuestBook() {
+  _isPreloadCancelled = true;
+  if (_preloadThread.joinable()) {
+    _preloadThread.join();
+  }
+}
 
-void QuestBook::update(Quest::Objective::Type objectiveType) {
-  VGLOG(LOG_INFO, "Updating quests");
-  for (const auto quest : _inProgressQuests) {
-    if (quest->getCurrentStage().objective->getObjectiveType() != objectiveType) {
-      continue;
+
+void QuestBook::update(Quest::Objective::Type objectiveType, const string& targetName) {
+  auto it = _objectiveIndex.find({objectiveType, targetName});
+  if (it == _objectiveIndex.end()) {
+    return;
+  }
+
+  // Advancing a quest moves it to another index entry, so iterate over a copy.
+  const vector<Quest*> quests = it->second;
+  for (const auto quest : quests) {
+    if (objectiveType == Quest::Objective::Type::KILL) {
+      auto o = static_cast<KillTargetObjective*>(quest->getCurrentStage().objective.get());
+      o->incrementCurrentAmount();
+      SaveJournal::getInstance()->recordQuestObjectiveUpdated(quest->getQuestProfile().jsonFileName,
+                                                              o->getCurrentAmount());
     }
+    advanceIfObjectiveCompleted(quest);
+  }
+}
 
-    while (!quest->isCompleted() && quest->getCurrentStage().objective->isCompleted()) {
-      quest->advanceStage();
+void QuestBook::advanceIfObjectiveCompleted(Quest* quest) {
+  auto isObjectiveCompleted = [quest]() {
+    return !quest->isCompleted() &&
+           quest->getCurrentStage().objective &&
+           quest->getCurrentStage().objective->isCompleted();
+  };
 
-      if (quest->isCompleted()) {
-        markCompleted(quest);
-      } else {
-        QuestHints::getInstance()->show(quest->getCurrentStage().objective->getDesc());
-      }
+  if (!isObjectiveCompleted()) {
+    return;
+  }
+
+  removeFromObjectiveIndex(quest);
+  while (isObjectiveCompleted()) {
+    quest->advanceStage();
+
+    if (quest->isCompleted()) {
+      markCompleted(quest);
+    } else if (quest->getCurrentStage().objective) {
+      QuestHints::getInstance()->show(quest->getCurrentStage().objective->getDesc());
     }
   }
+
+  // The stage's commands may have completed this quest as well.
+  if (_inProgressQuestSet.count(quest)) {
+    addToObjectiveIndex(quest);
+  }
+}
+
+void QuestBook::addToObjectiveIndex(Quest* quest) {
+  if (quest->getCurrentStageIdx() < 0 || quest->isCompleted() ||
+      !quest->getCurrentStage().objective) {
+    return;
+  }
+
+  const Quest::Objective* objective = quest->getCurrentStage().objective.get();
+  ObjectiveKey key(objective->getObjectiveType(), objective->getTargetName());
+  _objectiveIndex[key].push_back(quest);
+  _indexedObjectiveKeys[quest] = std::move(key);
+}
+
+void QuestBook::removeFromObjectiveIndex(Quest* quest) {
+  auto keyIt = _indexedObjectiveKeys.find(quest);
+  if (keyIt == _indexedObjectiveKeys.end()) {
+    return;
+  }
+
+  auto it = _objectiveIndex.find(keyIt->second);
+  vector<Quest*>& quests = it->second;
+  quests.erase(std::remove(quests.begin(), quests.end(), quest), quests.end());
+  if (quests.empty()) {
+    _objectiveIndex.erase(it);
+  }
+  _indexedObjectiveKeys.erase(keyIt);
+}
+
+void QuestBook::rebuildIndices() {
+  _inProgressQuestSet.clear();
+  _objectiveIndex.clear();
+  _indexedObjectiveKeys.clear();
+
+  for (const auto quest : _inProgressQuests) {
+    _inProgressQuestSet.insert(quest);
+    addToObjectiveIndex(quest);
+  }
 }
 
 
@@ -60,24 +139,26 @@ void QuestBook::unlockQuest(Quest* quest) {
 
 void QuestBook::startQuest(Quest* quest) {
   // If the quest is already completed or is already in progress, return at once.
-  if (quest->isCompleted() ||
-      std::find(_inProgressQuests.begin(), _inProgressQuests.end(), quest) != _inProgressQuests.end()) {
+  if (quest->isCompleted() || _inProgressQuestSet.count(quest)) {
     return;
   }
 
   // Add this quest to _inProgressQuests.
   _inProgressQuests.push_back(quest);
+  _inProgressQuestSet.insert(quest);
 
   quest->advanceStage();
+  addToObjectiveIndex(quest);
   QuestHints::getInstance()->show("Started: " + quest->getQuestProfile().title);
   QuestHints::getInstance()->show(quest->getCurrentStage().objective->getDesc());
 }
 
 void QuestBook::markCompleted(Quest* quest) {
   // If `quest` is currently NOT in progress, return at once.
-  if (std::find(_inProgressQuests.begin(), _inProgressQuests.end(), quest) == _inProgressQuests.end()) {
+  if (!_inProgressQuestSet.erase(quest)) {
     return;
   }
+  removeFromObjectiveIndex(quest);
 
   // If we can get here, then `quest` must be in progress, and we have to
   // mark it as completed. We'll erase this quest from _inProgressQuests,
@@ -92,30 +173,118 @@ void QuestBook::markCompleted(Quest* quest) {
 
 
 void QuestBook::unlockQuest(const string& questJsonFileName) {
-  auto it = _questMapper.find(questJsonFileName);
-  if (it == _questMapper.end()) {
+  Quest* quest = getQuest(questJsonFileName);
+  if (!quest) {
     return;
   }
-  unlockQuest(it->second.get());
+  unlockQuest(quest);
 }
 
 void QuestBook::startQuest(const string& questJsonFileName) {
-  auto it = _questMapper.find(questJsonFileName);
-  if (it == _questMapper.end()) {
+  Quest* quest = getQuest(questJsonFileName);
+  if (!quest) {
     return;
   }
-  startQuest(it->second.get());
+  startQuest(quest);
 }
 
 void QuestBook::markCompleted(const string& questJsonFileName) {
+  // A quest that hasn't been loaded can't be in progress.
   auto it = _questMapper.find(questJsonFileName);
-  if (it == _questMapper.end()) {
+  if (it == _questMapper.end() || !it->second) {
     return;
   }
   markCompleted(it->second.get());
 }
 
 
+Quest* QuestBook::getQuest(const string& questJsonFileName) {
+  auto it = _questMapper.find(questJsonFileName);
+  if (it == _questMapper.end()) {
+    return nullptr;
+  }
+
+  if (!it->second) {
+    {
+      lock_guard<mutex> lock(_preloadMutex);
+      auto preloadedIt = _preloadedQuests.find(questJsonFileName);
+      if (preloadedIt != _preloadedQuests.end()) {
+        it->second = std::move(preloadedIt->second);
+        _preloadedQuests.erase(preloadedIt);
+      } else if (_pendingPreloads.erase(questJsonFileName)) {
+        // The worker will skip it, or discard its copy.
+        _preloadQueue.erase(std::remove(_preloadQueue.begin(), _preloadQueue.end(), questJsonFileName),
+                            _preloadQueue.end());
+      }
+    }
+    if (!it->second) {
+      it->second = std::make_unique<Quest>(questJsonFileName);
+    }
+  }
+  return it->second.get();
+}
+
+void QuestBook::preloadInBackground(const vector<string>& questJsonFileNames) {
+  lock_guard<mutex> lock(_preloadMutex);
+
+  for (const auto& questJsonFileName : questJsonFileNames) {
+    auto it = _questMapper.find(questJsonFileName);
+    if (it == _questMapper.end() || it->second ||
+        _preloadedQuests.count(questJsonFileName) ||
+        !_pendingPreloads.insert(questJsonFileName).second) {
+      continue;
+    }
+    _preloadQueue.push_back(questJsonFileName);
+  }
+
+  if (_preloadQueue.empty() || _isPreloadThreadRunning) {
+    return;
+  }
+
+  // The previous worker (if any) has already found the queue empty.
+  if (_preloadThread.joinable()) {
+    _preloadThread.join();
+  }
+  _isPreloadThreadRunning = true;
+  _preloadThread = thread(&QuestBook::runPreloadThread, this);
+}
+
+void QuestBook::runPreloadThread() {
+  int preloadedCount = 0;
+
+  while (!_isPreloadCancelled) {
+    string questJsonFileName;
+    {
+      lock_guard<mutex> lock(_preloadMutex);
+      if (_preloadQueue.empty()) {
+        _isPreloadThreadRunning = false;
+        break;
+      }
+      questJsonFileName = std::move(_preloadQueue.front());
+      _preloadQueue.pop_front();
+    }
+
+    try {
+      auto quest = std::make_unique<Quest>(questJsonFileName);
+      lock_guard<mutex> lock(_preloadMutex);
+      // Unless the main thread has loaded its own copy in the meantime.
+      if (_pendingPreloads.erase(questJsonFileName)) {
+        _preloadedQuests[questJsonFileName] = std::move(quest);
+        preloadedCount++;
+      }
+    } catch (const std::exception& ex) {
+      VGLOG(LOG_ERR, "Failed to preload quest %s: %s", questJsonFileName.c_str(), ex.what());
+      lock_guard<mutex> lock(_preloadMutex);
+      _pendingPreloads.erase(questJsonFileName);
+    }
+  }
+
+  if (preloadedCount > 0) {
+    VGLOG(LOG_INFO, "Preloaded %d quests", preloadedCount);
+  }
+}
+
+
 vector<Quest*> QuestBook::getAllQuests() const {
   vector<Quest*> allQuests(_inProgressQuests.begin(), _inProgressQuests.end());
   allQuests.insert(allQuests.end(), _completedQuests.begin(), _completedQuests.end());
@@ -130,4 +299,9 @@ const vector<Quest*>& QuestBook::getCompletedQuests() const {
   return _completedQuests;
 }
 
+
+size_t QuestBook::ObjectiveKeyHash::operator()(const QuestBook::ObjectiveKey& key) const {
+  return std::hash<string>()(key.second) * 31 + key.first;
+}
+
 }  // namespace vigilante
@@ -2,21 +2,34 @@
 #ifndef VIGILANTE_QUEST_BOOK_H_
 #define VIGILANTE_QUEST_BOOK_H_
 
+#include <atomic>
+#include <deque>
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 #include "Quest.h"
 
 namespace vigilante {
 
+// Quests are loaded lazily. The ctor only reads the quests list, and
+// each Quest is constructed (its json parsed) when it's first needed,
+// or earlier on a worker thread if it has been passed to preloadInBackground()
+// (e.g., the quests an Npc's dialogue may start, once it begins).
 class QuestBook {
  public:
   explicit QuestBook(const std::string& questsListFileName);
-  virtual ~QuestBook() = default;
+  virtual ~QuestBook();
 
-  void update(const Quest::Objective::Type objectiveType);
+  // Called when something a quest objective may care about happens, e.g.
+  // (KILL, character name) or (COLLECT, item name). Only the in-progress quests
+  // whose current objective matches the event are checked (and advanced).
+  void update(const Quest::Objective::Type objectiveType, const std::string& targetName);
 
   void unlockQuest(Quest* quest);
   void startQuest(Quest* quest);
@@ -26,14 +39,60 @@ class QuestBook {
   void startQuest(const std::string& questJsonFileName);
   void markCompleted(const std::string& questJsonFileName);
 
+  // Loads the given quest if it hasn't been loaded yet.
+  // @return nullptr if the quest isn't in the quests list.
+  Quest* getQuest(const std::string& questJsonFileName);
+
+  // Starts loading the given quests on a worker thread, except those which
+  // have been loaded or queued already. They are handed over to the main
+  // thread by getQuest(), which also drops them from the queue if they're
+  // needed before the worker gets to them.
+  void preloadInBackground(const std::vector<std::string>& questJsonFileNames);
+
   std::vector<Quest*> getAllQuests() const;
   const std::vector<Quest*>& getInProgressQuests() const;
   const std::vector<Quest*>& getCompletedQuests() const;
 
  private:
+  using ObjectiveKey = std::pair<Quest::Objective::Type, std::string>;
+
+  struct ObjectiveKeyHash {
+    size_t operator()(const ObjectiveKey& key) const;
+  };
+
+  void advanceIfObjectiveCompleted(Quest* quest);
+  void addToObjectiveIndex(Quest* quest);
+  void removeFromObjectiveIndex(Quest* quest);
+
+  // Rebuilds the lookup structures below from `_inProgressQuests`.
+  void rebuildIndices();
+
+  // Quests which haven't been loaded yet are mapped to nullptr.
   std::unordered_map<std::string, std::unique_ptr<Quest>> _questMapper;
   std::vector<Quest*> _inProgressQuests;
   std::vector<Quest*> _completedQuests;
+  std::unordered_set<Quest*> _inProgressQuestSet;
+
+  // In-progress quests indexed by their current objective.
+  std::unordered_map<ObjectiveKey, std::vector<Quest*>, ObjectiveKeyHash> _objectiveIndex;
+  std::unordered_map<Quest*, ObjectiveKey> _indexedObjectiveKeys;
+
+  // Preloads the quests in `_preloadQueue`, and exits once it's empty.
+  void runPreloadThread();
+
+  std::thread _preloadThread;
+  std::atomic<bool> _isPreloadCancelled;
+  std::mutex _preloadMutex;
+  // The fields below are guarded by `_preloadMutex`.
+  bool _isPreloadThreadRunning;
+  std::deque<std::string> _preloadQueue;
+  // The quests in `_preloadQueue` or being preloaded, which are still wanted.
+  std::unordered_set<std::string> _pendingPreloads;
+  // The preloaded quests which getQuest() hasn't adopted yet.
+  std::unordered_map<std::string, std::unique_ptr<Quest>> _preloadedQuests;
+
+  // Saves and restores the progress of all quests.
+  friend class GameState;
 };
 
 } // namespace vigilante
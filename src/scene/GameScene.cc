@@ -9,8 +9,11 @@
 #include "Constants.h"
 #include "character/Player.h"
 #include "gameplay/ExpPointTable.h"
+#include "gameplay/GameState.h"
+#include "gameplay/SaveJournal.h"
 #include "gameplay/ItemPriceTable.h"
 #include "input/InputManager.h"
+#include "input/InputRecorder.h"
 #include "map/GameMap.h"
 #include "skill/Skill.h"
 #include "quest/Quest.h"
@@ -19,6 +22,7 @@
 #include "util/KeyCodeUtil.h"
 #include "util/RandUtil.h"
 #include "util/Logger.h"
+#include "util/Profiler.h"
 
 using std::string;
 using std::unique_ptr;
@@ -53,7 +57,12 @@ bool GameScene::init() {
 
   // Initialize Vigilante's utils.
   vigilante::keycode_util::init();
-  vigilante::rand_util::init();
+  // A recorded (or replayed) session must use the recorded seed.
+  if (InputRecorder::getInstance()->isActive()) {
+    vigilante::rand_util::init(InputRecorder::getInstance()->getSeed());
+  } else {
+    vigilante::rand_util::init();
+  }
 
   // Initialize HUD camera.
   _hudCamera = Camera::createOrthographic(winSize.width, winSize.height, 1, 1000);
@@ -139,19 +148,43 @@ bool GameScene::init() {
   _pauseMenu->getLayer()->setCameraMask(static_cast<uint16_t>(CameraFlag::USER1));
   addChild(_pauseMenu->getLayer(), graphical_layers::kPauseMenu);
 
+  // Initialize profiler overlay.
+  _profilerOverlay = ProfilerOverlay::getInstance();
+  _profilerOverlay->getLayer()->setCameraMask(static_cast<uint16_t>(CameraFlag::USER1));
+  addChild(_profilerOverlay->getLayer(), graphical_layers::kProfilerOverlay);
+
+  // Initialize physics overlay.
+  _physicsOverlay = PhysicsOverlay::getInstance();
+  _physicsOverlay->getLayer()->setCameraMask(static_cast<uint16_t>(CameraFlag::USER1));
+  addChild(_physicsOverlay->getLayer(), graphical_layers::kPhysicsOverlay);
+
   // Tick the box2d world.
   schedule(schedule_selector(GameScene::update));
-
-  startNewGame();
   return true;
 }
 
 void GameScene::update(float delta) {
+  // Gather the zones recorded since the previous frame.
+  profiler::collect();
+  _profilerOverlay->update(delta);
+
+  // Recorded (and replayed) sessions run on fixed ticks.
+  InputRecorder* inputRecorder = InputRecorder::getInstance();
+  if (inputRecorder->isActive()) {
+    inputRecorder->beginTick();
+    delta = 1 / kFps;
+  }
+
   if (!_gameMapManager->getGameMap()) {
     return;
   }
 
-  handleInput();
+  VGPROFILE_SCOPE("GameScene::update");
+
+  {
+    VGPROFILE_SCOPE("GameScene::handleInput");
+    handleInput();
+  }
 
   if (_pauseMenu->isVisible()) {
     return;
@@ -159,22 +192,52 @@ void GameScene::update(float delta) {
 
   // If there are no ongoing GameMap transitions, then step the box2d world.
   if (_shade->getImageView()->getNumberOfRunningActions() == 0) {
-    _gameMapManager->getWorld()->Step(1 / kFps,
-                                      kVelocityIterations,
-                                      kPositionIterations);
-  }
-
-  _gameMapManager->update(delta);
-  _floatingDamages->update(delta);
-  _notifications->update(delta);
-  _questHints->update(delta);
-  _dialogueManager->update(delta);
-  _console->update(delta);
-  _windowManager->update(delta);
-
-  vigilante::camera_util::lerpToTarget(_gameCamera, _gameMapManager->getPlayer()->getBody()->GetPosition());
-  vigilante::camera_util::boundCamera(_gameCamera, _gameMapManager->getGameMap());
-  vigilante::camera_util::updateShake(_gameCamera, delta);
+    _gameMapManager->stepWorld(1 / kFps);
+  }
+
+  {
+    VGPROFILE_SCOPE("PhysicsOverlay::update");
+    _physicsOverlay->update(delta);
+  }
+  {
+    VGPROFILE_SCOPE("GameMapManager::update");
+    _gameMapManager->update(delta);
+  }
+  {
+    VGPROFILE_SCOPE("FloatingDamages::update");
+    _floatingDamages->update(delta);
+  }
+  {
+    VGPROFILE_SCOPE("Notifications::update");
+    _notifications->update(delta);
+  }
+  {
+    VGPROFILE_SCOPE("QuestHints::update");
+    _questHints->update(delta);
+  }
+  {
+    VGPROFILE_SCOPE("DialogueManager::update");
+    _dialogueManager->update(delta);
+  }
+  {
+    VGPROFILE_SCOPE("Console::update");
+    _console->update(delta);
+  }
+  {
+    VGPROFILE_SCOPE("WindowManager::update");
+    _windowManager->update(delta);
+  }
+  // Compact the save journal between (not during) GameMap transitions.
+  if (_shade->getImageView()->getNumberOfRunningActions() == 0) {
+    VGPROFILE_SCOPE("SaveJournal::update");
+    SaveJournal::getInstance()->update();
+  }
+  {
+    VGPROFILE_SCOPE("camera_util");
+    vigilante::camera_util::lerpToTarget(_gameCamera, _gameMapManager->getPlayer()->getBody()->GetPosition());
+    vigilante::camera_util::boundCamera(_gameCamera, _gameMapManager->getGameMap());
+    vigilante::camera_util::updateShake(_gameCamera, delta);
+  }
 }
 
 void GameScene::handleInput() {
@@ -236,11 +299,17 @@ void GameScene::handleInput() {
 
 
 void GameScene::startNewGame() {
+  SaveJournal::getInstance()->close();
   _gameMapManager->loadGameMap(asset_manager::kNewGameInitialMap);
+  InputRecorder::getInstance()->onGameStarted("");
 }
 
-void GameScene::loadGame(const string& gameSaveFilePath) {
-
+bool GameScene::loadGame(const string& gameSaveFilePath) {
+  if (!GameState(gameSaveFilePath).load()) {
+    return false;
+  }
+  InputRecorder::getInstance()->onGameStarted(gameSaveFilePath);
+  return true;
 }
 
 }  // namespace vigilante
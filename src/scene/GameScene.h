@@ -19,6 +19,8 @@
 #include "ui/floating_damages/FloatingDamages.h"
 #include "ui/notifications/Notifications.h"
 #include "ui/pause_menu/PauseMenu.h"
+#include "ui/physics_overlay/PhysicsOverlay.h"
+#include "ui/profiler_overlay/ProfilerOverlay.h"
 #include "ui/quest_hints/QuestHints.h"
 #include "util/box2d/b2DebugRenderer.h"
 
@@ -33,8 +35,9 @@ class GameScene : public cocos2d::Scene, public Controllable {
   virtual void update(float delta) override;  // cocos2d::Scene
   virtual void handleInput() override;  // Controllable
 
+  // Call either of these after the scene has been created.
   void startNewGame();
-  void loadGame(const std::string& gameSaveFilePath);
+  bool loadGame(const std::string& gameSaveFilePath);
 
  private:
   cocos2d::Camera* _gameCamera;
@@ -54,6 +57,8 @@ class GameScene : public cocos2d::Scene, public Controllable {
   FloatingDamages* _floatingDamages;
   QuestHints* _questHints;
   Notifications* _notifications;
+  ProfilerOverlay* _profilerOverlay;
+  PhysicsOverlay* _physicsOverlay;
   GameMapManager* _gameMapManager;
   FxManager* _fxManager;
 };
@@ -0,0 +1,84 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "LoadingScene.h"
+
+#include <string>
+
+#include "AssetManager.h"
+#include "DecodedImageCache.h"
+#include "TextureResidencyManager.h"
+#include "input/InputRecorder.h"
+#include "scene/MainMenuScene.h"
+#include "scene/SceneManager.h"
+#include "util/Logger.h"
+
+// How long the main thread may spend uploading spritesheets per frame (in seconds),
+// so that the loading screen still renders at about 60 fps.
+#define UPLOAD_BUDGET_PER_FRAME .008f
+
+using std::string;
+using cocos2d::Director;
+using cocos2d::Label;
+using vigilante::asset_manager::kBoldFont;
+using vigilante::asset_manager::kRegularFontSize;
+
+namespace vigilante {
+
+bool LoadingScene::init() {
+  if (!Scene::init()) {
+    return false;
+  }
+
+  _beginTime = std::chrono::steady_clock::now();
+
+  VGLOG(LOG_INFO, "Loading textures...");
+  asset_manager::loadAtlasManifest(asset_manager::kAtlasManifest);
+  _spritesheetLoader.reset(new SpritesheetLoader(asset_manager::kSpritesheetsList));
+
+  auto winSize = Director::getInstance()->getWinSize();
+  _progressLabel = Label::createWithTTF("Loading...", kBoldFont, kRegularFontSize);
+  _progressLabel->getFontAtlas()->setAliasTexParameters();
+  _progressLabel->setPosition(winSize.width / 2, winSize.height / 2);
+  addChild(_progressLabel);
+
+  scheduleUpdate();
+  return true;
+}
+
+void LoadingScene::update(float) {
+  if (!_spritesheetLoader) {
+    return;
+  }
+
+  _spritesheetLoader->update(UPLOAD_BUDGET_PER_FRAME);
+  _progressLabel->setString("Loading... " +
+                            std::to_string(static_cast<int>(_spritesheetLoader->getProgress() * 100)) + "%");
+
+  if (!_spritesheetLoader->isDone()) {
+    return;
+  }
+
+  // These are few and small, and mostly come from the cache anyway.
+  DecodedImageCache* decodedImageCache = DecodedImageCache::getInstance();
+  for (const auto& fileName : asset_manager::kPreloadedImages) {
+    decodedImageCache->addImage(fileName);
+  }
+
+  const double timeToMainMenuMs = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - _beginTime).count();
+  VGLOG(LOG_INFO, "Loaded %zu spritesheets, time to main menu: %.1f ms (%zu images decoded, %zu from cache)",
+        _spritesheetLoader->getTotalCount(), timeToMainMenuMs,
+        decodedImageCache->getMissCount(), decodedImageCache->getHitCount());
+
+  // The workers have finished, so this doesn't block.
+  _spritesheetLoader.reset();
+  TextureResidencyManager::getInstance()->evictUnreferenced();
+  MainMenuScene* mainMenuScene = MainMenuScene::create();
+  SceneManager::getInstance()->replaceScene(mainMenuScene);
+
+  // The main menu isn't recorded, so a replay skips it.
+  if (InputRecorder::getInstance()->isReplaying()) {
+    mainMenuScene->startRecordedGame();
+  }
+}
+
+}  // namespace vigilante
@@ -0,0 +1,33 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_LOADING_SCENE_H_
+#define VIGILANTE_LOADING_SCENE_H_
+
+#include <chrono>
+#include <memory>
+
+#include <cocos2d.h>
+#include <2d/CCLabel.h>
+#include "SpritesheetLoader.h"
+
+namespace vigilante {
+
+// The first scene of the game. It loads the spritesheets a few per frame
+// with a SpritesheetLoader while showing the progress, and then replaces
+// itself with the MainMenuScene.
+class LoadingScene : public cocos2d::Scene {
+ public:
+  CREATE_FUNC(LoadingScene);
+  virtual ~LoadingScene() = default;
+
+  virtual bool init() override;  // cocos2d::Scene
+  virtual void update(float delta) override;  // cocos2d::Scene
+
+ private:
+  std::unique_ptr<SpritesheetLoader> _spritesheetLoader;
+  cocos2d::Label* _progressLabel;
+  std::chrono::steady_clock::time_point _beginTime;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_LOADING_SCENE_H_
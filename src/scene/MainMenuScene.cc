@@ -3,6 +3,8 @@
 
 #include <SimpleAudioEngine.h>
 #include "AssetManager.h"
+#include "gameplay/GameState.h"
+#include "input/InputRecorder.h"
 #include "scene/GameScene.h"
 #include "scene/SceneManager.h"
 #include "ui/Colorscheme.h"
@@ -99,13 +101,13 @@ void MainMenuScene::handleInput() {
 
   } else if (IS_KEY_JUST_PRESSED(EventKeyboard::KeyCode::KEY_ENTER)) {
     switch (static_cast<Option>(_current)) {
-      case Option::NEW_GAME: {
-        InputManager::getInstance()->deactivate();
-        SimpleAudioEngine::getInstance()->stopBackgroundMusic();
-        SceneManager::getInstance()->pushScene(GameScene::create());
+      case Option::NEW_GAME:
+        startGame("");
         break;
-      }
       case Option::LOAD_GAME:
+        if (GameState::exists(GameState::getDefaultFilePath())) {
+          startGame(GameState::getDefaultFilePath());
+        }
         break;
       case Option::OPTIONS:
         break;
@@ -118,4 +120,18 @@ void MainMenuScene::handleInput() {
   }
 }
 
+void MainMenuScene::startRecordedGame() {
+  startGame(InputRecorder::getInstance()->getGameSaveFilePath());
+}
+
+void MainMenuScene::startGame(const string& gameSaveFilePath) {
+  InputManager::getInstance()->deactivate();
+  SimpleAudioEngine::getInstance()->stopBackgroundMusic();
+  GameScene* gameScene = GameScene::create();
+  if (gameSaveFilePath.empty() || !gameScene->loadGame(gameSaveFilePath)) {
+    gameScene->startNewGame();
+  }
+  SceneManager::getInstance()->pushScene(gameScene);
+}
+
 }  // namespace vigilante
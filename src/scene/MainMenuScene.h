@@ -23,6 +23,10 @@ class MainMenuScene : public cocos2d::Scene, public Controllable {
   virtual void update(float delta) override; // cocos2d::Scene
   virtual void handleInput() override; // Controllable
 
+  // Starts the game the way the replayed session was started
+  // (see InputRecorder::Recording::gameSaveFilePath).
+  void startRecordedGame();
+
  private:
   enum Option {
     NEW_GAME,
@@ -38,6 +42,10 @@ class MainMenuScene : public cocos2d::Scene, public Controllable {
   static const int _kMenuOptionGap;
   static const int _kFooterLabelPadding;
 
+  // Loads the game saved at `gameSaveFilePath`, or starts a new game
+  // if it's empty or cannot be loaded.
+  void startGame(const std::string& gameSaveFilePath);
+
   cocos2d::ui::ImageView* _background;
   std::vector<cocos2d::Label*> _labels;
   int _current;
@@ -31,6 +31,12 @@ void SceneManager::popScene() {
   _scenes.pop();
 }
 
+void SceneManager::replaceScene(Scene* scene) {
+  _director->replaceScene(scene);
+  _scenes.pop();
+  _scenes.push(scene);
+}
+
 Scene* SceneManager::getCurrentScene() const {
   return _scenes.top();
 }
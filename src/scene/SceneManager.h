@@ -21,6 +21,7 @@ class SceneManager final {
   void runWithScene(cocos2d::Scene* scene);
   void pushScene(cocos2d::Scene* scene);
   void popScene();
+  void replaceScene(cocos2d::Scene* scene);
   cocos2d::Scene* getCurrentScene() const;
 
  private:
@@ -51,11 +51,16 @@ void BatForm::activate() {
   float oldBodyDamping = _user->getBody()->GetLinearDamping();
   _user->getBody()->SetLinearDamping(4.0f);
 
+  // Rushing is fast enough to tunnel through thin bodies (see PhysicsProfile).
+  bool wasBullet = _user->getBody()->IsBullet();
+  _user->getBody()->SetBullet(GameMapManager::getInstance()->getPhysicsProfile().isBulletEnabled);
+
   _user->setInvincible(true);
   _user->getFixtures()[Character::FixtureType::BODY]->SetSensor(true);
 
   CallbackManager::getInstance()->runAfter([=]() {
     _user->getBody()->SetLinearDamping(oldBodyDamping);
+    _user->getBody()->SetBullet(wasBullet);
     _user->setInvincible(false);
     _user->getFixtures()[Character::FixtureType::BODY]->SetSensor(false);
     _user->removeActiveSkill(this);
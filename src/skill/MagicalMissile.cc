@@ -65,8 +65,7 @@ bool MagicalMissile::showOnMap(float x, float y) {
              MAGICAL_MISSILE_MASK_BITS);
 
   defineTexture(_skillProfile.textureResDir, x, y);
-  GameMapManager::getInstance()->getLayer()->addChild(_bodySpritesheet,
-                                                      graphical_layers::kSpell);
+  GameMapManager::getInstance()->getGraphicalLayer(graphical_layers::kSpell)->addChild(_bodySpritesheet);
   return true;
 }
 
@@ -230,7 +229,7 @@ void MagicalMissile::defineBody(b2BodyType bodyType,
 }
 
 void MagicalMissile::defineTexture(const string& textureResDir, float x, float y) {
-  _bodySpritesheet = SpriteBatchNode::create(textureResDir + "/spritesheet.png");
+  _bodySpritesheet = SpriteBatchNode::create(asset_manager::getSpritesheetTexture(textureResDir));
 
   _bodyAnimations[AnimationType::LAUNCH_FX] = createAnimation(textureResDir, "launch", 5.0f / kPpm);
   _bodyAnimations[AnimationType::FLYING] = createAnimation(textureResDir, "flying", 1.0f / kPpm);
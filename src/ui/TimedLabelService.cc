@@ -1,9 +1,13 @@
 // Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
 #include "TimedLabelService.h"
 
+#include <algorithm>
+
 #include "AssetManager.h"
 
+using std::pair;
 using std::string;
+using std::vector;
 using cocos2d::Layer;
 using cocos2d::Label;
 using cocos2d::MoveBy;
@@ -25,6 +29,9 @@ TimedLabelService::TimedLabelService(int startingX, int startingY,
                                      uint8_t maxLabelCount, uint8_t labelLifetime,
                                      TimedLabelService::TimedLabel::Alignment alignment)
     : _layer(Layer::create()),
+      _labelQueue(),
+      _batchDepth(),
+      _pendingMessages(),
       _kStartingX(startingX),
       _kStartingY(startingY),
       _kMaxLabelCount(maxLabelCount),
@@ -52,6 +59,17 @@ void TimedLabelService::update(float delta) {
 }
 
 void TimedLabelService::show(const string& message) {
+  if (_batchDepth > 0) {
+    auto it = std::find_if(_pendingMessages.begin(), _pendingMessages.end(),
+                           [&message](const pair<string, int>& m) { return m.first == message; });
+    if (it != _pendingMessages.end()) {
+      it->second++;
+    } else {
+      _pendingMessages.push_back({message, 1});
+    }
+    return;
+  }
+
   // If the number of notifications being displayed has surpassed _kMaxLabelCount,
   // then remove the earliest notification.
   if ((int) _labelQueue.size() > _kMaxLabelCount) {
@@ -81,6 +99,32 @@ Layer* TimedLabelService::getLayer() const {
   return _layer;
 }
 
+void TimedLabelService::beginBatch() {
+  _batchDepth++;
+}
+
+void TimedLabelService::endBatch(bool discard) {
+  if (_batchDepth == 0 || --_batchDepth > 0) {
+    return;
+  }
+
+  vector<pair<string, int>> messages;
+  messages.swap(_pendingMessages);
+  if (discard) {
+    return;
+  }
+
+  // At most _kMaxLabelCount + 1 labels can be displayed at a time, so
+  // there's no point in creating labels for the earlier messages.
+  const size_t maxMessageCount = _kMaxLabelCount + 1;
+  const size_t begin = (messages.size() > maxMessageCount) ? messages.size() - maxMessageCount : 0;
+
+  for (size_t i = begin; i < messages.size(); i++) {
+    show((messages[i].second > 1) ?
+        messages[i].first + " (x" + std::to_string(messages[i].second) + ")" : messages[i].first);
+  }
+}
+
 
 const TimedLabelService::TimedLabel::Alignment TimedLabelService::TimedLabel::kLeft = {0, 1};
 const TimedLabelService::TimedLabel::Alignment TimedLabelService::TimedLabel::kCenter = {0.5, 1};
@@ -3,6 +3,8 @@
 #define VIGILANTE_TIMED_LABEL_SERVICE_H_
 
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <cocos2d.h>
 #include <2d/CCLabel.h>
@@ -32,6 +34,12 @@ class TimedLabelService {
   void show(const std::string& message);
   cocos2d::Layer* getLayer() const;
 
+  // Between beginBatch() and the matching endBatch(), show() only queues
+  // the messages, merging identical ones. The outermost endBatch() shows
+  // them all at once, or drops them if `discard` is true.
+  void beginBatch();
+  void endBatch(bool discard=false);
+
  protected:
   TimedLabelService(int startingX, int startingY,
                     uint8_t maxLabelCount, uint8_t labelLifetime,
@@ -45,6 +53,9 @@ class TimedLabelService {
   cocos2d::Layer* _layer;
   std::deque<TimedLabelService::TimedLabel> _labelQueue;
 
+  int _batchDepth;
+  std::vector<std::pair<std::string, int>> _pendingMessages;  // <message, count>
+
   const float _kStartingX;
   const float _kStartingY;
   const uint8_t _kMaxLabelCount;
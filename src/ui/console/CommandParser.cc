@@ -2,73 +2,287 @@
 #include "CommandParser.h"
 
 #include <memory>
+#include <unordered_map>
 
+#include "TextureResidencyManager.h"
 #include "character/Player.h"
 #include "character/Npc.h"
 #include "gameplay/DialogueTree.h"
+#include "input/InputRecorder.h"
 #include "item/Item.h"
 #include "map/GameMapManager.h"
 #include "ui/dialogue/DialogueManager.h"
 #include "ui/notifications/Notifications.h"
+#include "ui/quest_hints/QuestHints.h"
+#include "ui/physics_overlay/PhysicsOverlay.h"
+#include "ui/profiler_overlay/ProfilerOverlay.h"
 #include "util/StringUtil.h"
 #include "util/Logger.h"
+#include "util/Profiler.h"
 
 #define DEFAULT_ERR_MSG "unable to parse this line"
+#define BYTES_PER_MB (1024 * 1024)
 
 using std::string;
 using std::vector;
 using std::unique_ptr;
 using std::shared_ptr;
+using std::unordered_set;
 using std::out_of_range;
 using std::invalid_argument;
 
-using CmdTable = std::unordered_map<std::string,
-      void (vigilante::CommandParser::*)(const std::vector<std::string>&)>;
-
 namespace vigilante {
 
-CommandParser::CommandParser() : _success(), _errMsg() {}
+namespace {
+
+// Indexed by logger::Severity.
+const char* const kLogSeverityNames[logger::Severity::SIZE] = {"error", "warning", "info"};
+
+// The syntax of a command, checked by CommandParser::compile().
+struct CmdSpec final {
+  CommandParser::Opcode opcode;
+  size_t minArgc;  // including the command name itself
+  bool hasAmount;  // whether args[2] is an optional amount
+  const char* usage;
+};
+
+using CmdTable = std::unordered_map<std::string, CmdSpec>;
+
+bool parseAmount(const string& s, int* amount, string* errMsg) {
+  try {
+    *amount = std::stoi(s);
+  } catch (const invalid_argument& ex) {
+    *errMsg = "invalid argument `amount`";
+    return false;
+  } catch (const out_of_range& ex) {
+    *errMsg = "`amount` is too large";
+    return false;
+  } catch (...) {
+    *errMsg = "unknown error";
+    return false;
+  }
 
-void CommandParser::parse(const string& cmd, bool showNotification) {
-  vector<string> args;
-  if (cmd.empty() || (args = string_util::split(cmd)).empty()) {
-    return;
+  if (*amount <= 0) {
+    *errMsg = "`amount` has to be at least 1";
+    return false;
   }
+  return true;
+}
 
-  _success = false;
-  _errMsg = DEFAULT_ERR_MSG;
+}  // namespace
+
+
+CommandParser::Instruction::Instruction()
+    : opcode(CommandParser::Opcode::INVALID), cmd(), args(), amount(1) {}
+
+CommandParser::CommandParser()
+    : _success(),
+      _errMsg(),
+      _batchDepth(),
+      _changedItemNames() {}
 
-  // Command handler table.
+CommandParser::Instruction CommandParser::compile(const string& cmd, string* errMsg) {
+  // Command syntax table.
   static const CmdTable cmdTable = {
-    {"startQuest",              &CommandParser::startQuest             },
-    {"addItem",                 &CommandParser::addItem                },
-    {"removeItem",              &CommandParser::removeItem             },
-    {"updateDialogueTree",      &CommandParser::updateDialogueTree     },
-    {"joinPlayerParty",         &CommandParser::joinPlayerParty        },
-    {"leavePlayerParty",        &CommandParser::leavePlayerParty       },
-    {"playerPartyMemberWait",   &CommandParser::playerPartyMemberWait  },
-    {"playerPartyMemberFollow", &CommandParser::playerPartyMemberFollow},
-    {"tradeWithPlayer",         &CommandParser::tradeWithPlayer        },
-    {"killCurrentTarget",       &CommandParser::killCurrentTarget      },
+    {"startQuest",              {START_QUEST,                2, false, "usage: startQuest <quest>"}},
+    {"addItem",                 {ADD_ITEM,                   2, true,  "usage: addItem <itemName> [amount]"}},
+    {"removeItem",              {REMOVE_ITEM,                2, true,  "usage: removeItem <itemName> [amount]"}},
+    {"updateDialogueTree",      {UPDATE_DIALOGUE_TREE,       3, false, "usage: updateDialogueTree <npcJson> <dialogueTreeJson>"}},
+    {"joinPlayerParty",         {JOIN_PLAYER_PARTY,          1, false, ""}},
+    {"leavePlayerParty",        {LEAVE_PLAYER_PARTY,         1, false, ""}},
+    {"playerPartyMemberWait",   {PLAYER_PARTY_MEMBER_WAIT,   1, false, ""}},
+    {"playerPartyMemberFollow", {PLAYER_PARTY_MEMBER_FOLLOW, 1, false, ""}},
+    {"tradeWithPlayer",         {TRADE_WITH_PLAYER,          1, false, ""}},
+    {"killCurrentTarget",       {KILL_CURRENT_TARGET,        1, false, ""}},
+    {"toggleProfilerOverlay",   {TOGGLE_PROFILER_OVERLAY,    1, false, ""}},
+    {"toggleParallelNpcAi",     {TOGGLE_PARALLEL_NPC_AI,     1, false, ""}},
+    {"dumpProfilerTrace",       {DUMP_PROFILER_TRACE,        2, false, "usage: dumpProfilerTrace <file>"}},
+    {"stopInputRecording",      {STOP_INPUT_RECORDING,       1, false, ""}},
+    {"textureReport",           {TEXTURE_REPORT,             1, false, ""}},
+    {"setTextureBudget",        {SET_TEXTURE_BUDGET,         2, false, "usage: setTextureBudget <MB>"}},
+    {"toggleSpriteAnimator",    {TOGGLE_SPRITE_ANIMATOR,     1, false, ""}},
+    {"togglePhysicsOverlay",    {TOGGLE_PHYSICS_OVERLAY,     1, false, ""}},
+    {"togglePhysicsPipeline",   {TOGGLE_PHYSICS_PIPELINE,    1, false, ""}},
+    {"setPhysicsProfile",       {SET_PHYSICS_PROFILE,        2, false, "usage: setPhysicsProfile <performance|balanced|quality>"}},
+    {"setLogSeverity",          {SET_LOG_SEVERITY,           2, false, "usage: setLogSeverity <error|warning|info>"}},
+    {"toggleComposite",         {TOGGLE_COMPOSITE,           1, false, ""}},
   };
- 
-  // Execute the corresponding command handler from _cmdTable.
-  // The obtained value from _cmdTable is a class member function pointer.
-  CmdTable::const_iterator it = cmdTable.find(args[0]);
+
+  CommandParser::Instruction instruction;
+  instruction.cmd = cmd;
+  instruction.args = string_util::split(cmd);
+  if (instruction.args.empty()) {
+    return instruction;
+  }
+
+  string err = DEFAULT_ERR_MSG;
+  CmdTable::const_iterator it = cmdTable.find(instruction.args[0]);
+
   if (it != cmdTable.end()) {
-    (this->*((*it).second))(args);
+    const CmdSpec& spec = it->second;
+
+    if (instruction.args.size() < spec.minArgc) {
+      err = spec.usage;
+    } else if (!spec.hasAmount || instruction.args.size() < 3 ||
+               parseAmount(instruction.args[2], &instruction.amount, &err)) {
+      instruction.opcode = spec.opcode;
+      return instruction;
+    }
+  }
+
+  if (errMsg) {
+    *errMsg = instruction.args[0] + ": " + err;
+  }
+  return instruction;
+}
+
+vector<CommandParser::Instruction> CommandParser::compileAll(const vector<string>& cmds,
+                                                             const string& source) {
+  vector<CommandParser::Instruction> instructions;
+  instructions.reserve(cmds.size());
+
+  for (const auto& cmd : cmds) {
+    string errMsg;
+    CommandParser::Instruction instruction = CommandParser::compile(cmd, &errMsg);
+
+    if (instruction.opcode != CommandParser::Opcode::INVALID) {
+      instructions.push_back(std::move(instruction));
+    } else if (!errMsg.empty()) {
+      VGLOG(LOG_ERR, "%s: %s", source.c_str(), errMsg.c_str());
+    }
+  }
+  return instructions;
+}
+
+void CommandParser::execute(const CommandParser::Instruction& instruction, bool showNotification) {
+  using Handler = void (CommandParser::*)(const CommandParser::Instruction&);
+
+  // Command handler table, indexed by CommandParser::Opcode.
+  static const Handler handlers[CommandParser::Opcode::SIZE] = {
+    nullptr,
+    &CommandParser::startQuest,
+    &CommandParser::addItem,
+    &CommandParser::removeItem,
+    &CommandParser::updateDialogueTree,
+    &CommandParser::joinPlayerParty,
+    &CommandParser::leavePlayerParty,
+    &CommandParser::playerPartyMemberWait,
+    &CommandParser::playerPartyMemberFollow,
+    &CommandParser::tradeWithPlayer,
+    &CommandParser::killCurrentTarget,
+    &CommandParser::toggleProfilerOverlay,
+    &CommandParser::toggleParallelNpcAi,
+    &CommandParser::dumpProfilerTrace,
+    &CommandParser::stopInputRecording,
+    &CommandParser::textureReport,
+    &CommandParser::setTextureBudget,
+    &CommandParser::toggleSpriteAnimator,
+    &CommandParser::togglePhysicsOverlay,
+    &CommandParser::togglePhysicsPipeline,
+    &CommandParser::setPhysicsProfile,
+    &CommandParser::setLogSeverity,
+    &CommandParser::toggleComposite,
+  };
+
+  _success = false;
+  _errMsg = DEFAULT_ERR_MSG;
+
+  if (instruction.opcode == CommandParser::Opcode::INVALID) {
+    return;
   }
 
+  (this->*handlers[instruction.opcode])(instruction);
+
   if (!_success) {
-    _errMsg = args[0] + ": " + _errMsg;
+    _errMsg = instruction.args[0] + ": " + _errMsg;
     VGLOG(LOG_ERR, "%s", _errMsg.c_str());
   }
 
   if (showNotification) {
-    Notifications::getInstance()->show((_success) ? cmd : _errMsg);
+    Notifications::getInstance()->show((_success) ? instruction.cmd : _errMsg);
+  }
+
+  if (_batchDepth == 0) {
+    flushQuestUpdates();
   }
 }
 
+void CommandParser::parse(const string& cmd, bool showNotification) {
+  string errMsg;
+  CommandParser::Instruction instruction = CommandParser::compile(cmd, &errMsg);
+
+  if (instruction.opcode != CommandParser::Opcode::INVALID) {
+    execute(instruction, showNotification);
+    return;
+  }
+
+  if (errMsg.empty()) {  // blank line
+    return;
+  }
+
+  VGLOG(LOG_ERR, "%s", errMsg.c_str());
+  if (showNotification) {
+    Notifications::getInstance()->show(errMsg);
+  }
+}
+
+bool CommandParser::executeBatch(const CommandParser::Instruction* begin,
+                                 const CommandParser::Instruction* end,
+                                 bool rollbackOnFailure) {
+  if (rollbackOnFailure && !isReversible(begin, end)) {
+    VGLOG(LOG_ERR, "%s: cannot be rolled back, batch not executed", begin->cmd.c_str());
+    return false;
+  }
+
+  Notifications::getInstance()->beginBatch();
+  QuestHints::getInstance()->beginBatch();
+  _batchDepth++;
+
+  bool success = true;
+  string errMsg;
+  vector<CommandParser::Instruction> inverses;
+
+  for (auto it = begin; it != end; it++) {
+    CommandParser::Instruction inverse;
+    if (rollbackOnFailure) {
+      inverse = getInverse(*it);
+    }
+
+    VGLOG(LOG_INFO, "Executing: %s", it->cmd.c_str());
+    execute(*it, /*showNotification=*/false);
+
+    if (!_success) {
+      success = false;
+      if (rollbackOnFailure) {
+        errMsg = _errMsg;
+        break;
+      }
+    } else if (inverse.opcode != CommandParser::Opcode::INVALID) {
+      inverses.push_back(std::move(inverse));
+    }
+  }
+
+  const bool shouldRollback = !success && rollbackOnFailure;
+  if (shouldRollback) {
+    for (auto it = inverses.rbegin(); it != inverses.rend(); it++) {
+      VGLOG(LOG_INFO, "Rolling back: %s", it->cmd.c_str());
+      execute(*it, /*showNotification=*/false);
+    }
+    _changedItemNames.clear();
+  }
+
+  _batchDepth--;
+  if (_batchDepth == 0) {
+    flushQuestUpdates();
+  }
+  QuestHints::getInstance()->endBatch(/*discard=*/shouldRollback);
+  Notifications::getInstance()->endBatch(/*discard=*/shouldRollback);
+  if (shouldRollback) {
+    Notifications::getInstance()->show(errMsg);
+  }
+  return success;
+}
+
 void CommandParser::setSuccess() {
   _success = true;
 }
@@ -78,98 +292,183 @@ void CommandParser::setError(const string& errMsg) {
   _errMsg = errMsg;
 }
 
+CommandParser::Instruction CommandParser::getInverse(const CommandParser::Instruction& instruction) const {
+  CommandParser::Instruction inverse;
+  inverse.amount = instruction.amount;
+
+  switch (instruction.opcode) {
+    case CommandParser::Opcode::ADD_ITEM:
+      inverse.opcode = CommandParser::Opcode::REMOVE_ITEM;
+      inverse.args = {"removeItem", instruction.args[1], std::to_string(instruction.amount)};
+      break;
+    case CommandParser::Opcode::REMOVE_ITEM:
+      inverse.opcode = CommandParser::Opcode::ADD_ITEM;
+      inverse.args = {"addItem", instruction.args[1], std::to_string(instruction.amount)};
+      break;
+    case CommandParser::Opcode::UPDATE_DIALOGUE_TREE: {
+      // Without a dialogue tree, the inverse clears the update (see updateDialogueTree()).
+      inverse.opcode = CommandParser::Opcode::UPDATE_DIALOGUE_TREE;
+      inverse.args = {"updateDialogueTree", instruction.args[1]};
+      const string latestDialogueTree = DialogueTree::getLatestNpcDialogueTree(instruction.args[1]);
+      if (!latestDialogueTree.empty()) {
+        inverse.args.push_back(latestDialogueTree);
+      }
+      break;
+    }
+    case CommandParser::Opcode::JOIN_PLAYER_PARTY:
+      inverse.opcode = CommandParser::Opcode::LEAVE_PLAYER_PARTY;
+      inverse.args = {"leavePlayerParty"};
+      break;
+    case CommandParser::Opcode::LEAVE_PLAYER_PARTY:
+      inverse.opcode = CommandParser::Opcode::JOIN_PLAYER_PARTY;
+      inverse.args = {"joinPlayerParty"};
+      break;
+    case CommandParser::Opcode::PLAYER_PARTY_MEMBER_WAIT:
+      inverse.opcode = CommandParser::Opcode::PLAYER_PARTY_MEMBER_FOLLOW;
+      inverse.args = {"playerPartyMemberFollow"};
+      break;
+    case CommandParser::Opcode::PLAYER_PARTY_MEMBER_FOLLOW:
+      inverse.opcode = CommandParser::Opcode::PLAYER_PARTY_MEMBER_WAIT;
+      inverse.args = {"playerPartyMemberWait"};
+      break;
+    case CommandParser::Opcode::TOGGLE_PROFILER_OVERLAY:
+      inverse.opcode = CommandParser::Opcode::TOGGLE_PROFILER_OVERLAY;
+      inverse.args = {"toggleProfilerOverlay"};
+      break;
+    case CommandParser::Opcode::TOGGLE_PARALLEL_NPC_AI:
+      inverse.opcode = CommandParser::Opcode::TOGGLE_PARALLEL_NPC_AI;
+      inverse.args = {"toggleParallelNpcAi"};
+      break;
+    case CommandParser::Opcode::TOGGLE_SPRITE_ANIMATOR:
+      inverse.opcode = CommandParser::Opcode::TOGGLE_SPRITE_ANIMATOR;
+      inverse.args = {"toggleSpriteAnimator"};
+      break;
+    case CommandParser::Opcode::TOGGLE_PHYSICS_OVERLAY:
+      inverse.opcode = CommandParser::Opcode::TOGGLE_PHYSICS_OVERLAY;
+      inverse.args = {"togglePhysicsOverlay"};
+      break;
+    case CommandParser::Opcode::TOGGLE_PHYSICS_PIPELINE:
+      inverse.opcode = CommandParser::Opcode::TOGGLE_PHYSICS_PIPELINE;
+      inverse.args = {"togglePhysicsPipeline"};
+      break;
+    case CommandParser::Opcode::TOGGLE_COMPOSITE:
+      inverse.opcode = CommandParser::Opcode::TOGGLE_COMPOSITE;
+      inverse.args = {"toggleComposite"};
+      break;
+    case CommandParser::Opcode::SET_PHYSICS_PROFILE:
+      inverse.opcode = CommandParser::Opcode::SET_PHYSICS_PROFILE;
+      inverse.args = {"setPhysicsProfile",
+                      GameMapManager::getInstance()->getPhysicsProfile().name};
+      break;
+    case CommandParser::Opcode::SET_LOG_SEVERITY:
+      inverse.opcode = CommandParser::Opcode::SET_LOG_SEVERITY;
+      inverse.args = {"setLogSeverity", kLogSeverityNames[logger::getSeverity()]};
+      break;
+    case CommandParser::Opcode::SET_TEXTURE_BUDGET:
+      inverse.opcode = CommandParser::Opcode::SET_TEXTURE_BUDGET;
+      inverse.args = {"setTextureBudget",
+                      std::to_string(TextureResidencyManager::getInstance()->getBudget() / BYTES_PER_MB)};
+      break;
+    default:  // nothing to undo
+      return inverse;
+  }
 
-void CommandParser::startQuest(const vector<string>& args) {
-  if (args.size() < 2) {
-    setError("usage: startQuest <quest>");
-    return;
+  for (const auto& arg : inverse.args) {
+    inverse.cmd += (inverse.cmd.empty()) ? arg : " " + arg;
   }
+  return inverse;
+}
 
-  GameMapManager::getInstance()->getPlayer()->getQuestBook().startQuest(args[1]);
-  setSuccess();
+bool CommandParser::isReversible(const CommandParser::Instruction* begin,
+                                 const CommandParser::Instruction* end) {
+  for (auto it = begin; it != end; it++) {
+    if (!isReversible(it->opcode)) {
+      return false;
+    }
+  }
+  return true;
 }
 
+bool CommandParser::isReversible(CommandParser::Opcode opcode) {
+  switch (opcode) {
+    case CommandParser::Opcode::START_QUEST:
+    case CommandParser::Opcode::TRADE_WITH_PLAYER:
+    case CommandParser::Opcode::KILL_CURRENT_TARGET:
+    case CommandParser::Opcode::STOP_INPUT_RECORDING:
+      return false;
+    default:
+      return true;
+  }
+}
 
-void CommandParser::addItem(const vector<string>& args) {
-  if (args.size() < 2) {
-    setError("usage: addItem <itemName> [amount]");
+void CommandParser::flushQuestUpdates() {
+  if (_changedItemNames.empty()) {
     return;
   }
 
-  int amount = 1;
-  if (args.size() >= 3) {
-    try {
-      amount = std::stoi(args[2]);
-    } catch (const invalid_argument& ex) {
-      setError("invalid argument `amount`");
-      return;
-    } catch (const out_of_range& ex) {
-      setError("`amount` is too large");
-      return;
-    } catch (...) {
-      setError("unknown error");
-      return;
-    }
-  }
+  // Quest stages may execute commands which add or remove items as well.
+  unordered_set<string> itemNames;
+  itemNames.swap(_changedItemNames);
 
-  if (amount <= 0) {
-    setError("`amount` has to be at least 1");
-    return;
+  Player* player = GameMapManager::getInstance()->getPlayer();
+  for (const auto& itemName : itemNames) {
+    player->getQuestBook().update(Quest::Objective::Type::COLLECT, itemName);
   }
+}
+
 
-  unique_ptr<Item> item = Item::create(args[1]);
-  GameMapManager::getInstance()->getPlayer()->addItem(std::move(item), amount);
+void CommandParser::startQuest(const CommandParser::Instruction& instruction) {
+  GameMapManager::getInstance()->getPlayer()->getQuestBook().startQuest(instruction.args[1]);
   setSuccess();
 }
 
 
-void CommandParser::removeItem(const vector<string>& args) {
-  if (args.size() < 2) {
-    setError("usage: removeItem <itemName> [amount]");
+void CommandParser::addItem(const CommandParser::Instruction& instruction) {
+  unique_ptr<Item> item = Item::create(instruction.args[1]);
+  if (!item) {
+    setError("unknown item: " + instruction.args[1]);
     return;
   }
 
-  int amount = 1;
-  if (args.size() >= 3) {
-    try {
-      amount = std::stoi(args[2]);
-    } catch (const invalid_argument& ex) {
-      setError("invalid argument `amount`");
-      return;
-    } catch (const out_of_range& ex) {
-      setError("`amount` is too large");
-      return;
-    } catch (...) {
-      setError("unknown error");
-      return;
-    }
+  _changedItemNames.insert(item->getItemProfile().name);
+  GameMapManager::getInstance()->getPlayer()->addItem(std::move(item), instruction.amount);
+  setSuccess();
+}
+
+
+void CommandParser::removeItem(const CommandParser::Instruction& instruction) {
+  unique_ptr<Item> item = Item::create(instruction.args[1]);
+  if (!item) {
+    setError("unknown item: " + instruction.args[1]);
+    return;
   }
 
-  if (amount <= 0) {
-    setError("`amount` has to be at least 1");
+  Player* player = GameMapManager::getInstance()->getPlayer();
+  if (player->getItemAmount(item->getItemProfile().name) < instruction.amount) {
+    setError("the player doesn't have enough of this item");
     return;
   }
 
-  unique_ptr<Item> item = Item::create(args[1]);
-  GameMapManager::getInstance()->getPlayer()->removeItem(item.get(), amount);
+  _changedItemNames.insert(item->getItemProfile().name);
+  player->removeItem(item.get(), instruction.amount);
   setSuccess();
 }
 
 
-void CommandParser::updateDialogueTree(const vector<string>& args) {
-  if (args.size() < 3) {
-    setError("usage: updateDialogueTree <npcJson> <dialogueTreeJson>");
-    return;
-  }
-
+void CommandParser::updateDialogueTree(const CommandParser::Instruction& instruction) {
   // TODO: Maybe add some argument check here?
  
-  DialogueTree::setLatestNpcDialogueTree(args[1], args[2]);
+  // compile() requires the dialogue tree, so only the inverses built by getInverse() omit it.
+  if (instruction.args.size() < 3) {
+    DialogueTree::clearLatestNpcDialogueTree(instruction.args[1]);
+  } else {
+    DialogueTree::setLatestNpcDialogueTree(instruction.args[1], instruction.args[2]);
+  }
   setSuccess();
 }
 
 
-void CommandParser::joinPlayerParty(const vector<string>&) {
+void CommandParser::joinPlayerParty(const CommandParser::Instruction&) {
   Player* player = GameMapManager::getInstance()->getPlayer();
   Npc* targetNpc = DialogueManager::getInstance()->getTargetNpc();
   assert(player != nullptr && targetNpc != nullptr);
@@ -184,7 +483,7 @@ void CommandParser::joinPlayerParty(const vector<string>&) {
 }
 
 
-void CommandParser::leavePlayerParty(const vector<string>&) {
+void CommandParser::leavePlayerParty(const CommandParser::Instruction&) {
   Player* player = GameMapManager::getInstance()->getPlayer();
   Npc* targetNpc = DialogueManager::getInstance()->getTargetNpc();
   assert(player != nullptr && targetNpc != nullptr);
@@ -199,7 +498,7 @@ void CommandParser::leavePlayerParty(const vector<string>&) {
 }
 
 
-void CommandParser::playerPartyMemberWait(const vector<string>&) {
+void CommandParser::playerPartyMemberWait(const CommandParser::Instruction&) {
   Player* player = GameMapManager::getInstance()->getPlayer();
   Npc* targetNpc = DialogueManager::getInstance()->getTargetNpc();
   assert(player != nullptr && targetNpc != nullptr);
@@ -219,7 +518,7 @@ void CommandParser::playerPartyMemberWait(const vector<string>&) {
 }
 
 
-void CommandParser::playerPartyMemberFollow(const vector<string>&) {
+void CommandParser::playerPartyMemberFollow(const CommandParser::Instruction&) {
   Player* player = GameMapManager::getInstance()->getPlayer();
   Npc* targetNpc = DialogueManager::getInstance()->getTargetNpc();
   assert(player != nullptr && targetNpc != nullptr);
@@ -239,7 +538,7 @@ void CommandParser::playerPartyMemberFollow(const vector<string>&) {
 }
 
 
-void CommandParser::tradeWithPlayer(const vector<string>&) {
+void CommandParser::tradeWithPlayer(const CommandParser::Instruction&) {
   Player* player = GameMapManager::getInstance()->getPlayer();
   Npc* targetNpc = DialogueManager::getInstance()->getTargetNpc();
   assert(player != nullptr && targetNpc != nullptr);
@@ -254,7 +553,7 @@ void CommandParser::tradeWithPlayer(const vector<string>&) {
 }
 
 
-void CommandParser::killCurrentTarget(const vector<string>&) {
+void CommandParser::killCurrentTarget(const CommandParser::Instruction&) {
   Player* player = GameMapManager::getInstance()->getPlayer();
   Npc* targetNpc = DialogueManager::getInstance()->getTargetNpc();
   assert(player != nullptr && targetNpc != nullptr);
@@ -263,4 +562,116 @@ void CommandParser::killCurrentTarget(const vector<string>&) {
   setSuccess();
 }
 
+
+void CommandParser::toggleProfilerOverlay(const CommandParser::Instruction&) {
+  ProfilerOverlay* overlay = ProfilerOverlay::getInstance();
+  overlay->setVisible(!overlay->isVisible());
+  setSuccess();
+}
+
+void CommandParser::toggleParallelNpcAi(const CommandParser::Instruction&) {
+  GameMapManager* gmMgr = GameMapManager::getInstance();
+  gmMgr->setNpcAiParallel(!gmMgr->isNpcAiParallel());
+  setSuccess();
+}
+
+
+void CommandParser::dumpProfilerTrace(const CommandParser::Instruction& instruction) {
+  if (!profiler::isCompiledIn()) {
+    setError("the profiler is not compiled in");
+    return;
+  }
+
+  if (!profiler::dumpChromeTrace(instruction.args[1])) {
+    setError("unable to write to " + instruction.args[1]);
+    return;
+  }
+  setSuccess();
+}
+
+
+void CommandParser::stopInputRecording(const CommandParser::Instruction&) {
+  if (!InputRecorder::getInstance()->isRecording()) {
+    setError("input is not being recorded");
+    return;
+  }
+
+  if (!InputRecorder::getInstance()->stopRecording()) {
+    setError("unable to save the input recording");
+    return;
+  }
+  setSuccess();
+}
+
+
+
+void CommandParser::textureReport(const CommandParser::Instruction&) {
+  const string report = TextureResidencyManager::getInstance()->getReport();
+  for (const auto& line : string_util::split(report, '\n')) {
+    VGLOG(LOG_INFO, "%s", line.c_str());
+  }
+  setSuccess();
+}
+
+void CommandParser::setTextureBudget(const CommandParser::Instruction& instruction) {
+  int budgetMb = 0;
+  try {
+    budgetMb = std::stoi(instruction.args[1]);
+  } catch (const std::exception& ex) {
+    setError("invalid argument `MB`");
+    return;
+  }
+
+  if (budgetMb < 0) {
+    setError("`MB` cannot be negative");
+    return;
+  }
+
+  TextureResidencyManager::getInstance()->setBudget(static_cast<size_t>(budgetMb) * BYTES_PER_MB);
+  setSuccess();
+}
+
+void CommandParser::toggleSpriteAnimator(const CommandParser::Instruction&) {
+  GameMapManager* gmMgr = GameMapManager::getInstance();
+  gmMgr->setSpriteAnimatorEnabled(!gmMgr->isSpriteAnimatorEnabled());
+  setSuccess();
+}
+
+void CommandParser::togglePhysicsOverlay(const CommandParser::Instruction&) {
+  PhysicsOverlay* overlay = PhysicsOverlay::getInstance();
+  overlay->setVisible(!overlay->isVisible());
+  setSuccess();
+}
+
+void CommandParser::togglePhysicsPipeline(const CommandParser::Instruction&) {
+  GameMapManager* gmMgr = GameMapManager::getInstance();
+  gmMgr->setPhysicsPipelined(!gmMgr->isPhysicsPipelined());
+  setSuccess();
+}
+
+void CommandParser::setPhysicsProfile(const CommandParser::Instruction& instruction) {
+  if (!GameMapManager::getInstance()->setPhysicsProfile(instruction.args[1])) {
+    setError("unknown physics profile: " + instruction.args[1]);
+    return;
+  }
+  setSuccess();
+}
+
+void CommandParser::setLogSeverity(const CommandParser::Instruction& instruction) {
+  for (int i = 0; i < logger::Severity::SIZE; i++) {
+    if (instruction.args[1] == kLogSeverityNames[i]) {
+      logger::setSeverity(static_cast<logger::Severity>(i));
+      setSuccess();
+      return;
+    }
+  }
+  setError("unknown severity: " + instruction.args[1]);
+}
+
+void CommandParser::toggleComposite(const CommandParser::Instruction&) {
+  GameMapManager* gmMgr = GameMapManager::getInstance();
+  gmMgr->setCompositeEnabled(!gmMgr->isCompositeEnabled());
+  setSuccess();
+}
+
 }  // namespace vigilante
@@ -4,35 +4,123 @@
 
 #include <string>
 #include <vector>
-#include <unordered_map>
+#include <unordered_set>
 
 namespace vigilante {
 
 class CommandParser {
  public:
+  enum Opcode {
+    INVALID,
+    START_QUEST,
+    ADD_ITEM,
+    REMOVE_ITEM,
+    UPDATE_DIALOGUE_TREE,
+    JOIN_PLAYER_PARTY,
+    LEAVE_PLAYER_PARTY,
+    PLAYER_PARTY_MEMBER_WAIT,
+    PLAYER_PARTY_MEMBER_FOLLOW,
+    TRADE_WITH_PLAYER,
+    KILL_CURRENT_TARGET,
+    TOGGLE_PROFILER_OVERLAY,
+    TOGGLE_PARALLEL_NPC_AI,
+    DUMP_PROFILER_TRACE,
+    STOP_INPUT_RECORDING,
+    TEXTURE_REPORT,
+    SET_TEXTURE_BUDGET,
+    TOGGLE_SPRITE_ANIMATOR,
+    TOGGLE_PHYSICS_OVERLAY,
+    TOGGLE_PHYSICS_PIPELINE,
+    SET_PHYSICS_PROFILE,
+    SET_LOG_SEVERITY,
+    TOGGLE_COMPOSITE,
+    SIZE
+  };
+
+  // A command which has been parsed and checked in advance,
+  // so executing it involves no string processing at all.
+  struct Instruction final {
+    Instruction();
+
+    CommandParser::Opcode opcode;
+    std::string cmd;  // the source command, used in logs and notifications.
+    std::vector<std::string> args;  // args[0] is the command name.
+    int amount;  // addItem, removeItem
+  };
+
   CommandParser();
   virtual ~CommandParser() = default;
 
+  // Parses `cmd` into an Instruction. If `cmd` is invalid, the opcode
+  // of the returned Instruction is INVALID, and `errMsg` is set to the
+  // reason (unless `cmd` is blank). Safe to call from any thread.
+  static CommandParser::Instruction compile(const std::string& cmd, std::string* errMsg=nullptr);
+
+  // Compiles the commands of `source` (e.g., a tmx map or a quest json)
+  // and logs the invalid ones, which are left out of the result.
+  static std::vector<CommandParser::Instruction> compileAll(const std::vector<std::string>& cmds,
+                                                            const std::string& source);
+
+  void execute(const CommandParser::Instruction& instruction, bool showNotification);
   void parse(const std::string& cmd, bool showNotification);
 
+  // Executes [begin, end) as one unit. Notifications and quest hints are
+  // coalesced, and the affected quests are re-evaluated, once at the end.
+  // If `rollbackOnFailure` is true, the batch is all-or-nothing: it must
+  // only contain reversible commands, and if one of them fails, the ones
+  // executed before it are undone and their notifications are dropped
+  // in favor of the error of the one which failed.
+  // @return whether all of the commands succeeded.
+  bool executeBatch(const CommandParser::Instruction* begin,
+                    const CommandParser::Instruction* end,
+                    bool rollbackOnFailure);
+
+  // @return whether [begin, end) can be executed with `rollbackOnFailure`.
+  static bool isReversible(const CommandParser::Instruction* begin,
+                           const CommandParser::Instruction* end);
+
  private:
   void setSuccess();
   void setError(const std::string& errMsg);
 
+  // @return the instruction which undoes `instruction`. Its opcode is INVALID
+  //         if `instruction` has nothing to undo. Must be called right before
+  //         executing `instruction`, as some inverses depend on the current state.
+  CommandParser::Instruction getInverse(const CommandParser::Instruction& instruction) const;
+  static bool isReversible(CommandParser::Opcode opcode);
+
+  // Re-evaluates the quests waiting for the items added or removed.
+  void flushQuestUpdates();
+
   // Command handlers.
-  void startQuest(const std::vector<std::string>& args);
-  void addItem(const std::vector<std::string>& args);
-  void removeItem(const std::vector<std::string>& args);
-  void updateDialogueTree(const std::vector<std::string>& args);
-  void joinPlayerParty(const std::vector<std::string>& args);
-  void leavePlayerParty(const std::vector<std::string>& args);
-  void playerPartyMemberWait(const std::vector<std::string>& args);
-  void playerPartyMemberFollow(const std::vector<std::string>& args);
-  void tradeWithPlayer(const std::vector<std::string>& args);
-  void killCurrentTarget(const std::vector<std::string>& args);
+  void startQuest(const CommandParser::Instruction& instruction);
+  void addItem(const CommandParser::Instruction& instruction);
+  void removeItem(const CommandParser::Instruction& instruction);
+  void updateDialogueTree(const CommandParser::Instruction& instruction);
+  void joinPlayerParty(const CommandParser::Instruction& instruction);
+  void leavePlayerParty(const CommandParser::Instruction& instruction);
+  void playerPartyMemberWait(const CommandParser::Instruction& instruction);
+  void playerPartyMemberFollow(const CommandParser::Instruction& instruction);
+  void tradeWithPlayer(const CommandParser::Instruction& instruction);
+  void killCurrentTarget(const CommandParser::Instruction& instruction);
+  void toggleProfilerOverlay(const CommandParser::Instruction& instruction);
+  void toggleParallelNpcAi(const CommandParser::Instruction& instruction);
+  void dumpProfilerTrace(const CommandParser::Instruction& instruction);
+  void stopInputRecording(const CommandParser::Instruction& instruction);
+  void textureReport(const CommandParser::Instruction& instruction);
+  void setTextureBudget(const CommandParser::Instruction& instruction);
+  void toggleSpriteAnimator(const CommandParser::Instruction& instruction);
+  void togglePhysicsOverlay(const CommandParser::Instruction& instruction);
+  void togglePhysicsPipeline(const CommandParser::Instruction& instruction);
+  void setPhysicsProfile(const CommandParser::Instruction& instruction);
+  void setLogSeverity(const CommandParser::Instruction& instruction);
+  void toggleComposite(const CommandParser::Instruction& instruction);
 
   bool _success;
   std::string _errMsg;
+
+  int _batchDepth;
+  std::unordered_set<std::string> _changedItemNames;  // deferred until flushQuestUpdates()
 };
 
 }  // namespace vigilante
@@ -9,6 +9,7 @@
 #define DEFAULT_HISTORY_SIZE 32
 
 using std::string;
+using std::vector;
 using cocos2d::Layer;
 using cocos2d::Event;
 using cocos2d::EventKeyboard;
@@ -78,6 +79,23 @@ void Console::executeCmd(const string& cmd,
   }
 }
 
+void Console::executeCmd(const CommandParser::Instruction& instruction,
+                         bool showNotification) {
+  VGLOG(LOG_INFO, "Executing: %s", instruction.cmd.c_str());
+  _cmdParser.execute(instruction, showNotification);
+}
+
+bool Console::executeCmds(const vector<CommandParser::Instruction>& instructions,
+                          bool rollbackOnFailure) {
+  return executeCmds(instructions.data(), instructions.data() + instructions.size(), rollbackOnFailure);
+}
+
+bool Console::executeCmds(const CommandParser::Instruction* begin,
+                          const CommandParser::Instruction* end,
+                          bool rollbackOnFailure) {
+  return _cmdParser.executeBatch(begin, end, rollbackOnFailure);
+}
+
 
 bool Console::isVisible() const {
   return _layer->isVisible();
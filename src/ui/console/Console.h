@@ -4,6 +4,7 @@
 
 #include <deque>
 #include <string>
+#include <vector>
 
 #include <cocos2d.h>
 #include "ui/TextField.h"
@@ -21,6 +22,15 @@ class Console {
   virtual void executeCmd(const std::string& cmd,
                           bool showNotification=false,
                           bool saveInHistory=false);
+  virtual void executeCmd(const CommandParser::Instruction& instruction,
+                          bool showNotification=false);
+
+  // Executes the commands as a batch. See CommandParser::executeBatch().
+  virtual bool executeCmds(const std::vector<CommandParser::Instruction>& instructions,
+                           bool rollbackOnFailure=false);
+  virtual bool executeCmds(const CommandParser::Instruction* begin,
+                           const CommandParser::Instruction* end,
+                           bool rollbackOnFailure=false);
 
   bool isVisible() const;
   void setVisible(bool visible);
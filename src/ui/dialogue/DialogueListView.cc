@@ -39,9 +39,11 @@ void DialogueListView::confirm() {
   auto dialogueMenu = dialogueMgr->getDialogueMenu();
   auto subtitles = dialogueMgr->getSubtitles();
 
-  for (const auto& cmd : getSelectedObject()->getCmds()) {
-    Console::getInstance()->executeCmd(cmd);
-  }
+  // A choice takes effect as a whole (e.g., paying for an item and receiving it)
+  // or not at all, unless some of its commands (e.g., startQuest) cannot be undone.
+  const DialogueGraph::CmdRange cmds = getSelectedObject()->getCmds();
+  const bool isAtomic = CommandParser::isReversible(cmds.begin(), cmds.end());
+  Console::getInstance()->executeCmds(cmds.begin(), cmds.end(), /*rollbackOnFailure=*/isAtomic);
 
   if (getSelectedObject()->getChildren().empty()) {
     subtitles->endSubtitles();
@@ -55,7 +57,6 @@ void DialogueListView::confirm() {
     dialogueMgr->setCurrentDialogue(nextDialogue);
   }
 
-  dialogueMgr->getTargetNpc()->getDialogueTree().update();
   dialogueMenu->getLayer()->setVisible(false);
 }
 
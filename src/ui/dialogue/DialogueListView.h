@@ -12,7 +12,7 @@ class DialogueMenu;
 
 // using Dialogue = DialogueTree::Node
 // See gameplay/DialogueTree.h for this alias.
-using Dialogue = DialogueTree::Node;
+using Dialogue = const DialogueTree::Node;
 
 class DialogueListView : public ListView<Dialogue*> {
  public:
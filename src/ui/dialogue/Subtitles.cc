@@ -150,11 +150,10 @@ void Subtitles::showNextSubtitle() {
   DialogueListView* dialogueListView = dialogueMenu->getDialogueListView();
   Dialogue* currentDialogue = dialogueMgr->getCurrentDialogue();
 
-  for (const auto& cmd : currentDialogue->getCmds()) {
-    Console::getInstance()->executeCmd(cmd);
-  }
+  const DialogueGraph::CmdRange cmds = currentDialogue->getCmds();
+  Console::getInstance()->executeCmds(cmds.begin(), cmds.end());
 
-  vector<DialogueTree::Node*> children = currentDialogue->getChildren();
+  vector<Dialogue*> children = dialogueMgr->getTargetNpc()->getDialogueTree().getChildren(currentDialogue);
   if (children.empty()) {  // end of dialogue
     endSubtitles();
     dialogueMgr->getTargetNpc()->getDialogueTree().resetCurrentNode();
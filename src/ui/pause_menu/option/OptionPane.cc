@@ -4,9 +4,11 @@
 #include <vector>
 
 #include "std/make_unique.h"
+#include "gameplay/GameState.h"
 #include "input/InputManager.h"
 #include "scene/SceneManager.h"
 #include "scene/GameScene.h"
+#include "ui/notifications/Notifications.h"
 
 #define OPTIONS_COUNT 4
 
@@ -30,15 +32,33 @@ OptionPane::OptionPane(PauseMenu* pauseMenu)
   _layout->addChild(_optionListView->getLayout());
 
   auto quit = []() {
+    // Don't leave the last save half-written.
+    GameState::waitForPendingWrites();
     InputManager::getInstance()->deactivate();
     SceneManager::getInstance()->popScene();
     InputManager::getInstance()->activate(SceneManager::getInstance()->getCurrentScene());
   };
 
+  auto saveGame = []() {
+    GameState().save();
+    Notifications::getInstance()->show("Game saved.");
+  };
+
+  auto loadGame = [pauseMenu]() {
+    if (!GameState::exists(GameState::getDefaultFilePath())) {
+      Notifications::getInstance()->show("No saved game.");
+      return;
+    }
+    pauseMenu->setVisible(false);
+    if (!GameState().load()) {
+      Notifications::getInstance()->show("Unable to load the saved game.");
+    }
+  };
+
   // Define available Options.
   _options = {{
-    {"Save Game", []() {}},
-    {"Load Game", []() {}},
+    {"Save Game", saveGame},
+    {"Load Game", loadGame},
     {"Options",   []() {}},
     {"Quit",      quit   },
   }};
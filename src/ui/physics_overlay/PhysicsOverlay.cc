@@ -0,0 +1,105 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "PhysicsOverlay.h"
+
+#include <algorithm>
+#include <string>
+
+#include "AssetManager.h"
+#include "map/GameMapManager.h"
+#include "util/StringUtil.h"
+
+#define OVERLAY_X cocos2d::Director::getInstance()->getWinSize().width - 10
+#define OVERLAY_Y cocos2d::Director::getInstance()->getWinSize().height - 70
+
+using std::string;
+using cocos2d::Layer;
+using cocos2d::Label;
+using vigilante::asset_manager::kRegularFont;
+using vigilante::asset_manager::kRegularFontSize;
+
+namespace vigilante {
+
+const float PhysicsOverlay::_kRefreshInterval = .25f;
+
+PhysicsOverlay* PhysicsOverlay::getInstance() {
+  static PhysicsOverlay instance;
+  return &instance;
+}
+
+PhysicsOverlay::PhysicsOverlay()
+    : _layer(Layer::create()),
+      _label(Label::createWithTTF("", kRegularFont, kRegularFontSize)),
+      _timer(),
+      _maxStepMs() {
+  _label->getFontAtlas()->setAliasTexParameters();
+  _label->setAnchorPoint({1, 1});
+  _label->setAlignment(cocos2d::TextHAlignment::RIGHT);
+
+  _layer->setVisible(false);
+  _layer->setPosition(OVERLAY_X, OVERLAY_Y);
+  _layer->addChild(_label);
+}
+
+
+void PhysicsOverlay::update(float delta) {
+  if (!_layer->isVisible()) {
+    return;
+  }
+
+  const b2World* world = GameMapManager::getInstance()->getWorld();
+  _maxStepMs = std::max(_maxStepMs, world->GetProfile().step);
+
+  _timer += delta;
+  if (_timer >= _kRefreshInterval) {
+    _timer = 0;
+    refresh();
+  }
+}
+
+void PhysicsOverlay::refresh() {
+  const GameMapManager* gmMgr = GameMapManager::getInstance();
+  const b2World* world = gmMgr->getWorld();
+
+  // b2World doesn't keep count of the fixtures,
+  // but this only runs a few times per second.
+  int fixtureCount = 0;
+  for (const b2Body* b = world->GetBodyList(); b; b = b->GetNext()) {
+    for (const b2Fixture* f = b->GetFixtureList(); f; f = f->GetNext()) {
+      fixtureCount++;
+    }
+  }
+
+  const b2Profile& profile = world->GetProfile();
+  string text;
+  text += string_util::format("profile: %s\n", gmMgr->getPhysicsProfile().name.c_str());
+  text += string_util::format("bodies: %d\n", world->GetBodyCount());
+  text += string_util::format("fixtures: %d\n", fixtureCount);
+  text += string_util::format("contacts: %d\n", world->GetContactCount());
+  text += string_util::format("proxies: %d\n", world->GetProxyCount());
+  text += string_util::format("step: %.2f ms (max %.2f)\n", profile.step, _maxStepMs);
+  text += string_util::format("collide / solve / toi: %.2f / %.2f / %.2f ms",
+                              profile.collide, profile.solve, profile.solveTOI);
+  if (gmMgr->isPhysicsPipelined()) {
+    text += string_util::format("\nstepped during render, waited %.2f ms", gmMgr->getLastWorldStepWaitMs());
+  }
+  _label->setString(text);
+}
+
+
+bool PhysicsOverlay::isVisible() const {
+  return _layer->isVisible();
+}
+
+void PhysicsOverlay::setVisible(bool visible) {
+  _layer->setVisible(visible);
+  if (visible) {
+    _maxStepMs = 0;
+    refresh();
+  }
+}
+
+Layer* PhysicsOverlay::getLayer() const {
+  return _layer;
+}
+
+}  // namespace vigilante
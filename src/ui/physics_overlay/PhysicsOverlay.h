@@ -0,0 +1,38 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_PHYSICS_OVERLAY_H_
+#define VIGILANTE_PHYSICS_OVERLAY_H_
+
+#include <cocos2d.h>
+#include <2d/CCLabel.h>
+#include <Box2D/Box2D.h>
+
+namespace vigilante {
+
+// Displays the size of the b2World (bodies, fixtures, contacts and
+// broadphase proxies) and how long its last b2World::Step() took.
+class PhysicsOverlay {
+ public:
+  static PhysicsOverlay* getInstance();
+  virtual ~PhysicsOverlay() = default;
+
+  void update(float delta);
+
+  bool isVisible() const;
+  void setVisible(bool visible);
+  cocos2d::Layer* getLayer() const;
+
+ private:
+  PhysicsOverlay();
+  void refresh();
+
+  static const float _kRefreshInterval;
+
+  cocos2d::Layer* _layer;
+  cocos2d::Label* _label;
+  float _timer;
+  float32 _maxStepMs;  // since it has been shown
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_PHYSICS_OVERLAY_H_
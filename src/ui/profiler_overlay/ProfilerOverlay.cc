@@ -0,0 +1,106 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "ProfilerOverlay.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "AssetManager.h"
+#include "util/Profiler.h"
+#include "util/StringUtil.h"
+
+#define OVERLAY_X 10
+#define OVERLAY_Y cocos2d::Director::getInstance()->getWinSize().height - 70
+#define MAX_ZONE_COUNT 12
+
+using std::string;
+using std::vector;
+using cocos2d::Layer;
+using cocos2d::Label;
+using vigilante::asset_manager::kRegularFont;
+using vigilante::asset_manager::kRegularFontSize;
+
+namespace vigilante {
+
+const float ProfilerOverlay::_kRefreshInterval = .25f;
+
+ProfilerOverlay* ProfilerOverlay::getInstance() {
+  static ProfilerOverlay instance;
+  return &instance;
+}
+
+ProfilerOverlay::ProfilerOverlay()
+    : _layer(Layer::create()),
+      _label(Label::createWithTTF("", kRegularFont, kRegularFontSize)),
+      _timer(),
+      _lastSortStats(),
+      _maxSortedChildCount() {
+  _label->getFontAtlas()->setAliasTexParameters();
+  _label->setAnchorPoint({0, 1});
+
+  _layer->setVisible(false);
+  _layer->setPosition(OVERLAY_X, OVERLAY_Y);
+  _layer->addChild(_label);
+}
+
+
+void ProfilerOverlay::update(float delta) {
+  // Collected even if it's hidden, so that it only covers the last frame.
+  _lastSortStats = GraphicalLayer::collectSortStats();
+
+  if (!_layer->isVisible()) {
+    return;
+  }
+  _maxSortedChildCount = std::max(_maxSortedChildCount, _lastSortStats.sortedChildCount);
+
+  _timer += delta;
+  if (_timer >= _kRefreshInterval) {
+    _timer = 0;
+    refresh();
+  }
+}
+
+void ProfilerOverlay::refresh() {
+  string text = string_util::format("sort: %zu layers, %zu children / frame (max %zu)\n",
+                                    _lastSortStats.sortCount,
+                                    _lastSortStats.sortedChildCount,
+                                    _maxSortedChildCount);
+
+  if (!profiler::isCompiledIn()) {
+    text += "Profiler is not compiled in (see VIGILANTE_PROFILER).";
+    _label->setString(text);
+    return;
+  }
+
+  const vector<profiler::ZoneStats> stats = profiler::getStats();
+  text += "zone: avg / max ms (calls)\n";
+
+  for (size_t i = 0; i < stats.size() && i < MAX_ZONE_COUNT; i++) {
+    text += string_util::format("%s: %.2f / %.2f (%d)\n",
+                                stats[i].name.c_str(),
+                                stats[i].avgMs,
+                                stats[i].maxMs,
+                                stats[i].calls);
+  }
+  _label->setString(text);
+}
+
+
+bool ProfilerOverlay::isVisible() const {
+  return _layer->isVisible();
+}
+
+void ProfilerOverlay::setVisible(bool visible) {
+  _layer->setVisible(visible);
+  if (visible) {
+    _maxSortedChildCount = 0;
+    profiler::resetStats();
+    refresh();
+  }
+}
+
+Layer* ProfilerOverlay::getLayer() const {
+  return _layer;
+}
+
+}  // namespace vigilante
@@ -0,0 +1,40 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_PROFILER_OVERLAY_H_
+#define VIGILANTE_PROFILER_OVERLAY_H_
+
+#include <cocos2d.h>
+#include <2d/CCLabel.h>
+#include "map/GraphicalLayer.h"
+
+namespace vigilante {
+
+// Displays the per-zone stats collected by util/Profiler.h,
+// and how many children the GraphicalLayers have re-sorted.
+class ProfilerOverlay {
+ public:
+  static ProfilerOverlay* getInstance();
+  virtual ~ProfilerOverlay() = default;
+
+  void update(float delta);
+
+  bool isVisible() const;
+  void setVisible(bool visible);
+  cocos2d::Layer* getLayer() const;
+
+ private:
+  ProfilerOverlay();
+  void refresh();
+
+  static const float _kRefreshInterval;
+
+  cocos2d::Layer* _layer;
+  cocos2d::Label* _label;
+  float _timer;
+
+  GraphicalLayer::SortStats _lastSortStats;  // of the last frame
+  size_t _maxSortedChildCount;  // per frame, since it has been shown
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_PROFILER_OVERLAY_H_
@@ -0,0 +1,137 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "BinaryStream.h"
+
+#include <cstring>
+
+using std::string;
+
+namespace vigilante {
+
+BinaryWriter::BinaryWriter() : _buf() {}
+
+void BinaryWriter::writeU8(uint8_t val) {
+  _buf.push_back(static_cast<char>(val));
+}
+
+void BinaryWriter::writeU32(uint32_t val) {
+  for (int i = 0; i < 4; i++) {
+    _buf.push_back(static_cast<char>((val >> (i * 8)) & 0xff));
+  }
+}
+
+void BinaryWriter::writeU64(uint64_t val) {
+  writeU32(static_cast<uint32_t>(val));
+  writeU32(static_cast<uint32_t>(val >> 32));
+}
+
+void BinaryWriter::writeI32(int32_t val) {
+  writeU32(static_cast<uint32_t>(val));
+}
+
+void BinaryWriter::writeFloat(float val) {
+  uint32_t bits;
+  memcpy(&bits, &val, sizeof(bits));
+  writeU32(bits);
+}
+
+void BinaryWriter::writeBool(bool val) {
+  writeU8(val ? 1 : 0);
+}
+
+void BinaryWriter::writeString(const string& val) {
+  writeU32(static_cast<uint32_t>(val.size()));
+  _buf.append(val);
+}
+
+const string& BinaryWriter::getBuffer() const {
+  return _buf;
+}
+
+string& BinaryWriter::getBuffer() {
+  return _buf;
+}
+
+
+
+BinaryReader::BinaryReader(const char* data, size_t size)
+    : _data(data),
+      _size(size),
+      _offset(),
+      _good(true) {}
+
+uint8_t BinaryReader::readU8() {
+  if (!require(1)) {
+    return 0;
+  }
+  return static_cast<uint8_t>(_data[_offset++]);
+}
+
+uint32_t BinaryReader::readU32() {
+  if (!require(4)) {
+    return 0;
+  }
+  uint32_t val = 0;
+  for (int i = 0; i < 4; i++) {
+    val |= static_cast<uint32_t>(static_cast<uint8_t>(_data[_offset++])) << (i * 8);
+  }
+  return val;
+}
+
+uint64_t BinaryReader::readU64() {
+  const uint64_t low = readU32();
+  const uint64_t high = readU32();
+  return low | (high << 32);
+}
+
+int32_t BinaryReader::readI32() {
+  return static_cast<int32_t>(readU32());
+}
+
+float BinaryReader::readFloat() {
+  uint32_t bits = readU32();
+  float val;
+  memcpy(&val, &bits, sizeof(val));
+  return val;
+}
+
+bool BinaryReader::readBool() {
+  return readU8() != 0;
+}
+
+string BinaryReader::readString() {
+  uint32_t size = readU32();
+  if (!require(size)) {
+    return "";
+  }
+  string val(_data + _offset, size);
+  _offset += size;
+  return val;
+}
+
+void BinaryReader::skip(size_t size) {
+  if (require(size)) {
+    _offset += size;
+  }
+}
+
+bool BinaryReader::good() const {
+  return _good;
+}
+
+bool BinaryReader::eof() const {
+  return _offset >= _size;
+}
+
+size_t BinaryReader::getOffset() const {
+  return _offset;
+}
+
+bool BinaryReader::require(size_t size) {
+  if (!_good || size > _size - _offset) {
+    _good = false;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace vigilante
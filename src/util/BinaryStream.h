@@ -0,0 +1,66 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_BINARY_STREAM_H_
+#define VIGILANTE_BINARY_STREAM_H_
+
+#include <cstdint>
+#include <string>
+
+namespace vigilante {
+
+// Serializes values into an in-memory byte buffer.
+// Integers and floats are stored in little-endian byte order,
+// and strings are prefixed with their length.
+class BinaryWriter {
+ public:
+  BinaryWriter();
+  virtual ~BinaryWriter() = default;
+
+  void writeU8(uint8_t val);
+  void writeU32(uint32_t val);
+  void writeU64(uint64_t val);
+  void writeI32(int32_t val);
+  void writeFloat(float val);
+  void writeBool(bool val);
+  void writeString(const std::string& val);
+
+  const std::string& getBuffer() const;
+  std::string& getBuffer();
+
+ private:
+  std::string _buf;
+};
+
+
+// Deserializes values written by BinaryWriter.
+// Once a read runs past the end of the buffer, the reader enters
+// a failed state, and all subsequent reads return zero values.
+class BinaryReader {
+ public:
+  BinaryReader(const char* data, size_t size);
+  virtual ~BinaryReader() = default;
+
+  uint8_t readU8();
+  uint32_t readU32();
+  uint64_t readU64();
+  int32_t readI32();
+  float readFloat();
+  bool readBool();
+  std::string readString();
+  void skip(size_t size);
+
+  bool good() const;
+  bool eof() const;
+  size_t getOffset() const;
+
+ private:
+  bool require(size_t size);
+
+  const char* _data;
+  size_t _size;
+  size_t _offset;
+  bool _good;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_BINARY_STREAM_H_
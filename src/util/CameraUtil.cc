@@ -85,8 +85,10 @@ void updateShake(Camera* camera, float delta) {
 
   if (::currentTime <= ::duration) {
     ::currentPower = ::power * ((::duration - ::currentTime) / ::duration);
-    ::pos.x = (rand_util::randFloat() - 0.5f) * 2 * ::currentPower; // camera offset X
-    ::pos.y = (rand_util::randFloat() - 0.5f) * 2 * ::currentPower; // camera offset Y
+    float offsets[2];
+    rand_util::fillFloats(rand_util::FX, offsets, 2, -1.0f, 1.0f);
+    ::pos.x = offsets[0] * ::currentPower; // camera offset X
+    ::pos.y = offsets[1] * ::currentPower; // camera offset Y
     ::currentTime += delta;
     // Translate camera
     const Vec2& camPos = camera->getPosition();
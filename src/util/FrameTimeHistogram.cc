@@ -0,0 +1,135 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "FrameTimeHistogram.h"
+
+#include <cstdio>
+#include <fstream>
+
+using std::string;
+using std::ifstream;
+using std::ofstream;
+
+namespace vigilante {
+
+const float FrameTimeHistogram::kBucketWidthMs = .25f;
+
+FrameTimeHistogram::FrameTimeHistogram() : _buckets(), _sampleCount(), _sumMs() {}
+
+
+void FrameTimeHistogram::add(float frameTimeMs) {
+  int idx = static_cast<int>(frameTimeMs / kBucketWidthMs);
+  if (idx < 0) {
+    idx = 0;
+  } else if (idx >= kBucketCount) {
+    idx = kBucketCount - 1;
+  }
+
+  _buckets[idx]++;
+  _sampleCount++;
+  _sumMs += frameTimeMs;
+}
+
+void FrameTimeHistogram::clear() {
+  _buckets.fill(0);
+  _sampleCount = 0;
+  _sumMs = 0;
+}
+
+
+float FrameTimeHistogram::getPercentile(float percentile) const {
+  if (_sampleCount == 0) {
+    return 0;
+  }
+
+  const double target = _sampleCount * percentile / 100.0;
+  int accumulated = 0;
+
+  for (int i = 0; i < kBucketCount; i++) {
+    accumulated += _buckets[i];
+    if (accumulated >= target) {
+      return (i + 1) * kBucketWidthMs;
+    }
+  }
+  return kBucketCount * kBucketWidthMs;
+}
+
+float FrameTimeHistogram::getMean() const {
+  return (_sampleCount > 0) ? _sumMs / _sampleCount : 0;
+}
+
+int FrameTimeHistogram::getSampleCount() const {
+  return _sampleCount;
+}
+
+
+bool FrameTimeHistogram::save(const string& fileName) const {
+  ofstream fout(fileName);
+  if (!fout.is_open()) {
+    return false;
+  }
+
+  fout << "samples " << _sampleCount << "\n";
+  fout << "sum_ms " << _sumMs << "\n";
+  for (int i = 0; i < kBucketCount; i++) {
+    if (_buckets[i] > 0) {
+      fout << i << " " << _buckets[i] << "\n";
+    }
+  }
+  return fout.good();
+}
+
+bool FrameTimeHistogram::load(const string& fileName) {
+  ifstream fin(fileName);
+  if (!fin.is_open()) {
+    return false;
+  }
+
+  clear();
+
+  string key;
+  if (!(fin >> key >> _sampleCount) || key != "samples" ||
+      !(fin >> key >> _sumMs) || key != "sum_ms") {
+    clear();
+    return false;
+  }
+
+  int idx = 0;
+  int count = 0;
+  while (fin >> idx >> count) {
+    if (idx < 0 || idx >= kBucketCount) {
+      clear();
+      return false;
+    }
+    _buckets[idx] = count;
+  }
+  return true;
+}
+
+bool FrameTimeHistogram::compare(const FrameTimeHistogram& baseline, float tolerance,
+                                 string* report) const {
+  static const float percentiles[] = {50, 95, 99};
+  bool passed = true;
+  string result;
+  char line[128];
+
+  snprintf(line, sizeof(line), "mean: %.2fms (baseline: %.2fms)\n",
+           getMean(), baseline.getMean());
+  result += line;
+
+  for (auto p : percentiles) {
+    const float current = getPercentile(p);
+    const float expected = baseline.getPercentile(p);
+    const bool regressed = current > expected * (1 + tolerance);
+    passed &= !regressed;
+
+    snprintf(line, sizeof(line), "p%d: %.2fms (baseline: %.2fms)%s\n",
+             static_cast<int>(p), current, expected, (regressed) ? " REGRESSED" : "");
+    result += line;
+  }
+
+  if (report) {
+    *report = result;
+  }
+  return passed;
+}
+
+}  // namespace vigilante
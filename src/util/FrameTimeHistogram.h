@@ -0,0 +1,53 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_FRAME_TIME_HISTOGRAM_H_
+#define VIGILANTE_FRAME_TIME_HISTOGRAM_H_
+
+#include <array>
+#include <string>
+
+namespace vigilante {
+
+// A fixed-bucket histogram of frame times.
+//
+// Buckets are kBucketWidthMs wide, and the last bucket also
+// holds every sample which is greater than its lower bound.
+class FrameTimeHistogram {
+ public:
+  static const int kBucketCount = 200;
+  static const float kBucketWidthMs;
+
+  FrameTimeHistogram();
+  virtual ~FrameTimeHistogram() = default;
+
+  void add(float frameTimeMs);
+  void clear();
+
+  // @param percentile: in the range (0, 100]
+  // @return the upper bound of the bucket which contains the given percentile.
+  float getPercentile(float percentile) const;
+  float getMean() const;
+  int getSampleCount() const;
+
+  // Text format:
+  //   samples <n>
+  //   sum_ms <total>
+  //   <bucket index> <count>  (one line per non-empty bucket)
+  bool save(const std::string& fileName) const;
+  bool load(const std::string& fileName);
+
+  // Compares p50/p95/p99 against the baseline. A percentile is considered
+  // regressed if it is more than `tolerance` (e.g., .1 = 10%) slower.
+  // @param report: receives a human readable summary
+  // @return true if none of the percentiles regressed.
+  bool compare(const FrameTimeHistogram& baseline, float tolerance,
+               std::string* report) const;
+
+ private:
+  std::array<int, kBucketCount> _buckets;
+  int _sampleCount;
+  double _sumMs;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_FRAME_TIME_HISTOGRAM_H_
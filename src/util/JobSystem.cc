@@ -0,0 +1,172 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "JobSystem.h"
+
+#include <algorithm>
+
+using std::atomic;
+using std::mutex;
+using std::thread;
+using std::function;
+using std::lock_guard;
+using std::unique_lock;
+using std::unique_ptr;
+
+namespace vigilante {
+
+JobSystem* JobSystem::getInstance() {
+  static JobSystem instance;
+  return &instance;
+}
+
+JobSystem::JobSystem()
+    : _queues(),
+      _workers(),
+      _queuedJobCount(0),
+      _isShuttingDown(false),
+      _sleepMutex(),
+      _hasJobsCv() {
+  // The thread calling parallelFor() is one of the "workers" too.
+  const size_t workerCount = std::max(thread::hardware_concurrency(), 1u) - 1;
+
+  for (size_t i = 0; i < workerCount + 1; i++) {
+    unique_ptr<JobSystem::JobQueue> queue(new JobSystem::JobQueue());
+    queue->head = 0;
+    _queues.push_back(std::move(queue));
+  }
+
+  for (size_t i = 0; i < workerCount; i++) {
+    _workers.push_back(thread(&JobSystem::runWorker, this, i));
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    lock_guard<mutex> lock(_sleepMutex);
+    _isShuttingDown = true;
+  }
+  _hasJobsCv.notify_all();
+
+  for (auto& worker : _workers) {
+    worker.join();
+  }
+}
+
+void JobSystem::parallelFor(size_t count, size_t grainSize,
+                            const function<void (size_t, size_t)>& fn) {
+  if (count == 0) {
+    return;
+  }
+
+  grainSize = std::max<size_t>(grainSize, 1);
+  const size_t jobCount = (count + grainSize - 1) / grainSize;
+
+  // Not worth waking up the workers.
+  if (jobCount == 1 || _workers.empty()) {
+    fn(0, count);
+    return;
+  }
+
+  atomic<size_t> remainingCount(jobCount);
+  _queuedJobCount += jobCount;
+
+  // Deal the jobs to all queues round-robin. Whoever finishes its share
+  // first will steal the rest.
+  for (size_t i = 0; i < jobCount; i++) {
+    JobSystem::Job job;
+    job.fn = &fn;
+    job.begin = i * grainSize;
+    job.end = std::min(job.begin + grainSize, count);
+    job.remainingCount = &remainingCount;
+
+    JobSystem::JobQueue& queue = *_queues[i % _queues.size()];
+    lock_guard<mutex> lock(queue.mutex);
+    queue.jobs.push_back(job);
+  }
+
+  {
+    // Synchronizes with the workers which are about to sleep,
+    // so none of them misses this notification.
+    lock_guard<mutex> lock(_sleepMutex);
+  }
+  _hasJobsCv.notify_all();
+
+  const size_t callerQueueIdx = _queues.size() - 1;
+  while (remainingCount > 0) {
+    if (!tryRunJob(callerQueueIdx)) {
+      // All jobs are taken, and some of them are still running.
+      std::this_thread::yield();
+    }
+  }
+}
+
+size_t JobSystem::getWorkerCount() const {
+  return _workers.size();
+}
+
+
+void JobSystem::runWorker(size_t queueIdx) {
+  while (true) {
+    if (tryRunJob(queueIdx)) {
+      continue;
+    }
+
+    unique_lock<mutex> lock(_sleepMutex);
+    _hasJobsCv.wait(lock, [this]() {
+      return _isShuttingDown || _queuedJobCount > 0;
+    });
+
+    if (_isShuttingDown) {
+      return;
+    }
+  }
+}
+
+bool JobSystem::tryRunJob(size_t queueIdx) {
+  JobSystem::Job job;
+  if (!tryPopJob(queueIdx, &job) && !tryStealJob(queueIdx, &job)) {
+    return false;
+  }
+
+  --_queuedJobCount;
+  (*job.fn)(job.begin, job.end);
+  --(*job.remainingCount);
+  return true;
+}
+
+bool JobSystem::tryPopJob(size_t queueIdx, JobSystem::Job* job) {
+  JobSystem::JobQueue& queue = *_queues[queueIdx];
+  lock_guard<mutex> lock(queue.mutex);
+
+  if (queue.head == queue.jobs.size()) {
+    return false;
+  }
+
+  *job = queue.jobs.back();
+  queue.jobs.pop_back();
+  if (queue.head == queue.jobs.size()) {
+    queue.jobs.clear();
+    queue.head = 0;
+  }
+  return true;
+}
+
+bool JobSystem::tryStealJob(size_t queueIdx, JobSystem::Job* job) {
+  for (size_t i = 1; i < _queues.size(); i++) {
+    JobSystem::JobQueue& victim = *_queues[(queueIdx + i) % _queues.size()];
+    lock_guard<mutex> lock(victim.mutex);
+
+    if (victim.head == victim.jobs.size()) {
+      continue;
+    }
+
+    *job = victim.jobs[victim.head++];
+    if (victim.head == victim.jobs.size()) {
+      victim.jobs.clear();
+      victim.head = 0;
+    }
+    return true;
+  }
+  return false;
+}
+
+}  // namespace vigilante
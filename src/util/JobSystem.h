@@ -0,0 +1,75 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_JOB_SYSTEM_H_
+#define VIGILANTE_JOB_SYSTEM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vigilante {
+
+// A small work-stealing job system for data-parallel work
+// of the main thread, e.g., the Npcs' think phase (see GameMapManager::update()).
+//
+// Each worker thread owns a queue of jobs. A worker takes jobs from the back
+// of its own queue, and once it runs out, steals from the front of the others.
+// The thread calling parallelFor() owns a queue as well and works on the jobs
+// too, so it doesn't idle while waiting for them to finish.
+class JobSystem {
+ public:
+  static JobSystem* getInstance();
+  virtual ~JobSystem();
+
+  // Calls fn(begin, end) for consecutive chunks of [0, count), each with at most
+  // `grainSize` elements, in parallel. Returns once all chunks are done.
+  // Only one thread may call it at a time, and `fn` must not call it.
+  void parallelFor(size_t count, size_t grainSize,
+                   const std::function<void (size_t begin, size_t end)>& fn);
+
+  size_t getWorkerCount() const;
+
+ private:
+  struct Job final {
+    const std::function<void (size_t, size_t)>* fn;
+    size_t begin;
+    size_t end;
+    std::atomic<size_t>* remainingCount;  // # of unfinished jobs of the same parallelFor()
+  };
+
+  // `jobs` is only cleared when it's empty, so that the queue
+  // stops allocating once it's large enough.
+  struct JobQueue final {
+    std::mutex mutex;
+    std::vector<JobSystem::Job> jobs;
+    size_t head;  // where the thieves steal from
+  };
+
+  JobSystem();
+
+  void runWorker(size_t queueIdx);
+
+  // Runs a job from the `queueIdx`-th queue, or steals one from the others.
+  // @return false if there were no jobs at all.
+  bool tryRunJob(size_t queueIdx);
+  bool tryPopJob(size_t queueIdx, JobSystem::Job* job);
+  bool tryStealJob(size_t queueIdx, JobSystem::Job* job);
+
+  // _queues[0 ... workerCount-1] belong to the workers,
+  // and the last one belongs to the thread calling parallelFor().
+  std::vector<std::unique_ptr<JobSystem::JobQueue>> _queues;
+  std::vector<std::thread> _workers;
+  std::atomic<size_t> _queuedJobCount;
+  std::atomic<bool> _isShuttingDown;
+
+  // Idle workers sleep on `_hasJobsCv` instead of spinning.
+  std::mutex _sleepMutex;
+  std::condition_variable _hasJobsCv;
+};
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_JOB_SYSTEM_H_
@@ -1,32 +1,309 @@
 // Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
 #include "Logger.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 extern "C" {
 #include <execinfo.h> // backtrace*
 #include <signal.h> // signal
 #include <stdlib.h> // exit
-#include <unistd.h> // close
+#include <unistd.h> // close, _exit
 #include <fcntl.h> // open
 }
 
 #define NUM_STACKTRACE_FUNC 10
 #define LOG_FILENAME "vigilante.log"
+#define RING_BUFFER_CAPACITY 1024  // entries per thread, must be a power of 2
+#define FLUSH_INTERVAL_MS 2
+#define RATE_LIMIT_WINDOW_NS 1000000000ULL
+#define RATE_LIMIT_BURST 20
+
+using std::mutex;
+using std::thread;
+using std::vector;
+using std::lock_guard;
+using std::unique_lock;
+using std::unique_ptr;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
 
 namespace vigilante {
 
 namespace logger {
 
+namespace {
+
+// Single producer (the owning thread), single consumer (whoever holds flushMutex).
+struct RingBuffer {
+  RingBuffer() : head(), tail(), drainedHead(), droppedCount(), entries(RING_BUFFER_CAPACITY) {}
+
+  std::atomic<size_t> head;  // next entry to be written by the producer
+  std::atomic<size_t> tail;  // next entry to be read by the consumer
+  size_t drainedHead;  // head at the time of the last drain, consumer only
+  std::atomic<int> droppedCount;
+  vector<internal::Entry> entries;
+};
+
+class AsyncLogger {
+ public:
+  // Never destroyed, so that VGLOG() remains usable from other static destructors.
+  static AsyncLogger& getInstance() {
+    static AsyncLogger* instance = new AsyncLogger();
+    return *instance;
+  }
+
+  RingBuffer* getThreadRingBuffer() {
+    // The ring buffers are owned by AsyncLogger, so that entries logged by
+    // a thread right before it exits are not lost.
+    thread_local RingBuffer* ringBuffer = nullptr;
+    if (!ringBuffer) {
+      lock_guard<mutex> lock(_ringBuffersMutex);
+      _ringBuffers.push_back(unique_ptr<RingBuffer>(new RingBuffer()));
+      ringBuffer = _ringBuffers.back().get();
+      startFlushThread();
+    }
+    return ringBuffer;
+  }
+
+  void flush() {
+    lock_guard<mutex> lock(_flushMutex);
+    {
+      lock_guard<mutex> ringBuffersLock(_ringBuffersMutex);
+      collect();
+    }
+    // New threads may register their ring buffers while the batch is written.
+    writeBatch();
+    {
+      lock_guard<mutex> ringBuffersLock(_ringBuffersMutex);
+      release();
+    }
+  }
+
+  // Called from the SIGSEGV handler, hence it mustn't block on either mutex,
+  // which may be held by the thread that crashed. If either is, the pending
+  // entries are lost, but the backtrace still gets written.
+  void tryFlush() {
+    unique_lock<mutex> lock(_flushMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      return;
+    }
+    unique_lock<mutex> ringBuffersLock(_ringBuffersMutex, std::try_to_lock);
+    if (!ringBuffersLock.owns_lock()) {
+      return;
+    }
+    collect();
+    writeBatch();
+    release();
+  }
+
+  std::atomic<int> severity;
+
+ private:
+  AsyncLogger()
+      : severity(Severity::INFO),
+        _ringBuffersMutex(),
+        _ringBuffers(),
+        _flushMutex(),
+        _flushThread(),
+        _isRunning(),
+        _batch(),
+        _logFile(fopen(LOG_FILENAME, "w")) {}
+
+  static void shutdown() {
+    AsyncLogger& instance = getInstance();
+    instance._isRunning = false;
+    if (instance._flushThread.joinable()) {
+      instance._flushThread.join();
+    }
+    instance.flush();
+  }
+
+  // Must be called with _ringBuffersMutex held.
+  void startFlushThread() {
+    if (_isRunning) {
+      return;
+    }
+    _isRunning = true;
+    std::atexit(&AsyncLogger::shutdown);
+    _flushThread = thread([this]() {
+      while (_isRunning) {
+        flush();
+        std::this_thread::sleep_for(std::chrono::milliseconds(FLUSH_INTERVAL_MS));
+      }
+    });
+  }
+
+  // Must be called with both _flushMutex and _ringBuffersMutex held.
+  void collect() {
+    _batch.clear();
+    for (auto& ringBuffer : _ringBuffers) {
+      collect(*ringBuffer);
+    }
+  }
+
+  // Must be called with _flushMutex held.
+  void writeBatch() {
+    // Entries of different threads are interleaved by their timestamps.
+    std::stable_sort(_batch.begin(), _batch.end(),
+                     [](const internal::Entry* e1, const internal::Entry* e2) {
+      return e1->header.timestampNs < e2->header.timestampNs;
+    });
+
+    for (auto entry : _batch) {
+      write(*entry);
+    }
+    if (_logFile) {
+      fflush(_logFile);
+    }
+    fflush(stdout);
+  }
+
+  // Gives the written entries back to the producers.
+  // Must be called with both _flushMutex and _ringBuffersMutex held.
+  void release() {
+    for (auto& ringBuffer : _ringBuffers) {
+      ringBuffer->tail.store(ringBuffer->drainedHead, memory_order_release);
+    }
+  }
+
+  void collect(RingBuffer& ringBuffer) {
+    const size_t tail = ringBuffer.tail.load(memory_order_relaxed);
+    const size_t head = ringBuffer.head.load(memory_order_acquire);
+    ringBuffer.drainedHead = head;
+    for (size_t i = tail; i != head; i++) {
+      _batch.push_back(&ringBuffer.entries[i & (RING_BUFFER_CAPACITY - 1)]);
+    }
+
+    int droppedCount = ringBuffer.droppedCount.exchange(0, memory_order_relaxed);
+    if (droppedCount > 0) {
+      fprintf(stdout, "[WARNING] [Logger.cc] %d log entries dropped (ring buffer full)\n", droppedCount);
+      if (_logFile) {
+        fprintf(_logFile, "[WARNING] [Logger.cc] %d log entries dropped (ring buffer full)\n", droppedCount);
+      }
+    }
+  }
+
+  void write(const internal::Entry& entry) {
+    char msg[512];
+    entry.header.formatFn(entry, msg, sizeof(msg));
+
+    const char* severityStr = _kSeverityStr[entry.header.severity].c_str();
+    fprintf(stdout, "[%s] [%s: %d] %s\n", severityStr, entry.header.fileName, entry.header.line, msg);
+    if (_logFile) {
+      fprintf(_logFile, "[%s] [%s: %d] %s\n", severityStr, entry.header.fileName, entry.header.line, msg);
+    }
+  }
+
+  mutex _ringBuffersMutex;
+  vector<unique_ptr<RingBuffer>> _ringBuffers;
+
+  mutex _flushMutex;
+  thread _flushThread;
+  std::atomic<bool> _isRunning;
+  vector<const internal::Entry*> _batch;
+  FILE* _logFile;
+};
+
+}  // namespace
+
+
+bool isEnabled(Severity severity) {
+  return severity <= AsyncLogger::getInstance().severity.load(memory_order_relaxed);
+}
+
+Severity getSeverity() {
+  return static_cast<Severity>(AsyncLogger::getInstance().severity.load(memory_order_relaxed));
+}
+
+void setSeverity(Severity severity) {
+  AsyncLogger::getInstance().severity.store(severity, memory_order_relaxed);
+}
+
+void flush() {
+  AsyncLogger::getInstance().flush();
+}
+
 void segvHandler(int) {
-  void* array[10];
-  size_t size = backtrace(array, 10);
+  AsyncLogger::getInstance().tryFlush();
+
+  void* array[NUM_STACKTRACE_FUNC];
+  size_t size = backtrace(array, NUM_STACKTRACE_FUNC);
 
-  int fd = open(LOG_FILENAME, O_CREAT | O_WRONLY, 0600);
+  int fd = open(LOG_FILENAME, O_CREAT | O_WRONLY | O_APPEND, 0600);
   backtrace_symbols_fd(array + 2, size - 2, fd);
   close(fd);
 
-  exit(EXIT_FAILURE);
+  // Unlike exit(), _exit() is async-signal-safe, and skips the atexit handlers,
+  // e.g., AsyncLogger::shutdown(), which would block on the mutexes skipped above.
+  _exit(EXIT_FAILURE);
 }
 
+
+RateLimiter::RateLimiter() : _windowBeginNs(), _count(), _suppressedCount() {}
+
+int RateLimiter::acquire() {
+  const uint64_t now = internal::now();
+  uint64_t windowBeginNs = _windowBeginNs.load(memory_order_relaxed);
+
+  if (now - windowBeginNs >= RATE_LIMIT_WINDOW_NS &&
+      _windowBeginNs.compare_exchange_strong(windowBeginNs, now, memory_order_relaxed)) {
+    _count.store(0, memory_order_relaxed);
+  }
+
+  if (_count.fetch_add(1, memory_order_relaxed) >= RATE_LIMIT_BURST) {
+    _suppressedCount.fetch_add(1, memory_order_relaxed);
+    return -1;
+  }
+  return _suppressedCount.exchange(0, memory_order_relaxed);
+}
+
+
+namespace internal {
+
+Entry* beginEntry() {
+  RingBuffer* ringBuffer = AsyncLogger::getInstance().getThreadRingBuffer();
+  const size_t head = ringBuffer->head.load(memory_order_relaxed);
+  const size_t tail = ringBuffer->tail.load(memory_order_acquire);
+
+  if (head - tail >= RING_BUFFER_CAPACITY) {
+    ringBuffer->droppedCount.fetch_add(1, memory_order_relaxed);
+    return nullptr;
+  }
+  return &ringBuffer->entries[head & (RING_BUFFER_CAPACITY - 1)];
+}
+
+void commitEntry() {
+  RingBuffer* ringBuffer = AsyncLogger::getInstance().getThreadRingBuffer();
+  ringBuffer->head.fetch_add(1, memory_order_release);
+}
+
+uint64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int formatPreformatted(const Entry& entry, char* buf, size_t bufSize) {
+  return snprintf(buf, bufSize, "%s", entry.args);
+}
+
+void logSuppressed(Severity severity, const char* fileName, int line, int suppressedCount) {
+  Entry* entry = beginEntry();
+  if (!entry) {
+    return;
+  }
+  entry->header = {&formatPreformatted, nullptr, fileName, now(), line, severity};
+  snprintf(entry->args, sizeof(entry->args), "(%d similar messages suppressed)", suppressedCount);
+  commitEntry();
+}
+
+}  // namespace internal
+
 } // namespace logger
 
 } // namespace vigilante
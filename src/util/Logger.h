@@ -3,8 +3,15 @@
 #define VIGILANTE_LOGGER_H_
 
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <string>
 #include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 #include <cocos2d.h>
 
@@ -13,13 +20,49 @@
 #define LOG_WARN vigilante::logger::Severity::WARNING
 #define LOG_INFO vigilante::logger::Severity::INFO
 
-// Example usage: VGLOG(LOG_INFO, __FILE__, "test msg %d", 5);
+#if defined(__GNUC__) || defined(__clang__)
+#define VIGILANTE_PRINTF_FORMAT(formatIdx, firstArgIdx) \
+  __attribute__((format(printf, formatIdx, firstArgIdx)))
+#else
+#define VIGILANTE_PRINTF_FORMAT(formatIdx, firstArgIdx)
+#endif
+
+// Compile-time severity filter: 0 = errors only, 1 = + warnings, 2 = + info.
+// Messages above this level are compiled out.
+#ifndef VIGILANTE_LOG_LEVEL
+#define VIGILANTE_LOG_LEVEL 2
+#endif
+
+// Example usage: VGLOG(LOG_INFO, "test msg %d", 5);
+//
+// The arguments are copied into the calling thread's ring buffer and
+// formatted later by the logger's flush thread, which writes them to
+// stdout and vigilante.log. C strings are copied, so passing
+// std::string::c_str() of a temporary is fine.
+//
+// The format string is checked against the arguments at compile time, as for
+// printf(). Without any arguments, it's written verbatim.
+//
+// Each call site may log at most RATE_LIMIT_BURST (see Logger.cc) messages per
+// second, whatever their arguments, e.g., a call site in a loop still writes
+// that many lines per second. The rest are counted and reported as suppressed
+// by the next message which goes through.
 #define VGLOG(severity, format, ...)\
-  cocos2d::log("[%s] [%s: %d] " format,\
-      (vigilante::logger::_kSeverityStr[severity].c_str()),\
-      (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__),\
-      (__LINE__),\
-      ##__VA_ARGS__)
+  do {\
+    if (0) {\
+      vigilante::logger::internal::checkFormat(format, ##__VA_ARGS__);\
+    }\
+    if (static_cast<int>(severity) <= VIGILANTE_LOG_LEVEL &&\
+        vigilante::logger::isEnabled(severity)) {\
+      static vigilante::logger::RateLimiter _vgLogRateLimiter;\
+      vigilante::logger::log(severity,\
+          (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__),\
+          (__LINE__),\
+          _vgLogRateLimiter,\
+          format,\
+          ##__VA_ARGS__);\
+    }\
+  } while (0)
 
 
 namespace vigilante {
@@ -39,9 +82,187 @@ const std::array<std::string, Severity::SIZE> _kSeverityStr = {{
 }};
 
 
+// Runtime severity filter.
+// The messages less severe than getSeverity() are dropped (INFO by default).
+bool isEnabled(Severity severity);
+Severity getSeverity();
+void setSeverity(Severity severity);
+
+// Blocks until every pending entry has been written.
+void flush();
+
 // SIGSEGV handler
 void segvHandler(int);
 
+
+// Limits a single call site of VGLOG() to a burst of messages per second,
+// no matter which messages they are.
+class RateLimiter {
+ public:
+  RateLimiter();
+
+  // @return -1 if this message should be suppressed, otherwise the number of
+  //         messages suppressed since the last one that went through.
+  int acquire();
+
+ private:
+  std::atomic<uint64_t> _windowBeginNs;
+  std::atomic<int> _count;
+  std::atomic<int> _suppressedCount;
+};
+
+
+namespace internal {
+
+// Never called. VGLOG() only passes its arguments here so that
+// the compiler checks them against the format string.
+inline void checkFormat(const char* format, ...) VIGILANTE_PRINTF_FORMAT(1, 2);
+inline void checkFormat(const char*, ...) {}
+
+// A log entry as stored in a thread's ring buffer. The arguments are
+// encoded right after the header, and `formatFn` knows how to decode them.
+struct Entry;
+using FormatFn = int (*)(const Entry& entry, char* buf, size_t bufSize);
+
+struct Entry {
+  static const size_t kSize = 256;
+
+  struct Header {
+    FormatFn formatFn;
+    const char* format;
+    const char* fileName;
+    uint64_t timestampNs;
+    int line;
+    Severity severity;
+  } header;
+  char args[kSize - sizeof(Header)];
+};
+
+// Returns a free entry in the calling thread's ring buffer, or nullptr if it's full.
+Entry* beginEntry();
+void commitEntry();
+uint64_t now();
+
+
+// Encoding/decoding of a single printf argument.
+template <typename T, typename Enable = void>
+struct ArgCodec {
+  static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                "VGLOG() only accepts the same argument types as printf()");
+  using Decoded = T;
+
+  static bool encode(char*& p, char* end, T val) {
+    if (p + sizeof(T) > end) {
+      return false;
+    }
+    memcpy(p, &val, sizeof(T));
+    p += sizeof(T);
+    return true;
+  }
+
+  static T decode(const char*& p) {
+    T val;
+    memcpy(&val, p, sizeof(T));
+    p += sizeof(T);
+    return val;
+  }
+};
+
+// C strings are copied (and truncated if necessary).
+template <typename T>
+struct ArgCodec<T, typename std::enable_if<std::is_same<T, const char*>::value ||
+                                           std::is_same<T, char*>::value>::type> {
+  using Decoded = const char*;
+
+  static bool encode(char*& p, char* end, const char* val) {
+    if (p >= end) {
+      return false;
+    }
+    if (!val) {
+      val = "(null)";
+    }
+    size_t len = std::min(strlen(val), static_cast<size_t>(end - p - 1));
+    memcpy(p, val, len);
+    p[len] = '\0';
+    p += len + 1;
+    return true;
+  }
+
+  static const char* decode(const char*& p) {
+    const char* val = p;
+    p += strlen(p) + 1;
+    return val;
+  }
+};
+
+// The format string has been checked by checkFormat() already.
+template <typename... Args>
+int format(char* buf, size_t bufSize, const char* format, const Args&... args) {
+  return snprintf(buf, bufSize, format, args...);
+}
+
+inline int format(char* buf, size_t bufSize, const char* format) {
+  return snprintf(buf, bufSize, "%s", format);
+}
+
+template <typename... Args, size_t... I>
+int formatTuple(char* buf, size_t bufSize, const char* format,
+                const std::tuple<Args...>& args, std::index_sequence<I...>) {
+  return internal::format(buf, bufSize, format, std::get<I>(args)...);
+}
+
+template <typename... Args>
+int formatEntry(const Entry& entry, char* buf, size_t bufSize) {
+  const char* p = entry.args;
+  (void) p;  // unused if there are no arguments
+  // Braced initialization guarantees left-to-right evaluation.
+  std::tuple<typename ArgCodec<Args>::Decoded...> args{ArgCodec<Args>::decode(p)...};
+  return formatTuple(buf, bufSize, entry.header.format, args, std::index_sequence_for<Args...>());
+}
+
+// Used when the arguments didn't fit, and hence have been formatted eagerly.
+int formatPreformatted(const Entry& entry, char* buf, size_t bufSize);
+
+inline bool encodeAll(char*&, char*) {
+  return true;
+}
+
+template <typename T, typename... Rest>
+bool encodeAll(char*& p, char* end, const T& val, const Rest&... rest) {
+  return ArgCodec<typename std::decay<T>::type>::encode(p, end, val) && encodeAll(p, end, rest...);
+}
+
+void logSuppressed(Severity severity, const char* fileName, int line, int suppressedCount);
+
+}  // namespace internal
+
+
+template <typename... Args>
+void log(Severity severity, const char* fileName, int line,
+         RateLimiter& rateLimiter, const char* format, const Args&... args) {
+  int suppressedCount = rateLimiter.acquire();
+  if (suppressedCount < 0) {
+    return;
+  } else if (suppressedCount > 0) {
+    internal::logSuppressed(severity, fileName, line, suppressedCount);
+  }
+
+  internal::Entry* entry = internal::beginEntry();
+  if (!entry) {
+    return;
+  }
+
+  entry->header = {&internal::formatEntry<typename std::decay<Args>::type...>,
+                   format, fileName, internal::now(), line, severity};
+
+  char* p = entry->args;
+  if (!internal::encodeAll(p, entry->args + sizeof(entry->args), args...)) {
+    internal::format(entry->args, sizeof(entry->args), format, args...);
+    entry->header.formatFn = &internal::formatPreformatted;
+  }
+  internal::commitEntry();
+}
+
 } // namespace logger
 
 } // namespace vigilante
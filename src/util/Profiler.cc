@@ -0,0 +1,193 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "std/make_unique.h"
+
+#define MAX_HISTORY_EVENTS 262144
+#define AVG_SMOOTHING_FACTOR .05
+
+using std::string;
+using std::vector;
+using std::deque;
+using std::mutex;
+using std::lock_guard;
+using std::ofstream;
+using std::unique_ptr;
+using std::unordered_map;
+
+namespace vigilante {
+
+namespace profiler {
+
+namespace {
+
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+// Every thread which has ever entered a zone owns one of these buffers.
+// The buffers are never freed, so that the events of a thread which
+// has already exited can still be collected.
+mutex threadBuffersMutex;
+vector<unique_ptr<ThreadBuffer>> threadBuffers;
+thread_local ThreadBuffer* currentThreadBuffer = nullptr;
+
+// The following are only accessed by the main thread.
+deque<Event> history;
+unordered_map<string, ZoneStats> stats;
+
+ThreadBuffer* getCurrentThreadBuffer() {
+  if (!currentThreadBuffer) {
+    lock_guard<mutex> lock(threadBuffersMutex);
+    threadBuffers.push_back(std::make_unique<ThreadBuffer>(threadBuffers.size()));
+    currentThreadBuffer = threadBuffers.back().get();
+  }
+  return currentThreadBuffer;
+}
+
+void writeJsonString(ofstream& fout, const char* s) {
+  fout << '"';
+  for (; *s; s++) {
+    if (*s == '"' || *s == '\\') {
+      fout << '\\';
+    }
+    fout << *s;
+  }
+  fout << '"';
+}
+
+}  // namespace
+
+
+ThreadBuffer::ThreadBuffer(uint32_t threadId)
+    : _events(),
+      _head(0),
+      _tail(0),
+      _droppedCount(0),
+      _threadId(threadId) {}
+
+void ThreadBuffer::push(const char* name, uint64_t beginNs, uint64_t endNs) {
+  const size_t tail = _tail.load(std::memory_order_relaxed);
+  if (tail - _head.load(std::memory_order_acquire) >= kCapacity) {
+    _droppedCount.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  _events[tail & (kCapacity - 1)] = {name, beginNs, endNs, _threadId};
+  _tail.store(tail + 1, std::memory_order_release);
+}
+
+uint32_t ThreadBuffer::getThreadId() const {
+  return _threadId;
+}
+
+size_t ThreadBuffer::getDroppedCount() const {
+  return _droppedCount.load(std::memory_order_relaxed);
+}
+
+
+Zone::Zone(const char* name) : _name(name), _beginNs(now()) {}
+
+Zone::~Zone() {
+  getCurrentThreadBuffer()->push(_name, _beginNs, now());
+}
+
+
+uint64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - epoch).count();
+}
+
+bool isCompiledIn() {
+#ifdef VIGILANTE_PROFILER
+  return true;
+#else
+  return false;
+#endif
+}
+
+void collect() {
+  unordered_map<string, std::pair<double, int>> frameTotals;
+
+  auto onEvent = [&frameTotals](const Event& e) {
+    auto& total = frameTotals[e.name];
+    total.first += (e.endNs - e.beginNs) / 1e6;
+    total.second++;
+
+    if (history.size() >= MAX_HISTORY_EVENTS) {
+      history.pop_front();
+    }
+    history.push_back(e);
+  };
+
+  {
+    lock_guard<mutex> lock(threadBuffersMutex);
+    for (auto& buffer : threadBuffers) {
+      buffer->drain(onEvent);
+    }
+  }
+
+  for (const auto& total : frameTotals) {
+    if (stats.find(total.first) == stats.end()) {
+      stats[total.first] = {total.first, 0, total.second.first, 0, 0};
+    }
+  }
+
+  for (auto& entry : stats) {
+    ZoneStats& s = entry.second;
+    auto it = frameTotals.find(entry.first);
+    s.lastFrameMs = (it != frameTotals.end()) ? it->second.first : 0;
+    s.calls = (it != frameTotals.end()) ? it->second.second : 0;
+    s.avgMs += (s.lastFrameMs - s.avgMs) * AVG_SMOOTHING_FACTOR;
+    s.maxMs = std::max(s.maxMs, s.lastFrameMs);
+  }
+}
+
+vector<ZoneStats> getStats() {
+  vector<ZoneStats> ret;
+  ret.reserve(stats.size());
+  for (const auto& entry : stats) {
+    ret.push_back(entry.second);
+  }
+
+  std::sort(ret.begin(), ret.end(), [](const ZoneStats& s1, const ZoneStats& s2) {
+      return s1.avgMs > s2.avgMs;
+  });
+  return ret;
+}
+
+void resetStats() {
+  stats.clear();
+}
+
+bool dumpChromeTrace(const string& fileName) {
+  ofstream fout(fileName);
+  if (!fout.is_open()) {
+    return false;
+  }
+
+  fout << std::fixed << std::setprecision(3);
+  fout << "{\"traceEvents\":[";
+  for (size_t i = 0; i < history.size(); i++) {
+    const Event& e = history[i];
+    fout << ((i == 0) ? "\n" : ",\n") << "{\"name\":";
+    writeJsonString(fout, e.name);
+    fout << ",\"cat\":\"vigilante\",\"ph\":\"X\",\"pid\":0"
+         << ",\"tid\":" << e.threadId
+         << ",\"ts\":" << e.beginNs / 1000.0
+         << ",\"dur\":" << (e.endNs - e.beginNs) / 1000.0 << "}";
+  }
+  fout << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return fout.good();
+}
+
+}  // namespace profiler
+
+}  // namespace vigilante
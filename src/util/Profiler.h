@@ -0,0 +1,127 @@
+// Copyright (c) 2018-2021 Marco Wang <m.aesophor@gmail.com>. All rights reserved.
+#ifndef VIGILANTE_PROFILER_H_
+#define VIGILANTE_PROFILER_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The profiler is compiled in only if VIGILANTE_PROFILER is defined
+// (see CMakeLists.txt). Otherwise VGPROFILE_SCOPE() expands to nothing.
+//
+// Example usage:
+//   void GameMapManager::update(float delta) {
+//     VGPROFILE_SCOPE("GameMapManager::update");
+//     ...
+//   }
+#define VGPROFILE_CONCAT_IMPL(a, b) a##b
+#define VGPROFILE_CONCAT(a, b) VGPROFILE_CONCAT_IMPL(a, b)
+
+#ifdef VIGILANTE_PROFILER
+#define VGPROFILE_SCOPE(name)\
+  vigilante::profiler::Zone VGPROFILE_CONCAT(_vgProfilerZone, __LINE__)(name)
+#else
+#define VGPROFILE_SCOPE(name)
+#endif
+
+
+namespace vigilante {
+
+namespace profiler {
+
+// A zone which has been closed, i.e., [beginNs, endNs) on thread `threadId`.
+// `name` must be a string literal (or otherwise outlive the profiler).
+struct Event {
+  const char* name;
+  uint64_t beginNs;
+  uint64_t endNs;
+  uint32_t threadId;
+};
+
+struct ZoneStats {
+  std::string name;
+  double lastFrameMs;  // total time spent in this zone during the last frame
+  double avgMs;  // exponential moving average of `lastFrameMs`
+  double maxMs;  // max of `lastFrameMs` since the last resetStats()
+  int calls;  // # of times this zone was entered during the last frame
+};
+
+
+// Single-producer single-consumer ring buffer of events.
+// The producer is the thread which owns the buffer, and
+// the consumer is the main thread (see collect()).
+class ThreadBuffer {
+ public:
+  static const size_t kCapacity = 4096;  // must be a power of 2
+
+  explicit ThreadBuffer(uint32_t threadId);
+  virtual ~ThreadBuffer() = default;
+
+  // Producer side. If the buffer is full, the event is dropped.
+  void push(const char* name, uint64_t beginNs, uint64_t endNs);
+
+  // Consumer side.
+  template <typename Callable>
+  void drain(const Callable& callable);
+
+  uint32_t getThreadId() const;
+  size_t getDroppedCount() const;
+
+ private:
+  std::array<Event, kCapacity> _events;
+  std::atomic<size_t> _head;  // next slot to read, written by the consumer
+  std::atomic<size_t> _tail;  // next slot to write, written by the producer
+  std::atomic<size_t> _droppedCount;
+  const uint32_t _threadId;
+};
+
+
+// RAII zone. See VGPROFILE_SCOPE().
+class Zone final {
+ public:
+  explicit Zone(const char* name);
+  ~Zone();
+
+ private:
+  const char* _name;
+  uint64_t _beginNs;
+};
+
+
+// Nanoseconds elapsed since the profiler's epoch.
+uint64_t now();
+
+// Returns true if VIGILANTE_PROFILER was defined at compile time.
+bool isCompiledIn();
+
+// Drains every thread's buffer into the main thread's history and
+// updates the per-zone stats. Call this once per frame from the main thread.
+void collect();
+
+// Per-zone stats sorted by `avgMs` in descending order.
+std::vector<ZoneStats> getStats();
+void resetStats();
+
+// Writes the collected history in Chrome's trace_event JSON format
+// (open it with chrome://tracing or https://ui.perfetto.dev).
+bool dumpChromeTrace(const std::string& fileName);
+
+
+template <typename Callable>
+void ThreadBuffer::drain(const Callable& callable) {
+  size_t head = _head.load(std::memory_order_relaxed);
+  const size_t tail = _tail.load(std::memory_order_acquire);
+
+  for (; head != tail; head++) {
+    callable(_events[head & (kCapacity - 1)]);
+  }
+  _head.store(head, std::memory_order_release);
+}
+
+}  // namespace profiler
+
+}  // namespace vigilante
+
+#endif  // VIGILANTE_PROFILER_H_
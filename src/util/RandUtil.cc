@@ -2,22 +2,168 @@
 #include "RandUtil.h"
 
 #include <ctime>
-#include <random>
+
+using std::array;
 
 namespace vigilante {
 
 namespace rand_util {
 
+namespace {
+
+unsigned int currentSeed = 0;
+array<Generator, Stream::STREAM_SIZE> generators;
+
+inline uint64_t rotl(const uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+inline uint64_t splitmix64(uint64_t& x) {
+  uint64_t z = (x += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+}  // namespace
+
+
+Generator::Generator(uint64_t seed) : _s() {
+  this->seed(seed);
+}
+
+void Generator::seed(uint64_t seed) {
+  for (auto& s : _s) {
+    s = splitmix64(seed);
+  }
+}
+
+uint64_t Generator::next() {
+  const uint64_t result = rotl(_s[1] * 5, 7) * 9;
+  const uint64_t t = _s[1] << 17;
+
+  _s[2] ^= _s[0];
+  _s[3] ^= _s[1];
+  _s[1] ^= _s[2];
+  _s[0] ^= _s[3];
+  _s[2] ^= t;
+  _s[3] = rotl(_s[3], 45);
+
+  return result;
+}
+
+void Generator::jump() {
+  static const uint64_t kJump[] = {
+    0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c
+  };
+
+  array<uint64_t, 4> s = {{0, 0, 0, 0}};
+  for (auto j : kJump) {
+    for (int b = 0; b < 64; b++) {
+      if (j & (uint64_t(1) << b)) {
+        for (int i = 0; i < 4; i++) {
+          s[i] ^= _s[i];
+        }
+      }
+      next();
+    }
+  }
+  _s = s;
+}
+
+uint32_t Generator::nextUInt(uint32_t bound) {
+  // Lemire's nearly divisionless method, which (unlike `rand() % n`) is unbiased.
+  uint64_t m = (next() >> 32) * bound;
+  uint32_t l = static_cast<uint32_t>(m);
+
+  if (l < bound) {
+    const uint32_t threshold = -bound % bound;
+    while (l < threshold) {
+      m = (next() >> 32) * bound;
+      l = static_cast<uint32_t>(m);
+    }
+  }
+  return static_cast<uint32_t>(m >> 32);
+}
+
+int Generator::nextInt(int min, int max) {
+  if (max <= min) {
+    return min;
+  }
+  const uint32_t range = static_cast<uint32_t>(static_cast<int64_t>(max) - min + 1);
+  // If range overflows to 0, then [min, max] covers every 32-bit integer.
+  const uint32_t r = (range == 0) ? static_cast<uint32_t>(next() >> 32) : nextUInt(range);
+  return static_cast<int>(static_cast<int64_t>(min) + r);
+}
+
+float Generator::nextFloat(float min, float max) {
+  // The upper 24 bits fill a float's mantissa exactly, giving [0, 1).
+  const float r = (next() >> 40) * (1.0f / (uint64_t(1) << 24));
+  return r * (max - min) + min;
+}
+
+void Generator::fillInts(int* out, size_t count, int min, int max) {
+  for (size_t i = 0; i < count; i++) {
+    out[i] = nextInt(min, max);
+  }
+}
+
+void Generator::fillFloats(float* out, size_t count, float min, float max) {
+  for (size_t i = 0; i < count; i++) {
+    out[i] = nextFloat(min, max);
+  }
+}
+
+
 void init() {
-  srand(time(nullptr));
+  init(time(nullptr));
+}
+
+void init(unsigned int seed) {
+  currentSeed = seed;
+
+  uint64_t x = seed;
+  for (auto& generator : generators) {
+    generator.seed(splitmix64(x));
+  }
+}
+
+unsigned int getSeed() {
+  return currentSeed;
+}
+
+Generator& getGenerator(Stream stream) {
+  return generators[stream];
+}
+
+Generator fork(Stream stream) {
+  Generator forked = generators[stream];
+  generators[stream].jump();
+  return forked;
 }
 
 int randInt(int min, int max) {
-  return (rand() % (max + 1 - min)) + min;
+  return generators[Stream::DEFAULT].nextInt(min, max);
 }
 
 float randFloat(float min, float max) {
-  return (float(rand()) / (float(RAND_MAX) + 1.0)) * (max - min) + min;
+  return generators[Stream::DEFAULT].nextFloat(min, max);
+}
+
+int randInt(Stream stream, int min, int max) {
+  return generators[stream].nextInt(min, max);
+}
+
+float randFloat(Stream stream, float min, float max) {
+  return generators[stream].nextFloat(min, max);
+}
+
+void fillInts(Stream stream, int* out, size_t count, int min, int max) {
+  generators[stream].fillInts(out, count, min, max);
+}
+
+void fillFloats(Stream stream, float* out, size_t count, float min, float max) {
+  generators[stream].fillFloats(out, count, min, max);
 }
 
 } // namespace rand_util
@@ -2,13 +2,72 @@
 #ifndef VIGILANTE_RAND_UTIL_H_
 #define VIGILANTE_RAND_UTIL_H_
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
 namespace vigilante {
 
 namespace rand_util {
 
+// Each subsystem draws from its own stream, so that e.g. adding a camera shake
+// doesn't change the outcome of the next loot roll.
+enum Stream {
+  DEFAULT,
+  LOOT,
+  AI,
+  FX,
+  COMBAT,
+  STREAM_SIZE
+};
+
+
+// xoshiro256** 1.0 (http://prng.di.unimi.it/), seeded with splitmix64.
+// A Generator is NOT thread-safe. Threads which need random numbers
+// should fork() their own Generator from a stream instead.
+class Generator {
+ public:
+  explicit Generator(uint64_t seed=0);
+  virtual ~Generator() = default;
+
+  void seed(uint64_t seed);
+  uint64_t next();
+
+  // Advances the state by 2^128 calls to next(). Used to create
+  // non-overlapping subsequences for parallel computations.
+  void jump();
+
+  uint32_t nextUInt(uint32_t bound);  // [0, bound)
+  int nextInt(int min, int max);  // [min, max]
+  float nextFloat(float min, float max);  // [min, max)
+
+  void fillInts(int* out, size_t count, int min, int max);
+  void fillFloats(float* out, size_t count, float min, float max);
+
+ private:
+  std::array<uint64_t, 4> _s;
+};
+
+
+// Seeds every stream from the given seed.
+// If no seed is given, the current time is used.
 void init();
+void init(unsigned int seed);
+unsigned int getSeed();
+
+Generator& getGenerator(Stream stream);
+
+// Returns a copy of the stream's generator, and then jumps the stream ahead,
+// so that the returned generator never overlaps with the stream (or with
+// any other generator forked from it).
+Generator fork(Stream stream);
+
 int randInt(int min=0, int max=1);
 float randFloat(float min=0.0f, float max=1.0f);
+int randInt(Stream stream, int min, int max);
+float randFloat(Stream stream, float min, float max);
+void fillInts(Stream stream, int* out, size_t count, int min, int max);
+void fillFloats(Stream stream, float* out, size_t count, float min, float max);
 
 } // namespace rand_util
 